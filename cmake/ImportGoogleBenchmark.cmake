@@ -0,0 +1,19 @@
+# SPDX-License-Identifier: MIT
+
+find_package(benchmark 1.6.0)
+
+if (NOT benchmark_FOUND)
+    include(FetchContent)
+
+    FetchContent_Declare(
+        googlebenchmark
+        GIT_REPOSITORY "https://github.com/google/benchmark.git"
+        GIT_TAG v1.8.3
+        SOURCE_DIR ${PROJECT_SOURCE_DIR}/extern/googlebenchmark
+    )
+
+    option(BENCHMARK_ENABLE_TESTING "" OFF)
+    option(BENCHMARK_ENABLE_INSTALL "" OFF)
+
+    FetchContent_MakeAvailable(googlebenchmark)
+endif()
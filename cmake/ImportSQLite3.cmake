@@ -1,6 +1,9 @@
 # SPDX-License-Identifier: MIT
 
-find_package(SQLite3 3.40.1)
+if (NOT SQLITEPP_ENABLE_SNAPSHOT AND NOT SQLITEPP_ENABLE_STMT_SCANSTATUS)
+    # system builds of SQLite rarely include the snapshot or scan status APIs
+    find_package(SQLite3 3.40.1)
+endif()
 
 if (NOT SQLite3_FOUND)
     include(FetchContent)
@@ -25,5 +28,12 @@ if (NOT SQLite3_FOUND)
     set(SQLITE_USE_ALLOCA ON INTERNAL "")
     set(SQLITE_BUILD_SHELL ON INTERNAL "")
 
+    if (SQLITEPP_ENABLE_SNAPSHOT)
+        set(SQLITE_ENABLE_SNAPSHOT ON CACHE INTERNAL "")
+    endif()
+    if (SQLITEPP_ENABLE_STMT_SCANSTATUS)
+        set(SQLITE_ENABLE_STMT_SCANSTATUS ON CACHE INTERNAL "")
+    endif()
+
     FetchContent_MakeAvailable(sqlite-amalgamation)
 endif()
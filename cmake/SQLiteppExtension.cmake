@@ -0,0 +1,16 @@
+# SPDX-License-Identifier: MIT
+
+# sqlitepp_add_extension(<name> <source>...)
+#
+# Adds a shared module target <name> building a loadable SQLite extension
+# from sources defining SQLITEPP_EXTENSION(<name>). The file is named
+# <name> plus the module suffix, from which SQLite derives the entry point
+# sqlite3_<name>_init, so <name> should consist of letters only.
+function(sqlitepp_add_extension name)
+    add_library(${name} MODULE ${ARGN})
+    target_link_libraries(${name} PRIVATE SQLitepp::sqlitepp_ext)
+    set_target_properties(${name} PROPERTIES
+        PREFIX ""
+        CXX_VISIBILITY_PRESET hidden
+        VISIBILITY_INLINES_HIDDEN ON)
+endfunction()
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef BENCH_SUPPORT_HPP
+#define BENCH_SUPPORT_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+inline void bench_exec(sqlite3* db, const char* sql)
+{
+    char* message = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &message) != SQLITE_OK) {
+        std::string what = message != nullptr ? message : "sqlite3_exec failed";
+        sqlite3_free(message);
+        throw std::runtime_error(what);
+    }
+}
+
+inline void bench_remove_database(const std::string& filename)
+{
+    std::remove(filename.c_str());
+    std::remove((filename + "-journal").c_str());
+    std::remove((filename + "-wal").c_str());
+    std::remove((filename + "-shm").c_str());
+}
+
+// Fills kv(id INTEGER PRIMARY KEY, v TEXT) with the given number of rows.
+inline void bench_populate_kv(sqlite3* db, int rows)
+{
+    bench_exec(db, "CREATE TABLE IF NOT EXISTS kv(id INTEGER PRIMARY KEY, v TEXT NOT NULL)");
+    std::string sql = "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(rows) +
+                      ") INSERT INTO kv SELECT x, printf('value-%08d', x) FROM n";
+    bench_exec(db, sql.c_str());
+}
+
+#endif // BENCH_SUPPORT_HPP
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/compress_vfs.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int table_rows = 200000;
+
+// A database of archival-looking rows, through the VFS named, or the
+// default one for null.
+std::string archive(const char* vfsname)
+{
+    std::string filename = std::string{"compress_vfs_bench_"} + (vfsname != nullptr ? vfsname : "default") + ".db";
+    bench_remove_database(filename);
+    auto conn = connect(filename, connection::openmode::rwc, vfsname);
+    bench_exec(conn.conn_handle(), "CREATE TABLE events(id INTEGER PRIMARY KEY, kind TEXT, source TEXT, message TEXT)");
+    std::string sql = "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(table_rows) +
+                      ") INSERT INTO events SELECT x, 'kind-' || (x % 7), 'host-' || (x % 31) || '.example.org', "
+                      "printf('request %d served in %d ms with status %d', x, x % 250, 200 + x % 3) FROM n";
+    bench_exec(conn.conn_handle(), sql.c_str());
+    return filename;
+}
+
+// Full scans with a page cache too small for the table, so every page comes
+// from the file.
+void run_scan(benchmark::State& state, const char* vfsname)
+{
+    vfs::register_compress();
+    auto filename = archive(vfsname);
+    auto conn = connect(filename, connection::openmode::rw, vfsname);
+    bench_exec(conn.conn_handle(), "PRAGMA cache_size = 16");
+    statement scan{conn, "SELECT sum(length(message)) FROM events"};
+    for (auto _ : state) {
+        scan.step();
+        benchmark::DoNotOptimize(scan.column_int64(0));
+        scan.reset();
+    }
+    std::ifstream file{filename, std::ios::binary | std::ios::ate};
+    state.counters["file_bytes"] = static_cast<double>(file.tellg());
+    state.SetItemsProcessed(state.iterations() * table_rows);
+    conn.close();
+    bench_remove_database(filename);
+}
+
+} // namespace
+
+static void BM_Scan_DefaultVfs(benchmark::State& state)
+{
+    run_scan(state, nullptr);
+}
+BENCHMARK(BM_Scan_DefaultVfs)->Unit(benchmark::kMillisecond);
+
+static void BM_Scan_CompressVfs(benchmark::State& state)
+{
+    run_scan(state, "compress");
+}
+BENCHMARK(BM_Scan_CompressVfs)->Unit(benchmark::kMillisecond);
+
+static void BM_Insert_DefaultVfs(benchmark::State& state)
+{
+    for (auto _ : state) {
+        bench_remove_database(archive(nullptr));
+    }
+    state.SetItemsProcessed(state.iterations() * table_rows);
+}
+BENCHMARK(BM_Insert_DefaultVfs)->Unit(benchmark::kMillisecond);
+
+static void BM_Insert_CompressVfs(benchmark::State& state)
+{
+    vfs::register_compress();
+    for (auto _ : state) {
+        bench_remove_database(archive("compress"));
+    }
+    state.SetItemsProcessed(state.iterations() * table_rows);
+}
+BENCHMARK(BM_Insert_CompressVfs)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+
+#include <array>
+#include <benchmark/benchmark.h>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+struct open_case
+{
+    const char* label;
+    const char* filename;
+    connection::openmode mode;
+};
+
+constexpr const char database[] = "connection_bench.db";
+
+const std::array<open_case, 5> cases{{
+    {"ro", database, connection::openmode::ro},
+    {"rw", database, connection::openmode::rw},
+    {"rwc", database, connection::openmode::rwc},
+    {"mem", database, connection::openmode::mem},
+    {"uri", "file:connection_bench.db?cache=private", connection::openmode::uri},
+}};
+
+void ensure_database()
+{
+    sqlite3* db = nullptr;
+    sqlite3_open_v2(database, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+    bench_exec(db, "CREATE TABLE IF NOT EXISTS t(x)");
+    sqlite3_close_v2(db);
+}
+
+} // namespace
+
+static void BM_OpenClose_Sqlitepp(benchmark::State& state)
+{
+    ensure_database();
+    const auto& c = cases[static_cast<std::size_t>(state.range(0))];
+    state.SetLabel(c.label);
+    for (auto _ : state) {
+        connection conn{c.filename, c.mode};
+        benchmark::DoNotOptimize(conn.conn_handle());
+        conn.close();
+    }
+}
+BENCHMARK(BM_OpenClose_Sqlitepp)->DenseRange(0, static_cast<int>(cases.size()) - 1);
+
+static void BM_OpenClose_Raw(benchmark::State& state)
+{
+    ensure_database();
+    const auto& c = cases[static_cast<std::size_t>(state.range(0))];
+    state.SetLabel(c.label);
+    for (auto _ : state) {
+        sqlite3* db = nullptr;
+        if (sqlite3_open_v2(c.filename, &db, static_cast<int>(c.mode) | SQLITE_OPEN_EXRESCODE, nullptr) != SQLITE_OK) {
+            state.SkipWithError(sqlite3_errmsg(db));
+        }
+        benchmark::DoNotOptimize(db);
+        sqlite3_close_v2(db);
+    }
+}
+BENCHMARK(BM_OpenClose_Raw)->DenseRange(0, static_cast<int>(cases.size()) - 1);
+
+namespace
+{
+
+// a fixture load followed by queries whose rows a script throws away
+constexpr const char script[] = "DELETE FROM s;"
+                                "WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM c LIMIT 1000) INSERT INTO s SELECT i, i * 0.5, 'row ' || i FROM c;"
+                                "SELECT * FROM s;"
+                                "SELECT * FROM s WHERE a % 2 = 0;";
+
+int discard_row(void*, int, char**, char**)
+{
+    return 0;
+}
+
+} // namespace
+
+static void BM_Script_Sqlitepp(benchmark::State& state)
+{
+    connection conn{":memory:"};
+    bench_exec(conn.conn_handle(), "CREATE TABLE s(a, b, c)");
+    for (auto _ : state) {
+        auto result = conn.execute_script(script);
+        benchmark::DoNotOptimize(result.statements);
+    }
+}
+BENCHMARK(BM_Script_Sqlitepp);
+
+static void BM_Script_Exec(benchmark::State& state)
+{
+    connection conn{":memory:"};
+    bench_exec(conn.conn_handle(), "CREATE TABLE s(a, b, c)");
+    for (auto _ : state) {
+        // with a callback sqlite3_exec converts every column of every row to text
+        if (sqlite3_exec(conn.conn_handle(), script, discard_row, nullptr, nullptr) != SQLITE_OK) {
+            state.SkipWithError(sqlite3_errmsg(conn.conn_handle()));
+        }
+    }
+}
+BENCHMARK(BM_Script_Exec);
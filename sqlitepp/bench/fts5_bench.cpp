@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/fts5_tokenizer.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int corpus_documents = 2000;
+constexpr int document_words = 150;
+
+// Documents of mixed-case English-like words and punctuation.
+const std::vector<std::string>& corpus()
+{
+    static const std::vector<std::string> documents = []() {
+        std::mt19937 rng{5};
+        std::vector<std::string> vocabulary;
+        std::uniform_int_distribution<int> length{2, 12};
+        std::uniform_int_distribution<int> letter{0, 25};
+        for (int i = 0; i < 5000; ++i) {
+            std::string word;
+            for (int n = length(rng); n > 0; --n) {
+                word += static_cast<char>((i % 7 == 0 && word.empty() ? 'A' : 'a') + letter(rng));
+            }
+            vocabulary.push_back(word);
+        }
+        const char* separators[] = {" ", " ", " ", " ", ", ", ". ", " - ", "; ", " (", ") "};
+        std::uniform_int_distribution<std::size_t> pick_word{0, vocabulary.size() - 1};
+        std::uniform_int_distribution<std::size_t> pick_separator{0, std::size(separators) - 1};
+        std::vector<std::string> result;
+        for (int d = 0; d < corpus_documents; ++d) {
+            std::string document;
+            for (int w = 0; w < document_words; ++w) {
+                document += vocabulary[pick_word(rng)];
+                document += separators[pick_separator(rng)];
+            }
+            result.push_back(document);
+        }
+        return result;
+    }();
+    return documents;
+}
+
+void run_index(benchmark::State& state, const char* tokenize)
+{
+    auto& documents = corpus();
+    std::size_t bytes = 0;
+    for (auto& document : documents) {
+        bytes += document.size();
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto conn = connect(":memory:");
+        register_tokenizer<word_tokenizer>(conn, "word");
+        bench_exec(conn.conn_handle(), (std::string{"CREATE VIRTUAL TABLE docs USING fts5(body, tokenize = '"} + tokenize + "')").c_str());
+        state.ResumeTiming();
+
+        bench_exec(conn.conn_handle(), "BEGIN");
+        statement insert{conn, "INSERT INTO docs(body) VALUES (?1)"};
+        for (auto& document : documents) {
+            insert.bind(1, document);
+            insert.step();
+            insert.reset();
+        }
+        bench_exec(conn.conn_handle(), "COMMIT");
+    }
+    // documents per second
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(documents.size()));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(bytes));
+}
+
+} // namespace
+
+static void BM_Fts5Index_Unicode61(benchmark::State& state)
+{
+    run_index(state, "unicode61");
+}
+BENCHMARK(BM_Fts5Index_Unicode61)->Unit(benchmark::kMillisecond);
+
+static void BM_Fts5Index_Word(benchmark::State& state)
+{
+    run_index(state, "word");
+}
+BENCHMARK(BM_Fts5Index_Word)->Unit(benchmark::kMillisecond);
+
+// The tokenizers alone, through fts5_api::xFindTokenizer.
+static void BM_Tokenize_Unicode61(benchmark::State& state)
+{
+    auto conn = connect(":memory:");
+    std::error_code ec;
+    auto api = get_fts5_api(conn, ec);
+    void* context = nullptr;
+    fts5_tokenizer tokenizer;
+    api->xFindTokenizer(api, "unicode61", &context, &tokenizer);
+    Fts5Tokenizer* instance = nullptr;
+    tokenizer.xCreate(context, nullptr, 0, &instance);
+    auto& documents = corpus();
+    for (auto _ : state) {
+        for (auto& document : documents) {
+            tokenizer.xTokenize(instance, nullptr, FTS5_TOKENIZE_DOCUMENT, document.data(), static_cast<int>(document.size()),
+                                [](void*, int, const char*, int, int, int) { return SQLITE_OK; });
+        }
+    }
+    tokenizer.xDelete(instance);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(documents.size()));
+}
+BENCHMARK(BM_Tokenize_Unicode61);
+
+static void BM_Tokenize_Word(benchmark::State& state)
+{
+    auto conn = connect(":memory:");
+    std::error_code ec;
+    word_tokenizer tokenizer{get_fts5_api(conn, ec), {}};
+    auto& documents = corpus();
+    for (auto _ : state) {
+        for (auto& document : documents) {
+            token_emitter emit{nullptr, FTS5_TOKENIZE_DOCUMENT, [](void*, int, const char*, int, int, int) { return SQLITE_OK; }};
+            tokenizer.tokenize(document, emit);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(documents.size()));
+}
+BENCHMARK(BM_Tokenize_Word);
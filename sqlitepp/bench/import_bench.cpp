@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/import.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int csv_rows = 200000;
+constexpr const char database[] = "import_bench.db";
+constexpr const char csv_file[] = "import_bench.csv";
+
+void write_csv()
+{
+    std::ofstream out{csv_file, std::ios::binary};
+    out << "id,name,city,amount\n";
+    for (int i = 0; i < csv_rows; ++i) {
+        out << i << ",customer-" << i * 7 % 1000 << ",\"Springfield, " << i % 50 << "\"," << i * 0.25 << '\n';
+    }
+}
+
+connection make_database()
+{
+    bench_remove_database(database);
+    auto conn = connect(database);
+    bench_exec(conn.conn_handle(), "PRAGMA journal_mode = WAL");
+    bench_exec(conn.conn_handle(), "PRAGMA synchronous = NORMAL");
+    bench_exec(conn.conn_handle(), "CREATE TABLE t(id, name, city, amount)");
+    return conn;
+}
+
+void truncate(benchmark::State& state, sqlite3* db)
+{
+    state.PauseTiming();
+    bench_exec(db, "DELETE FROM t");
+    state.ResumeTiming();
+}
+
+} // namespace
+
+// The usual hand-written loader: getline, split into strings, bind copies.
+static void BM_ImportCsv_Iostream(benchmark::State& state)
+{
+    write_csv();
+    {
+        auto conn = make_database();
+        statement stmt{conn, "INSERT INTO t VALUES (?1, ?2, ?3, ?4)"};
+        for (auto _ : state) {
+            std::ifstream in{csv_file};
+            std::string line;
+            std::getline(in, line);
+            transaction tx{conn};
+            while (std::getline(in, line)) {
+                std::vector<std::string> fields;
+                std::string field;
+                bool quoted = false;
+                for (char c : line) {
+                    if (c == '"') {
+                        quoted = !quoted;
+                    }
+                    else if (c == ',' && !quoted) {
+                        fields.push_back(std::move(field));
+                        field.clear();
+                    }
+                    else {
+                        field += c;
+                    }
+                }
+                fields.push_back(std::move(field));
+                for (std::size_t i = 0; i < fields.size(); ++i) {
+                    stmt.bind(static_cast<int>(i + 1), fields[i]);
+                }
+                stmt.step();
+                stmt.reset();
+            }
+            tx.commit();
+            truncate(state, conn.conn_handle());
+        }
+    }
+    bench_remove_database(database);
+    std::remove(csv_file);
+    state.SetItemsProcessed(state.iterations() * csv_rows);
+}
+BENCHMARK(BM_ImportCsv_Iostream)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ImportCsv_Sqlitepp(benchmark::State& state)
+{
+    write_csv();
+    {
+        auto conn = make_database();
+        for (auto _ : state) {
+            import_csv(conn, csv_file, "t");
+            truncate(state, conn.conn_handle());
+        }
+    }
+    bench_remove_database(database);
+    std::remove(csv_file);
+    state.SetItemsProcessed(state.iterations() * csv_rows);
+}
+BENCHMARK(BM_ImportCsv_Sqlitepp)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/bulk_loader.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int rows_per_iteration = 10000;
+constexpr const char database[] = "insert_bench.db";
+constexpr const char insert_sql[] = "INSERT INTO kv(id, v) VALUES (?1, ?2)";
+
+connection make_database()
+{
+    bench_remove_database(database);
+    auto conn = connect(database);
+    bench_exec(conn.conn_handle(), "PRAGMA journal_mode = WAL");
+    bench_exec(conn.conn_handle(), "PRAGMA synchronous = NORMAL");
+    bench_exec(conn.conn_handle(), "CREATE TABLE kv(id INTEGER PRIMARY KEY, v TEXT NOT NULL)");
+    return conn;
+}
+
+// Keys in random order, as they come out of an unsorted export.
+std::vector<std::int64_t> shuffled_keys(int rows)
+{
+    std::vector<std::int64_t> keys(rows);
+    std::iota(keys.begin(), keys.end(), std::int64_t{1});
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64{42});
+    return keys;
+}
+
+void truncate(benchmark::State& state, sqlite3* db)
+{
+    state.PauseTiming();
+    bench_exec(db, "DELETE FROM kv");
+    state.ResumeTiming();
+}
+
+} // namespace
+
+static void BM_BulkInsert_Sqlitepp(benchmark::State& state)
+{
+    auto transaction_size = static_cast<int>(state.range(0));
+    {
+        auto conn = make_database();
+        statement stmt{conn, insert_sql};
+        std::optional<transaction> tx;
+        for (auto _ : state) {
+            for (int i = 0; i < rows_per_iteration; ++i) {
+                if (i % transaction_size == 0) {
+                    tx.emplace(conn);
+                }
+                stmt.bind(1, i);
+                stmt.bind(2, "value");
+                stmt.step();
+                stmt.reset();
+                if ((i + 1) % transaction_size == 0 || i + 1 == rows_per_iteration) {
+                    tx->commit();
+                    tx.reset();
+                }
+            }
+            truncate(state, conn.conn_handle());
+        }
+    }
+    bench_remove_database(database);
+    state.SetItemsProcessed(state.iterations() * rows_per_iteration);
+}
+BENCHMARK(BM_BulkInsert_Sqlitepp)->RangeMultiplier(10)->Range(1, 10000)->Unit(benchmark::kMillisecond);
+
+static void BM_BulkInsert_Raw(benchmark::State& state)
+{
+    auto transaction_size = static_cast<int>(state.range(0));
+    {
+        auto conn = make_database();
+        sqlite3* db = conn.conn_handle();
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v3(db, insert_sql, sizeof(insert_sql) - 1, 0, &stmt, nullptr);
+        for (auto _ : state) {
+            for (int i = 0; i < rows_per_iteration; ++i) {
+                if (i % transaction_size == 0) {
+                    bench_exec(db, "BEGIN IMMEDIATE");
+                }
+                sqlite3_bind_int64(stmt, 1, i);
+                sqlite3_bind_text64(stmt, 2, "value", 5, SQLITE_TRANSIENT, SQLITE_UTF8);
+                sqlite3_step(stmt);
+                sqlite3_reset(stmt);
+                if ((i + 1) % transaction_size == 0 || i + 1 == rows_per_iteration) {
+                    bench_exec(db, "COMMIT");
+                }
+            }
+            truncate(state, db);
+        }
+        sqlite3_finalize(stmt);
+    }
+    bench_remove_database(database);
+    state.SetItemsProcessed(state.iterations() * rows_per_iteration);
+}
+BENCHMARK(BM_BulkInsert_Raw)->RangeMultiplier(10)->Range(1, 10000)->Unit(benchmark::kMillisecond);
+
+// Inserts in transactions of 1000 rows while a subscriber receives each batch.
+static void BM_BulkInsert_Subscribed(benchmark::State& state)
+{
+    auto delivery = state.range(0) == 0 ? change_delivery::on_commit : change_delivery::worker;
+    std::atomic<std::size_t> notified{0};
+    {
+        auto conn = make_database();
+        auto subscription = conn.on_change("kv", [&notified](const table_changes& changes) { notified += changes.rows.size(); }, delivery);
+        statement stmt{conn, insert_sql};
+        for (auto _ : state) {
+            for (int i = 0; i < rows_per_iteration; i += 1000) {
+                transaction tx{conn};
+                for (int j = i; j < i + 1000; ++j) {
+                    stmt.bind(1, j);
+                    stmt.bind(2, "value");
+                    stmt.step();
+                    stmt.reset();
+                }
+                tx.commit();
+            }
+            truncate(state, conn.conn_handle());
+        }
+    }
+    bench_remove_database(database);
+    state.SetItemsProcessed(state.iterations() * rows_per_iteration);
+    state.counters["notified"] = static_cast<double>(notified.load());
+}
+BENCHMARK(BM_BulkInsert_Subscribed)->ArgName("worker")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+constexpr int unsorted_rows = 200000;
+
+static void BM_UnsortedInsert_Sqlitepp(benchmark::State& state)
+{
+    auto keys = shuffled_keys(unsorted_rows);
+    {
+        auto conn = make_database();
+        bench_exec(conn.conn_handle(), "CREATE INDEX kv_v ON kv(v)");
+        statement stmt{conn, insert_sql};
+        for (auto _ : state) {
+            transaction tx{conn};
+            for (auto key : keys) {
+                stmt.bind(1, key);
+                stmt.bind(2, std::to_string(key * 7919 % unsorted_rows));
+                stmt.step();
+                stmt.reset();
+            }
+            tx.commit();
+            truncate(state, conn.conn_handle());
+        }
+    }
+    bench_remove_database(database);
+    state.SetItemsProcessed(state.iterations() * unsorted_rows);
+}
+BENCHMARK(BM_UnsortedInsert_Sqlitepp)->Unit(benchmark::kMillisecond);
+
+static void BM_UnsortedInsert_BulkLoader(benchmark::State& state)
+{
+    auto keys = shuffled_keys(unsorted_rows);
+    {
+        auto conn = make_database();
+        bench_exec(conn.conn_handle(), "CREATE INDEX kv_v ON kv(v)");
+        thread_pool threads;
+        bulk_load_options options;
+        options.rebuild_indexes = state.range(0) != 0;
+        for (auto _ : state) {
+            bulk_loader<std::int64_t, std::string> loader{conn, "kv", insert_sql, threads, options};
+            loader.reserve(keys.size());
+            for (auto key : keys) {
+                loader.add(key, std::to_string(key * 7919 % unsorted_rows));
+            }
+            loader.load();
+            truncate(state, conn.conn_handle());
+        }
+    }
+    bench_remove_database(database);
+    state.SetItemsProcessed(state.iterations() * unsorted_rows);
+}
+BENCHMARK(BM_UnsortedInsert_BulkLoader)->ArgName("rebuild_indexes")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
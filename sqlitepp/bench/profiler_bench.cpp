@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/profiler.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <benchmark/benchmark.h>
+#include <memory>
+
+using namespace sqlitepp;
+
+static int bench_ignore_trace(unsigned, void*, void*, void*)
+{
+    return 0;
+}
+
+// Point query with and without a profiler attached, for the overhead of the
+// profiler on a short statement. Argument 2 installs a trace callback that
+// does nothing for the events the profiler asks for: the part of the
+// overhead that is SQLite's own.
+static void BM_PointQuery_Profiler(benchmark::State& state)
+{
+    auto conn = connect(":memory:");
+    bench_populate_kv(conn.conn_handle(), 100000);
+    std::unique_ptr<profiler> prof;
+    if (state.range(0) == 1) {
+        prof = std::make_unique<profiler>(conn);
+    }
+    else if (state.range(0) == 2) {
+        sqlite3_trace_v2(conn.conn_handle(), SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &bench_ignore_trace, nullptr);
+    }
+    statement stmt{conn, "SELECT v FROM kv WHERE id = ?1"};
+    int key = 0;
+    for (auto _ : state) {
+        stmt.bind(1, key++ % 100000 + 1);
+        stmt.step();
+        benchmark::DoNotOptimize(stmt.column_text(0));
+        stmt.reset();
+    }
+    state.SetLabel(state.range(0) == 0 ? "detached" : state.range(0) == 1 ? "attached" : "empty trace callback");
+}
+BENCHMARK(BM_PointQuery_Profiler)->Arg(0)->Arg(1)->Arg(2);
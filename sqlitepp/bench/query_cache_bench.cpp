@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/query_cache.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <benchmark/benchmark.h>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int kv_rows = 100000;
+constexpr const char dashboard_sql[] = "SELECT count(*), max(v) FROM kv WHERE id BETWEEN ?1 AND ?1 + 1000";
+
+connection make_kv()
+{
+    auto conn = connect(":memory:");
+    bench_populate_kv(conn.conn_handle(), kv_rows);
+    return conn;
+}
+
+} // namespace
+
+static void BM_DashboardQuery_Uncached(benchmark::State& state)
+{
+    auto conn = make_kv();
+    statement stmt{conn, dashboard_sql};
+    for (auto _ : state) {
+        stmt.bind(1, 5000);
+        stmt.step();
+        benchmark::DoNotOptimize(stmt.column_int64(0));
+        benchmark::DoNotOptimize(stmt.column_text(1));
+        stmt.reset();
+    }
+}
+BENCHMARK(BM_DashboardQuery_Uncached);
+
+static void BM_DashboardQuery_Cached(benchmark::State& state)
+{
+    auto conn = make_kv();
+    query_cache cache{conn};
+    for (auto _ : state) {
+        auto result = cache.query(dashboard_sql, 5000);
+        benchmark::DoNotOptimize(result->column_int64(0, 0));
+        benchmark::DoNotOptimize(result->column_text(0, 1));
+    }
+    state.counters["hit_rate"] = cache.stats().hit_rate();
+}
+BENCHMARK(BM_DashboardQuery_Cached);
+
+// Every tenth lookup follows a write to the table the query reads.
+static void BM_DashboardQuery_CachedWithWrites(benchmark::State& state)
+{
+    auto conn = make_kv();
+    query_cache cache{conn};
+    statement update{conn, "UPDATE kv SET v = v WHERE id = 1"};
+    int i = 0;
+    for (auto _ : state) {
+        if (++i % 10 == 0) {
+            update.step();
+            update.reset();
+        }
+        auto result = cache.query(dashboard_sql, 5000);
+        benchmark::DoNotOptimize(result->column_int64(0, 0));
+    }
+    state.counters["hit_rate"] = cache.stats().hit_rate();
+}
+BENCHMARK(BM_DashboardQuery_CachedWithWrites);
@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int kv_rows = 100000;
+constexpr int wide_rows = 10000;
+constexpr int wide_columns = 32;
+constexpr const char lookup_sql[] = "SELECT v FROM kv WHERE id = ?1";
+
+struct kv_row
+{
+    std::int64_t id;
+    std::string v;
+};
+
+connection make_kv()
+{
+    auto conn = connect(":memory:");
+    bench_populate_kv(conn.conn_handle(), kv_rows);
+    return conn;
+}
+
+connection make_wide()
+{
+    auto conn = connect(":memory:");
+    std::string create = "CREATE TABLE wide(";
+    std::string select = "SELECT ";
+    for (int i = 0; i < wide_columns; ++i) {
+        auto name = "c" + std::to_string(i);
+        create += (i != 0 ? ", " : "") + name;
+        select += (i != 0 ? ", " : "") + (i % 2 == 0 ? "x * " + std::to_string(i) : "printf('text-%d', x + " + std::to_string(i) + ")");
+    }
+    bench_exec(conn.conn_handle(), (create + ")").c_str());
+    std::string insert = "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(wide_rows) +
+                         ") INSERT INTO wide " + select + " FROM n";
+    bench_exec(conn.conn_handle(), insert.c_str());
+    return conn;
+}
+
+std::vector<int> random_keys()
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{1, kv_rows};
+    std::vector<int> keys(4096);
+    for (auto& k : keys) {
+        k = dist(gen);
+    }
+    return keys;
+}
+
+} // namespace
+
+static void BM_PrepareBindStepFinalize_Sqlitepp(benchmark::State& state)
+{
+    auto conn = make_kv();
+    for (auto _ : state) {
+        statement stmt{conn, lookup_sql};
+        stmt.bind(1, 500);
+        stmt.step();
+        benchmark::DoNotOptimize(stmt.column_text(0));
+    }
+}
+BENCHMARK(BM_PrepareBindStepFinalize_Sqlitepp);
+
+static void BM_PrepareBindStepFinalize_Raw(benchmark::State& state)
+{
+    auto conn = make_kv();
+    sqlite3* db = conn.conn_handle();
+    for (auto _ : state) {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v3(db, lookup_sql, sizeof(lookup_sql) - 1, 0, &stmt, nullptr);
+        sqlite3_bind_int64(stmt, 1, 500);
+        sqlite3_step(stmt);
+        benchmark::DoNotOptimize(sqlite3_column_text(stmt, 0));
+        sqlite3_finalize(stmt);
+    }
+}
+BENCHMARK(BM_PrepareBindStepFinalize_Raw);
+
+static void BM_BindStepReset_Sqlitepp(benchmark::State& state)
+{
+    auto conn = make_kv();
+    statement stmt{conn, lookup_sql};
+    for (auto _ : state) {
+        stmt.bind(1, 500);
+        stmt.step();
+        benchmark::DoNotOptimize(stmt.column_text(0));
+        stmt.reset();
+    }
+}
+BENCHMARK(BM_BindStepReset_Sqlitepp);
+
+static void BM_BindStepReset_Raw(benchmark::State& state)
+{
+    auto conn = make_kv();
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v3(conn.conn_handle(), lookup_sql, sizeof(lookup_sql) - 1, 0, &stmt, nullptr);
+    for (auto _ : state) {
+        sqlite3_bind_int64(stmt, 1, 500);
+        sqlite3_step(stmt);
+        benchmark::DoNotOptimize(sqlite3_column_text(stmt, 0));
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+}
+BENCHMARK(BM_BindStepReset_Raw);
+
+static void BM_PointLookup_Sqlitepp(benchmark::State& state)
+{
+    auto conn = make_kv();
+    auto keys = random_keys();
+    statement stmt{conn, lookup_sql};
+    std::size_t i = 0;
+    for (auto _ : state) {
+        stmt.bind(1, keys[i++ % keys.size()]);
+        if (stmt.step()) {
+            benchmark::DoNotOptimize(stmt.column_text(0));
+        }
+        stmt.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PointLookup_Sqlitepp);
+
+static void BM_PointLookup_Raw(benchmark::State& state)
+{
+    auto conn = make_kv();
+    auto keys = random_keys();
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v3(conn.conn_handle(), lookup_sql, sizeof(lookup_sql) - 1, 0, &stmt, nullptr);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        sqlite3_bind_int64(stmt, 1, keys[i++ % keys.size()]);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            benchmark::DoNotOptimize(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PointLookup_Raw);
+
+static void BM_WideRowScan_Sqlitepp(benchmark::State& state)
+{
+    auto conn = make_wide();
+    statement stmt{conn, "SELECT * FROM wide"};
+    for (auto _ : state) {
+        while (stmt.step()) {
+            for (int c = 0; c < wide_columns; c += 2) {
+                benchmark::DoNotOptimize(stmt.column_int64(c));
+                benchmark::DoNotOptimize(stmt.column_text(c + 1));
+            }
+        }
+        stmt.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * wide_rows);
+}
+BENCHMARK(BM_WideRowScan_Sqlitepp);
+
+static void BM_WideRowScan_Raw(benchmark::State& state)
+{
+    auto conn = make_wide();
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v3(conn.conn_handle(), "SELECT * FROM wide", -1, 0, &stmt, nullptr);
+    for (auto _ : state) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            for (int c = 0; c < wide_columns; c += 2) {
+                benchmark::DoNotOptimize(sqlite3_column_int64(stmt, c));
+                benchmark::DoNotOptimize(sqlite3_column_text(stmt, c + 1));
+                benchmark::DoNotOptimize(sqlite3_column_bytes(stmt, c + 1));
+            }
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    state.SetItemsProcessed(state.iterations() * wide_rows);
+}
+BENCHMARK(BM_WideRowScan_Raw);
+
+static void BM_WideRowScan_Arrow(benchmark::State& state)
+{
+    auto conn = make_wide();
+    statement stmt{conn, "SELECT * FROM wide"};
+    auto batch_rows = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        for (;;) {
+            auto batch = stmt.to_arrow(batch_rows);
+            benchmark::DoNotOptimize(batch.array()->children);
+            if (static_cast<std::size_t>(batch.rows()) < batch_rows) {
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * wide_rows);
+}
+BENCHMARK(BM_WideRowScan_Arrow)->ArgName("batch_rows")->Arg(1024)->Arg(65536);
+
+static void BM_WideRowScan_Deadline(benchmark::State& state)
+{
+    auto conn = make_wide();
+    // never reached; measures the progress handler checks
+    conn.set_deadline(std::chrono::steady_clock::now() + std::chrono::hours{1});
+    statement stmt{conn, "SELECT * FROM wide"};
+    for (auto _ : state) {
+        while (stmt.step()) {
+            for (int c = 0; c < wide_columns; c += 2) {
+                benchmark::DoNotOptimize(stmt.column_int64(c));
+                benchmark::DoNotOptimize(stmt.column_text(c + 1));
+            }
+        }
+        stmt.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * wide_rows);
+}
+BENCHMARK(BM_WideRowScan_Deadline);
+
+static void BM_KvFetch_Columns(benchmark::State& state)
+{
+    auto conn = make_kv();
+    statement stmt{conn, "SELECT id, v FROM kv"};
+    std::vector<kv_row> rows;
+    for (auto _ : state) {
+        rows.clear();
+        while (stmt.step()) {
+            rows.push_back(kv_row{stmt.column_int64(0), std::string{stmt.column_text(1)}});
+        }
+        stmt.reset();
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kv_rows);
+}
+BENCHMARK(BM_KvFetch_Columns);
+
+static void BM_KvFetch_Aggregate(benchmark::State& state)
+{
+    auto conn = make_kv();
+    statement stmt{conn, "SELECT id, v FROM kv"};
+    std::vector<kv_row> rows;
+    for (auto _ : state) {
+        rows.clear();
+        stmt.fetch(rows);
+        stmt.reset();
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kv_rows);
+}
+BENCHMARK(BM_KvFetch_Aggregate);
+
+static void BM_WideRowScan_Values(benchmark::State& state)
+{
+    auto conn = make_wide();
+    statement stmt{conn, "SELECT * FROM wide"};
+    std::vector<value> cells;
+    cells.reserve(static_cast<std::size_t>(wide_rows) * wide_columns);
+    for (auto _ : state) {
+        cells.clear();
+        while (stmt.step()) {
+            for (int i = 0; i < wide_columns; ++i) {
+                cells.push_back(stmt.column_value(i));
+            }
+        }
+        stmt.reset();
+        benchmark::DoNotOptimize(cells.data());
+    }
+    state.SetItemsProcessed(state.iterations() * wide_rows * wide_columns);
+}
+BENCHMARK(BM_WideRowScan_Values);
+
+static void BM_WideRowScan_ValueDup(benchmark::State& state)
+{
+    auto conn = make_wide();
+    statement stmt{conn, "SELECT * FROM wide"};
+    std::vector<sqlite3_value*> cells;
+    cells.reserve(static_cast<std::size_t>(wide_rows) * wide_columns);
+    for (auto _ : state) {
+        for (auto cell : cells) {
+            sqlite3_value_free(cell);
+        }
+        cells.clear();
+        while (stmt.step()) {
+            for (int i = 0; i < wide_columns; ++i) {
+                cells.push_back(sqlite3_value_dup(sqlite3_column_value(stmt.stmt_handle(), i)));
+            }
+        }
+        stmt.reset();
+        benchmark::DoNotOptimize(cells.data());
+    }
+    for (auto cell : cells) {
+        sqlite3_value_free(cell);
+    }
+    state.SetItemsProcessed(state.iterations() * wide_rows * wide_columns);
+}
+BENCHMARK(BM_WideRowScan_ValueDup);
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: MIT
+
+#include "bench_support.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/extension.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/vector_functions.hpp>
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr std::size_t dimensions = 768;
+constexpr int item_rows = 10000;
+
+std::vector<float> random_vector(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+    std::vector<float> v(dimensions);
+    for (auto& x : v) {
+        x = dist(rng);
+    }
+    return v;
+}
+
+blob_view as_blob(const std::vector<float>& v)
+{
+    return blob_view{v.data(), v.size() * sizeof(float)};
+}
+
+// items(id, embedding) with random vectors, and vec_cosine_scalar, the
+// function a plain scalar UDF would compute.
+connection make_items()
+{
+    auto conn = connect(":memory:");
+    install_vector_functions(conn);
+    extension_registry registry;
+    registry.function("vec_cosine_scalar", [](blob_view a, blob_view b) {
+        double similarity = 0;
+        detail::cosine_similarity(detail::scalar_vector_kernels(), a.data, b.data, a.size / sizeof(float), similarity);
+        return similarity;
+    });
+    registry.install(conn);
+
+    bench_exec(conn.conn_handle(), "CREATE TABLE items(id INTEGER PRIMARY KEY, embedding BLOB)");
+    std::mt19937 rng{1};
+    statement insert{conn, "INSERT INTO items VALUES (?1, ?2)"};
+    bench_exec(conn.conn_handle(), "BEGIN");
+    for (int i = 1; i <= item_rows; ++i) {
+        auto v = random_vector(rng);
+        insert.bind(1, i);
+        insert.bind(2, as_blob(v));
+        insert.step();
+        insert.reset();
+    }
+    bench_exec(conn.conn_handle(), "COMMIT");
+    return conn;
+}
+
+void run_kernel(benchmark::State& state, const detail::vector_kernels& kernels)
+{
+    std::mt19937 rng{2};
+    auto a = random_vector(rng);
+    auto b = random_vector(rng);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels.dot(a.data(), b.data(), dimensions));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(kernels.name);
+}
+
+void run_query(benchmark::State& state, const char* sql)
+{
+    auto conn = make_items();
+    std::mt19937 rng{3};
+    auto query = random_vector(rng);
+    statement stmt{conn, sql};
+    for (auto _ : state) {
+        stmt.bind(1, as_blob(query));
+        while (stmt.step()) {
+            benchmark::DoNotOptimize(stmt.column_int64(0));
+        }
+        stmt.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * item_rows);
+}
+
+} // namespace
+
+static void BM_Dot768_Scalar(benchmark::State& state)
+{
+    run_kernel(state, detail::scalar_vector_kernels());
+}
+BENCHMARK(BM_Dot768_Scalar);
+
+static void BM_Dot768_Dispatched(benchmark::State& state)
+{
+    run_kernel(state, detail::select_vector_kernels());
+}
+BENCHMARK(BM_Dot768_Dispatched);
+
+static void BM_TopK_ScalarUdfOrderBy(benchmark::State& state)
+{
+    run_query(state, "SELECT id FROM items ORDER BY vec_cosine_scalar(embedding, ?1) DESC LIMIT 10");
+}
+BENCHMARK(BM_TopK_ScalarUdfOrderBy);
+
+static void BM_TopK_VecCosineOrderBy(benchmark::State& state)
+{
+    run_query(state, "SELECT id FROM items ORDER BY vec_cosine(embedding, ?1) DESC LIMIT 10");
+}
+BENCHMARK(BM_TopK_VecCosineOrderBy);
+
+static void BM_TopK_VirtualTable(benchmark::State& state)
+{
+    run_query(state, "SELECT id FROM vec_topk('items', 'embedding', ?1, 10)");
+}
+BENCHMARK(BM_TopK_VirtualTable);
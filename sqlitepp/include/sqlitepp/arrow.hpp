@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_ARROW_HPP
+#define SQLITEPP_ARROW_HPP
+
+#include <sqlitepp/arrow_c_data.hpp>
+
+#include <cstdint>
+#include <utility>
+
+namespace sqlitepp
+{
+
+// Rows of a query as an Arrow struct array with one child per result
+// column, together with its schema. Consumers take the structs over by
+// copying them and clearing the release member of the originals, as the
+// Arrow C Data Interface prescribes; whatever is left is released here.
+class arrow_batch
+{
+public:
+    arrow_batch() noexcept = default;
+
+    ~arrow_batch() noexcept
+    {
+        release();
+    }
+
+    arrow_batch(const arrow_batch&) = delete;
+    arrow_batch& operator=(const arrow_batch&) = delete;
+
+    arrow_batch(arrow_batch&& other) noexcept : array_(std::exchange(other.array_, {})), schema_(std::exchange(other.schema_, {}))
+    {
+    }
+
+    arrow_batch& operator=(arrow_batch&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            array_ = std::exchange(other.array_, {});
+            schema_ = std::exchange(other.schema_, {});
+        }
+        return *this;
+    }
+
+    std::int64_t rows() const noexcept
+    {
+        return array_.release != nullptr ? array_.length : 0;
+    }
+
+    ArrowArray* array() noexcept
+    {
+        return &array_;
+    }
+
+    ArrowSchema* schema() noexcept
+    {
+        return &schema_;
+    }
+
+    void release() noexcept
+    {
+        if (array_.release != nullptr) {
+            array_.release(&array_);
+        }
+        if (schema_.release != nullptr) {
+            schema_.release(&schema_);
+        }
+    }
+
+private:
+    ArrowArray array_{};
+    ArrowSchema schema_{};
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_ARROW_HPP
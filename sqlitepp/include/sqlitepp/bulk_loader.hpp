@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_BULK_LOADER_HPP
+#define SQLITEPP_BULK_LOADER_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+#include <sqlitepp/transaction.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+struct bulk_load_options
+{
+    // rows committed per transaction
+    std::size_t transaction_rows = 1000000;
+    // drop the secondary indexes of the table before the load and create them again afterwards
+    bool rebuild_indexes = false;
+};
+
+// Collects rows in memory and inserts them in primary key order, which
+// appends to the table B-tree instead of splitting pages at random. Columns
+// are bound to ?1..?N of the insert statement in tuple order; the first
+// column is the sort key.
+template<typename... Columns>
+class bulk_loader
+{
+public:
+    using row_type = std::tuple<Columns...>;
+
+    static_assert(sizeof...(Columns) > 0, "a row needs at least the key column");
+
+    bulk_loader(connection& conn, std::string table, std::string insert_sql, thread_pool& threads, bulk_load_options options = {})
+        : conn_(conn), table_(std::move(table)), insert_sql_(std::move(insert_sql)), threads_(threads), options_(options)
+    {
+    }
+
+    bulk_loader(const bulk_loader&) = delete;
+    bulk_loader& operator=(const bulk_loader&) = delete;
+
+    void reserve(std::size_t rows)
+    {
+        rows_.reserve(rows);
+    }
+
+    template<typename... Args>
+    void add(Args&&... args)
+    {
+        rows_.emplace_back(std::forward<Args>(args)...);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return rows_.size();
+    }
+
+    // Sorts and inserts the collected rows and returns how many were inserted.
+    // The rows are released afterwards, also on error.
+    std::size_t load(std::error_code& ec) noexcept
+    {
+        ec.clear();
+        std::size_t loaded = 0;
+        try {
+            sort();
+
+            std::vector<std::string> indexes;
+            if (options_.rebuild_indexes) {
+                indexes = drop_indexes(ec);
+            }
+            if (!ec) {
+                loaded = insert(ec);
+            }
+            // the indexes come back even after a failed load, the rows committed so far stay
+            std::error_code create_ec;
+            for (auto& sql : indexes) {
+                execute(sql, create_ec);
+                if (create_ec && !ec) {
+                    ec = create_ec;
+                }
+            }
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        catch (const std::system_error& e) {
+            // the thread pool could not run the sort
+            ec = e.code();
+        }
+        catch (...) {
+            // thrown by moving the column values while sorting
+            ec.assign(SQLITE_ERROR, sqlite3_category());
+        }
+        rows_ = std::vector<row_type>{};
+        return loaded;
+    }
+
+    std::size_t load()
+    {
+        std::error_code ec;
+        auto loaded = load(ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+        return loaded;
+    }
+
+private:
+    connection& conn_;
+    std::string table_;
+    std::string insert_sql_;
+    thread_pool& threads_;
+    bulk_load_options options_;
+    std::vector<row_type> rows_;
+
+    static bool less(const row_type& a, const row_type& b) noexcept
+    {
+        return std::get<0>(a) < std::get<0>(b);
+    }
+
+    // Sorts one chunk per thread, then merges neighbouring chunks pairwise.
+    void sort()
+    {
+        auto chunks = std::min(threads_.size(), std::max<std::size_t>(rows_.size() / min_chunk_rows, 1));
+        std::vector<std::size_t> bounds;
+        for (std::size_t i = 0; i <= chunks; ++i) {
+            bounds.push_back(rows_.size() * i / chunks);
+        }
+
+        auto begin = rows_.begin();
+        std::vector<std::future<void>> done;
+        try {
+            for (std::size_t i = 0; i < chunks; ++i) {
+                done.push_back(threads_.submit([&, i]() { std::sort(begin + bounds[i], begin + bounds[i + 1], less); }));
+            }
+            wait(done);
+
+            for (std::size_t width = 1; width < chunks; width *= 2) {
+                for (std::size_t i = 0; i + width < chunks; i += 2 * width) {
+                    auto last = std::min(i + 2 * width, chunks);
+                    done.push_back(threads_.submit(
+                        [&, i, width, last]() { std::inplace_merge(begin + bounds[i], begin + bounds[i + width], begin + bounds[last], less); }));
+                }
+                wait(done);
+            }
+        }
+        catch (...) {
+            // a failed submit leaves the tasks already queued working on the rows
+            for (auto& d : done) {
+                if (d.valid()) {
+                    d.wait();
+                }
+            }
+            throw;
+        }
+    }
+
+    static void wait(std::vector<std::future<void>>& done)
+    {
+        for (auto& d : done) {
+            d.wait();
+        }
+        for (auto& d : done) {
+            d.get();
+        }
+        done.clear();
+    }
+
+    // Returns the number of committed rows.
+    std::size_t insert(std::error_code& ec) noexcept
+    {
+        statement stmt{conn_, insert_sql_, ec};
+        if (ec) {
+            return 0;
+        }
+        auto transaction_rows = std::max<std::size_t>(options_.transaction_rows, 1);
+        std::size_t committed = 0;
+        for (std::size_t first = 0; first < rows_.size(); first += transaction_rows) {
+            auto last = std::min(first + transaction_rows, rows_.size());
+            transaction tx{conn_, transaction::mode::immediate, ec};
+            for (auto i = first; !ec && i < last; ++i) {
+                bind(stmt, rows_[i], ec, std::index_sequence_for<Columns...>{});
+                if (!ec) {
+                    stmt.step(ec);
+                }
+                if (!ec) {
+                    stmt.reset(ec);
+                }
+            }
+            if (!ec) {
+                tx.commit(ec);
+            }
+            if (ec) {
+                // a failed step leaves the statement to be reset before the rollback
+                std::error_code reset_ec;
+                stmt.reset(reset_ec);
+                return committed;
+            }
+            committed = last;
+        }
+        return committed;
+    }
+
+    template<std::size_t... I>
+    static void bind(statement& stmt, const row_type& row, std::error_code& ec, std::index_sequence<I...>) noexcept
+    {
+        (bind_column(stmt, static_cast<int>(I + 1), std::get<I>(row), ec), ...);
+    }
+
+    template<typename T>
+    static void bind_column(statement& stmt, int index, const T& value, std::error_code& ec) noexcept
+    {
+        if (ec) {
+            return;
+        }
+        // the row outlives the step, so text needs no copy
+        if constexpr (std::is_convertible_v<const T&, std::string_view> && !std::is_same_v<T, std::nullptr_t>) {
+            stmt.bind_static(index, std::string_view{value}, ec);
+        }
+        else {
+            stmt.bind(index, value, ec);
+        }
+    }
+
+    std::vector<std::string> drop_indexes(std::error_code& ec)
+    {
+        std::vector<std::string> created;
+        std::vector<std::string> names;
+        {
+            statement stmt{conn_, "SELECT name, sql FROM sqlite_master WHERE type = 'index' AND tbl_name = ?1 AND sql IS NOT NULL", ec};
+            if (!ec) {
+                stmt.bind(1, table_, ec);
+            }
+            while (!ec && stmt.step(ec)) {
+                names.emplace_back(stmt.column_text(0));
+                created.emplace_back(stmt.column_text(1));
+            }
+        }
+        for (std::size_t i = 0; !ec && i < names.size(); ++i) {
+            std::string sql{"DROP INDEX "};
+            detail::append_identifier(sql, names[i]);
+            execute(sql, ec);
+            if (ec) {
+                // keep the ones still in place
+                created.resize(i);
+            }
+        }
+        return created;
+    }
+
+    void execute(const std::string& sql, std::error_code& ec) noexcept
+    {
+        statement stmt{conn_, sql, ec};
+        if (!ec) {
+            stmt.step(ec);
+        }
+    }
+
+    static constexpr std::size_t min_chunk_rows = 16384;
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_BULK_LOADER_HPP
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_CHANGE_SUBSCRIPTION_HPP
+#define SQLITEPP_CHANGE_SUBSCRIPTION_HPP
+
+#include <sqlitepp/detail/change_bus.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace sqlitepp
+{
+
+class connection;
+
+// Keeps a connection::on_change callback subscribed until destroyed. It may
+// outlive the connection, which ends the subscription when it closes.
+class change_subscription
+{
+public:
+    change_subscription() noexcept = default;
+
+    ~change_subscription() noexcept
+    {
+        unsubscribe();
+    }
+
+    change_subscription(const change_subscription&) = delete;
+    change_subscription& operator=(const change_subscription&) = delete;
+
+    change_subscription(change_subscription&& other) noexcept : bus_(std::move(other.bus_)), id_(std::exchange(other.id_, 0))
+    {
+    }
+
+    change_subscription& operator=(change_subscription&& other) noexcept
+    {
+        if (this != &other) {
+            unsubscribe();
+            bus_ = std::move(other.bus_);
+            id_ = std::exchange(other.id_, 0);
+        }
+        return *this;
+    }
+
+    bool is_subscribed() const noexcept
+    {
+        return id_ != 0 && !bus_.expired();
+    }
+
+    void unsubscribe() noexcept
+    {
+        if (auto bus = bus_.lock()) {
+            bus->unsubscribe(id_);
+        }
+        bus_.reset();
+        id_ = 0;
+    }
+
+private:
+    friend class connection;
+
+    std::weak_ptr<detail::change_bus> bus_;
+    std::uint64_t id_{0};
+
+    change_subscription(std::weak_ptr<detail::change_bus> bus, std::uint64_t id) noexcept : bus_(std::move(bus)), id_(id)
+    {
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_CHANGE_SUBSCRIPTION_HPP
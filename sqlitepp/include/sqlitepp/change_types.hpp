@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_CHANGE_TYPES_HPP
+#define SQLITEPP_CHANGE_TYPES_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sqlitepp
+{
+
+enum class change_kind : int
+{
+    insert = SQLITE_INSERT,
+    update = SQLITE_UPDATE,
+    erase = SQLITE_DELETE
+};
+
+struct row_change
+{
+    change_kind kind;
+    std::int64_t rowid;
+};
+
+// The rows of one table changed by one committed transaction, in the order
+// they were changed. Rows undone by a failed statement or ROLLBACK TO inside
+// the transaction are still listed; treat them as rows to re-read rather
+// than as facts. A COMMIT that fails with SQLITE_BUSY delivers nothing, and
+// the rows follow the transaction to its next COMMIT or its ROLLBACK.
+struct table_changes
+{
+    std::string database;
+    std::string table;
+    std::vector<row_change> rows;
+    // false when rows were lost for want of memory; re-read the whole table
+    bool complete{true};
+};
+
+using change_callback = std::function<void(const table_changes&)>;
+
+enum class change_delivery
+{
+    // once the commit has succeeded, on the thread that commits, before the
+    // statement that committed returns; the callback must not use the
+    // connection and holds up that statement while it runs
+    on_commit,
+    // on a thread of the connection, one batch after the other in commit order
+    worker
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_CHANGE_TYPES_HPP
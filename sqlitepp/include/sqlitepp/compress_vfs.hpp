@@ -0,0 +1,884 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_COMPRESS_VFS_HPP
+#define SQLITEPP_COMPRESS_VFS_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/lz_codec.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp::vfs
+{
+
+struct compress_options
+{
+    const char* name{"compress"};
+    // the VFS underneath, null for the default one
+    const char* base{nullptr};
+    bool make_default{false};
+};
+
+struct compress_stats
+{
+    // the size of the database as SQLite sees it
+    std::uint64_t logical_size{0};
+    // the size of the file
+    std::uint64_t physical_size{0};
+    // the bytes of the current version of each page, records included;
+    // the rest of the file is older versions, which compact reclaims
+    std::uint64_t live_size{0};
+    std::uint64_t pages{0};
+};
+
+namespace detail
+{
+
+using sqlitepp::detail::lz_codec;
+
+// The file control returning the compress_stats of a database.
+constexpr int compress_stats_opcode = 0x53510001;
+
+constexpr std::size_t compress_file_header_size = 32;
+constexpr unsigned char compress_file_magic[16] = {'S', 'Q', 'L', 'i', 't', 'e', 'p', 'p', ' ', 'l', 'z', ' ', 'v', '1', 0, 0};
+constexpr std::size_t compress_record_header_size = 32;
+constexpr std::uint32_t compress_record_magic = 0x43505153;
+constexpr std::uint32_t compress_record_raw = 1;
+constexpr std::uint32_t compress_record_truncate = 2;
+
+inline void put_u32(unsigned char* p, std::uint32_t v) noexcept
+{
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+inline void put_u64(unsigned char* p, std::uint64_t v) noexcept
+{
+    put_u32(p, static_cast<std::uint32_t>(v));
+    put_u32(p + 4, static_cast<std::uint32_t>(v >> 32));
+}
+
+inline std::uint32_t get_u32(const unsigned char* p) noexcept
+{
+    return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 | static_cast<std::uint32_t>(p[2]) << 16 |
+           static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+inline std::uint64_t get_u64(const unsigned char* p) noexcept
+{
+    return get_u32(p) | static_cast<std::uint64_t>(get_u32(p + 4)) << 32;
+}
+
+// A 32-bit checksum taking 8 bytes at a time.
+inline std::uint32_t compress_checksum(const unsigned char* p, std::size_t n) noexcept
+{
+    std::uint64_t h = 0xcbf29ce484222325ull ^ n;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p + i, sizeof(w));
+        h = (h ^ w) * 0x100000001b3ull;
+        h ^= h >> 29;
+    }
+    for (; i < n; ++i) {
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    }
+    return static_cast<std::uint32_t>(h ^ h >> 32);
+}
+
+// The main database file of the compress VFS: a header, then an append-only
+// log of records, each a header and a block of the database, compressed or
+// raw, or a truncation. The page map, brought up to date from the record
+// headers when a lock is taken and before each write, once the file has
+// grown, points at the latest record of each block; rewriting a block
+// appends a new record.
+//
+// Record header: magic, flags, logical offset (64 bits), logical length,
+// stored length, payload checksum, header checksum, little-endian.
+struct compress_file
+{
+    struct block
+    {
+        std::uint64_t position;
+        std::uint32_t length;
+        std::uint32_t stored;
+        std::uint32_t checksum;
+        bool raw;
+    };
+
+    sqlite3_file base;
+    sqlite3_file* real;
+    std::map<std::uint64_t, block>* blocks;
+    std::uint64_t logical_size;
+    // end of the last valid record, where the next one is appended; 0 before the file header is read
+    std::uint64_t end;
+    // the size of the file when the records were last read or appended to
+    std::uint64_t physical_size;
+    std::uint64_t live_size;
+    int lock;
+    lz_codec* codec;
+    std::vector<unsigned char>* buffer;
+    std::vector<unsigned char>* scratch;
+
+    int read_real(void* data, std::size_t n, std::uint64_t offset) noexcept
+    {
+        return real->pMethods->xRead(real, data, static_cast<int>(n), static_cast<sqlite3_int64>(offset));
+    }
+
+    // Reads the records from end onwards, up to the first that is torn or
+    // invalid, where the next write goes.
+    int scan(std::uint64_t physical_size) noexcept
+    {
+        unsigned char header[compress_record_header_size];
+        if (end == 0) {
+            if (physical_size == 0) {
+                return SQLITE_OK;
+            }
+            int rc = read_real(header, compress_file_header_size, 0);
+            if (rc != SQLITE_OK || std::memcmp(header, compress_file_magic, sizeof(compress_file_magic)) != 0) {
+                return SQLITE_NOTADB;
+            }
+            end = compress_file_header_size;
+        }
+        try {
+            // read ahead, the headers of small records share a read
+            std::vector<unsigned char>& window = *scratch;
+            std::uint64_t window_start = 0;
+            std::size_t window_size = 0;
+            while (end + compress_record_header_size <= physical_size) {
+                if (end < window_start || end + compress_record_header_size > window_start + window_size) {
+                    window_size = static_cast<std::size_t>(std::min<std::uint64_t>(physical_size - end, 256 * 1024));
+                    window.resize(window_size);
+                    window_start = end;
+                    if (read_real(window.data(), window_size, window_start) != SQLITE_OK) {
+                        break;
+                    }
+                }
+                auto h = window.data() + (end - window_start);
+                if (get_u32(h) != compress_record_magic || get_u32(h + 28) != compress_checksum(h, 28)) {
+                    break;
+                }
+                auto flags = get_u32(h + 4);
+                auto offset = get_u64(h + 8);
+                auto length = get_u32(h + 16);
+                auto stored = get_u32(h + 20);
+                if (end + compress_record_header_size + stored > physical_size) {
+                    break;
+                }
+                if ((flags & compress_record_truncate) != 0) {
+                    truncate_map(offset);
+                }
+                else {
+                    replace(offset, block{end, length, stored, get_u32(h + 24), (flags & compress_record_raw) != 0});
+                }
+                end += compress_record_header_size + stored;
+            }
+            return SQLITE_OK;
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+        }
+    }
+
+    // Catches up with the records other connections appended, or starts
+    // over when the file has shrunk. Called when a lock is taken and before
+    // every write: in WAL mode connections checkpoint in turns under the
+    // checkpoint lock alone, each appending after the records of the others.
+    int refresh() noexcept
+    {
+        sqlite3_int64 size = 0;
+        int rc = real->pMethods->xFileSize(real, &size);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        auto current = static_cast<std::uint64_t>(size);
+        if (current == physical_size && end != 0) {
+            return SQLITE_OK;
+        }
+        if (current < end) {
+            blocks->clear();
+            logical_size = 0;
+            live_size = 0;
+            end = 0;
+        }
+        rc = scan(current);
+        if (rc == SQLITE_OK) {
+            physical_size = current;
+        }
+        return rc;
+    }
+
+    void replace(std::uint64_t offset, const block& b)
+    {
+        erase_overlapping(offset, b.length);
+        blocks->emplace(offset, b);
+        live_size += compress_record_header_size + b.stored;
+        logical_size = std::max(logical_size, offset + b.length);
+    }
+
+    void erase_overlapping(std::uint64_t offset, std::uint64_t length) noexcept
+    {
+        auto it = blocks->lower_bound(offset);
+        if (it != blocks->begin()) {
+            auto previous = std::prev(it);
+            if (previous->first + previous->second.length > offset) {
+                it = previous;
+            }
+        }
+        while (it != blocks->end() && it->first < offset + length) {
+            live_size -= compress_record_header_size + it->second.stored;
+            it = blocks->erase(it);
+        }
+    }
+
+    void truncate_map(std::uint64_t size) noexcept
+    {
+        for (auto it = blocks->lower_bound(size); it != blocks->end();) {
+            live_size -= compress_record_header_size + it->second.stored;
+            it = blocks->erase(it);
+        }
+        logical_size = size;
+    }
+
+    // Decompresses a block into out.
+    int load_block(const block& b, unsigned char* out) noexcept
+    {
+        try {
+            auto& stored = *buffer;
+            stored.resize(b.stored);
+            int rc = read_real(stored.data(), b.stored, b.position + compress_record_header_size);
+            if (rc != SQLITE_OK) {
+                return rc == SQLITE_IOERR_SHORT_READ ? SQLITE_CORRUPT : rc;
+            }
+            if (compress_checksum(stored.data(), b.stored) != b.checksum) {
+                return SQLITE_CORRUPT;
+            }
+            if (b.raw) {
+                std::memcpy(out, stored.data(), b.length);
+            }
+            else if (!lz_codec::decompress(stored.data(), b.stored, out, b.length)) {
+                return SQLITE_CORRUPT;
+            }
+            return SQLITE_OK;
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_IOERR_NOMEM;
+        }
+    }
+
+    // Reads [offset, offset + n) of the database; holes read as zeros.
+    int read_range(unsigned char* out, std::size_t n, std::uint64_t offset) noexcept
+    {
+        auto stop = offset + n;
+        auto available = std::min(stop, std::max(logical_size, offset));
+        auto pos = offset;
+        while (pos < available) {
+            auto next = blocks->upper_bound(pos);
+            if (next != blocks->begin()) {
+                auto& [start, b] = *std::prev(next);
+                if (start + b.length > pos) {
+                    auto segment_end = std::min<std::uint64_t>(start + b.length, available);
+                    if (start == pos && segment_end == start + b.length) {
+                        int rc = load_block(b, out + (pos - offset));
+                        if (rc != SQLITE_OK) {
+                            return rc;
+                        }
+                    }
+                    else {
+                        try {
+                            std::vector<unsigned char> whole(b.length);
+                            int rc = load_block(b, whole.data());
+                            if (rc != SQLITE_OK) {
+                                return rc;
+                            }
+                            std::memcpy(out + (pos - offset), whole.data() + (pos - start), static_cast<std::size_t>(segment_end - pos));
+                        }
+                        catch (const std::bad_alloc&) {
+                            return SQLITE_IOERR_NOMEM;
+                        }
+                    }
+                    pos = segment_end;
+                    continue;
+                }
+            }
+            auto hole_end = next != blocks->end() ? std::min(next->first, available) : available;
+            std::memset(out + (pos - offset), 0, static_cast<std::size_t>(hole_end - pos));
+            pos = hole_end;
+        }
+        if (available < stop) {
+            std::memset(out + (available - offset), 0, static_cast<std::size_t>(stop - available));
+            return SQLITE_IOERR_SHORT_READ;
+        }
+        return SQLITE_OK;
+    }
+
+    int append(std::uint32_t flags, std::uint64_t offset, const unsigned char* data, std::uint32_t length) noexcept
+    {
+        try {
+            int rc = SQLITE_OK;
+            if (end == 0) {
+                unsigned char header[compress_file_header_size]{};
+                std::memcpy(header, compress_file_magic, sizeof(compress_file_magic));
+                rc = real->pMethods->xWrite(real, header, sizeof(header), 0);
+                if (rc != SQLITE_OK) {
+                    return rc;
+                }
+                end = compress_file_header_size;
+            }
+            auto& record = *buffer;
+            record.resize(compress_record_header_size + length);
+            std::uint32_t stored = 0;
+            if (length != 0) {
+                stored = static_cast<std::uint32_t>(codec->compress(data, length, record.data() + compress_record_header_size, length - 1));
+                if (stored == 0) {
+                    flags |= compress_record_raw;
+                    std::memcpy(record.data() + compress_record_header_size, data, length);
+                    stored = length;
+                }
+            }
+            auto h = record.data();
+            auto checksum = compress_checksum(h + compress_record_header_size, stored);
+            put_u32(h, compress_record_magic);
+            put_u32(h + 4, flags);
+            put_u64(h + 8, offset);
+            put_u32(h + 16, length);
+            put_u32(h + 20, stored);
+            put_u32(h + 24, checksum);
+            put_u32(h + 28, compress_checksum(h, 28));
+            rc = real->pMethods->xWrite(real, h, static_cast<int>(compress_record_header_size + stored), static_cast<sqlite3_int64>(end));
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            if ((flags & compress_record_truncate) != 0) {
+                truncate_map(offset);
+            }
+            else {
+                replace(offset, block{end, length, stored, checksum, (flags & compress_record_raw) != 0});
+            }
+            end += compress_record_header_size + stored;
+            physical_size = std::max(physical_size, end);
+            return SQLITE_OK;
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_IOERR_NOMEM;
+        }
+    }
+
+    // Writes a block. SQLite writes whole pages, which replace their
+    // previous record; a write overlapping blocks otherwise, as when the
+    // page size changes, merges them into one.
+    int write(const unsigned char* data, std::size_t n, std::uint64_t offset) noexcept
+    {
+        auto lo = offset;
+        auto hi = offset + n;
+        auto it = blocks->lower_bound(offset);
+        if (it != blocks->begin() && std::prev(it)->first + std::prev(it)->second.length > offset) {
+            it = std::prev(it);
+        }
+        bool exact = it == blocks->end() || it->first >= hi || (it->first == offset && it->second.length == n);
+        if (exact && it != blocks->end() && it->first == offset) {
+            auto next = std::next(it);
+            exact = next == blocks->end() || next->first >= hi;
+        }
+        if (exact) {
+            return n <= lz_codec::max_input ? append(0, offset, data, static_cast<std::uint32_t>(n)) : write_split(data, n, offset);
+        }
+        for (auto last = it; last != blocks->end() && last->first < hi; ++last) {
+            lo = std::min(lo, last->first);
+            hi = std::max<std::uint64_t>(hi, last->first + last->second.length);
+        }
+        try {
+            std::vector<unsigned char> merged(static_cast<std::size_t>(hi - lo));
+            int rc = read_range(merged.data(), merged.size(), lo);
+            if (rc != SQLITE_OK && rc != SQLITE_IOERR_SHORT_READ) {
+                return rc;
+            }
+            std::memcpy(merged.data() + (offset - lo), data, n);
+            erase_overlapping(lo, hi - lo);
+            return write_split(merged.data(), merged.size(), lo);
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_IOERR_NOMEM;
+        }
+    }
+
+    // Writes a range larger than a block in blocks of the largest size.
+    int write_split(const unsigned char* data, std::size_t n, std::uint64_t offset) noexcept
+    {
+        for (std::size_t done = 0; done < n;) {
+            auto length = std::min(n - done, lz_codec::max_input);
+            int rc = append(0, offset + done, data + done, static_cast<std::uint32_t>(length));
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            done += length;
+        }
+        return SQLITE_OK;
+    }
+
+    static compress_file& of(sqlite3_file* file) noexcept
+    {
+        return *reinterpret_cast<compress_file*>(file);
+    }
+
+    static int x_close(sqlite3_file* file) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.real->pMethods->xClose(f.real);
+        delete f.blocks;
+        delete f.codec;
+        delete f.buffer;
+        delete f.scratch;
+        return rc;
+    }
+
+    static int x_read(sqlite3_file* file, void* data, int n, sqlite3_int64 offset) noexcept
+    {
+        return of(file).read_range(static_cast<unsigned char*>(data), static_cast<std::size_t>(n), static_cast<std::uint64_t>(offset));
+    }
+
+    static int x_write(sqlite3_file* file, const void* data, int n, sqlite3_int64 offset) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.refresh();
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        return f.write(static_cast<const unsigned char*>(data), static_cast<std::size_t>(n), static_cast<std::uint64_t>(offset));
+    }
+
+    static int x_truncate(sqlite3_file* file, sqlite3_int64 size) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.refresh();
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        if (static_cast<std::uint64_t>(size) == f.logical_size) {
+            return SQLITE_OK;
+        }
+        return f.append(compress_record_truncate, static_cast<std::uint64_t>(size), nullptr, 0);
+    }
+
+    static int x_sync(sqlite3_file* file, int flags) noexcept
+    {
+        auto real = of(file).real;
+        return real->pMethods->xSync(real, flags);
+    }
+
+    static int x_file_size(sqlite3_file* file, sqlite3_int64* size) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.refresh();
+        *size = static_cast<sqlite3_int64>(f.logical_size);
+        return rc;
+    }
+
+    static int x_lock(sqlite3_file* file, int level) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.real->pMethods->xLock(f.real, level);
+        if (rc == SQLITE_OK) {
+            auto previous = std::exchange(f.lock, level);
+            if (previous == SQLITE_LOCK_NONE) {
+                rc = f.refresh();
+            }
+        }
+        return rc;
+    }
+
+    static int x_unlock(sqlite3_file* file, int level) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.real->pMethods->xUnlock(f.real, level);
+        if (rc == SQLITE_OK) {
+            f.lock = level;
+        }
+        return rc;
+    }
+
+    static int x_check_reserved_lock(sqlite3_file* file, int* reserved) noexcept
+    {
+        auto real = of(file).real;
+        return real->pMethods->xCheckReservedLock(real, reserved);
+    }
+
+    static int x_file_control(sqlite3_file* file, int op, void* arg) noexcept
+    {
+        auto& f = of(file);
+        switch (op) {
+        case compress_stats_opcode: {
+            // the records are read with the first lock, which may not have been taken yet
+            int rc = f.lock == SQLITE_LOCK_NONE ? f.refresh() : SQLITE_OK;
+            sqlite3_int64 size = 0;
+            if (rc == SQLITE_OK) {
+                rc = f.real->pMethods->xFileSize(f.real, &size);
+            }
+            *static_cast<compress_stats*>(arg) = compress_stats{f.logical_size, static_cast<std::uint64_t>(size), f.live_size, f.blocks->size()};
+            return rc;
+        }
+        case SQLITE_FCNTL_SIZE_HINT:
+        case SQLITE_FCNTL_CHUNK_SIZE:
+            // about the logical size, which the file does not follow
+            return SQLITE_OK;
+        default:
+            return f.real->pMethods->xFileControl(f.real, op, arg);
+        }
+    }
+
+    static int x_sector_size(sqlite3_file* file) noexcept
+    {
+        auto real = of(file).real;
+        return real->pMethods->xSectorSize(real);
+    }
+
+    static int x_device_characteristics(sqlite3_file* file) noexcept
+    {
+        auto real = of(file).real;
+        // records are appended, so no write of a page is atomic or in place
+        constexpr int atomic = SQLITE_IOCAP_ATOMIC | SQLITE_IOCAP_ATOMIC512 | SQLITE_IOCAP_ATOMIC1K | SQLITE_IOCAP_ATOMIC2K | SQLITE_IOCAP_ATOMIC4K |
+                               SQLITE_IOCAP_ATOMIC8K | SQLITE_IOCAP_ATOMIC16K | SQLITE_IOCAP_ATOMIC32K | SQLITE_IOCAP_ATOMIC64K |
+                               SQLITE_IOCAP_BATCH_ATOMIC;
+        return real->pMethods->xDeviceCharacteristics(real) & ~atomic;
+    }
+
+    static int x_shm_map(sqlite3_file* file, int page, int size, int extend, void volatile** memory) noexcept
+    {
+        auto real = of(file).real;
+        return real->pMethods->xShmMap(real, page, size, extend, memory);
+    }
+
+    // A WAL read transaction starts with a shared lock on a read mark, while
+    // the file lock stays shared throughout; the file may have changed.
+    static int x_shm_lock(sqlite3_file* file, int offset, int n, int flags) noexcept
+    {
+        auto& f = of(file);
+        int rc = f.real->pMethods->xShmLock(f.real, offset, n, flags);
+        if (rc == SQLITE_OK && (flags & SQLITE_SHM_LOCK) != 0 && (flags & SQLITE_SHM_SHARED) != 0) {
+            rc = f.refresh();
+        }
+        return rc;
+    }
+
+    static void x_shm_barrier(sqlite3_file* file) noexcept
+    {
+        auto real = of(file).real;
+        real->pMethods->xShmBarrier(real);
+    }
+
+    static int x_shm_unmap(sqlite3_file* file, int delete_flag) noexcept
+    {
+        auto real = of(file).real;
+        return real->pMethods->xShmUnmap(real, delete_flag);
+    }
+
+    // Version 2: no xFetch, so SQLite does not memory-map the file.
+    static const sqlite3_io_methods* methods() noexcept
+    {
+        static const sqlite3_io_methods io{2,
+                                           &x_close,
+                                           &x_read,
+                                           &x_write,
+                                           &x_truncate,
+                                           &x_sync,
+                                           &x_file_size,
+                                           &x_lock,
+                                           &x_unlock,
+                                           &x_check_reserved_lock,
+                                           &x_file_control,
+                                           &x_sector_size,
+                                           &x_device_characteristics,
+                                           &x_shm_map,
+                                           &x_shm_lock,
+                                           &x_shm_barrier,
+                                           &x_shm_unmap,
+                                           nullptr,
+                                           nullptr};
+        return &io;
+    }
+};
+
+inline sqlite3_vfs* base_of(sqlite3_vfs* vfs) noexcept
+{
+    return static_cast<sqlite3_vfs*>(vfs->pAppData);
+}
+
+// The base VFS opens the real file right after the compress_file.
+constexpr std::size_t compress_real_offset = (sizeof(compress_file) + 15) / 16 * 16;
+
+inline int compress_open(sqlite3_vfs* vfs, const char* name, sqlite3_file* file, int flags, int* out_flags) noexcept
+{
+    auto base = base_of(vfs);
+    if ((flags & SQLITE_OPEN_MAIN_DB) == 0) {
+        // journals, WAL and temporary files are those of the base VFS
+        return base->xOpen(base, name, file, flags, out_flags);
+    }
+    auto& f = compress_file::of(file);
+    file->pMethods = nullptr;
+    f.real = reinterpret_cast<sqlite3_file*>(reinterpret_cast<unsigned char*>(file) + compress_real_offset);
+    int rc = base->xOpen(base, name, f.real, flags, out_flags);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    f.blocks = new (std::nothrow) std::map<std::uint64_t, compress_file::block>;
+    f.codec = new (std::nothrow) lz_codec;
+    f.buffer = new (std::nothrow) std::vector<unsigned char>;
+    f.scratch = new (std::nothrow) std::vector<unsigned char>;
+    f.logical_size = 0;
+    f.end = 0;
+    f.physical_size = 0;
+    f.live_size = 0;
+    f.lock = SQLITE_LOCK_NONE;
+    if (f.blocks == nullptr || f.codec == nullptr || f.buffer == nullptr || f.scratch == nullptr) {
+        rc = SQLITE_NOMEM;
+    }
+    else {
+        // only the format is checked here, the records are read under the first lock
+        sqlite3_int64 size = 0;
+        rc = f.real->pMethods->xFileSize(f.real, &size);
+        if (rc == SQLITE_OK && size != 0) {
+            unsigned char header[compress_file_header_size];
+            rc = f.real->pMethods->xRead(f.real, header, sizeof(header), 0);
+            if (rc != SQLITE_OK || std::memcmp(header, compress_file_magic, sizeof(compress_file_magic)) != 0) {
+                rc = SQLITE_NOTADB;
+            }
+        }
+    }
+    if (rc != SQLITE_OK) {
+        compress_file::x_close(file);
+        return rc;
+    }
+    file->pMethods = compress_file::methods();
+    return SQLITE_OK;
+}
+
+inline int compress_delete(sqlite3_vfs* vfs, const char* name, int sync_dir) noexcept
+{
+    return base_of(vfs)->xDelete(base_of(vfs), name, sync_dir);
+}
+
+inline int compress_access(sqlite3_vfs* vfs, const char* name, int flags, int* result) noexcept
+{
+    return base_of(vfs)->xAccess(base_of(vfs), name, flags, result);
+}
+
+inline int compress_full_pathname(sqlite3_vfs* vfs, const char* name, int n, char* out) noexcept
+{
+    return base_of(vfs)->xFullPathname(base_of(vfs), name, n, out);
+}
+
+inline void* compress_dl_open(sqlite3_vfs* vfs, const char* name) noexcept
+{
+    return base_of(vfs)->xDlOpen(base_of(vfs), name);
+}
+
+inline void compress_dl_error(sqlite3_vfs* vfs, int n, char* message) noexcept
+{
+    base_of(vfs)->xDlError(base_of(vfs), n, message);
+}
+
+inline void (*compress_dl_sym(sqlite3_vfs* vfs, void* handle, const char* symbol) noexcept)(void)
+{
+    return base_of(vfs)->xDlSym(base_of(vfs), handle, symbol);
+}
+
+inline void compress_dl_close(sqlite3_vfs* vfs, void* handle) noexcept
+{
+    base_of(vfs)->xDlClose(base_of(vfs), handle);
+}
+
+inline int compress_randomness(sqlite3_vfs* vfs, int n, char* out) noexcept
+{
+    return base_of(vfs)->xRandomness(base_of(vfs), n, out);
+}
+
+inline int compress_sleep(sqlite3_vfs* vfs, int microseconds) noexcept
+{
+    return base_of(vfs)->xSleep(base_of(vfs), microseconds);
+}
+
+inline int compress_current_time(sqlite3_vfs* vfs, double* now) noexcept
+{
+    return base_of(vfs)->xCurrentTime(base_of(vfs), now);
+}
+
+inline int compress_get_last_error(sqlite3_vfs* vfs, int n, char* message) noexcept
+{
+    return base_of(vfs)->xGetLastError != nullptr ? base_of(vfs)->xGetLastError(base_of(vfs), n, message) : 0;
+}
+
+inline int compress_current_time_int64(sqlite3_vfs* vfs, sqlite3_int64* now) noexcept
+{
+    return base_of(vfs)->xCurrentTimeInt64(base_of(vfs), now);
+}
+
+// The registered VFS, which must outlive every connection using them.
+struct compress_registry
+{
+    std::mutex mutex;
+    std::list<std::pair<std::string, sqlite3_vfs>> vfs;
+
+    static compress_registry& instance()
+    {
+        static compress_registry registry;
+        return registry;
+    }
+};
+
+} // namespace detail
+
+// Registers a VFS that stores the main database files it opens compressed,
+// in blocks of one page, over the base VFS, for connections opened with its
+// name as vfsname. Journals, WAL and temporary files pass through
+// unchanged. Rewritten pages are appended to the file, leaving their older
+// versions behind until compact; each connection keeps a map of the pages
+// of the file, about 80 bytes per page. Opening a database that is not in
+// this format fails with SQLITE_NOTADB. Registering a name again is a no-op.
+inline void register_compress(const compress_options& options, std::error_code& ec) noexcept
+{
+    ec.clear();
+    auto base = sqlite3_vfs_find(options.base);
+    if (base == nullptr || options.name == nullptr) {
+        ec = sqlitepp_errc::invalid_argument;
+        return;
+    }
+    auto& registry = detail::compress_registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    for (auto& [name, vfs] : registry.vfs) {
+        if (name == options.name) {
+            return;
+        }
+    }
+    try {
+        auto& [name, vfs] = registry.vfs.emplace_back(options.name, sqlite3_vfs{});
+        vfs.iVersion = std::min(base->iVersion, 2);
+        vfs.szOsFile = static_cast<int>(detail::compress_real_offset) + base->szOsFile;
+        vfs.mxPathname = base->mxPathname;
+        vfs.zName = name.c_str();
+        vfs.pAppData = base;
+        vfs.xOpen = &detail::compress_open;
+        vfs.xDelete = &detail::compress_delete;
+        vfs.xAccess = &detail::compress_access;
+        vfs.xFullPathname = &detail::compress_full_pathname;
+        vfs.xDlOpen = &detail::compress_dl_open;
+        vfs.xDlError = &detail::compress_dl_error;
+        vfs.xDlSym = &detail::compress_dl_sym;
+        vfs.xDlClose = &detail::compress_dl_close;
+        vfs.xRandomness = &detail::compress_randomness;
+        vfs.xSleep = &detail::compress_sleep;
+        vfs.xCurrentTime = &detail::compress_current_time;
+        vfs.xGetLastError = &detail::compress_get_last_error;
+        vfs.xCurrentTimeInt64 = &detail::compress_current_time_int64;
+        int rc = sqlite3_vfs_register(&vfs, options.make_default);
+        if (rc != SQLITE_OK) {
+            registry.vfs.pop_back();
+            ec.assign(rc, sqlite3_category());
+        }
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+}
+
+inline void register_compress(const compress_options& options = {})
+{
+    std::error_code ec;
+    register_compress(options, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+}
+
+// The sizes of a database of the connection opened through the compress
+// VFS; invalid_argument for another VFS.
+inline compress_stats stats(connection& conn, std::error_code& ec, const char* schema = "main") noexcept
+{
+    ec.clear();
+    compress_stats result;
+    if (!conn.is_open()) {
+        ec = sqlitepp_errc::invalid_handle;
+        return result;
+    }
+    int rc = sqlite3_file_control(conn.conn_handle(), schema, detail::compress_stats_opcode, &result);
+    if (rc == SQLITE_NOTFOUND) {
+        ec = sqlitepp_errc::invalid_argument;
+    }
+    else if (rc != SQLITE_OK) {
+        ec.assign(rc, sqlite3_category());
+    }
+    return result;
+}
+
+inline compress_stats stats(connection& conn, const char* schema = "main")
+{
+    std::error_code ec;
+    auto result = stats(conn, ec, schema);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+    return result;
+}
+
+// Rewrites a database of the compress VFS vfsname with only the current
+// version of its pages, through VACUUM INTO a file beside it that then
+// replaces it. No connection may have the database open.
+inline void compact(const std::string& filename, std::error_code& ec, const char* vfsname = "compress") noexcept
+{
+    try {
+        auto target = filename + "-compact";
+        std::remove(target.c_str());
+        {
+            connection conn;
+            if (!conn.open(filename, connection::openmode::rw, vfsname, ec)) {
+                return;
+            }
+            std::string sql{"VACUUM INTO "};
+            sqlitepp::detail::append_literal(sql, target);
+            int rc = sqlite3_exec(conn.conn_handle(), sql.c_str(), nullptr, nullptr, nullptr);
+            if (rc != SQLITE_OK) {
+                ec.assign(rc, sqlite3_category());
+                std::remove(target.c_str());
+                return;
+            }
+        }
+#if defined(_WIN32)
+        std::remove(filename.c_str());
+#endif
+        if (std::rename(target.c_str(), filename.c_str()) != 0) {
+            ec.assign(SQLITE_IOERR, sqlite3_category());
+        }
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+}
+
+inline void compact(const std::string& filename, const char* vfsname = "compress")
+{
+    std::error_code ec;
+    compact(filename, ec, vfsname);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+}
+
+} // namespace sqlitepp::vfs
+
+#endif // SQLITEPP_COMPRESS_VFS_HPP
@@ -3,10 +3,26 @@
 #ifndef SQLITEPP_CONNECTION_HPP
 #define SQLITEPP_CONNECTION_HPP
 
+#include <sqlitepp/change_subscription.hpp>
+#include <sqlitepp/change_types.hpp>
 #include <sqlitepp/detail/connection_impl.hpp>
+#include <sqlitepp/detail/script_impl.hpp>
 #include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/status_impl.hpp>
+#include <sqlitepp/fixed_string.hpp>
+#include <sqlitepp/script.hpp>
+#include <sqlitepp/snapshot.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/status.hpp>
 #include <sqlitepp/types.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <system_error>
 #include <type_traits>
 #include <utility>
@@ -14,6 +30,17 @@
 namespace sqlitepp
 {
 
+class transaction;
+class savepoint;
+class query_cache;
+class optimize_scheduler;
+class statement;
+
+#if defined(SQLITEPP_HAS_FIXED_STRING)
+template<fixed_string Sql>
+class static_statement;
+#endif
+
 class connection
 {
 public:
@@ -48,7 +75,7 @@ public:
 
     connection(connection&& other) noexcept
     {
-        std::swap(impl_, other.impl_);
+        impl_.swap(other.impl_);
     }
 
     connection& operator=(connection&& other)
@@ -57,7 +84,7 @@ public:
             std::error_code ec;
             impl_.close(ec);
             throw_on_error(ec);
-            std::swap(impl_, other.impl_);
+            impl_.swap(other.impl_);
         }
         return *this;
     }
@@ -99,7 +126,162 @@ public:
         return impl_.conn_handle();
     }
 
+    connection_status status(status_mode mode = status_mode::current) noexcept
+    {
+        return detail::read_connection_status(impl_.conn_handle(), mode);
+    }
+
+    // Runs the statements of sql in order, discarding the rows they return,
+    // and stops at the first error, where the result tells which statement
+    // failed and at which byte. sql is read in place, not copied; without
+    // timings nothing is allocated besides what SQLite needs to prepare.
+    script_result execute_script(std::string_view sql, const script_options& options, std::error_code& ec) noexcept
+    {
+        script_result result;
+        detail::run_script(impl_.conn_handle(), impl_.shared_deadline_guard().get(), sql, options, result, ec);
+        return result;
+    }
+
+    script_result execute_script(std::string_view sql, const script_options& options = {})
+    {
+        std::error_code ec;
+        auto result = execute_script(sql, options, ec);
+        if (ec) {
+            throw script_error(ec, result.error_statement, result.error_offset);
+        }
+        return result;
+    }
+
+    // Calls callback with the rows of table, in any attached schema, changed by
+    // each committed transaction; changes of rolled back transactions are
+    // dropped. SQLite reports no rows of WITHOUT ROWID tables. Takes the
+    // commit and rollback hooks of the connection and shares its trace callback.
+    change_subscription on_change(std::string_view table, change_callback callback, change_delivery delivery, std::error_code& ec) noexcept
+    {
+        auto bus = impl_.change_notifications(ec);
+        if (ec) {
+            return {};
+        }
+        auto id = bus->subscribe(table, std::move(callback), delivery, ec);
+        if (ec) {
+            return {};
+        }
+        return change_subscription{bus, id};
+    }
+
+    change_subscription on_change(std::string_view table, change_callback callback, change_delivery delivery = change_delivery::on_commit)
+    {
+        std::error_code ec;
+        auto subscription = on_change(table, std::move(callback), delivery, ec);
+        throw_on_error(ec);
+        return subscription;
+    }
+
+    // Whether close runs PRAGMA optimize first, bounded by analysis_limit
+    // rows per index, as SQLite recommends for short-lived connections.
+    void set_optimize_on_close(bool enabled, int analysis_limit = 400) noexcept
+    {
+        impl_.set_optimize_on_close(enabled ? std::max(analysis_limit, 0) : -1);
+    }
+
+    // Interrupts statements still running at deadline, and fails the ones
+    // stepped after it, with sqlitepp_errc::deadline_exceeded. Takes the
+    // progress handler of the connection. See deadline_scope for one call.
+    void set_deadline(std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        impl_.set_deadline(deadline);
+    }
+
+    void clear_deadline() noexcept
+    {
+        impl_.clear_deadline();
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> deadline() const noexcept
+    {
+        return impl_.deadline();
+    }
+
+#if defined(SQLITEPP_ENABLE_SNAPSHOT)
+    // Records the state of schema the open read transaction of the connection
+    // sees. The database must be in WAL mode.
+    snapshot snapshot_get(std::string_view schema, std::error_code& ec) noexcept
+    {
+        if (!is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return {};
+        }
+        try {
+            std::string name{schema};
+            sqlite3_snapshot* handle = nullptr;
+            int rc = sqlite3_snapshot_get(impl_.conn_handle(), name.c_str(), &handle);
+            if (rc != SQLITE_OK) {
+                ec.assign(rc, sqlite3_category());
+                return {};
+            }
+            ec.clear();
+            return snapshot{handle, std::move(name)};
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        return {};
+    }
+
+    snapshot snapshot_get(std::string_view schema = "main")
+    {
+        std::error_code ec;
+        auto s = snapshot_get(schema, ec);
+        throw_on_error(ec);
+        return s;
+    }
+
+    // Starts the read transaction of the connection, begun and not yet read
+    // from, at s instead of the latest state of its schema.
+    void snapshot_open(const snapshot& s, std::error_code& ec) noexcept
+    {
+        if (!is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        if (!s) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        int rc = sqlite3_snapshot_open(impl_.conn_handle(), s.schema().c_str(), s.handle());
+        if (rc != SQLITE_OK) {
+            ec.assign(rc, sqlite3_category());
+        }
+        else {
+            ec.clear();
+        }
+    }
+
+    void snapshot_open(const snapshot& s)
+    {
+        std::error_code ec;
+        snapshot_open(s, ec);
+        throw_on_error(ec);
+    }
+#endif
+
+#if defined(SQLITEPP_HAS_FIXED_STRING)
+    // Prepares SQL given as a template argument, see static_statement.hpp.
+    template<fixed_string Sql>
+    static_statement<Sql> prepare();
+
+    template<fixed_string Sql>
+    static_statement<Sql> prepare(std::error_code& ec) noexcept;
+#endif
+
 private:
+    friend class transaction;
+    friend class savepoint;
+    friend class query_cache;
+    friend class optimize_scheduler;
+    friend class profiler;
+    friend class statement;
+
     detail::connection_impl impl_;
 
     static void throw_on_error(const std::error_code& ec)
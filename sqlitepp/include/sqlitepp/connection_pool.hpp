@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_CONNECTION_POOL_HPP
+#define SQLITEPP_CONNECTION_POOL_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/converter.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/prepared_statements.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// Fixed set of connections opened with the same arguments, handed out one
+// thread at a time through leases. Each connection keeps the statements
+// prepared on it for the holders of its leases, see warmup.
+class connection_pool
+{
+public:
+    class lease
+    {
+    public:
+        lease() noexcept = default;
+
+        ~lease() noexcept
+        {
+            release();
+        }
+
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+
+        lease(lease&& other) noexcept : pool_(std::exchange(other.pool_, nullptr)), index_(other.index_)
+        {
+        }
+
+        lease& operator=(lease&& other) noexcept
+        {
+            if (this != &other) {
+                release();
+                pool_ = std::exchange(other.pool_, nullptr);
+                index_ = other.index_;
+            }
+            return *this;
+        }
+
+        connection& operator*() const noexcept
+        {
+            return pool_->at(index_);
+        }
+
+        connection* operator->() const noexcept
+        {
+            return &pool_->at(index_);
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return pool_ != nullptr;
+        }
+
+        std::size_t index() const noexcept
+        {
+            return index_;
+        }
+
+        // The statements kept with the connection; they stay with it when
+        // the lease ends and are finalized before it closes.
+        prepared_statements& prepared() const noexcept
+        {
+            return pool_->prepared_[index_];
+        }
+
+        void release() noexcept
+        {
+            if (pool_ != nullptr) {
+                pool_->give_back(index_);
+                pool_ = nullptr;
+            }
+        }
+
+    private:
+        friend class connection_pool;
+
+        connection_pool* pool_{nullptr};
+        std::size_t index_{0};
+
+        lease(connection_pool* pool, std::size_t index) noexcept : pool_(pool), index_(index)
+        {
+        }
+    };
+
+    template<typename... Args, std::enable_if_t<std::disjunction_v<std::is_same<Args, std::error_code&>...>, bool> = true>
+    explicit connection_pool(std::size_t size, Args&&... args) noexcept
+    {
+        open(size, args...);
+    }
+
+    template<typename... Args, std::enable_if_t<std::negation_v<std::disjunction<std::is_same<Args, std::error_code&>...>>, bool> = true>
+    explicit connection_pool(std::size_t size, Args&&... args)
+    {
+        std::error_code ec;
+        open(size, args..., ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    connection_pool(const connection_pool&) = delete;
+    connection_pool& operator=(const connection_pool&) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return connections_.size();
+    }
+
+    // Blocks until a connection is available.
+    lease acquire()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        released_.wait(lock, [this]() { return available_ != 0; });
+        return lease{this, take()};
+    }
+
+    // Blocks until n connections are available and takes them together, so
+    // that callers needing several cannot each hold some while waiting for
+    // the rest. Fails with invalid_argument when n exceeds the size of the
+    // pool.
+    std::vector<lease> acquire(std::size_t n)
+    {
+        std::error_code ec;
+        auto leases = acquire(n, ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+        return leases;
+    }
+
+    std::vector<lease> acquire(std::size_t n, std::error_code& ec)
+    {
+        std::vector<lease> leases;
+        if (n > connections_.size()) {
+            ec = sqlitepp_errc::invalid_argument;
+            return leases;
+        }
+        leases.reserve(n);
+        std::unique_lock<std::mutex> lock{mutex_};
+        released_.wait(lock, [this, n]() { return available_ >= n; });
+        for (std::size_t i = 0; i < n; ++i) {
+            leases.push_back(lease{this, take()});
+        }
+        ec.clear();
+        return leases;
+    }
+
+    std::optional<lease> try_acquire()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (available_ == 0) {
+            return std::nullopt;
+        }
+        return lease{this, take()};
+    }
+
+    // The arguments the connections were opened with, for opening another
+    // one to the same database; vfsname is null for the default VFS.
+    const std::string& filename() const noexcept
+    {
+        return filename_;
+    }
+
+    int flags() const noexcept
+    {
+        return flags_;
+    }
+
+    const char* vfsname() const noexcept
+    {
+        return vfsname_ ? vfsname_->c_str() : nullptr;
+    }
+
+    // Direct access that bypasses leasing, for setup while no lease is out.
+    connection& at(std::size_t index) const noexcept
+    {
+        return *connections_[index];
+    }
+
+    // Frees the memory the connections no one leases can spare, such as
+    // unused cache pages. Returns how many connections were idle.
+    std::size_t release_idle_memory() noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        std::size_t idle = 0;
+        for (std::size_t i = 0; i < connections_.size(); ++i) {
+            if (!in_use_[i]) {
+                sqlite3_db_release_memory(connections_[i]->conn_handle());
+                ++idle;
+            }
+        }
+        return idle;
+    }
+
+private:
+    std::vector<std::unique_ptr<connection>> connections_;
+    // after the connections, so that the statements are finalized first
+    std::vector<prepared_statements> prepared_;
+    std::vector<bool> in_use_;
+    std::size_t available_{0};
+    std::mutex mutex_;
+    std::condition_variable released_;
+    std::string filename_;
+    int flags_{0};
+    std::optional<std::string> vfsname_;
+
+    template<typename... Args>
+    void open(std::size_t size, Args&... args) noexcept
+    {
+        try {
+            remember(args...);
+            connections_.reserve(size);
+            prepared_.resize(size);
+            in_use_.assign(size, false);
+            for (std::size_t i = 0; i < size; ++i) {
+                auto& conn = connections_.emplace_back(std::make_unique<connection>());
+                conn->open(args...);
+                if (!conn->is_open()) {
+                    connections_.clear();
+                    prepared_.clear();
+                    in_use_.clear();
+                    return;
+                }
+            }
+            available_ = size;
+        }
+        catch (const std::bad_alloc&) {
+            connections_.clear();
+            prepared_.clear();
+            in_use_.clear();
+            assign_error(SQLITE_NOMEM, args...);
+        }
+    }
+
+    // The same shapes as connection::open.
+    template<typename String>
+    void remember(const String& filename, const std::error_code&)
+    {
+        remember(filename, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr, std::error_code{});
+    }
+
+    template<typename String, typename Flags>
+    void remember(const String& filename, Flags flags, const std::error_code&)
+    {
+        remember(filename, flags, nullptr, std::error_code{});
+    }
+
+    template<typename String, typename Flags, typename StringOrNull>
+    void remember(const String& filename, Flags flags, const StringOrNull& vfsname, const std::error_code&)
+    {
+        auto name = detail::string_converter::to_czstring(filename);
+        filename_ = name != nullptr ? name : "";
+        flags_ = static_cast<int>(flags);
+        auto vfs = detail::string_converter::to_czstring(vfsname);
+        vfsname_ = vfs != nullptr ? std::optional<std::string>{vfs} : std::nullopt;
+    }
+
+    template<typename... Args>
+    static void assign_error(int rc, Args&... args) noexcept
+    {
+        auto assign = [rc](auto& arg) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, std::error_code>) {
+                arg.assign(rc, sqlite3_category());
+            }
+        };
+        (assign(args), ...);
+    }
+
+    std::size_t take() noexcept
+    {
+        for (std::size_t i = 0; i < in_use_.size(); ++i) {
+            if (!in_use_[i]) {
+                in_use_[i] = true;
+                --available_;
+                return i;
+            }
+        }
+        return in_use_.size();
+    }
+
+    void give_back(std::size_t index) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            in_use_[index] = false;
+            ++available_;
+        }
+        // waiters for one connection and for several wait on different
+        // conditions, so waking one of them could wake one that cannot proceed
+        released_.notify_all();
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_CONNECTION_POOL_HPP
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DEADLINE_HPP
+#define SQLITEPP_DEADLINE_HPP
+
+#include <sqlitepp/connection.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+namespace sqlitepp
+{
+
+// Sets the deadline of a connection for the lifetime of the scope, keeping an
+// earlier deadline already set, and restores the previous one on exit.
+class deadline_scope
+{
+public:
+    deadline_scope(connection& conn, std::chrono::steady_clock::time_point deadline) noexcept : conn_(conn), previous_(conn.deadline())
+    {
+        conn_.set_deadline(previous_ ? std::min(*previous_, deadline) : deadline);
+    }
+
+    deadline_scope(connection& conn, std::chrono::steady_clock::duration timeout) noexcept : deadline_scope(conn, std::chrono::steady_clock::now() + timeout)
+    {
+    }
+
+    ~deadline_scope() noexcept
+    {
+        if (previous_) {
+            conn_.set_deadline(*previous_);
+        }
+        else {
+            conn_.clear_deadline();
+        }
+    }
+
+    deadline_scope(const deadline_scope&) = delete;
+    deadline_scope& operator=(const deadline_scope&) = delete;
+
+private:
+    connection& conn_;
+    std::optional<std::chrono::steady_clock::time_point> previous_;
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_DEADLINE_HPP
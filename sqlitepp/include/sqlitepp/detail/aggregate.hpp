@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_AGGREGATE_HPP
+#define SQLITEPP_DETAIL_AGGREGATE_HPP
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sqlitepp::detail
+{
+
+inline constexpr std::size_t max_aggregate_fields = 16;
+
+// Converts to anything, so T{any_field{}...} compiles for as many
+// initializers as T has fields. The conversion is to an lvalue reference,
+// which keeps it from competing with converting constructors such as the
+// one of std::optional.
+struct any_field
+{
+    template<typename T>
+    operator T&() const noexcept;
+};
+
+template<typename T, typename Indexes, typename = void>
+struct is_brace_constructible : std::false_type
+{
+};
+
+template<typename T, std::size_t... I>
+struct is_brace_constructible<T, std::index_sequence<I...>, std::void_t<decltype(T{(static_cast<void>(I), any_field{})...})>> : std::true_type
+{
+};
+
+template<typename T, std::size_t N = max_aggregate_fields>
+constexpr std::size_t count_fields() noexcept
+{
+    if constexpr (N == 0 || is_brace_constructible<T, std::make_index_sequence<N>>::value) {
+        return N;
+    }
+    else {
+        return count_fields<T, N - 1>();
+    }
+}
+
+// Number of fields of a flat aggregate, known at compile time. Members that
+// are aggregates themselves would be counted through brace elision, so
+// only scalar, string, blob and optional members are supported.
+template<typename T>
+inline constexpr std::size_t field_count_v = count_fields<std::remove_cv_t<T>>();
+
+// References to the fields of an aggregate, in declaration order.
+template<typename T>
+constexpr auto tie_fields(T& value) noexcept
+{
+    constexpr auto N = field_count_v<T>;
+    static_assert(std::is_aggregate_v<std::remove_cv_t<T>>, "rows and parameters must be aggregates");
+    static_assert(N != 0, "aggregates need at least one field");
+    if constexpr (N == 1) {
+        auto& [f0] = value;
+        return std::tie(f0);
+    }
+    else if constexpr (N == 2) {
+        auto& [f0, f1] = value;
+        return std::tie(f0, f1);
+    }
+    else if constexpr (N == 3) {
+        auto& [f0, f1, f2] = value;
+        return std::tie(f0, f1, f2);
+    }
+    else if constexpr (N == 4) {
+        auto& [f0, f1, f2, f3] = value;
+        return std::tie(f0, f1, f2, f3);
+    }
+    else if constexpr (N == 5) {
+        auto& [f0, f1, f2, f3, f4] = value;
+        return std::tie(f0, f1, f2, f3, f4);
+    }
+    else if constexpr (N == 6) {
+        auto& [f0, f1, f2, f3, f4, f5] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5);
+    }
+    else if constexpr (N == 7) {
+        auto& [f0, f1, f2, f3, f4, f5, f6] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6);
+    }
+    else if constexpr (N == 8) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+    }
+    else if constexpr (N == 9) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+    }
+    else if constexpr (N == 10) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+    }
+    else if constexpr (N == 11) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+    }
+    else if constexpr (N == 12) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+    }
+    else if constexpr (N == 13) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+    }
+    else if constexpr (N == 14) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+    }
+    else if constexpr (N == 15) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+    }
+    else if constexpr (N == 16) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+    }
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_AGGREGATE_HPP
@@ -0,0 +1,447 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_ARROW_IMPL_HPP
+#define SQLITEPP_DETAIL_ARROW_IMPL_HPP
+
+#include <sqlitepp/arrow_c_data.hpp>
+#include <sqlitepp/detail/deadline_guard.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+enum class arrow_type
+{
+    null,
+    int64,
+    float64,
+    large_utf8,
+    large_binary
+};
+
+inline const char* arrow_format(arrow_type type) noexcept
+{
+    switch (type) {
+    case arrow_type::int64:
+        return "l";
+    case arrow_type::float64:
+        return "g";
+    case arrow_type::large_utf8:
+        return "U";
+    case arrow_type::large_binary:
+        return "Z";
+    default:
+        return "n";
+    }
+}
+
+// Type of a declared column by the SQLite affinity rules, null when the
+// result column is an expression or has NUMERIC affinity, so that the type
+// must come from the values.
+inline arrow_type declared_arrow_type(const char* declared)
+{
+    if (declared == nullptr || *declared == '\0') {
+        return arrow_type::null;
+    }
+    std::string upper{declared};
+    for (auto& c : upper) {
+        c = static_cast<char>(c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+    }
+    auto contains = [&upper](const char* part) { return upper.find(part) != std::string::npos; };
+    if (contains("INT")) {
+        return arrow_type::int64;
+    }
+    if (contains("CHAR") || contains("CLOB") || contains("TEXT")) {
+        return arrow_type::large_utf8;
+    }
+    if (contains("BLOB")) {
+        return arrow_type::large_binary;
+    }
+    if (contains("REAL") || contains("FLOA") || contains("DOUB")) {
+        return arrow_type::float64;
+    }
+    return arrow_type::null;
+}
+
+inline arrow_type value_arrow_type(int type) noexcept
+{
+    switch (type) {
+    case SQLITE_INTEGER:
+        return arrow_type::int64;
+    case SQLITE_FLOAT:
+        return arrow_type::float64;
+    case SQLITE_TEXT:
+        return arrow_type::large_utf8;
+    case SQLITE_BLOB:
+        return arrow_type::large_binary;
+    default:
+        return arrow_type::null;
+    }
+}
+
+// The type of a column whose values were all null in the first of several
+// batches, which later batches must keep: float64 for NUMERIC affinity,
+// which holds integers and reals, and large_utf8, which any value converts
+// to, for expressions.
+inline arrow_type fallback_arrow_type(const char* declared) noexcept
+{
+    return declared != nullptr && *declared != '\0' ? arrow_type::float64 : arrow_type::large_utf8;
+}
+
+// Buffers of one result column. Values that do not match the column type
+// are converted the way sqlite3_column_* converts them, except that a column
+// whose type comes from its values widens from int64 to float64 when a real
+// appears.
+class arrow_column
+{
+public:
+    arrow_column(arrow_type type, std::size_t rows) : type_(type), inferred_(type == arrow_type::null)
+    {
+        // sized for the batch up front, empty buffers also need a valid address
+        rows = std::max<std::size_t>(std::min(rows, max_reserved_rows), 1);
+        validity_.reserve(rows / 8 + 1);
+        integers_.reserve(type == arrow_type::int64 || type == arrow_type::null ? rows : 1);
+        reals_.reserve(type == arrow_type::float64 ? rows : 1);
+        offsets_.reserve(type == arrow_type::large_utf8 || type == arrow_type::large_binary || type == arrow_type::null ? rows + 1 : 1);
+        bytes_.reserve(1);
+        offsets_.push_back(0);
+        fill_values(0);
+    }
+
+    // The caller holds the database mutex, which makes the column value a
+    // protected one that sqlite3_value_* may read.
+    void append(sqlite3_value* value)
+    {
+        int type = sqlite3_value_type(value);
+        if (type_ == arrow_type::null && type != SQLITE_NULL) {
+            // the first value decides an undeclared type, the nulls so far get placeholders
+            type_ = value_arrow_type(type);
+            fill_values(length_);
+        }
+        else if (inferred_ && type_ == arrow_type::int64 && type == SQLITE_FLOAT) {
+            reals_.assign(integers_.begin(), integers_.end());
+            integers_ = {};
+            type_ = arrow_type::float64;
+        }
+        if ((length_ & 7) == 0) {
+            validity_.push_back(0);
+        }
+        if (type == SQLITE_NULL) {
+            ++null_count_;
+            fill_values(length_ + 1);
+        }
+        else {
+            validity_.back() |= static_cast<std::uint8_t>(1u << (length_ & 7));
+            switch (type_) {
+            case arrow_type::int64:
+                integers_.push_back(sqlite3_value_int64(value));
+                break;
+            case arrow_type::float64:
+                reals_.push_back(sqlite3_value_double(value));
+                break;
+            case arrow_type::large_utf8: {
+                auto text = reinterpret_cast<const char*>(sqlite3_value_text(value));
+                append_bytes(text, sqlite3_value_bytes(value));
+                break;
+            }
+            case arrow_type::large_binary: {
+                auto blob = static_cast<const char*>(sqlite3_value_blob(value));
+                append_bytes(blob, sqlite3_value_bytes(value));
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        ++length_;
+    }
+
+    arrow_type type() const noexcept
+    {
+        return type_;
+    }
+
+    // Gives a column of nulls only its type for later batches.
+    void settle(arrow_type type)
+    {
+        if (type_ == arrow_type::null) {
+            type_ = type;
+            fill_values(length_);
+        }
+    }
+
+    // Points out at the buffers, which stay owned by this column.
+    void export_to(ArrowArray& out) noexcept
+    {
+        out.length = length_;
+        out.offset = 0;
+        out.n_children = 0;
+        out.children = nullptr;
+        out.dictionary = nullptr;
+        if (type_ == arrow_type::null) {
+            out.null_count = length_;
+            out.n_buffers = 0;
+            out.buffers = nullptr;
+            return;
+        }
+        out.null_count = null_count_;
+        buffers_[0] = null_count_ != 0 ? validity_.data() : nullptr;
+        if (type_ == arrow_type::int64 || type_ == arrow_type::float64) {
+            buffers_[1] = type_ == arrow_type::int64 ? static_cast<const void*>(integers_.data()) : static_cast<const void*>(reals_.data());
+            out.n_buffers = 2;
+        }
+        else {
+            buffers_[1] = offsets_.data();
+            buffers_[2] = bytes_.data();
+            out.n_buffers = 3;
+        }
+        out.buffers = buffers_;
+    }
+
+private:
+    static constexpr std::size_t max_reserved_rows = 65536;
+
+    arrow_type type_;
+    bool inferred_;
+    std::int64_t length_{0};
+    std::int64_t null_count_{0};
+    std::vector<std::uint8_t> validity_;
+    std::vector<std::int64_t> integers_;
+    std::vector<double> reals_;
+    std::vector<std::int64_t> offsets_;
+    std::vector<char> bytes_;
+    const void* buffers_[3]{};
+
+    // Pads the value buffer of the current type to n entries.
+    void fill_values(std::int64_t n)
+    {
+        auto size = static_cast<std::size_t>(n);
+        switch (type_) {
+        case arrow_type::int64:
+            integers_.resize(size);
+            break;
+        case arrow_type::float64:
+            reals_.resize(size);
+            break;
+        case arrow_type::large_utf8:
+        case arrow_type::large_binary:
+            offsets_.resize(size + 1, static_cast<std::int64_t>(bytes_.size()));
+            break;
+        default:
+            break;
+        }
+    }
+
+    void append_bytes(const char* data, int size)
+    {
+        if (size > 0) {
+            bytes_.insert(bytes_.end(), data, data + size);
+        }
+        offsets_.push_back(static_cast<std::int64_t>(bytes_.size()));
+    }
+};
+
+struct arrow_array_data
+{
+    std::vector<ArrowArray> children;
+    std::vector<ArrowArray*> child_pointers;
+    const void* buffers[1]{nullptr};
+};
+
+struct arrow_schema_data
+{
+    std::vector<ArrowSchema> children;
+    std::vector<ArrowSchema*> child_pointers;
+};
+
+inline void release_arrow_column(ArrowArray* array) noexcept
+{
+    delete static_cast<arrow_column*>(array->private_data);
+    array->release = nullptr;
+}
+
+inline void release_arrow_struct(ArrowArray* array) noexcept
+{
+    auto data = static_cast<arrow_array_data*>(array->private_data);
+    for (auto& child : data->children) {
+        // children moved out by the consumer were marked released
+        if (child.release != nullptr) {
+            child.release(&child);
+        }
+    }
+    delete data;
+    array->release = nullptr;
+}
+
+inline void release_arrow_field(ArrowSchema* schema) noexcept
+{
+    delete static_cast<std::string*>(schema->private_data);
+    schema->release = nullptr;
+}
+
+inline void release_arrow_schema(ArrowSchema* schema) noexcept
+{
+    auto data = static_cast<arrow_schema_data*>(schema->private_data);
+    for (auto& child : data->children) {
+        if (child.release != nullptr) {
+            child.release(&child);
+        }
+    }
+    delete data;
+    schema->release = nullptr;
+}
+
+// Holds the recursive database mutex, which is null unless SQLite runs in
+// serialized mode.
+class database_lock
+{
+public:
+    explicit database_lock(sqlite3_mutex* mutex) noexcept : mutex_(mutex)
+    {
+        sqlite3_mutex_enter(mutex_);
+    }
+
+    ~database_lock() noexcept
+    {
+        sqlite3_mutex_leave(mutex_);
+    }
+
+    database_lock(const database_lock&) = delete;
+    database_lock& operator=(const database_lock&) = delete;
+
+private:
+    sqlite3_mutex* mutex_;
+};
+
+// Steps stmt up to rows times and exports the rows as a struct array with one
+// child per result column, along with its schema. Returns the number of rows.
+// types holds the column types of the batches of one run of the statement:
+// the first batch fills it and later ones keep to it, until the last one
+// clears it. deadline is the guard of the connection, or null.
+inline std::int64_t export_arrow(stmt_handle_t stmt, const deadline_guard* deadline, std::size_t rows, ArrowArray& array, ArrowSchema& schema,
+                                 std::vector<arrow_type>& types, std::error_code& ec) noexcept
+{
+    if (stmt == nullptr) {
+        ec = sqlitepp_errc::invalid_handle;
+        return 0;
+    }
+    try {
+        int count = sqlite3_column_count(stmt);
+        bool first = types.size() != static_cast<std::size_t>(count);
+        std::vector<std::unique_ptr<arrow_column>> columns;
+        for (int i = 0; i < count; ++i) {
+            auto type = first ? declared_arrow_type(sqlite3_column_decltype(stmt, i)) : types[i];
+            columns.push_back(std::make_unique<arrow_column>(type, rows));
+        }
+
+        std::int64_t length = 0;
+        bool last = false;
+        database_lock lock{sqlite3_db_mutex(sqlite3_db_handle(stmt))};
+        while (static_cast<std::size_t>(length) < rows) {
+            int rc = step_before_deadline(stmt, deadline);
+            if (rc == SQLITE_DONE) {
+                // the next step would start the query over
+                sqlite3_reset(stmt);
+                last = true;
+                break;
+            }
+            if (rc != SQLITE_ROW) {
+                assign_step_error(stmt, rc, ec);
+                sqlite3_reset(stmt);
+                types.clear();
+                return 0;
+            }
+            for (int i = 0; i < count; ++i) {
+                columns[i]->append(sqlite3_column_value(stmt, i));
+            }
+            ++length;
+        }
+        if (last) {
+            types.clear();
+        }
+        else if (first) {
+            types.resize(count);
+            for (int i = 0; i < count; ++i) {
+                columns[i]->settle(fallback_arrow_type(sqlite3_column_decltype(stmt, i)));
+                types[i] = columns[i]->type();
+            }
+        }
+
+        auto schema_data = std::make_unique<arrow_schema_data>();
+        schema_data->children.resize(count);
+        std::vector<std::unique_ptr<std::string>> names;
+        for (int i = 0; i < count; ++i) {
+            auto name = sqlite3_column_name(stmt, i);
+            names.push_back(std::make_unique<std::string>(name != nullptr ? name : ""));
+        }
+        auto array_data = std::make_unique<arrow_array_data>();
+        array_data->children.resize(count);
+        array_data->child_pointers.resize(count);
+        schema_data->child_pointers.resize(count);
+
+        // nothing below allocates, so ownership moves into the structs all at once
+        for (int i = 0; i < count; ++i) {
+            auto& field = schema_data->children[i];
+            field.format = arrow_format(columns[i]->type());
+            field.name = names[i]->c_str();
+            field.metadata = nullptr;
+            field.flags = ARROW_FLAG_NULLABLE;
+            field.n_children = 0;
+            field.children = nullptr;
+            field.dictionary = nullptr;
+            field.release = release_arrow_field;
+            field.private_data = names[i].release();
+            schema_data->child_pointers[i] = &field;
+
+            auto& child = array_data->children[i];
+            columns[i]->export_to(child);
+            child.release = release_arrow_column;
+            child.private_data = columns[i].release();
+            array_data->child_pointers[i] = &child;
+        }
+
+        schema.format = "+s";
+        schema.name = "";
+        schema.metadata = nullptr;
+        schema.flags = 0;
+        schema.n_children = count;
+        schema.children = schema_data->child_pointers.data();
+        schema.dictionary = nullptr;
+        schema.release = release_arrow_schema;
+        schema.private_data = schema_data.release();
+
+        array.length = length;
+        array.null_count = 0;
+        array.offset = 0;
+        array.n_buffers = 1;
+        array.n_children = count;
+        array.buffers = array_data->buffers;
+        array.children = array_data->child_pointers.data();
+        array.dictionary = nullptr;
+        array.release = release_arrow_struct;
+        array.private_data = array_data.release();
+
+        ec.clear();
+        return length;
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+        return 0;
+    }
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_ARROW_IMPL_HPP
@@ -0,0 +1,400 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_CHANGE_BUS_HPP
+#define SQLITEPP_DETAIL_CHANGE_BUS_HPP
+
+#include <sqlitepp/change_types.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/trace_hooks.hpp>
+#include <sqlitepp/detail/update_hooks.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+// Buffers the rows the update hook reports for subscribed tables until the
+// transaction ends, then hands them to the subscribers once the commit has
+// succeeded or drops them on rollback. The commit hook runs before the
+// commit can still fail with SQLITE_BUSY, so it only sets the batches aside;
+// the statement that committed delivers them when it completes with the
+// connection back in autocommit mode, which the profile trace event reports.
+// Owned by the connection; subscriptions hold it weakly.
+class change_bus
+{
+public:
+    change_bus() = default;
+
+    ~change_bus() noexcept
+    {
+        if (!worker_) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock{worker_->mutex};
+            worker_->stopping = true;
+        }
+        worker_->ready.notify_one();
+        if (worker_thread_.get_id() == std::this_thread::get_id()) {
+            // a callback released the last reference; the thread keeps its state alive
+            worker_thread_.detach();
+        }
+        else {
+            worker_thread_.join();
+        }
+    }
+
+    change_bus(const change_bus&) = delete;
+    change_bus& operator=(const change_bus&) = delete;
+
+    void attach(conn_handle_t db, update_hooks& hooks, trace_hooks& traces, std::error_code& ec) noexcept
+    {
+        hooks.add(db, this, &change_bus::on_update, ec);
+        if (ec) {
+            return;
+        }
+        traces.add(db, this, SQLITE_TRACE_PROFILE, &change_bus::on_trace, ec);
+        if (ec) {
+            hooks.remove(db, this);
+            return;
+        }
+        // the commit and rollback hooks have a single slot each, which the bus takes
+        sqlite3_commit_hook(db, &change_bus::on_commit, this);
+        sqlite3_rollback_hook(db, &change_bus::on_rollback, this);
+        db_ = db;
+        hooks_ = &hooks;
+        traces_ = &traces;
+    }
+
+    void detach() noexcept
+    {
+        if (db_ != nullptr) {
+            hooks_->remove(db_, this);
+            traces_->remove(db_, this);
+            sqlite3_commit_hook(db_, nullptr, nullptr);
+            sqlite3_rollback_hook(db_, nullptr, nullptr);
+            db_ = nullptr;
+        }
+    }
+
+    std::uint64_t subscribe(std::string_view table, change_callback callback, change_delivery delivery, std::error_code& ec) noexcept
+    {
+        try {
+            if (delivery == change_delivery::worker && !worker_) {
+                start_worker();
+            }
+            auto s = std::make_shared<subscriber>();
+            s->callback = std::move(callback);
+            s->delivery = delivery;
+
+            std::lock_guard<std::mutex> lock{mutex_};
+            s->id = ++last_id_;
+            auto it = std::find_if(tables_.begin(), tables_.end(), [table](const table_bucket& b) { return equal_names(b.name, table); });
+            if (it == tables_.end()) {
+                tables_.emplace_back();
+                tables_.back().name = table;
+                it = std::prev(tables_.end());
+            }
+            it->subscribers.push_back(s);
+            forget_last_table();
+            ec.clear();
+            return s->id;
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        catch (const std::system_error& e) {
+            // the worker thread did not start
+            ec = e.code();
+        }
+        return 0;
+    }
+
+    // Returns once the callback is neither running nor going to run, unless
+    // called from the callback itself.
+    void unsubscribe(std::uint64_t id) noexcept
+    {
+        std::shared_ptr<subscriber> removed;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (auto bucket = tables_.begin(); bucket != tables_.end() && !removed; ++bucket) {
+                auto& subscribers = bucket->subscribers;
+                auto it = std::find_if(subscribers.begin(), subscribers.end(), [id](const auto& s) { return s->id == id; });
+                if (it != subscribers.end()) {
+                    removed = std::move(*it);
+                    subscribers.erase(it);
+                    if (subscribers.empty()) {
+                        tables_.erase(bucket);
+                    }
+                }
+            }
+            forget_last_table();
+        }
+        if (removed) {
+            std::lock_guard<std::recursive_mutex> lock{removed->mutex};
+            removed->active = false;
+        }
+    }
+
+private:
+    struct subscriber
+    {
+        std::uint64_t id{0};
+        change_callback callback;
+        change_delivery delivery{change_delivery::on_commit};
+        // held while the callback runs, recursive so the callback can unsubscribe itself
+        std::recursive_mutex mutex;
+        bool active{true};
+
+        void deliver(const table_changes& changes) noexcept
+        {
+            std::lock_guard<std::recursive_mutex> lock{mutex};
+            if (active) {
+                try {
+                    callback(changes);
+                }
+                catch (...) {
+                    // nowhere to report it from a hook or the worker thread
+                }
+            }
+        }
+    };
+
+    struct table_bucket
+    {
+        std::string name;
+        std::vector<std::shared_ptr<subscriber>> subscribers;
+        // one batch per schema the open transaction changed the table in
+        std::vector<table_changes> pending;
+        // the batches of a COMMIT that has not completed yet
+        std::vector<table_changes> committing;
+    };
+
+    struct delivery
+    {
+        std::shared_ptr<const table_changes> changes;
+        std::shared_ptr<subscriber> target;
+    };
+
+    struct worker_state
+    {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<delivery> queue;
+        bool stopping{false};
+    };
+
+    conn_handle_t db_{nullptr};
+    update_hooks* hooks_{nullptr};
+    trace_hooks* traces_{nullptr};
+
+    // guards the buckets, which the hooks and unsubscribing threads share
+    std::mutex mutex_;
+    std::vector<table_bucket> tables_;
+    std::uint64_t last_id_{0};
+    // whether a bucket has committing batches
+    bool committing_{false};
+
+    // the batch of the last update, by name: SQLite may pass the address of a
+    // dropped table's name for another one
+    std::string last_db_;
+    std::string last_table_;
+    table_changes* last_pending_{nullptr};
+
+    std::shared_ptr<worker_state> worker_;
+    std::thread worker_thread_;
+
+    static bool equal_names(std::string_view a, std::string_view b) noexcept
+    {
+        return a.size() == b.size() && sqlite3_strnicmp(a.data(), b.data(), static_cast<int>(a.size())) == 0;
+    }
+
+    void forget_last_table() noexcept
+    {
+        last_db_.clear();
+        last_table_.clear();
+        last_pending_ = nullptr;
+    }
+
+    void start_worker()
+    {
+        auto state = std::make_shared<worker_state>();
+        worker_thread_ = std::thread{[state]() {
+            std::unique_lock<std::mutex> lock{state->mutex};
+            for (;;) {
+                state->ready.wait(lock, [&state]() { return state->stopping || !state->queue.empty(); });
+                if (state->queue.empty()) {
+                    return;
+                }
+                auto next = std::move(state->queue.front());
+                state->queue.pop_front();
+                lock.unlock();
+                next.target->deliver(*next.changes);
+                lock.lock();
+            }
+        }};
+        worker_ = std::move(state);
+    }
+
+    table_changes* pending_for(const char* db, const char* table)
+    {
+        auto bucket = std::find_if(tables_.begin(), tables_.end(), [table](const table_bucket& b) { return equal_names(b.name, table); });
+        if (bucket == tables_.end()) {
+            return nullptr;
+        }
+        for (auto& batch : bucket->pending) {
+            if (batch.database == db) {
+                return &batch;
+            }
+        }
+        auto& batch = bucket->pending.emplace_back();
+        batch.database = db;
+        batch.table = table;
+        return &batch;
+    }
+
+    static void on_update(void* self, int op, const char* db, const char* table, sqlite3_int64 rowid) noexcept
+    {
+        auto& bus = *static_cast<change_bus*>(self);
+        std::lock_guard<std::mutex> lock{bus.mutex_};
+        try {
+            if (bus.last_table_ != table || bus.last_db_ != db) {
+                bus.forget_last_table();
+                bus.last_pending_ = bus.pending_for(db, table);
+                bus.last_db_ = db;
+                bus.last_table_ = table;
+            }
+            if (bus.last_pending_ != nullptr) {
+                bus.last_pending_->rows.push_back({static_cast<change_kind>(op), rowid});
+            }
+        }
+        catch (const std::bad_alloc&) {
+            if (bus.last_pending_ != nullptr) {
+                bus.last_pending_->complete = false;
+            }
+            else {
+                // the batch itself could not be created
+                bus.forget_last_table();
+            }
+        }
+    }
+
+    static int on_commit(void* self) noexcept
+    {
+        auto& bus = *static_cast<change_bus*>(self);
+        std::lock_guard<std::mutex> lock{bus.mutex_};
+        try {
+            for (auto& bucket : bus.tables_) {
+                for (auto& batch : bucket.pending) {
+                    // a COMMIT retried after SQLITE_BUSY adds what ran in between
+                    auto it = std::find_if(bucket.committing.begin(), bucket.committing.end(),
+                                           [&batch](const table_changes& c) { return c.database == batch.database; });
+                    if (it == bucket.committing.end()) {
+                        bucket.committing.push_back(std::move(batch));
+                    }
+                    else {
+                        it->rows.insert(it->rows.end(), batch.rows.begin(), batch.rows.end());
+                        it->complete = it->complete && batch.complete;
+                    }
+                    bus.committing_ = true;
+                }
+                bucket.pending.clear();
+            }
+        }
+        catch (const std::bad_alloc&) {
+            for (auto& bucket : bus.tables_) {
+                for (auto& batch : bucket.committing) {
+                    batch.complete = false;
+                }
+                bucket.pending.clear();
+            }
+        }
+        bus.forget_last_table();
+        return 0;
+    }
+
+    static int on_trace(unsigned, void* self, void*, void*) noexcept
+    {
+        auto& bus = *static_cast<change_bus*>(self);
+        // a failed COMMIT either leaves the transaction open or rolls it back
+        if (sqlite3_get_autocommit(bus.db_) != 0) {
+            bus.deliver_committed();
+        }
+        return 0;
+    }
+
+    void deliver_committed() noexcept
+    {
+        std::vector<delivery> inline_deliveries;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (!committing_) {
+                return;
+            }
+            committing_ = false;
+            try {
+                for (auto& bucket : tables_) {
+                    for (auto& batch : bucket.committing) {
+                        auto changes = std::make_shared<const table_changes>(std::move(batch));
+                        for (auto& s : bucket.subscribers) {
+                            if (s->delivery == change_delivery::on_commit) {
+                                inline_deliveries.push_back({changes, s});
+                            }
+                            else {
+                                std::lock_guard<std::mutex> queue_lock{worker_->mutex};
+                                worker_->queue.push_back({changes, s});
+                            }
+                        }
+                    }
+                    bucket.committing.clear();
+                }
+            }
+            catch (const std::bad_alloc&) {
+                for (auto& bucket : tables_) {
+                    bucket.committing.clear();
+                }
+            }
+        }
+        if (worker_) {
+            worker_->ready.notify_one();
+        }
+        // outside the lock, so callbacks may unsubscribe
+        for (auto& d : inline_deliveries) {
+            d.target->deliver(*d.changes);
+        }
+    }
+
+    static void on_rollback(void* self) noexcept
+    {
+        static_cast<change_bus*>(self)->drop_pending();
+    }
+
+    void drop_pending() noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (auto& bucket : tables_) {
+            bucket.pending.clear();
+            bucket.committing.clear();
+        }
+        committing_ = false;
+        forget_last_table();
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_CHANGE_BUS_HPP
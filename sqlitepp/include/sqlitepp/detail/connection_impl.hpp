@@ -3,12 +3,24 @@
 #ifndef SQLITEPP_DETAIL_CONNECTION_IMPL_HPP
 #define SQLITEPP_DETAIL_CONNECTION_IMPL_HPP
 
+#include <sqlitepp/detail/change_bus.hpp>
+#include <sqlitepp/detail/control_statements.hpp>
 #include <sqlitepp/detail/converter.hpp>
+#include <sqlitepp/detail/deadline_guard.hpp>
 #include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/trace_hooks.hpp>
+#include <sqlitepp/detail/update_hooks.hpp>
 #include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
 #include <sqlitepp/types.hpp>
 
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <optional>
 #include <type_traits>
+#include <utility>
 
 namespace sqlitepp::detail
 {
@@ -24,6 +36,9 @@ public:
         do_close(ec);
     }
 
+    connection_impl(const connection_impl&) = delete;
+    connection_impl& operator=(const connection_impl&) = delete;
+
     template<typename String,
              std::enable_if_t<std::conjunction_v<std::is_convertible<String, std::string>, std::negation<std::is_same<String, std::nullptr_t>>>, bool> = true>
     void construct(String filename, std::error_code& ec) noexcept
@@ -91,9 +106,160 @@ public:
         return conn_handle_;
     }
 
+    void execute(control_statement which, std::error_code& ec) noexcept
+    {
+        control_.execute(conn_handle_, which, ec);
+    }
+
+    void execute(savepoint_statement which, std::size_t depth, std::error_code& ec) noexcept
+    {
+        control_.execute(conn_handle_, which, depth, ec);
+    }
+
+    // The update hook fan-out of the connection, created on first use and
+    // released on close, so that a weak reference tells whether it is gone.
+    std::shared_ptr<update_hooks> update_hook_registry(std::error_code& ec) noexcept
+    {
+        if (conn_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return nullptr;
+        }
+        if (!update_hooks_) {
+            // heap allocated, so that the address given to SQLite follows the handle on swap
+            update_hooks_.reset(new (std::nothrow) update_hooks);
+            if (!update_hooks_) {
+                ec.assign(SQLITE_NOMEM, sqlite3_category());
+                return nullptr;
+            }
+        }
+        ec.clear();
+        return update_hooks_;
+    }
+
+    // The trace callback fan-out of the connection, created on first use and
+    // released on close like the update hooks.
+    std::shared_ptr<trace_hooks> trace_hook_registry(std::error_code& ec) noexcept
+    {
+        if (conn_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return nullptr;
+        }
+        if (!trace_hooks_) {
+            trace_hooks_.reset(new (std::nothrow) trace_hooks);
+            if (!trace_hooks_) {
+                ec.assign(SQLITE_NOMEM, sqlite3_category());
+                return nullptr;
+            }
+        }
+        ec.clear();
+        return trace_hooks_;
+    }
+
+    // The change notification bus of the connection, created on first use.
+    std::shared_ptr<change_bus> change_notifications(std::error_code& ec) noexcept
+    {
+        if (change_bus_) {
+            ec.clear();
+            return change_bus_;
+        }
+        auto hooks = update_hook_registry(ec);
+        if (ec) {
+            return nullptr;
+        }
+        auto traces = trace_hook_registry(ec);
+        if (ec) {
+            return nullptr;
+        }
+        std::shared_ptr<change_bus> bus{new (std::nothrow) change_bus};
+        if (!bus) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return nullptr;
+        }
+        bus->attach(conn_handle_, *hooks, *traces, ec);
+        if (ec) {
+            return nullptr;
+        }
+        change_bus_ = bus;
+        return bus;
+    }
+
+    // Kept over close and open; statements stepped after it has passed fail.
+    void set_deadline(std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        if (auto guard = deadline_guard_ref()) {
+            guard->arm(conn_handle_, deadline);
+        }
+    }
+
+    void clear_deadline() noexcept
+    {
+        if (deadline_) {
+            deadline_->disarm(conn_handle_);
+        }
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> deadline() const noexcept
+    {
+        return deadline_ ? deadline_->deadline() : std::nullopt;
+    }
+
+    // The guard statements keep from when they are prepared, to check the
+    // deadline before they start; shared so that it outlives the connection
+    // for them. Null only when out of memory.
+    std::shared_ptr<const deadline_guard> shared_deadline_guard() noexcept
+    {
+        deadline_guard_ref();
+        return deadline_;
+    }
+
+    // Runs PRAGMA optimize with analysis_limit before closing, or not when
+    // analysis_limit is negative.
+    void set_optimize_on_close(int analysis_limit) noexcept
+    {
+        optimize_on_close_ = analysis_limit;
+    }
+
+    int optimize_on_close() const noexcept
+    {
+        return optimize_on_close_;
+    }
+
+    void swap(connection_impl& other) noexcept
+    {
+        std::swap(conn_handle_, other.conn_handle_);
+        std::swap(is_open_, other.is_open_);
+        std::swap(optimize_on_close_, other.optimize_on_close_);
+        control_.swap(other.control_);
+        update_hooks_.swap(other.update_hooks_);
+        trace_hooks_.swap(other.trace_hooks_);
+        change_bus_.swap(other.change_bus_);
+        // the guards go with the handles their progress handlers are installed on
+        deadline_.swap(other.deadline_);
+    }
+
 private:
     conn_handle_t conn_handle_{nullptr};
     bool is_open_{false};
+    int optimize_on_close_{-1};
+    control_statements control_;
+    std::shared_ptr<update_hooks> update_hooks_;
+    std::shared_ptr<trace_hooks> trace_hooks_;
+    std::shared_ptr<change_bus> change_bus_;
+    std::shared_ptr<deadline_guard> deadline_;
+
+    deadline_guard* deadline_guard_ref() noexcept
+    {
+        if (!deadline_) {
+            try {
+                deadline_ = std::make_shared<deadline_guard>();
+            }
+            catch (const std::bad_alloc&) {
+                return nullptr;
+            }
+            deadline_->rebind(conn_handle_);
+        }
+        return deadline_.get();
+    }
 
     void do_construct(const char* filename, int flags, const char* vfsname, std::error_code& ec) noexcept
     {
@@ -105,6 +271,9 @@ private:
         else {
             ec.clear();
             is_open_ = true;
+            if (deadline_) {
+                deadline_->rebind(conn_handle_);
+            }
         }
     }
 
@@ -120,10 +289,32 @@ private:
         return is_open_;
     }
 
+    static void optimize(conn_handle_t db, int analysis_limit) noexcept
+    {
+        char limit[48];
+        std::snprintf(limit, sizeof(limit), "PRAGMA analysis_limit = %d", analysis_limit);
+        for (const char* sql : {static_cast<const char*>(limit), "PRAGMA optimize"}) {
+            stmt_handle_t stmt = nullptr;
+            // best effort, the connection closes either way
+            if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+                while (sqlite3_step(stmt) == SQLITE_ROW) {
+                }
+            }
+            sqlite3_finalize(stmt);
+        }
+    }
+
     void do_close(std::error_code& ec) noexcept
     {
         ec.clear();
         if (conn_handle_ != nullptr) {
+            if (optimize_on_close_ >= 0) {
+                optimize(conn_handle_, optimize_on_close_);
+            }
+            control_.finalize();
+            if (change_bus_) {
+                change_bus_->detach();
+            }
             int rc = sqlite3_close_v2(conn_handle_);
             if (rc != SQLITE_OK) {
                 ec.assign(rc, sqlite3_category());
@@ -131,6 +322,13 @@ private:
             else {
                 conn_handle_ = nullptr;
                 is_open_ = false;
+                // delivers what the worker thread still has queued
+                change_bus_.reset();
+                update_hooks_.reset();
+                trace_hooks_.reset();
+                if (deadline_) {
+                    deadline_->rebind(nullptr);
+                }
             }
         }
     }
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_CONTROL_STATEMENTS_HPP
+#define SQLITEPP_DETAIL_CONTROL_STATEMENTS_HPP
+
+#include <sqlitepp/detail/deadline_guard.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <system_error>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+enum class control_statement : std::size_t
+{
+    begin_deferred,
+    begin_immediate,
+    begin_exclusive,
+    commit,
+    rollback
+};
+
+enum class savepoint_statement : std::size_t
+{
+    begin,
+    release,
+    rollback_to
+};
+
+// Transaction control statements of a connection, prepared on first use and
+// kept until the connection closes, so that BEGIN, COMMIT, ROLLBACK and the
+// savepoint statements are parsed only once per connection.
+class control_statements
+{
+public:
+    control_statements() = default;
+
+    ~control_statements() noexcept
+    {
+        finalize();
+    }
+
+    control_statements(const control_statements&) = delete;
+    control_statements& operator=(const control_statements&) = delete;
+
+    void execute(conn_handle_t db, control_statement which, std::error_code& ec) noexcept
+    {
+        static constexpr std::array<const char*, 5> sql{"BEGIN DEFERRED", "BEGIN IMMEDIATE", "BEGIN EXCLUSIVE", "COMMIT", "ROLLBACK"};
+        auto index = static_cast<std::size_t>(which);
+        run(db, control_[index], sql[index], ec);
+    }
+
+    void execute(conn_handle_t db, savepoint_statement which, std::size_t depth, std::error_code& ec) noexcept
+    {
+        static constexpr std::array<const char*, 3> format{"SAVEPOINT sqlitepp_%zu", "RELEASE sqlitepp_%zu", "ROLLBACK TO sqlitepp_%zu"};
+        try {
+            if (savepoints_.size() <= depth) {
+                savepoints_.resize(depth + 1);
+            }
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return;
+        }
+        auto index = static_cast<std::size_t>(which);
+        char sql[64];
+        std::snprintf(sql, sizeof(sql), format[index], depth);
+        run(db, savepoints_[depth][index], sql, ec);
+    }
+
+    void finalize() noexcept
+    {
+        for (auto& stmt : control_) {
+            finalize(stmt);
+        }
+        for (auto& level : savepoints_) {
+            for (auto& stmt : level) {
+                finalize(stmt);
+            }
+        }
+        savepoints_.clear();
+    }
+
+    void swap(control_statements& other) noexcept
+    {
+        control_.swap(other.control_);
+        savepoints_.swap(other.savepoints_);
+    }
+
+private:
+    std::array<stmt_handle_t, 5> control_{};
+    std::vector<std::array<stmt_handle_t, 3>> savepoints_;
+
+    static void run(conn_handle_t db, stmt_handle_t& stmt, const char* sql, std::error_code& ec) noexcept
+    {
+        if (stmt == nullptr) {
+            int rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+            if (rc != SQLITE_OK) {
+                ec.assign(rc, sqlite3_category());
+                return;
+            }
+        }
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE) {
+            assign_step_error(stmt, rc, ec);
+        }
+        else {
+            ec.clear();
+        }
+    }
+
+    static void finalize(stmt_handle_t& stmt) noexcept
+    {
+        if (stmt != nullptr) {
+            sqlite3_finalize(stmt);
+            stmt = nullptr;
+        }
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_CONTROL_STATEMENTS_HPP
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_CSV_SCANNER_HPP
+#define SQLITEPP_DETAIL_CSV_SCANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SQLITEPP_CSV_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SQLITEPP_CSV_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace sqlitepp::detail
+{
+
+inline unsigned count_trailing_zeros(std::uint64_t mask) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+// Finds the delimiter, quote and newline characters of a text 64 bytes at a
+// time. Each block is classified once into a bit mask, so that short fields
+// cost a bit scan instead of a byte loop.
+class csv_scanner
+{
+public:
+    csv_scanner(const char* begin, const char* end, char delimiter, char quote) noexcept
+        : end_(end), block_(begin), delimiter_(delimiter), quote_(quote)
+    {
+        load(begin);
+    }
+
+    const char* end() const noexcept
+    {
+        return end_;
+    }
+
+    // First special character at or after p, or end().
+    const char* find(const char* p) noexcept
+    {
+        while (p < end_) {
+            if (p < block_ || p >= block_ + block_size) {
+                load(p);
+            }
+            auto mask = mask_ >> (p - block_);
+            if (mask != 0) {
+                return p + count_trailing_zeros(mask);
+            }
+            p = block_ + block_size;
+        }
+        return end_;
+    }
+
+private:
+    static constexpr std::ptrdiff_t block_size = 64;
+
+    const char* end_;
+    const char* block_;
+    std::uint64_t mask_{0};
+    char delimiter_;
+    char quote_;
+
+    void load(const char* p) noexcept
+    {
+        block_ = p;
+        mask_ = 0;
+        std::ptrdiff_t i = 0;
+        if (end_ - p >= block_size) {
+#if defined(SQLITEPP_CSV_SSE2)
+            const __m128i delimiter = _mm_set1_epi8(delimiter_);
+            const __m128i quote = _mm_set1_epi8(quote_);
+            const __m128i newline = _mm_set1_epi8('\n');
+            for (; i < block_size; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, delimiter), _mm_cmpeq_epi8(chunk, quote)), _mm_cmpeq_epi8(chunk, newline));
+                mask_ |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(hits))) << i;
+            }
+#elif defined(SQLITEPP_CSV_NEON)
+            const uint8x16_t delimiter = vdupq_n_u8(static_cast<std::uint8_t>(delimiter_));
+            const uint8x16_t quote = vdupq_n_u8(static_cast<std::uint8_t>(quote_));
+            const uint8x16_t newline = vdupq_n_u8('\n');
+            static const std::uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+            const uint8x16_t bits = vld1q_u8(weights);
+            for (; i < block_size; i += 16) {
+                uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(p + i));
+                uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(chunk, delimiter), vceqq_u8(chunk, quote)), vceqq_u8(chunk, newline));
+                // movemask: one bit per lane, summed per half
+                uint8x16_t weighted = vandq_u8(hits, bits);
+                std::uint64_t low = vaddv_u8(vget_low_u8(weighted));
+                std::uint64_t high = vaddv_u8(vget_high_u8(weighted));
+                mask_ |= (low | high << 8) << i;
+            }
+#endif
+        }
+        // the tail of the text, or every block without SIMD support
+        for (auto n = end_ - p < block_size ? end_ - p : block_size; i < n; ++i) {
+            char c = p[i];
+            if (c == delimiter_ || c == quote_ || c == '\n') {
+                mask_ |= std::uint64_t{1} << i;
+            }
+        }
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_CSV_SCANNER_HPP
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_CYCLE_CLOCK_HPP
+#define SQLITEPP_DETAIL_CYCLE_CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace sqlitepp::detail
+{
+
+// Raw tick counter that is several times cheaper to read than
+// std::chrono::steady_clock. Ticks are converted to nanoseconds with a rate
+// calibrated against steady_clock over a long interval, see cycle_calibration.
+struct cycle_clock
+{
+    static std::uint64_t now() noexcept
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+};
+
+class cycle_calibration
+{
+public:
+    cycle_calibration() noexcept : ticks_(cycle_clock::now()), time_(std::chrono::steady_clock::now())
+    {
+    }
+
+    double nanoseconds_per_tick() const noexcept
+    {
+        auto ticks = cycle_clock::now() - ticks_;
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_).count();
+        return ticks != 0 ? elapsed / static_cast<double>(ticks) : 1.0;
+    }
+
+private:
+    std::uint64_t ticks_;
+    std::chrono::steady_clock::time_point time_;
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_CYCLE_CLOCK_HPP
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_DEADLINE_GUARD_HPP
+#define SQLITEPP_DETAIL_DEADLINE_GUARD_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <system_error>
+
+namespace sqlitepp::detail
+{
+
+// The connection whose deadline interrupted the last statement on this
+// thread; the progress handler runs on the thread that steps.
+inline thread_local conn_handle_t expired_deadline_db = nullptr;
+
+// Assigns the error of a failed step, telling an interrupt by the deadline of
+// the connection apart from one by sqlite3_interrupt.
+inline void assign_step_error(stmt_handle_t stmt, int rc, std::error_code& ec) noexcept
+{
+    if ((rc & 0xff) == SQLITE_INTERRUPT && expired_deadline_db != nullptr && expired_deadline_db == sqlite3_db_handle(stmt)) {
+        expired_deadline_db = nullptr;
+        ec = sqlitepp_errc::deadline_exceeded;
+        return;
+    }
+    ec.assign(rc, sqlite3_category());
+}
+
+// Interrupts statements of a connection once a deadline has passed, from
+// the progress handler. The number of VM instructions between two clock
+// reads adapts so that the checks are about check_period apart, and shrinks
+// as the deadline nears.
+class deadline_guard
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr int min_interval = 64;
+    static constexpr int max_interval = 1 << 20;
+    static constexpr std::chrono::microseconds check_period{100};
+
+    deadline_guard() = default;
+
+    deadline_guard(const deadline_guard&) = delete;
+    deadline_guard& operator=(const deadline_guard&) = delete;
+
+    void arm(conn_handle_t db, clock::time_point deadline) noexcept
+    {
+        deadline_ = deadline;
+        armed_ = true;
+        last_check_ = clock::now();
+        rebind(db);
+    }
+
+    void disarm(conn_handle_t db) noexcept
+    {
+        armed_ = false;
+        rebind(db);
+    }
+
+    std::optional<clock::time_point> deadline() const noexcept
+    {
+        return armed_ ? std::optional<clock::time_point>{deadline_} : std::nullopt;
+    }
+
+    // Whether a statement of db starting now would start after the deadline.
+    // The progress handler only runs every so many VM instructions, which a
+    // short statement never reaches, so statements check this before they
+    // start. Read without a lock: the deadline is set by the thread that
+    // uses the connection.
+    bool expired(conn_handle_t db) const noexcept
+    {
+        return armed_ && db == db_ && clock::now() >= deadline_;
+    }
+
+    // Installs or removes the progress handler of db to match this guard.
+    void rebind(conn_handle_t db) noexcept
+    {
+        db_ = db;
+        if (db_ == nullptr) {
+            installed_ = false;
+            return;
+        }
+        if (armed_) {
+            sqlite3_progress_handler(db_, interval_, &deadline_guard::on_progress, this);
+            installed_ = true;
+        }
+        else if (installed_) {
+            sqlite3_progress_handler(db_, 0, nullptr, nullptr);
+            installed_ = false;
+        }
+        if (expired_deadline_db == db_) {
+            expired_deadline_db = nullptr;
+        }
+    }
+
+private:
+    conn_handle_t db_{nullptr};
+    clock::time_point deadline_{};
+    clock::time_point last_check_{};
+    int interval_{1000};
+    bool armed_{false};
+    // whether db_ has the progress handler of this guard
+    bool installed_{false};
+
+    static int on_progress(void* self) noexcept
+    {
+        auto& guard = *static_cast<deadline_guard*>(self);
+        auto now = clock::now();
+        if (now >= guard.deadline_) {
+            expired_deadline_db = guard.db_;
+            return 1;
+        }
+        auto elapsed = now - guard.last_check_;
+        guard.last_check_ = now;
+        auto period = std::min<clock::duration>(check_period, (guard.deadline_ - now) / 4);
+
+        auto interval = guard.interval_;
+        if (elapsed < period / 2) {
+            interval = std::min(interval * 2, max_interval);
+        }
+        else if (elapsed > period * 2 && elapsed < check_period * 100) {
+            // a longer gap is the time between statements, not between checks
+            interval = std::max(interval / 2, min_interval);
+        }
+        if (interval != guard.interval_) {
+            guard.interval_ = interval;
+            sqlite3_progress_handler(guard.db_, interval, &deadline_guard::on_progress, self);
+        }
+        return 0;
+    }
+};
+
+// Steps stmt, or fails it as interrupted by the deadline when it would start
+// after the deadline of guard, the one of its connection or null; see
+// assign_step_error.
+inline int step_before_deadline(stmt_handle_t stmt, const deadline_guard* guard) noexcept
+{
+    if (guard != nullptr && sqlite3_stmt_busy(stmt) == 0 && guard->expired(sqlite3_db_handle(stmt))) {
+        expired_deadline_db = sqlite3_db_handle(stmt);
+        return SQLITE_INTERRUPT;
+    }
+    return sqlite3_step(stmt);
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_DEADLINE_GUARD_HPP
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_FUNCTION_IMPL_HPP
+#define SQLITEPP_DETAIL_FUNCTION_IMPL_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/statement_impl.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/types.hpp>
+#include <sqlitepp/value.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sqlitepp::detail
+{
+
+// The result and argument types of a function pointer, lambda or other
+// callable object with a single call operator.
+template<typename F>
+struct callable_traits : callable_traits<decltype(&F::operator())>
+{
+};
+
+template<typename R, typename... Args>
+struct callable_traits<R (*)(Args...)>
+{
+    using result_type = R;
+    using args_type = std::tuple<std::decay_t<Args>...>;
+};
+
+template<typename R, typename... Args>
+struct callable_traits<R(Args...)> : callable_traits<R (*)(Args...)>
+{
+};
+
+template<typename C, typename R, typename... Args>
+struct callable_traits<R (C::*)(Args...)> : callable_traits<R (*)(Args...)>
+{
+};
+
+template<typename C, typename R, typename... Args>
+struct callable_traits<R (C::*)(Args...) const> : callable_traits<R (*)(Args...)>
+{
+};
+
+template<typename T>
+T from_sql_value(sqlite3_value* v)
+{
+    if constexpr (std::is_same_v<T, sqlite3_value*>) {
+        return v;
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        return sqlite3_value_int64(v) != 0;
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(sqlite3_value_int64(v));
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(sqlite3_value_double(v));
+    }
+    else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>) {
+        // the pointer must be fetched before the size, see sqlite3_value_bytes
+        auto text = reinterpret_cast<const char*>(sqlite3_value_text(v));
+        if (text == nullptr) {
+            return T{};
+        }
+        return T{text, static_cast<std::size_t>(sqlite3_value_bytes(v))};
+    }
+    else if constexpr (std::is_same_v<T, blob_view>) {
+        auto data = sqlite3_value_blob(v);
+        return data != nullptr ? blob_view{data, static_cast<std::size_t>(sqlite3_value_bytes(v))} : blob_view{};
+    }
+    else if constexpr (std::is_same_v<T, sqlitepp::value>) {
+        return sqlitepp::value::from(v);
+    }
+    else if constexpr (is_optional<T>::value) {
+        if (sqlite3_value_type(v) == SQLITE_NULL) {
+            return std::nullopt;
+        }
+        return from_sql_value<typename T::value_type>(v);
+    }
+    else {
+        static_assert(always_false_v<T>, "no SQL function argument conversion for this type");
+    }
+}
+
+template<typename T>
+void set_result(sqlite3_context* ctx, const T& result)
+{
+    if constexpr (std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, std::nullopt_t>) {
+        sqlite3_result_null(ctx);
+    }
+    else if constexpr (std::is_same_v<T, sqlitepp::value>) {
+        switch (result.type()) {
+        case datatype::integer:
+            sqlite3_result_int64(ctx, result.as_int64());
+            break;
+        case datatype::real:
+            sqlite3_result_double(ctx, result.as_double());
+            break;
+        case datatype::text:
+            set_result(ctx, result.as_text());
+            break;
+        case datatype::blob:
+            set_result(ctx, result.as_blob());
+            break;
+        default:
+            sqlite3_result_null(ctx);
+        }
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(result));
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        sqlite3_result_double(ctx, static_cast<double>(result));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        std::string_view text{result};
+        sqlite3_result_text64(ctx, text.data(), text.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+    }
+    else if constexpr (std::is_same_v<T, blob_view>) {
+        if (result.data == nullptr) {
+            // a null pointer would return NULL instead of an empty blob
+            sqlite3_result_zeroblob(ctx, 0);
+        }
+        else {
+            sqlite3_result_blob64(ctx, result.data, result.size, SQLITE_TRANSIENT);
+        }
+    }
+    else if constexpr (is_byte_container<T>::value) {
+        set_result(ctx, blob_view{result.data(), result.size()});
+    }
+    else if constexpr (is_optional<T>::value) {
+        if (result) {
+            set_result(ctx, *result);
+        }
+        else {
+            sqlite3_result_null(ctx);
+        }
+    }
+    else {
+        static_assert(always_false_v<T>, "no SQL function result conversion for this type");
+    }
+}
+
+// Reports the exception in flight as the error of the function call.
+inline void set_error_result(sqlite3_context* ctx) noexcept
+{
+    try {
+        throw;
+    }
+    catch (const std::bad_alloc&) {
+        sqlite3_result_error_nomem(ctx);
+    }
+    catch (const std::system_error& e) {
+        sqlite3_result_error(ctx, e.what(), -1);
+        if (e.code().category() == sqlite3_category()) {
+            sqlite3_result_error_code(ctx, e.code().value());
+        }
+    }
+    catch (const std::exception& e) {
+        sqlite3_result_error(ctx, e.what(), -1);
+    }
+    catch (...) {
+        sqlite3_result_error(ctx, "unknown exception", -1);
+    }
+}
+
+// Calls f with argv converted to its parameter types and returns the result
+// to SQLite; a function returning void returns NULL.
+template<typename F, std::size_t... I>
+void call_with_values(sqlite3_context* ctx, F& f, sqlite3_value** argv, std::index_sequence<I...>)
+{
+    using traits = callable_traits<std::decay_t<F>>;
+    using args = typename traits::args_type;
+    if constexpr (std::is_void_v<typename traits::result_type>) {
+        f(from_sql_value<std::tuple_element_t<I, args>>(argv[I])...);
+    }
+    else {
+        set_result(ctx, f(from_sql_value<std::tuple_element_t<I, args>>(argv[I])...));
+    }
+}
+
+template<typename F>
+constexpr int arity_v = static_cast<int>(std::tuple_size_v<typename callable_traits<F>::args_type>);
+
+template<typename F>
+void scalar_function(sqlite3_context* ctx, int, sqlite3_value** argv) noexcept
+{
+    auto& f = *static_cast<F*>(sqlite3_user_data(ctx));
+    try {
+        call_with_values(ctx, f, argv, std::make_index_sequence<arity_v<F>>{});
+    }
+    catch (...) {
+        set_error_result(ctx);
+    }
+}
+
+template<typename T>
+void delete_object(void* object) noexcept
+{
+    delete static_cast<T*>(object);
+}
+
+template<typename State, std::size_t... I>
+void call_step(State& state, sqlite3_value** argv, std::index_sequence<I...>)
+{
+    using args = typename callable_traits<decltype(&State::step)>::args_type;
+    state.step(from_sql_value<std::tuple_element_t<I, args>>(argv[I])...);
+}
+
+// The aggregate context holds a pointer to the state, created on the first
+// step and deleted by the final call, which SQLite also makes when a
+// statement is reset before it is done.
+template<typename State>
+void aggregate_step(sqlite3_context* ctx, int, sqlite3_value** argv) noexcept
+{
+    auto slot = static_cast<State**>(sqlite3_aggregate_context(ctx, sizeof(State*)));
+    if (slot == nullptr) {
+        sqlite3_result_error_nomem(ctx);
+        return;
+    }
+    try {
+        if (*slot == nullptr) {
+            *slot = new State{};
+        }
+        call_step(**slot, argv, std::make_index_sequence<arity_v<decltype(&State::step)>>{});
+    }
+    catch (...) {
+        set_error_result(ctx);
+    }
+}
+
+template<typename State>
+void aggregate_final(sqlite3_context* ctx) noexcept
+{
+    // no allocation when no row was stepped
+    auto slot = static_cast<State**>(sqlite3_aggregate_context(ctx, 0));
+    std::unique_ptr<State> state{slot != nullptr ? *slot : nullptr};
+    try {
+        if (!state) {
+            state = std::make_unique<State>();
+        }
+        set_result(ctx, state->finish());
+    }
+    catch (...) {
+        set_error_result(ctx);
+    }
+}
+
+template<typename F>
+int collation_compare(void* compare, int a_size, const void* a, int b_size, const void* b) noexcept
+{
+    try {
+        auto result = (*static_cast<F*>(compare))(std::string_view{static_cast<const char*>(a), static_cast<std::size_t>(a_size)},
+                                                  std::string_view{static_cast<const char*>(b), static_cast<std::size_t>(b_size)});
+        return result < 0 ? -1 : result > 0 ? 1 : 0;
+    }
+    catch (...) {
+        // a collation cannot fail, so order the values as equal
+        return 0;
+    }
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_FUNCTION_IMPL_HPP
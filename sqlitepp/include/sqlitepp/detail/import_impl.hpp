@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_IMPORT_IMPL_HPP
+#define SQLITEPP_DETAIL_IMPORT_IMPL_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/csv_scanner.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+// Rows handed from the parser to the inserter. Fields point into the mapped
+// input, or into unescaped for quoted fields that had to be rewritten.
+struct import_batch
+{
+    std::vector<std::string_view> fields;
+    std::deque<std::string> unescaped;
+    std::size_t rows{0};
+
+    void clear() noexcept
+    {
+        fields.clear();
+        unescaped.clear();
+        rows = 0;
+    }
+};
+
+// Fixed ring of batches between one producer and one consumer. Batches are
+// reused, so their buffers are allocated only while the ring warms up.
+class import_ring
+{
+public:
+    explicit import_ring(std::size_t slots) : batches_(slots)
+    {
+    }
+
+    // Next batch to fill, or nullptr once the consumer gave up.
+    import_batch* producer_acquire()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        changed_.wait(lock, [this]() { return closed_ || full_ < batches_.size(); });
+        if (closed_) {
+            return nullptr;
+        }
+        auto& batch = batches_[(head_ + full_) % batches_.size()];
+        batch.clear();
+        return &batch;
+    }
+
+    void producer_publish()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            ++full_;
+        }
+        changed_.notify_all();
+    }
+
+    // Next batch to insert, or nullptr once the producer finished and all batches are consumed.
+    import_batch* consumer_acquire()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        changed_.wait(lock, [this]() { return full_ != 0 || finished_ || closed_; });
+        if (full_ == 0 || closed_) {
+            return nullptr;
+        }
+        return &batches_[head_];
+    }
+
+    void consumer_release()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            head_ = (head_ + 1) % batches_.size();
+            --full_;
+        }
+        changed_.notify_all();
+    }
+
+    void finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            finished_ = true;
+        }
+        changed_.notify_all();
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            closed_ = true;
+        }
+        changed_.notify_all();
+    }
+
+private:
+    std::vector<import_batch> batches_;
+    std::size_t head_{0};
+    std::size_t full_{0};
+    bool finished_{false};
+    bool closed_{false};
+    std::mutex mutex_;
+    std::condition_variable changed_;
+};
+
+// RFC 4180 records: fields separated by the delimiter, optionally quoted
+// with doubled quotes inside, records ending in LF or CRLF.
+class csv_parser
+{
+public:
+    csv_parser(std::string_view text, char delimiter, char quote) noexcept
+        : scanner_(text.data(), text.data() + text.size(), delimiter, quote), p_(text.data()), delimiter_(delimiter), quote_(quote)
+    {
+    }
+
+    bool at_end() noexcept
+    {
+        skip_blank_lines();
+        return p_ == scanner_.end();
+    }
+
+    // Appends the fields of the next record and returns their number.
+    std::size_t parse_record(import_batch& batch, std::error_code& ec)
+    {
+        auto end = scanner_.end();
+        std::size_t fields = 0;
+        for (;;) {
+            ++fields;
+            if (p_ < end && *p_ == quote_) {
+                const char* q = p_ + 1;
+                bool escaped = false;
+                for (;;) {
+                    q = scanner_.find(q);
+                    if (q == end) {
+                        // unterminated quoted field
+                        ec = sqlitepp_errc::invalid_argument;
+                        return fields;
+                    }
+                    if (*q != quote_) {
+                        ++q;
+                    }
+                    else if (q + 1 < end && q[1] == quote_) {
+                        escaped = true;
+                        q += 2;
+                    }
+                    else {
+                        break;
+                    }
+                }
+                std::string_view raw{p_ + 1, static_cast<std::size_t>(q - p_ - 1)};
+                batch.fields.push_back(escaped ? unescape(batch, raw) : raw);
+                p_ = q + 1;
+                if (p_ + 1 < end && p_[0] == '\r' && p_[1] == '\n') {
+                    ++p_;
+                }
+                if (p_ == end) {
+                    return fields;
+                }
+                if (*p_ == '\n') {
+                    ++p_;
+                    return fields;
+                }
+                if (*p_ != delimiter_) {
+                    // text between the closing quote and the delimiter
+                    ec = sqlitepp_errc::invalid_argument;
+                    return fields;
+                }
+                ++p_;
+                continue;
+            }
+
+            const char* s = scanner_.find(p_);
+            // quotes inside an unquoted field are literal
+            while (s != end && *s == quote_) {
+                s = scanner_.find(s + 1);
+            }
+            if (s == end || *s == '\n') {
+                auto last = s;
+                if (last != p_ && last[-1] == '\r') {
+                    --last;
+                }
+                batch.fields.emplace_back(p_, static_cast<std::size_t>(last - p_));
+                p_ = s == end ? end : s + 1;
+                return fields;
+            }
+            batch.fields.emplace_back(p_, static_cast<std::size_t>(s - p_));
+            p_ = s + 1;
+        }
+    }
+
+private:
+    csv_scanner scanner_;
+    const char* p_;
+    char delimiter_;
+    char quote_;
+
+    void skip_blank_lines() noexcept
+    {
+        auto end = scanner_.end();
+        for (;;) {
+            if (p_ < end && *p_ == '\n') {
+                ++p_;
+            }
+            else if (p_ + 1 < end && p_[0] == '\r' && p_[1] == '\n') {
+                p_ += 2;
+            }
+            else {
+                return;
+            }
+        }
+    }
+
+    std::string_view unescape(import_batch& batch, std::string_view raw) const
+    {
+        auto& text = batch.unescaped.emplace_back();
+        text.reserve(raw.size());
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            text += raw[i];
+            if (raw[i] == quote_) {
+                ++i;
+            }
+        }
+        return text;
+    }
+};
+
+// One JSON document per line; blank lines are skipped.
+class ndjson_parser
+{
+public:
+    explicit ndjson_parser(std::string_view text) noexcept : p_(text.data()), end_(text.data() + text.size())
+    {
+    }
+
+    bool at_end() noexcept
+    {
+        while (p_ < end_ && (*p_ == '\n' || *p_ == '\r' || *p_ == ' ' || *p_ == '\t')) {
+            ++p_;
+        }
+        return p_ == end_;
+    }
+
+    std::size_t parse_record(import_batch& batch, std::error_code&)
+    {
+        auto newline = static_cast<const char*>(std::memchr(p_, '\n', static_cast<std::size_t>(end_ - p_)));
+        auto last = newline != nullptr ? newline : end_;
+        if (last[-1] == '\r') {
+            --last;
+        }
+        batch.fields.emplace_back(p_, static_cast<std::size_t>(last - p_));
+        p_ = newline != nullptr ? newline + 1 : end_;
+        return 1;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+struct import_settings
+{
+    std::size_t batch_rows;
+    std::size_t batch_count;
+    std::size_t transaction_rows;
+};
+
+// Parses on a separate thread while the calling thread binds and inserts,
+// with the two handing batches over through a ring. Every record must have
+// columns fields. Returns the number of committed rows.
+template<typename Parser>
+std::size_t run_import(connection& conn, Parser& parser, const std::string& insert_sql, std::size_t columns, const import_settings& settings,
+                       std::error_code& ec) noexcept
+{
+    statement stmt{conn, insert_sql, ec};
+    if (ec) {
+        return 0;
+    }
+
+    std::size_t committed = 0;
+    std::error_code parse_ec;
+    try {
+        import_ring ring{std::max<std::size_t>(settings.batch_count, 2)};
+        std::thread producer{[&]() {
+            try {
+                while (!parse_ec && !parser.at_end()) {
+                    auto batch = ring.producer_acquire();
+                    if (batch == nullptr) {
+                        return;
+                    }
+                    while (!parse_ec && batch->rows < settings.batch_rows && !parser.at_end()) {
+                        if (parser.parse_record(*batch, parse_ec) != columns && !parse_ec) {
+                            parse_ec = sqlitepp_errc::invalid_argument;
+                        }
+                        ++batch->rows;
+                    }
+                    if (parse_ec) {
+                        // a partial record must not reach the inserter
+                        --batch->rows;
+                        batch->fields.resize(batch->rows * columns);
+                    }
+                    ring.producer_publish();
+                }
+            }
+            catch (const std::bad_alloc&) {
+                parse_ec.assign(SQLITE_NOMEM, sqlite3_category());
+            }
+            ring.finish();
+        }};
+
+        auto transaction_rows = std::max<std::size_t>(settings.transaction_rows, 1);
+        std::size_t pending = 0;
+        std::optional<transaction> tx;
+        for (auto batch = ring.consumer_acquire(); batch != nullptr && !ec; batch = ring.consumer_acquire()) {
+            if (!tx) {
+                tx.emplace(conn, transaction::mode::immediate, ec);
+            }
+            auto field = batch->fields.data();
+            for (std::size_t row = 0; !ec && row < batch->rows; ++row) {
+                for (std::size_t column = 0; !ec && column < columns; ++column, ++field) {
+                    stmt.bind_static(static_cast<int>(column + 1), *field, ec);
+                }
+                if (!ec) {
+                    stmt.step(ec);
+                }
+                if (!ec) {
+                    stmt.reset(ec);
+                }
+            }
+            pending += batch->rows;
+            ring.consumer_release();
+            if (ec) {
+                break;
+            }
+            if (pending >= transaction_rows) {
+                tx->commit(ec);
+                tx.reset();
+                if (!ec) {
+                    committed += pending;
+                    pending = 0;
+                }
+            }
+        }
+        if (tx && !ec && !parse_ec) {
+            tx->commit(ec);
+            if (!ec) {
+                committed += pending;
+            }
+        }
+        if (ec) {
+            std::error_code reset_ec;
+            stmt.reset(reset_ec);
+        }
+        ring.close();
+        producer.join();
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+    catch (const std::system_error& e) {
+        // no thread for the parser
+        ec = e.code();
+    }
+    if (!ec) {
+        ec = parse_ec;
+    }
+    return committed;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_IMPORT_IMPL_HPP
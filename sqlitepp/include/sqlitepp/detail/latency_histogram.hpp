@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_LATENCY_HISTOGRAM_HPP
+#define SQLITEPP_DETAIL_LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sqlitepp::detail
+{
+
+// Log-linear bucketing in the spirit of HDR histograms: values below 16 get
+// an exact bucket, larger values get 8 sub-buckets per power of two, which
+// bounds the relative error of a reported percentile to 12.5%.
+struct histogram_layout
+{
+    static constexpr std::size_t linear_buckets = 16;
+    static constexpr std::size_t sub_bucket_bits = 3;
+    static constexpr std::size_t sub_buckets = std::size_t{1} << sub_bucket_bits;
+    static constexpr std::size_t bucket_count = linear_buckets + (64 - 4) * sub_buckets;
+
+    static std::size_t bucket_of(std::uint64_t value) noexcept
+    {
+        if (value < linear_buckets) {
+            return static_cast<std::size_t>(value);
+        }
+        std::size_t exponent = 63 - count_leading_zeros(value);
+        std::size_t sub = static_cast<std::size_t>(value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+        return linear_buckets + (exponent - 4) * sub_buckets + sub;
+    }
+
+    static std::uint64_t lower_bound_of(std::size_t bucket) noexcept
+    {
+        if (bucket < linear_buckets) {
+            return bucket;
+        }
+        std::size_t exponent = (bucket - linear_buckets) / sub_buckets + 4;
+        std::uint64_t sub = (bucket - linear_buckets) % sub_buckets;
+        return (std::uint64_t{1} << exponent) | (sub << (exponent - sub_bucket_bits));
+    }
+
+    static std::uint64_t upper_bound_of(std::size_t bucket) noexcept
+    {
+        if (bucket + 1 >= bucket_count) {
+            return UINT64_MAX;
+        }
+        return lower_bound_of(bucket + 1) - 1;
+    }
+
+private:
+    static std::size_t count_leading_zeros(std::uint64_t value) noexcept
+    {
+#if defined(__GNUC__)
+        return static_cast<std::size_t>(__builtin_clzll(value));
+#else
+        std::size_t n = 0;
+        for (std::uint64_t mask = std::uint64_t{1} << 63; (value & mask) == 0; mask >>= 1) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+};
+
+// Histogram with a single writer and any number of concurrent readers. The
+// writer never performs a read-modify-write bus operation; readers observe
+// each bucket atomically but not the histogram as a whole.
+class single_writer_histogram
+{
+public:
+    void record(std::uint64_t value) noexcept
+    {
+        auto& bucket = buckets_[histogram_layout::bucket_of(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    template<typename Array>
+    void merge_into(Array& counts) const noexcept
+    {
+        for (std::size_t i = 0; i < histogram_layout::bucket_count; ++i) {
+            counts[i] += buckets_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, histogram_layout::bucket_count> buckets_{};
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_LATENCY_HISTOGRAM_HPP
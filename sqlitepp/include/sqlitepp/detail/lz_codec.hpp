@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_LZ_CODEC_HPP
+#define SQLITEPP_DETAIL_LZ_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace sqlitepp::detail
+{
+
+// A greedy compressor for the LZ4 block format, for inputs of up to 64 KiB
+// such as database pages: sequences of a token, literals, a 16-bit offset
+// and a match length, the last sequence holding literals only.
+class lz_codec
+{
+public:
+    static constexpr std::size_t max_input = 65536;
+
+    // The size of the compressed input in out, 0 when it does not fit in
+    // capacity or the input is too large.
+    std::size_t compress(const unsigned char* in, std::size_t n, unsigned char* out, std::size_t capacity) noexcept
+    {
+        if (n > max_input) {
+            return 0;
+        }
+        std::memset(table_, 0, sizeof(table_));
+        std::size_t op = 0;
+        std::size_t anchor = 0;
+        if (n >= min_input) {
+            // the format ends with 5 literals, and the last match starts 12 bytes before the end
+            const std::size_t match_limit = n - 5;
+            const std::size_t search_limit = n - 12;
+            std::size_t ip = 1;
+            table_[hash(read32(in))] = 0;
+            while (ip < search_limit) {
+                auto h = hash(read32(in + ip));
+                std::size_t ref = table_[h];
+                table_[h] = static_cast<std::uint16_t>(ip);
+                if (ref >= ip || read32(in + ref) != read32(in + ip)) {
+                    // skip faster through data that does not compress
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+                while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+                    --ip;
+                    --ref;
+                }
+                std::size_t length = 4;
+                while (ip + length < match_limit && in[ref + length] == in[ip + length]) {
+                    ++length;
+                }
+                if (!emit(in + anchor, ip - anchor, out, op, capacity) || !emit_match(ip - ref, length, out, op, capacity)) {
+                    return 0;
+                }
+                ip += length;
+                anchor = ip;
+                if (ip < search_limit) {
+                    table_[hash(read32(in + ip - 2))] = static_cast<std::uint16_t>(ip - 2);
+                }
+            }
+        }
+        if (!emit(in + anchor, n - anchor, out, op, capacity)) {
+            return 0;
+        }
+        return op;
+    }
+
+    // Decompresses exactly size bytes into out, false for input that is
+    // corrupt or of another size.
+    static bool decompress(const unsigned char* in, std::size_t n, unsigned char* out, std::size_t size) noexcept
+    {
+        std::size_t ip = 0;
+        std::size_t op = 0;
+        while (ip < n) {
+            auto token = in[ip++];
+            std::size_t literals = token >> 4;
+            if (literals == 15 && !read_length(in, n, ip, literals)) {
+                return false;
+            }
+            if (literals > n - ip || literals > size - op) {
+                return false;
+            }
+            std::memcpy(out + op, in + ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == n) {
+                break;
+            }
+            if (n - ip < 2) {
+                return false;
+            }
+            std::size_t offset = in[ip] | static_cast<std::size_t>(in[ip + 1]) << 8;
+            ip += 2;
+            std::size_t length = token & 15;
+            if (length == 15 && !read_length(in, n, ip, length)) {
+                return false;
+            }
+            length += 4;
+            if (offset == 0 || offset > op || length > size - op) {
+                return false;
+            }
+            // byte by byte, a match may overlap the bytes it produces
+            for (std::size_t i = 0; i < length; ++i, ++op) {
+                out[op] = out[op - offset];
+            }
+        }
+        return op == size;
+    }
+
+private:
+    static constexpr std::size_t min_input = 13;
+    static constexpr int hash_bits = 12;
+
+    std::uint16_t table_[1 << hash_bits];
+
+    static std::uint32_t read32(const unsigned char* p) noexcept
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static std::uint32_t hash(std::uint32_t v) noexcept
+    {
+        return (v * 2654435761u) >> (32 - hash_bits);
+    }
+
+    static bool read_length(const unsigned char* in, std::size_t n, std::size_t& ip, std::size_t& length) noexcept
+    {
+        unsigned char b;
+        do {
+            if (ip == n) {
+                return false;
+            }
+            b = in[ip++];
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+
+    static bool write_length(std::size_t length, unsigned char* out, std::size_t& op, std::size_t capacity) noexcept
+    {
+        for (; length >= 255; length -= 255) {
+            if (op == capacity) {
+                return false;
+            }
+            out[op++] = 255;
+        }
+        if (op == capacity) {
+            return false;
+        }
+        out[op++] = static_cast<unsigned char>(length);
+        return true;
+    }
+
+    // Writes the token and literals of a sequence, whose match, if any,
+    // emit_match adds to the token.
+    bool emit(const unsigned char* literals, std::size_t count, unsigned char* out, std::size_t& op, std::size_t capacity) noexcept
+    {
+        if (op == capacity) {
+            return false;
+        }
+        token_ = op;
+        out[op++] = static_cast<unsigned char>((count < 15 ? count : 15) << 4);
+        if (count >= 15 && !write_length(count - 15, out, op, capacity)) {
+            return false;
+        }
+        if (count > capacity - op) {
+            return false;
+        }
+        std::memcpy(out + op, literals, count);
+        op += count;
+        return true;
+    }
+
+    bool emit_match(std::size_t offset, std::size_t length, unsigned char* out, std::size_t& op, std::size_t capacity) noexcept
+    {
+        if (capacity - op < 2) {
+            return false;
+        }
+        out[op++] = static_cast<unsigned char>(offset);
+        out[op++] = static_cast<unsigned char>(offset >> 8);
+        length -= 4;
+        out[token_] |= static_cast<unsigned char>(length < 15 ? length : 15);
+        return length < 15 || write_length(length - 15, out, op, capacity);
+    }
+
+    std::size_t token_{0};
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_LZ_CODEC_HPP
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_MAPPED_FILE_HPP
+#define SQLITEPP_DETAIL_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sqlitepp::detail
+{
+
+// Read-only mapping of a whole file.
+class mapped_file
+{
+public:
+    mapped_file() noexcept = default;
+
+    ~mapped_file() noexcept
+    {
+        close();
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    void open(const std::string& path, std::error_code& ec) noexcept
+    {
+        close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            ec.assign(static_cast<int>(GetLastError()), std::system_category());
+            return;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            ec.assign(static_cast<int>(GetLastError()), std::system_category());
+            CloseHandle(file);
+            return;
+        }
+        if (size.QuadPart != 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping == nullptr) {
+                ec.assign(static_cast<int>(GetLastError()), std::system_category());
+                CloseHandle(file);
+                return;
+            }
+            data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (data_ == nullptr) {
+                ec.assign(static_cast<int>(GetLastError()), std::system_category());
+            }
+            // the view keeps the mapping alive
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        size_ = data_ != nullptr ? static_cast<std::size_t>(size.QuadPart) : 0;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            ec.assign(errno, std::system_category());
+            return;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ec.assign(errno, std::system_category());
+            ::close(fd);
+            return;
+        }
+        if (info.st_size != 0) {
+            void* data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ec.assign(errno, std::system_category());
+                ::close(fd);
+                return;
+            }
+            ::madvise(data, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+            size_ = static_cast<std::size_t>(info.st_size);
+        }
+        ::close(fd);
+#endif
+    }
+
+    void close() noexcept
+    {
+        if (data_ != nullptr) {
+#if defined(_WIN32)
+            UnmapViewOfFile(data_);
+#else
+            ::munmap(const_cast<char*>(data_), size_);
+#endif
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::string_view data() const noexcept
+    {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_{nullptr};
+    std::size_t size_{0};
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_MAPPED_FILE_HPP
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_MEMORY_PRESSURE_HPP
+#define SQLITEPP_DETAIL_MEMORY_PRESSURE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace sqlitepp::detail
+{
+
+// What the kernel reports about the memory of the cgroup of the process.
+struct memory_sample
+{
+    // share of the last 10 seconds some task stalled on memory, in percent
+    std::optional<double> pressure;
+    // bytes in use, of the cgroup or else the resident set of the process
+    std::optional<std::uint64_t> current;
+    // bytes the cgroup may use, none when unlimited
+    std::optional<std::uint64_t> limit;
+};
+
+inline std::optional<std::string> read_small_file(const std::string& path)
+{
+    std::ifstream in{path};
+    if (!in) {
+        return std::nullopt;
+    }
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+inline std::optional<std::uint64_t> parse_bytes(const std::optional<std::string>& text)
+{
+    if (!text || text->empty() || text->front() < '0' || text->front() > '9') {
+        // "max" for no limit
+        return std::nullopt;
+    }
+    return std::strtoull(text->c_str(), nullptr, 10);
+}
+
+// The avg10 of the "some" line of a PSI file such as memory.pressure.
+inline std::optional<double> parse_pressure(const std::optional<std::string>& text)
+{
+    if (!text) {
+        return std::nullopt;
+    }
+    std::string_view psi{*text};
+    if (psi.substr(0, 5) != "some ") {
+        return std::nullopt;
+    }
+    auto avg10 = psi.find("avg10=");
+    if (avg10 == std::string_view::npos || avg10 > psi.find('\n')) {
+        return std::nullopt;
+    }
+    return std::strtod(text->c_str() + avg10 + 6, nullptr);
+}
+
+inline std::optional<std::uint64_t> resident_set_size()
+{
+#if defined(__unix__)
+    // the second field of statm is the resident set in pages
+    auto statm = read_small_file("/proc/self/statm");
+    if (statm) {
+        auto resident = statm->find(' ');
+        if (resident != std::string::npos) {
+            return std::strtoull(statm->c_str() + resident + 1, nullptr, 10) * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+        }
+    }
+#endif
+    return std::nullopt;
+}
+
+// cgroup is the cgroup v2 directory of the process, usually /sys/fs/cgroup
+// inside a container.
+inline memory_sample sample_memory(const std::string& cgroup) noexcept
+{
+    memory_sample sample;
+    try {
+        sample.pressure = parse_pressure(read_small_file(cgroup + "/memory.pressure"));
+        sample.current = parse_bytes(read_small_file(cgroup + "/memory.current"));
+        if (!sample.current) {
+            sample.current = resident_set_size();
+        }
+        sample.limit = parse_bytes(read_small_file(cgroup + "/memory.max"));
+    }
+    catch (...) {
+        // no sample, no pressure
+    }
+    return sample;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_MEMORY_PRESSURE_HPP
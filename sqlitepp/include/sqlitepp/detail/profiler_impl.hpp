@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_PROFILER_IMPL_HPP
+#define SQLITEPP_DETAIL_PROFILER_IMPL_HPP
+
+#include <sqlitepp/detail/cycle_clock.hpp>
+#include <sqlitepp/detail/latency_histogram.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+class profiler_impl
+{
+public:
+    struct entry
+    {
+        explicit entry(std::string_view text) : sql(text)
+        {
+        }
+
+        void record(std::uint64_t elapsed_ticks, std::uint64_t rows_returned) noexcept
+        {
+            // single writer: plain load/store pairs instead of locked read-modify-write
+            calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            rows.store(rows.load(std::memory_order_relaxed) + rows_returned, std::memory_order_relaxed);
+            total_ticks.store(total_ticks.load(std::memory_order_relaxed) + elapsed_ticks, std::memory_order_relaxed);
+            if (elapsed_ticks < min_ticks.load(std::memory_order_relaxed)) {
+                min_ticks.store(elapsed_ticks, std::memory_order_relaxed);
+            }
+            if (elapsed_ticks > max_ticks.load(std::memory_order_relaxed)) {
+                max_ticks.store(elapsed_ticks, std::memory_order_relaxed);
+            }
+            histogram.record(elapsed_ticks);
+        }
+
+        const std::string sql;
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> rows{0};
+        std::atomic<std::uint64_t> total_ticks{0};
+        std::atomic<std::uint64_t> min_ticks{UINT64_MAX};
+        std::atomic<std::uint64_t> max_ticks{0};
+        single_writer_histogram histogram;
+    };
+
+    template<typename Visitor>
+    void visit(Visitor&& visitor) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (const auto& s : shards_) {
+            std::lock_guard<std::mutex> shard_lock{s->mutex};
+            for (const auto& [sql, e] : s->entries) {
+                visitor(*e);
+            }
+        }
+    }
+
+    double nanoseconds_per_tick() const noexcept
+    {
+        return calibration_.nanoseconds_per_tick();
+    }
+
+    static int trace_mask() noexcept
+    {
+        // SQLITE_TRACE_STMT supplies the start time: the elapsed time reported
+        // with SQLITE_TRACE_PROFILE has only millisecond resolution on most VFSes.
+        return SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW;
+    }
+
+    static int on_trace(unsigned type, void* context, void* p, void* x) noexcept
+    {
+        try {
+            auto self = static_cast<profiler_impl*>(context);
+            auto stmt = static_cast<sqlite3_stmt*>(p);
+            switch (type) {
+            case SQLITE_TRACE_STMT:
+                self->on_stmt(stmt, static_cast<const char*>(x));
+                break;
+            case SQLITE_TRACE_ROW:
+                self->on_row(stmt);
+                break;
+            case SQLITE_TRACE_PROFILE:
+                self->on_profile(stmt, *static_cast<const sqlite3_int64*>(x));
+                break;
+            default:
+                break;
+            }
+        }
+        catch (...) {
+            // drop the sample rather than unwind through SQLite
+        }
+        return 0;
+    }
+
+private:
+    struct statement_slot
+    {
+        // the SQL text target was found for; a finalized statement's address may be reused
+        std::string text;
+        entry* target;
+        std::uint64_t start;
+        std::uint64_t rows;
+        bool running;
+    };
+
+    struct shard
+    {
+        std::thread::id owner;
+        // taken by the owning thread only to insert entries, and by snapshots
+        mutable std::mutex mutex;
+        std::unordered_map<std::string_view, std::unique_ptr<entry>> entries;
+        // keyed by statement so that the SQL text is normalized and hashed only the first time a statement runs
+        std::unordered_map<sqlite3_stmt*, statement_slot> statements;
+        sqlite3_stmt* last_stmt{nullptr};
+        statement_slot* last_slot{nullptr};
+    };
+
+    struct shard_cache_slot
+    {
+        std::uint64_t owner_id;
+        shard* cached;
+    };
+
+    inline static std::atomic<std::uint64_t> next_id_{1};
+
+    const std::uint64_t id_{next_id_.fetch_add(1, std::memory_order_relaxed)};
+    const cycle_calibration calibration_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<shard>> shards_;
+
+    static constexpr std::size_t max_tracked_statements = 1024;
+
+    void on_stmt(sqlite3_stmt* stmt, const char* text)
+    {
+        if (text != nullptr && text[0] == '-' && text[1] == '-') {
+            // trigger sub-program of a statement that is already running
+            return;
+        }
+        auto& s = local_shard();
+        auto slot = find_slot(s, stmt);
+        if (slot == nullptr) {
+            if (s.statements.size() >= max_tracked_statements) {
+                forget_finished(s);
+            }
+            slot = &s.statements[stmt];
+            slot->target = nullptr;
+            s.last_stmt = stmt;
+            s.last_slot = slot;
+        }
+        const char* raw = sqlite3_sql(stmt);
+        std::string_view sql = raw != nullptr ? std::string_view{raw} : std::string_view{};
+        if (slot->target == nullptr || slot->text != sql) {
+            slot->target = &entry_for(s, stmt);
+            slot->text.assign(sql);
+        }
+        slot->rows = 0;
+        slot->running = true;
+        slot->start = cycle_clock::now();
+    }
+
+    void on_row(sqlite3_stmt* stmt)
+    {
+        auto slot = find_slot(local_shard(), stmt);
+        if (slot != nullptr && slot->running) {
+            ++slot->rows;
+        }
+    }
+
+    void on_profile(sqlite3_stmt* stmt, sqlite3_int64 sqlite_elapsed_ns)
+    {
+        auto now = cycle_clock::now();
+        auto& s = local_shard();
+        auto slot = find_slot(s, stmt);
+        if (slot != nullptr && slot->running) {
+            slot->target->record(now - slot->start, slot->rows);
+            slot->running = false;
+        }
+        else {
+            // started on another thread or before the profiler was attached
+            auto elapsed = static_cast<double>(std::max<sqlite3_int64>(sqlite_elapsed_ns, 0)) / calibration_.nanoseconds_per_tick();
+            entry_for(s, stmt).record(static_cast<std::uint64_t>(elapsed), 0);
+        }
+    }
+
+    static statement_slot* find_slot(shard& s, sqlite3_stmt* stmt) noexcept
+    {
+        if (s.last_stmt == stmt) {
+            return s.last_slot;
+        }
+        auto it = s.statements.find(stmt);
+        if (it == s.statements.end()) {
+            return nullptr;
+        }
+        s.last_stmt = stmt;
+        s.last_slot = &it->second;
+        return s.last_slot;
+    }
+
+    // Drops the statements that are not running, which includes the
+    // finalized ones, so that the slots stay bounded.
+    static void forget_finished(shard& s) noexcept
+    {
+        for (auto it = s.statements.begin(); it != s.statements.end();) {
+            it = it->second.running ? std::next(it) : s.statements.erase(it);
+        }
+        s.last_stmt = nullptr;
+        s.last_slot = nullptr;
+    }
+
+    static entry& entry_for(shard& s, sqlite3_stmt* stmt)
+    {
+#if defined(SQLITE_ENABLE_NORMALIZE)
+        const char* text = sqlite3_normalized_sql(stmt);
+        return find_or_insert(s, text != nullptr ? std::string_view{text} : std::string_view{});
+#else
+        // SQLite only normalizes when built with SQLITE_ENABLE_NORMALIZE
+        const char* text = sqlite3_sql(stmt);
+        return find_or_insert(s, normalize_sql(text != nullptr ? std::string_view{text} : std::string_view{}));
+#endif
+    }
+
+    static entry& find_or_insert(shard& s, std::string_view sql)
+    {
+        // only the owning thread inserts, so it may look up without the lock
+        auto it = s.entries.find(sql);
+        if (it != s.entries.end()) {
+            return *it->second;
+        }
+        auto created = std::make_unique<entry>(sql);
+        std::string_view key{created->sql};
+        std::lock_guard<std::mutex> lock{s.mutex};
+        return *s.entries.emplace(key, std::move(created)).first->second;
+    }
+
+    shard& local_shard()
+    {
+        static thread_local std::array<shard_cache_slot, 4> cache{};
+        static thread_local std::size_t victim = 0;
+
+        for (const auto& slot : cache) {
+            if (slot.owner_id == id_) {
+                return *slot.cached;
+            }
+        }
+
+        shard* found = nullptr;
+        auto owner = std::this_thread::get_id();
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (const auto& s : shards_) {
+                if (s->owner == owner) {
+                    found = s.get();
+                    break;
+                }
+            }
+            if (found == nullptr) {
+                shards_.push_back(std::make_unique<shard>());
+                found = shards_.back().get();
+                found->owner = owner;
+            }
+        }
+        cache[victim] = shard_cache_slot{id_, found};
+        victim = (victim + 1) % cache.size();
+        return *found;
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_PROFILER_IMPL_HPP
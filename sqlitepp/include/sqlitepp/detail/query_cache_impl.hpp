@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_QUERY_CACHE_IMPL_HPP
+#define SQLITEPP_DETAIL_QUERY_CACHE_IMPL_HPP
+
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/statement_impl.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+template<typename T>
+void append_key_bytes(std::string& key, const T& value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    key.append(bytes, sizeof(T));
+}
+
+inline void append_key_span(std::string& key, char tag, const void* data, std::size_t size)
+{
+    key += tag;
+    append_key_bytes(key, size);
+    key.append(static_cast<const char*>(data), size);
+}
+
+// Appends a bound value to a cache key. Values are tagged with the type they
+// are bound as, so that 1, 1.0 and '1' make different keys.
+template<typename T>
+void append_key_value(std::string& key, const T& value)
+{
+    if constexpr (std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, std::nullopt_t>) {
+        key += 'n';
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        key += 'i';
+        append_key_bytes(key, static_cast<std::int64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        key += 'r';
+        append_key_bytes(key, static_cast<double>(value));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        std::string_view text{value};
+        append_key_span(key, 't', text.data(), text.size());
+    }
+    else if constexpr (std::is_same_v<T, blob_view>) {
+        append_key_span(key, 'b', value.data, value.size);
+    }
+    else if constexpr (is_byte_container<T>::value) {
+        append_key_span(key, 'b', value.data(), value.size());
+    }
+    else if constexpr (is_optional<T>::value) {
+        if (value) {
+            append_key_value(key, *value);
+        }
+        else {
+            key += 'n';
+        }
+    }
+    else {
+        static_assert(always_false_v<T>, "no SQLite binding for this type");
+    }
+}
+
+// The tables a query reads, each as the schema name and the table name
+// separated by a NUL character, which is how the update hook names them.
+struct query_dependencies
+{
+    std::vector<std::string> tables;
+    // false for statements that write or read virtual tables, whose changes
+    // the update hook does not report
+    bool cacheable{false};
+};
+
+// Finds the tables a prepared statement reads from its bytecode. Every
+// OpenRead and ReopenIdx opens the b-tree at a root page of a schema, which
+// sqlite_schema maps to a table; views are already expanded there.
+inline query_dependencies resolve_query_dependencies(conn_handle_t db, stmt_handle_t stmt, std::error_code& ec)
+{
+    query_dependencies deps;
+    ec.clear();
+    if (sqlite3_stmt_readonly(stmt) == 0) {
+        return deps;
+    }
+
+    std::vector<std::pair<int, std::int64_t>> roots;
+    {
+        statement_impl explain;
+        explain.prepare(db, std::string{"EXPLAIN "} + sqlite3_sql(stmt), 0, ec);
+        while (!ec && explain.step(ec)) {
+            auto opcode = explain.column_text(1);
+            if (opcode == "VOpen") {
+                return deps;
+            }
+            if (opcode == "OpenRead" || opcode == "ReopenIdx") {
+                roots.emplace_back(static_cast<int>(explain.column_int64(4)), explain.column_int64(3));
+            }
+        }
+        if (ec) {
+            return deps;
+        }
+    }
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+    statement_impl databases;
+    databases.prepare(db, "SELECT seq, name FROM pragma_database_list", 0, ec);
+    std::vector<std::pair<int, std::string>> schemas;
+    while (!ec && databases.step(ec)) {
+        schemas.emplace_back(static_cast<int>(databases.column_int64(0)), databases.column_text(1));
+    }
+    if (ec) {
+        return deps;
+    }
+
+    for (auto [schema, root] : roots) {
+        if (root == 1) {
+            // sqlite_schema itself, covered by the schema version
+            continue;
+        }
+        auto it = std::find_if(schemas.begin(), schemas.end(), [schema = schema](const auto& s) { return s.first == schema; });
+        if (it == schemas.end()) {
+            return deps;
+        }
+        std::string sql{"SELECT tbl_name FROM "};
+        append_identifier(sql, it->second);
+        sql += ".sqlite_schema WHERE rootpage = ?1";
+        statement_impl lookup;
+        lookup.prepare(db, sql, 0, ec);
+        if (!ec) {
+            lookup.bind(1, root, ec);
+        }
+        if (ec || !lookup.step(ec)) {
+            // a b-tree that is not in the schema, e.g. of a table dropped meanwhile
+            return deps;
+        }
+        std::string table = it->second;
+        table += '\0';
+        table += lookup.column_text(0);
+        if (std::find(deps.tables.begin(), deps.tables.end(), table) == deps.tables.end()) {
+            deps.tables.push_back(std::move(table));
+        }
+    }
+    deps.cacheable = true;
+    return deps;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_QUERY_CACHE_IMPL_HPP
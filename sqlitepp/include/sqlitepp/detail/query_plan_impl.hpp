@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_QUERY_PLAN_IMPL_HPP
+#define SQLITEPP_DETAIL_QUERY_PLAN_IMPL_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/statement_impl.hpp>
+#include <sqlitepp/query_plan.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+struct plan_row
+{
+    int id;
+    int parent;
+    std::string detail;
+};
+
+// Rows come parents first, so the children of parent follow it in order.
+inline std::vector<plan_node> plan_children(const std::vector<plan_row>& rows, int parent)
+{
+    std::vector<plan_node> nodes;
+    for (auto& row : rows) {
+        if (row.parent == parent) {
+            nodes.push_back({row.id, row.parent, row.detail, plan_children(rows, row.id)});
+        }
+    }
+    return nodes;
+}
+
+// Runs EXPLAIN QUERY PLAN on the SQL text of stmt, on its connection.
+inline query_plan read_query_plan(stmt_handle_t stmt, std::error_code& ec) noexcept
+{
+    query_plan plan;
+    if (stmt == nullptr) {
+        ec = sqlitepp_errc::invalid_handle;
+        return plan;
+    }
+    try {
+        std::string sql{"EXPLAIN QUERY PLAN "};
+        sql += sqlite3_sql(stmt);
+        statement_impl explain;
+        explain.prepare(sqlite3_db_handle(stmt), sql, 0, ec);
+        std::vector<plan_row> rows;
+        while (!ec && explain.step(ec)) {
+            rows.push_back({static_cast<int>(explain.column_int64(0)), static_cast<int>(explain.column_int64(1)), std::string{explain.column_text(3)}});
+        }
+        if (!ec) {
+            plan.nodes = plan_children(rows, 0);
+        }
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+    return plan;
+}
+
+// Reports every full scan of stmt to the installed full_scan_handler.
+inline void check_indexed(stmt_handle_t stmt, std::error_code& ec) noexcept
+{
+    ec.clear();
+    auto handler = installed_full_scan_handler.load();
+    if (handler == nullptr) {
+        return;
+    }
+    auto plan = read_query_plan(stmt, ec);
+    if (ec) {
+        return;
+    }
+    try {
+        for (auto node : plan.full_scans()) {
+            handler(sqlite3_sql(stmt), node->detail);
+        }
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+}
+
+#if defined(SQLITEPP_ENABLE_STMT_SCANSTATUS)
+
+inline std::vector<scan_loop> read_scan_status(stmt_handle_t stmt, std::error_code& ec) noexcept
+{
+    std::vector<scan_loop> loops;
+    if (stmt == nullptr) {
+        ec = sqlitepp_errc::invalid_handle;
+        return loops;
+    }
+    try {
+        sqlite3_int64 nloop = 0;
+        // a loop index past the last one returns non-zero
+        for (int i = 0; sqlite3_stmt_scanstatus(stmt, i, SQLITE_SCANSTAT_NLOOP, &nloop) == 0; ++i) {
+            scan_loop loop;
+            loop.loops = nloop;
+            sqlite3_int64 visited = 0;
+            sqlite3_stmt_scanstatus(stmt, i, SQLITE_SCANSTAT_NVISIT, &visited);
+            loop.visited = visited;
+            sqlite3_stmt_scanstatus(stmt, i, SQLITE_SCANSTAT_EST, &loop.estimated);
+            const char* text = nullptr;
+            if (sqlite3_stmt_scanstatus(stmt, i, SQLITE_SCANSTAT_NAME, &text) == 0 && text != nullptr) {
+                loop.name = text;
+            }
+            text = nullptr;
+            if (sqlite3_stmt_scanstatus(stmt, i, SQLITE_SCANSTAT_EXPLAIN, &text) == 0 && text != nullptr) {
+                loop.explain = text;
+            }
+            sqlite3_stmt_scanstatus(stmt, i, SQLITE_SCANSTAT_SELECTID, &loop.select_id);
+            loops.push_back(std::move(loop));
+        }
+        ec.clear();
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+    return loops;
+}
+
+#endif
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_QUERY_PLAN_IMPL_HPP
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_SCRIPT_IMPL_HPP
+#define SQLITEPP_DETAIL_SCRIPT_IMPL_HPP
+
+#include <sqlitepp/detail/deadline_guard.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/script.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <system_error>
+
+namespace sqlitepp::detail
+{
+
+// The first character of the statement in [begin, end), after whitespace
+// and comments.
+inline const char* skip_space(const char* begin, const char* end) noexcept
+{
+    std::string_view text{begin, static_cast<std::size_t>(end - begin)};
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r' || text[i] == '\f') {
+            ++i;
+        }
+        else if (text.substr(i, 2) == "--") {
+            i = text.find('\n', i);
+        }
+        else if (text.substr(i, 2) == "/*") {
+            auto close = text.find("*/", i + 2);
+            i = close == std::string_view::npos ? close : close + 2;
+        }
+        else {
+            break;
+        }
+    }
+    return begin + std::min(i, text.size());
+}
+
+// Prepares and steps the statements of sql one after the other, straight
+// from the caller's text through the tail pointer, without copying it and
+// without reading the rows they return. deadline is the guard of the
+// connection, or null.
+inline void run_script(conn_handle_t db, const deadline_guard* deadline, std::string_view sql, const script_options& options, script_result& result, std::error_code& ec) noexcept
+{
+    ec.clear();
+    if (db == nullptr) {
+        ec = sqlitepp_errc::invalid_handle;
+        return;
+    }
+    if (sql.size() > static_cast<std::size_t>(INT_MAX)) {
+        ec = sqlitepp_errc::invalid_argument;
+        return;
+    }
+    auto fail = [&](const char* at) {
+        result.error_statement = result.statements;
+        result.error_offset = static_cast<std::size_t>(at - sql.data());
+    };
+
+    const char* head = sql.data();
+    const char* end = sql.data() + sql.size();
+    while (head < end) {
+        auto start = std::chrono::steady_clock::now();
+        stmt_handle_t stmt = nullptr;
+        const char* tail = nullptr;
+        int rc = sqlite3_prepare_v3(db, head, static_cast<int>(end - head), 0, &stmt, &tail);
+        if (rc != SQLITE_OK) {
+            ec.assign(rc, sqlite3_category());
+            int token = sqlite3_error_offset(db);
+            fail(token >= 0 ? head + token : skip_space(head, end));
+            return;
+        }
+        if (stmt == nullptr) {
+            if (tail == head) {
+                break;
+            }
+            // an empty statement, or only whitespace and comments were left
+            head = tail;
+            continue;
+        }
+        auto statement_start = skip_space(head, tail);
+        do {
+            rc = step_before_deadline(stmt, deadline);
+        } while (rc == SQLITE_ROW);
+        if (rc != SQLITE_DONE) {
+            assign_step_error(stmt, rc, ec);
+            sqlite3_finalize(stmt);
+            fail(statement_start);
+            return;
+        }
+        sqlite3_finalize(stmt);
+        if (options.timed) {
+            try {
+                result.timings.push_back({static_cast<std::size_t>(statement_start - sql.data()), static_cast<std::size_t>(tail - statement_start),
+                                          std::chrono::steady_clock::now() - start});
+            }
+            catch (const std::bad_alloc&) {
+                ec.assign(SQLITE_NOMEM, sqlite3_category());
+                return;
+            }
+        }
+        ++result.statements;
+        head = tail;
+    }
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_SCRIPT_IMPL_HPP
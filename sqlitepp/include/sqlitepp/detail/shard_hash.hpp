@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_SHARD_HASH_HPP
+#define SQLITEPP_DETAIL_SHARD_HASH_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace sqlitepp::detail
+{
+
+// Maps a key hash to one of n buckets so that growing from n to n + 1
+// buckets moves only the keys that land in the new one (Lamping and Veach).
+inline std::size_t jump_consistent_hash(std::uint64_t key, std::size_t buckets) noexcept
+{
+    std::int64_t b = -1;
+    std::int64_t j = 0;
+    while (j < static_cast<std::int64_t>(buckets)) {
+        b = j;
+        key = key * 2862933555777941757ULL + 1;
+        j = static_cast<std::int64_t>(static_cast<double>(b + 1) * (static_cast<double>(1LL << 31) / static_cast<double>((key >> 33) + 1)));
+    }
+    return static_cast<std::size_t>(b);
+}
+
+// The bytes an integer key is hashed as, the same on every platform.
+struct integer_key
+{
+    char bytes[8];
+
+    explicit integer_key(std::int64_t key) noexcept
+    {
+        auto value = static_cast<std::uint64_t>(key);
+        for (auto& byte : bytes) {
+            byte = static_cast<char>(value & 0xff);
+            value >>= 8;
+        }
+    }
+
+    std::string_view view() const noexcept
+    {
+        return {bytes, sizeof(bytes)};
+    }
+};
+
+// The state of the SQL function that routes keys during a rebalance.
+struct shard_routing
+{
+    const std::function<std::uint64_t(std::string_view)>* hash;
+    std::size_t shards;
+};
+
+// sqlitepp_shard_of(key): the shard a key belongs to, hashed exactly as
+// shard_set::shard_index hashes it.
+inline void shard_of_function(sqlite3_context* ctx, int, sqlite3_value** argv) noexcept
+{
+    auto& routing = *static_cast<const shard_routing*>(sqlite3_user_data(ctx));
+    std::string_view key;
+    integer_key integer{0};
+    switch (sqlite3_value_type(argv[0])) {
+    case SQLITE_INTEGER:
+        integer = integer_key{sqlite3_value_int64(argv[0])};
+        key = integer.view();
+        break;
+    case SQLITE_TEXT: {
+        auto text = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+        key = {text, static_cast<std::size_t>(sqlite3_value_bytes(argv[0]))};
+        break;
+    }
+    case SQLITE_BLOB: {
+        auto blob = static_cast<const char*>(sqlite3_value_blob(argv[0]));
+        key = {blob, static_cast<std::size_t>(sqlite3_value_bytes(argv[0]))};
+        break;
+    }
+    default:
+        sqlite3_result_error(ctx, "shard keys must be integers, text or blobs", -1);
+        return;
+    }
+    try {
+        sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(jump_consistent_hash((*routing.hash)(key), routing.shards)));
+    }
+    catch (...) {
+        sqlite3_result_error(ctx, "shard hash failed", -1);
+    }
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_SHARD_HASH_HPP
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_SQL_PARAMETERS_HPP
+#define SQLITEPP_DETAIL_SQL_PARAMETERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace sqlitepp::detail
+{
+
+// Placeholders of the first statement in a SQL text, numbered the way
+// sqlite3_prepare numbers them: ?NNN takes index NNN, while a bare ? and
+// the first use of a :name, @name or $name take the largest index so far
+// plus one. Literals, quoted identifiers and comments are skipped. Usable in
+// constant expressions.
+struct sql_parameters
+{
+    static constexpr std::size_t max_names = 64;
+
+    struct named
+    {
+        std::string_view name;
+        int index;
+    };
+
+    int count{0};
+    std::size_t named_count{0};
+    std::array<named, max_names> names{};
+    // false for SQL that SQLite would reject, e.g. an unterminated literal
+    bool valid{true};
+
+    constexpr int index_of(std::string_view name) const noexcept
+    {
+        for (std::size_t i = 0; i < named_count; ++i) {
+            if (names[i].name == name) {
+                return names[i].index;
+            }
+        }
+        return 0;
+    }
+};
+
+constexpr bool is_sql_identifier_char(char c) noexcept
+{
+    // bytes of UTF-8 sequences are identifier characters to SQLite
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+constexpr bool is_sql_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr sql_parameters parse_sql_parameters(std::string_view sql) noexcept
+{
+    sql_parameters result;
+    std::size_t i = 0;
+    auto n = sql.size();
+    auto skip_quoted = [&](char close) {
+        // doubled closing characters are escapes, except for ]
+        for (++i; i < n; ++i) {
+            if (sql[i] == close) {
+                if (close != ']' && i + 1 < n && sql[i + 1] == close) {
+                    ++i;
+                    continue;
+                }
+                ++i;
+                return;
+            }
+        }
+        result.valid = false;
+    };
+
+    while (i < n) {
+        char c = sql[i];
+        if (c == '\'' || c == '"' || c == '`') {
+            skip_quoted(c);
+        }
+        else if (c == '[') {
+            skip_quoted(']');
+        }
+        else if (c == '-' && i + 1 < n && sql[i + 1] == '-') {
+            while (i < n && sql[i] != '\n') {
+                ++i;
+            }
+        }
+        else if (c == '/' && i + 1 < n && sql[i + 1] == '*') {
+            auto end = sql.find("*/", i + 2);
+            // an unterminated block comment runs to the end, as in SQLite
+            i = end == std::string_view::npos ? n : end + 2;
+        }
+        else if (c == ';') {
+            break;
+        }
+        else if (c == '?') {
+            ++i;
+            if (i < n && is_sql_digit(sql[i])) {
+                int index = 0;
+                while (i < n && is_sql_digit(sql[i])) {
+                    index = index * 10 + (sql[i] - '0');
+                    if (index > 32766) {
+                        result.valid = false;
+                        return result;
+                    }
+                    ++i;
+                }
+                if (index == 0) {
+                    result.valid = false;
+                }
+                result.count = index > result.count ? index : result.count;
+            }
+            else {
+                ++result.count;
+            }
+        }
+        else if (c == ':' || c == '@' || c == '$') {
+            auto start = i++;
+            while (i < n) {
+                if (is_sql_identifier_char(sql[i])) {
+                    ++i;
+                }
+                else if (c == '$' && sql[i] == ':' && i + 1 < n && sql[i + 1] == ':') {
+                    // TCL namespace separator
+                    i += 2;
+                }
+                else {
+                    break;
+                }
+            }
+            if (i == start + 1) {
+                result.valid = false;
+                continue;
+            }
+            auto name = sql.substr(start, i - start);
+            if (result.index_of(name) == 0) {
+                if (result.named_count == sql_parameters::max_names) {
+                    result.valid = false;
+                    return result;
+                }
+                result.names[result.named_count++] = {name, ++result.count};
+            }
+        }
+        else if (is_sql_identifier_char(c)) {
+            // keeps a $ inside an identifier from starting a parameter
+            while (i < n && is_sql_identifier_char(sql[i])) {
+                ++i;
+            }
+        }
+        else {
+            ++i;
+        }
+    }
+    return result;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_SQL_PARAMETERS_HPP
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_SQL_TEXT_HPP
+#define SQLITEPP_DETAIL_SQL_TEXT_HPP
+
+#include <string>
+#include <string_view>
+
+namespace sqlitepp::detail
+{
+
+// Appends name as a double-quoted SQL identifier.
+inline void append_identifier(std::string& sql, std::string_view name)
+{
+    sql += '"';
+    for (char c : name) {
+        sql += c;
+        if (c == '"') {
+            sql += '"';
+        }
+    }
+    sql += '"';
+}
+
+// Appends text as a single-quoted SQL string literal.
+inline void append_literal(std::string& sql, std::string_view text)
+{
+    sql += '\'';
+    for (char c : text) {
+        sql += c;
+        if (c == '\'') {
+            sql += '\'';
+        }
+    }
+    sql += '\'';
+}
+
+inline bool is_identifier_char(char c) noexcept
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Returns sql with literals and parameters replaced by ?, comments removed and
+// runs of whitespace collapsed to one space, so statements that differ only
+// in their values compare equal. Keywords and identifiers keep their case.
+inline std::string normalize_sql(std::string_view sql)
+{
+    std::string normalized;
+    normalized.reserve(sql.size());
+    bool space = false;
+    auto emit = [&normalized, &space](std::string_view token) {
+        if (space && !normalized.empty()) {
+            normalized += ' ';
+        }
+        space = false;
+        normalized += token;
+    };
+    // the end of the quoted token starting at i, with the quote doubled to escape it
+    auto quoted_end = [sql](std::size_t i, char close) {
+        for (++i; i < sql.size(); ++i) {
+            if (sql[i] == close) {
+                if (i + 1 < sql.size() && sql[i + 1] == close && close != ']') {
+                    ++i;
+                    continue;
+                }
+                return i + 1;
+            }
+        }
+        return sql.size();
+    };
+
+    std::size_t i = 0;
+    while (i < sql.size()) {
+        char c = sql[i];
+        char next = i + 1 < sql.size() ? sql[i + 1] : '\0';
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') {
+            space = true;
+            ++i;
+        }
+        else if (c == '-' && next == '-') {
+            auto end = sql.find('\n', i);
+            i = end != std::string_view::npos ? end : sql.size();
+            space = true;
+        }
+        else if (c == '/' && next == '*') {
+            auto end = sql.find("*/", i + 2);
+            i = end != std::string_view::npos ? end + 2 : sql.size();
+            space = true;
+        }
+        else if (c == '\'') {
+            emit("?");
+            i = quoted_end(i, '\'');
+        }
+        else if (c == '"' || c == '`' || c == '[') {
+            auto end = quoted_end(i, c == '[' ? ']' : c);
+            emit(sql.substr(i, end - i));
+            i = end;
+        }
+        else if ((c == 'x' || c == 'X') && next == '\'') {
+            emit("?");
+            i = quoted_end(i + 1, '\'');
+        }
+        else if ((c >= '0' && c <= '9') || (c == '.' && next >= '0' && next <= '9')) {
+            emit("?");
+            bool hex = c == '0' && (next == 'x' || next == 'X');
+            for (++i; i < sql.size(); ++i) {
+                bool exponent_sign = !hex && (sql[i] == '+' || sql[i] == '-') && (sql[i - 1] == 'e' || sql[i - 1] == 'E');
+                if (!is_identifier_char(sql[i]) && sql[i] != '.' && !exponent_sign) {
+                    break;
+                }
+            }
+        }
+        else if (c == '?' || ((c == ':' || c == '@' || c == '$') && is_identifier_char(next))) {
+            emit("?");
+            for (++i; i < sql.size() && is_identifier_char(sql[i]); ++i) {
+            }
+        }
+        else if (is_identifier_char(c)) {
+            auto start = i;
+            for (++i; i < sql.size() && is_identifier_char(sql[i]); ++i) {
+            }
+            emit(sql.substr(start, i - start));
+        }
+        else {
+            emit(sql.substr(i, 1));
+            ++i;
+        }
+    }
+    return normalized;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_SQL_TEXT_HPP
@@ -26,6 +26,8 @@ public:
             return "Invalid handle";
         case sqlitepp_errc::invalid_argument:
             return "Invalid argument";
+        case sqlitepp_errc::deadline_exceeded:
+            return "Deadline exceeded";
         }
         return "Unknown error";
     }
@@ -0,0 +1,495 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_STATEMENT_IMPL_HPP
+#define SQLITEPP_DETAIL_STATEMENT_IMPL_HPP
+
+#include <sqlitepp/detail/aggregate.hpp>
+#include <sqlitepp/detail/deadline_guard.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+#include <sqlitepp/value.hpp>
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+template<typename T>
+struct is_optional : std::false_type
+{
+};
+
+template<typename T>
+struct is_optional<std::optional<T>> : std::true_type
+{
+};
+
+template<typename T, typename = void>
+struct is_byte_container : std::false_type
+{
+};
+
+template<typename T>
+struct is_byte_container<T, std::void_t<decltype(std::declval<const T&>().data()), decltype(std::declval<const T&>().size()), typename T::value_type>>
+    : std::disjunction<std::is_same<typename T::value_type, std::byte>, std::is_same<typename T::value_type, unsigned char>>
+{
+};
+
+template<typename T>
+inline constexpr bool always_false_v = false;
+
+class statement_impl
+{
+public:
+    statement_impl() = default;
+
+    ~statement_impl() noexcept
+    {
+        finalize();
+    }
+
+    void prepare(conn_handle_t db, std::string_view sql, unsigned int flags, std::error_code& ec) noexcept
+    {
+        finalize();
+        if (db == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        if (sql.size() > static_cast<std::size_t>(INT_MAX)) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        int rc = sqlite3_prepare_v3(db, sql.data(), static_cast<int>(sql.size()), flags, &stmt_handle_, nullptr);
+        if (rc != SQLITE_OK) {
+            ec.assign(rc, sqlite3_category());
+        }
+        else if (stmt_handle_ == nullptr) {
+            // the text holds only whitespace or comments
+            ec = sqlitepp_errc::invalid_argument;
+        }
+        else {
+            ec.clear();
+        }
+    }
+
+    // Prepares a statement that fails when stepped to start after the
+    // deadline of guard, the guard of the connection of db.
+    void prepare(conn_handle_t db, std::shared_ptr<const deadline_guard> guard, std::string_view sql, unsigned int flags, std::error_code& ec) noexcept
+    {
+        prepare(db, sql, flags, ec);
+        if (!ec) {
+            deadline_ = std::move(guard);
+        }
+    }
+
+    void finalize() noexcept
+    {
+        if (stmt_handle_ != nullptr) {
+            // the result repeats the error of the last step, which was already reported
+            sqlite3_finalize(stmt_handle_);
+            stmt_handle_ = nullptr;
+        }
+        deadline_.reset();
+    }
+
+    bool is_prepared() const noexcept
+    {
+        return stmt_handle_ != nullptr;
+    }
+
+    stmt_handle_t stmt_handle() const noexcept
+    {
+        return stmt_handle_;
+    }
+
+    const deadline_guard* deadline() const noexcept
+    {
+        return deadline_.get();
+    }
+
+    bool step(std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return false;
+        }
+        int rc = step_before_deadline(stmt_handle_, deadline_.get());
+        if (rc == SQLITE_ROW) {
+            ec.clear();
+            return true;
+        }
+        if (rc == SQLITE_DONE) {
+            ec.clear();
+        }
+        else {
+            assign_step_error(stmt_handle_, rc, ec);
+        }
+        return false;
+    }
+
+    void reset(std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        // the result repeats the error of the last step, which was already reported
+        sqlite3_reset(stmt_handle_);
+        ec.clear();
+    }
+
+    void clear_bindings(std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        check(sqlite3_clear_bindings(stmt_handle_), ec);
+    }
+
+    template<typename T>
+    void bind(int index, const T& value, std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        if constexpr (std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, std::nullopt_t>) {
+            check(sqlite3_bind_null(stmt_handle_, index), ec);
+        }
+        else if constexpr (std::is_same_v<T, sqlitepp::value>) {
+            bind_value(index, value, ec);
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            check(sqlite3_bind_int64(stmt_handle_, index, static_cast<sqlite3_int64>(value)), ec);
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            check(sqlite3_bind_double(stmt_handle_, index, static_cast<double>(value)), ec);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            std::string_view text{value};
+            check(sqlite3_bind_text64(stmt_handle_, index, text.data(), text.size(), SQLITE_TRANSIENT, SQLITE_UTF8), ec);
+        }
+        else if constexpr (std::is_same_v<T, blob_view>) {
+            bind_blob(index, value, SQLITE_TRANSIENT, ec);
+        }
+        else if constexpr (is_byte_container<T>::value) {
+            bind_blob(index, blob_view{value.data(), value.size()}, SQLITE_TRANSIENT, ec);
+        }
+        else if constexpr (is_optional<T>::value) {
+            if (value) {
+                bind(index, *value, ec);
+            }
+            else {
+                check(sqlite3_bind_null(stmt_handle_, index), ec);
+            }
+        }
+        else {
+            static_assert(always_false_v<T>, "no SQLite binding for this type");
+        }
+    }
+
+    // Binds without copying; the text must stay valid until it is rebound or the statement is finalized.
+    void bind_static(int index, std::string_view text, std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        check(sqlite3_bind_text64(stmt_handle_, index, text.data(), text.size(), SQLITE_STATIC, SQLITE_UTF8), ec);
+    }
+
+    void bind_static(int index, blob_view blob, std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        bind_blob(index, blob, SQLITE_STATIC, ec);
+    }
+
+    // Binds field i of an aggregate to parameter i + 1.
+    template<typename Params>
+    void bind_fields(const Params& params, std::error_code& ec) noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        if (sqlite3_bind_parameter_count(stmt_handle_) != static_cast<int>(field_count_v<Params>)) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        ec.clear();
+        std::apply(
+            [&](const auto&... fields) {
+                int index = 0;
+                ((ec ? void() : bind(++index, fields, ec)), ...);
+            },
+            tie_fields(params));
+    }
+
+    int parameter_count() const noexcept
+    {
+        return stmt_handle_ != nullptr ? sqlite3_bind_parameter_count(stmt_handle_) : 0;
+    }
+
+    int parameter_index(const char* name) const noexcept
+    {
+        return stmt_handle_ != nullptr ? sqlite3_bind_parameter_index(stmt_handle_, name) : 0;
+    }
+
+    int column_count() const noexcept
+    {
+        return stmt_handle_ != nullptr ? sqlite3_column_count(stmt_handle_) : 0;
+    }
+
+    datatype column_type(int index) const noexcept
+    {
+        return stmt_handle_ != nullptr ? static_cast<datatype>(sqlite3_column_type(stmt_handle_, index)) : datatype::null;
+    }
+
+    std::string_view column_name(int index) const noexcept
+    {
+        const char* name = stmt_handle_ != nullptr ? sqlite3_column_name(stmt_handle_, index) : nullptr;
+        return name != nullptr ? std::string_view{name} : std::string_view{};
+    }
+
+    std::int64_t column_int64(int index) const noexcept
+    {
+        return stmt_handle_ != nullptr ? sqlite3_column_int64(stmt_handle_, index) : 0;
+    }
+
+    double column_double(int index) const noexcept
+    {
+        return stmt_handle_ != nullptr ? sqlite3_column_double(stmt_handle_, index) : 0.0;
+    }
+
+    std::string_view column_text(int index) const noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            return {};
+        }
+        // the pointer must be fetched before the size, see sqlite3_column_bytes
+        auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt_handle_, index));
+        if (text == nullptr) {
+            return {};
+        }
+        return std::string_view{text, static_cast<std::size_t>(sqlite3_column_bytes(stmt_handle_, index))};
+    }
+
+    blob_view column_blob(int index) const noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            return {};
+        }
+        const void* data = sqlite3_column_blob(stmt_handle_, index);
+        if (data == nullptr) {
+            return {};
+        }
+        return blob_view{data, static_cast<std::size_t>(sqlite3_column_bytes(stmt_handle_, index))};
+    }
+
+    // Copies a column, a text or blob longer than value::inline_capacity
+    // into arena when there is one.
+    sqlitepp::value column_value(int index, value_arena* arena) const
+    {
+        if (stmt_handle_ == nullptr) {
+            return sqlitepp::value{};
+        }
+        switch (sqlite3_column_type(stmt_handle_, index)) {
+        case SQLITE_INTEGER:
+            return sqlitepp::value{static_cast<std::int64_t>(sqlite3_column_int64(stmt_handle_, index))};
+        case SQLITE_FLOAT:
+            return sqlitepp::value{sqlite3_column_double(stmt_handle_, index)};
+        case SQLITE_TEXT:
+            return sqlitepp::value{column_text(index), arena};
+        case SQLITE_BLOB:
+            return sqlitepp::value{column_blob(index), arena};
+        default:
+            return sqlitepp::value{};
+        }
+    }
+
+    // Reads a column with the conversion picked by the type of out. Strings
+    // and byte containers are assigned in place and keep their capacity.
+    template<typename T>
+    void read_column(int index, T& out) const
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            out = sqlite3_column_int64(stmt_handle_, index) != 0;
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            out = static_cast<T>(sqlite3_column_int64(stmt_handle_, index));
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            out = static_cast<T>(sqlite3_column_double(stmt_handle_, index));
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            auto text = column_text(index);
+            out.assign(text.data(), text.size());
+        }
+        else if constexpr (std::is_same_v<T, std::string_view>) {
+            // valid until the next step
+            out = column_text(index);
+        }
+        else if constexpr (std::is_same_v<T, blob_view>) {
+            out = column_blob(index);
+        }
+        else if constexpr (std::is_same_v<T, sqlitepp::value>) {
+            out = column_value(index, nullptr);
+        }
+        else if constexpr (is_byte_container<T>::value) {
+            auto blob = column_blob(index);
+            auto first = static_cast<const typename T::value_type*>(blob.data);
+            out.assign(first, first + blob.size);
+        }
+        else if constexpr (is_optional<T>::value) {
+            if (sqlite3_column_type(stmt_handle_, index) == SQLITE_NULL) {
+                out.reset();
+            }
+            else {
+                read_column(index, out ? *out : out.emplace());
+            }
+        }
+        else {
+            static_assert(always_false_v<T>, "no SQLite column conversion for this type");
+        }
+    }
+
+    // Steps one row into an aggregate, field i from column i.
+    template<typename Row>
+    bool fetch(Row& row, std::error_code& ec) noexcept
+    {
+        if (!check_row_shape<Row>(ec) || !step(ec)) {
+            return false;
+        }
+        try {
+            read_row(row);
+            return true;
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return false;
+        }
+    }
+
+    // Appends up to max_rows rows, each read in place into the back of rows.
+    template<typename Row>
+    std::size_t fetch(std::vector<Row>& rows, std::size_t max_rows, std::error_code& ec) noexcept
+    {
+        std::size_t appended = 0;
+        if (!check_row_shape<Row>(ec)) {
+            return appended;
+        }
+        try {
+            while (appended < max_rows && step(ec)) {
+                read_row(rows.emplace_back());
+                ++appended;
+            }
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        return appended;
+    }
+
+    std::string_view sql() const noexcept
+    {
+        const char* text = stmt_handle_ != nullptr ? sqlite3_sql(stmt_handle_) : nullptr;
+        return text != nullptr ? std::string_view{text} : std::string_view{};
+    }
+
+    void swap(statement_impl& other) noexcept
+    {
+        std::swap(stmt_handle_, other.stmt_handle_);
+        deadline_.swap(other.deadline_);
+    }
+
+private:
+    stmt_handle_t stmt_handle_{nullptr};
+    std::shared_ptr<const deadline_guard> deadline_;
+
+    template<typename Row>
+    bool check_row_shape(std::error_code& ec) const noexcept
+    {
+        if (stmt_handle_ == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return false;
+        }
+        if (sqlite3_column_count(stmt_handle_) != static_cast<int>(field_count_v<Row>)) {
+            ec = sqlitepp_errc::invalid_argument;
+            return false;
+        }
+        return true;
+    }
+
+    template<typename Row>
+    void read_row(Row& row) const
+    {
+        std::apply(
+            [this](auto&... fields) {
+                int index = 0;
+                (read_column(index++, fields), ...);
+            },
+            tie_fields(row));
+    }
+
+    void bind_blob(int index, blob_view blob, sqlite3_destructor_type destructor, std::error_code& ec) noexcept
+    {
+        // a null pointer would bind NULL instead of an empty blob
+        static const char empty = 0;
+        const void* data = blob.data != nullptr ? blob.data : &empty;
+        check(sqlite3_bind_blob64(stmt_handle_, index, data, blob.size, destructor), ec);
+    }
+
+    void bind_value(int index, const sqlitepp::value& value, std::error_code& ec) noexcept
+    {
+        switch (value.type()) {
+        case datatype::integer:
+            check(sqlite3_bind_int64(stmt_handle_, index, value.as_int64()), ec);
+            break;
+        case datatype::real:
+            check(sqlite3_bind_double(stmt_handle_, index, value.as_double()), ec);
+            break;
+        case datatype::text: {
+            auto text = value.as_text();
+            check(sqlite3_bind_text64(stmt_handle_, index, text.data(), text.size(), SQLITE_TRANSIENT, SQLITE_UTF8), ec);
+            break;
+        }
+        case datatype::blob:
+            bind_blob(index, value.as_blob(), SQLITE_TRANSIENT, ec);
+            break;
+        default:
+            check(sqlite3_bind_null(stmt_handle_, index), ec);
+        }
+    }
+
+    static void check(int rc, std::error_code& ec) noexcept
+    {
+        if (rc != SQLITE_OK) {
+            ec.assign(rc, sqlite3_category());
+        }
+        else {
+            ec.clear();
+        }
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_STATEMENT_IMPL_HPP
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_STATUS_IMPL_HPP
+#define SQLITEPP_DETAIL_STATUS_IMPL_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/status.hpp>
+#include <sqlitepp/types.hpp>
+
+namespace sqlitepp::detail
+{
+
+inline connection_status read_connection_status(conn_handle_t db, status_mode mode) noexcept
+{
+    connection_status status;
+    if (db == nullptr) {
+        return status;
+    }
+
+    int reset = mode == status_mode::delta ? 1 : 0;
+    int current = 0;
+    int highwater = 0;
+    // gauges pass 0, resetting would also wipe their highwater marks
+    auto read = [&](int op, int reset_flag) {
+        current = 0;
+        highwater = 0;
+        sqlite3_db_status(db, op, &current, &highwater, reset_flag);
+    };
+
+    read(SQLITE_DBSTATUS_CACHE_HIT, reset);
+    status.cache_hit = current;
+    read(SQLITE_DBSTATUS_CACHE_MISS, reset);
+    status.cache_miss = current;
+    read(SQLITE_DBSTATUS_CACHE_WRITE, reset);
+    status.cache_write = current;
+    read(SQLITE_DBSTATUS_CACHE_SPILL, reset);
+    status.cache_spill = current;
+    // the lookaside hit and miss counts are reported as highwater values
+    read(SQLITE_DBSTATUS_LOOKASIDE_HIT, reset);
+    status.lookaside_hit = highwater;
+    read(SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, reset);
+    status.lookaside_miss_size = highwater;
+    read(SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, reset);
+    status.lookaside_miss_full = highwater;
+    read(SQLITE_DBSTATUS_LOOKASIDE_USED, 0);
+    status.lookaside_used = current;
+    status.lookaside_used_highwater = highwater;
+    read(SQLITE_DBSTATUS_CACHE_USED, 0);
+    status.cache_used = current;
+    read(SQLITE_DBSTATUS_CACHE_USED_SHARED, 0);
+    status.cache_used_shared = current;
+    read(SQLITE_DBSTATUS_SCHEMA_USED, 0);
+    status.schema_used = current;
+    read(SQLITE_DBSTATUS_STMT_USED, 0);
+    status.stmt_used = current;
+    read(SQLITE_DBSTATUS_DEFERRED_FKS, 0);
+    status.deferred_fks = current;
+    return status;
+}
+
+inline statement_status read_statement_status(stmt_handle_t stmt, status_mode mode) noexcept
+{
+    statement_status status;
+    if (stmt == nullptr) {
+        return status;
+    }
+
+    int reset = mode == status_mode::delta ? 1 : 0;
+    status.fullscan_steps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, reset);
+    status.sort_operations = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, reset);
+    status.autoindex_count = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, reset);
+    status.vm_steps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, reset);
+    status.reprepares = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, reset);
+    status.runs = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_RUN, reset);
+    status.filter_misses = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FILTER_MISS, reset);
+    status.filter_hits = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FILTER_HIT, reset);
+    status.memory_used = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_MEMUSED, 0);
+    return status;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_STATUS_IMPL_HPP
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_TOKENIZER_IMPL_HPP
+#define SQLITEPP_DETAIL_TOKENIZER_IMPL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SQLITEPP_TOKENIZER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#define SQLITEPP_TOKENIZER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace sqlitepp::detail
+{
+
+inline unsigned count_trailing_zeros(std::uint64_t bits) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+
+// Per byte of a text, bit i % 64 of word i / 64: whether it belongs to a
+// word, an ASCII letter or digit or any byte of a non-ASCII character, and
+// whether it is non-ASCII.
+struct byte_classes
+{
+    std::vector<std::uint64_t> word;
+    std::vector<std::uint64_t> high;
+};
+
+inline bool is_ascii_word_byte(unsigned char c) noexcept
+{
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26 || static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline char ascii_lower(unsigned char c) noexcept
+{
+    return static_cast<char>(static_cast<unsigned char>(c - 'A') < 26 ? c + 0x20 : c);
+}
+
+inline void classify_bytes_scalar(const unsigned char* text, std::size_t begin, std::size_t end, char* lower, byte_classes& classes) noexcept
+{
+    for (auto i = begin; i < end; ++i) {
+        auto c = text[i];
+        auto bit = std::uint64_t{1} << (i % 64);
+        if (c >= 0x80) {
+            classes.word[i / 64] |= bit;
+            classes.high[i / 64] |= bit;
+        }
+        else if (is_ascii_word_byte(c)) {
+            classes.word[i / 64] |= bit;
+        }
+        lower[i] = ascii_lower(c);
+    }
+}
+
+// Copies text into lower with its ASCII letters lower-cased and fills
+// classes, 16 bytes at a time where SSE2 or NEON is available.
+inline void classify_bytes(const char* text, std::size_t n, char* lower, byte_classes& classes)
+{
+    auto bytes = reinterpret_cast<const unsigned char*>(text);
+    classes.word.assign((n + 63) / 64, 0);
+    classes.high.assign((n + 63) / 64, 0);
+    std::size_t i = 0;
+#if defined(SQLITEPP_TOKENIZER_SSE2)
+    // signed compares: bytes from 0x80 are negative and fall outside every range
+    const auto upper_lo = _mm_set1_epi8('A' - 1);
+    const auto upper_hi = _mm_set1_epi8('Z' + 1);
+    const auto lower_lo = _mm_set1_epi8('a' - 1);
+    const auto lower_hi = _mm_set1_epi8('z' + 1);
+    const auto digit_lo = _mm_set1_epi8('0' - 1);
+    const auto digit_hi = _mm_set1_epi8('9' + 1);
+    const auto case_bit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= n; i += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        auto upper = _mm_and_si128(_mm_cmpgt_epi8(v, upper_lo), _mm_cmplt_epi8(v, upper_hi));
+        auto letter = _mm_or_si128(upper, _mm_and_si128(_mm_cmpgt_epi8(v, lower_lo), _mm_cmplt_epi8(v, lower_hi)));
+        auto digit = _mm_and_si128(_mm_cmpgt_epi8(v, digit_lo), _mm_cmplt_epi8(v, digit_hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lower + i), _mm_or_si128(v, _mm_and_si128(upper, case_bit)));
+        auto high = static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(v)));
+        auto word = static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(letter, digit)))) | high;
+        classes.word[i / 64] |= word << (i % 64);
+        classes.high[i / 64] |= high << (i % 64);
+    }
+#elif defined(SQLITEPP_TOKENIZER_NEON)
+    // the bit of each lane, to turn a compare result into a 16-bit mask
+    static const std::uint8_t lane_bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const auto bits = vld1q_u8(lane_bits);
+    auto movemask = [&](uint8x16_t m) {
+        auto b = vandq_u8(m, bits);
+        return static_cast<std::uint64_t>(vaddv_u8(vget_low_u8(b))) | static_cast<std::uint64_t>(vaddv_u8(vget_high_u8(b))) << 8;
+    };
+    for (; i + 16 <= n; i += 16) {
+        auto v = vld1q_u8(bytes + i);
+        auto upper = vcltq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8(26));
+        auto letter = vcltq_u8(vsubq_u8(vorrq_u8(v, vdupq_n_u8(0x20)), vdupq_n_u8('a')), vdupq_n_u8(26));
+        auto digit = vcltq_u8(vsubq_u8(v, vdupq_n_u8('0')), vdupq_n_u8(10));
+        vst1q_u8(reinterpret_cast<std::uint8_t*>(lower + i), vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20))));
+        auto high = movemask(vcgeq_u8(v, vdupq_n_u8(0x80)));
+        auto word = movemask(vorrq_u8(letter, digit)) | high;
+        classes.word[i / 64] |= word << (i % 64);
+        classes.high[i / 64] |= high << (i % 64);
+    }
+#endif
+    classify_bytes_scalar(bytes, i, n, lower, classes);
+}
+
+// The first position from pos, up to n, whose bit in bits is set, or
+// clear when set is false.
+inline std::size_t find_bit(const std::vector<std::uint64_t>& bits, std::size_t pos, std::size_t n, bool set) noexcept
+{
+    while (pos < n) {
+        auto word = set ? bits[pos / 64] : ~bits[pos / 64];
+        word &= ~std::uint64_t{0} << (pos % 64);
+        if (word != 0) {
+            auto found = pos / 64 * 64 + count_trailing_zeros(word);
+            return found < n ? found : n;
+        }
+        pos = (pos / 64 + 1) * 64;
+    }
+    return n;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_TOKENIZER_IMPL_HPP
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_TRACE_HOOKS_HPP
+#define SQLITEPP_DETAIL_TRACE_HOOKS_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <new>
+#include <system_error>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+// Fans the single sqlite3_trace_v2 callback of a connection out to several
+// subscribers, each for the events of its own mask. The callback is installed
+// for the union of the masks and removed with the last subscriber.
+class trace_hooks
+{
+public:
+    using callback = int (*)(unsigned type, void* context, void* p, void* x);
+
+    void add(conn_handle_t db, void* context, unsigned mask, callback fn, std::error_code& ec) noexcept
+    {
+        try {
+            subscribers_.push_back({context, mask, fn});
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return;
+        }
+        int rc = install(db);
+        if (rc != SQLITE_OK) {
+            subscribers_.pop_back();
+            install(db);
+            ec.assign(rc, sqlite3_category());
+            return;
+        }
+        ec.clear();
+    }
+
+    void remove(conn_handle_t db, void* context) noexcept
+    {
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(), [context](const subscriber& s) { return s.context == context; }),
+                           subscribers_.end());
+        if (db != nullptr) {
+            install(db);
+        }
+    }
+
+private:
+    struct subscriber
+    {
+        void* context;
+        unsigned mask;
+        callback fn;
+    };
+
+    std::vector<subscriber> subscribers_;
+
+    int install(conn_handle_t db) noexcept
+    {
+        unsigned mask = 0;
+        for (auto& s : subscribers_) {
+            mask |= s.mask;
+        }
+        return mask != 0 ? sqlite3_trace_v2(db, mask, &trace_hooks::dispatch, this) : sqlite3_trace_v2(db, 0, nullptr, nullptr);
+    }
+
+    static int dispatch(unsigned type, void* self, void* p, void* x) noexcept
+    {
+        for (auto& s : static_cast<trace_hooks*>(self)->subscribers_) {
+            if ((s.mask & type) != 0) {
+                s.fn(type, s.context, p, x);
+            }
+        }
+        return 0;
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_TRACE_HOOKS_HPP
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_UPDATE_HOOKS_HPP
+#define SQLITEPP_DETAIL_UPDATE_HOOKS_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <new>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp::detail
+{
+
+// Fans the single sqlite3_update_hook of a connection out to several
+// subscribers. The hook is installed with the first subscriber and removed
+// with the last, so a connection without subscribers pays nothing per row.
+class update_hooks
+{
+public:
+    using callback = void (*)(void* context, int op, const char* db, const char* table, sqlite3_int64 rowid);
+
+    void add(conn_handle_t db, void* context, callback fn, std::error_code& ec) noexcept
+    {
+        try {
+            subscribers_.emplace_back(context, fn);
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return;
+        }
+        if (subscribers_.size() == 1) {
+            sqlite3_update_hook(db, &update_hooks::dispatch, this);
+        }
+        ec.clear();
+    }
+
+    void remove(conn_handle_t db, void* context) noexcept
+    {
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(), [context](const auto& s) { return s.first == context; }),
+                           subscribers_.end());
+        if (subscribers_.empty() && db != nullptr) {
+            sqlite3_update_hook(db, nullptr, nullptr);
+        }
+    }
+
+private:
+    std::vector<std::pair<void*, callback>> subscribers_;
+
+    static void dispatch(void* self, int op, const char* db, const char* table, sqlite3_int64 rowid) noexcept
+    {
+        for (auto& [context, fn] : static_cast<update_hooks*>(self)->subscribers_) {
+            fn(context, op, db, table, rowid);
+        }
+    }
+};
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_UPDATE_HOOKS_HPP
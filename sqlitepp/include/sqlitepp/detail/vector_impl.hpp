@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_DETAIL_VECTOR_IMPL_HPP
+#define SQLITEPP_DETAIL_VECTOR_IMPL_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SQLITEPP_VECTOR_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define SQLITEPP_VECTOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace sqlitepp::detail
+{
+
+// Kernels over float32 vectors of n elements, which the blobs of SQLite
+// hold without any alignment; loads are unaligned throughout.
+struct vector_kernels
+{
+    const char* name;
+    float (*dot)(const void* a, const void* b, std::size_t n) noexcept;
+    // squared Euclidean distance
+    float (*l2_squared)(const void* a, const void* b, std::size_t n) noexcept;
+    // the dot product and both squared norms in one pass
+    void (*cosine_terms)(const void* a, const void* b, std::size_t n, float* terms) noexcept;
+};
+
+inline float load_float(const void* p, std::size_t i) noexcept
+{
+    float f;
+    std::memcpy(&f, static_cast<const unsigned char*>(p) + i * sizeof(float), sizeof(float));
+    return f;
+}
+
+inline float scalar_dot(const void* a, const void* b, std::size_t n) noexcept
+{
+    // four independent sums, which the compiler may keep in one register
+    float sum[4]{};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            sum[j] += load_float(a, i + j) * load_float(b, i + j);
+        }
+    }
+    for (; i < n; ++i) {
+        sum[0] += load_float(a, i) * load_float(b, i);
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+inline float scalar_l2_squared(const void* a, const void* b, std::size_t n) noexcept
+{
+    float sum[4]{};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            auto d = load_float(a, i + j) - load_float(b, i + j);
+            sum[j] += d * d;
+        }
+    }
+    for (; i < n; ++i) {
+        auto d = load_float(a, i) - load_float(b, i);
+        sum[0] += d * d;
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+inline void scalar_cosine_terms(const void* a, const void* b, std::size_t n, float* terms) noexcept
+{
+    float ab = 0;
+    float aa = 0;
+    float bb = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto x = load_float(a, i);
+        auto y = load_float(b, i);
+        ab += x * y;
+        aa += x * x;
+        bb += y * y;
+    }
+    terms[0] = ab;
+    terms[1] = aa;
+    terms[2] = bb;
+}
+
+#if defined(SQLITEPP_VECTOR_X86)
+
+__attribute__((target("avx2,fma"))) inline float avx2_sum(__m256 v) noexcept
+{
+    auto s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2,fma"))) inline float avx2_dot(const void* a, const void* b, std::size_t n) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto s0 = _mm256_setzero_ps();
+    auto s1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+    }
+    auto sum = avx2_sum(_mm256_add_ps(s0, s1));
+    for (; i < n; ++i) {
+        sum += load_float(a, i) * load_float(b, i);
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma"))) inline float avx2_l2_squared(const void* a, const void* b, std::size_t n) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto s0 = _mm256_setzero_ps();
+    auto s1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto d0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+        auto d1 = _mm256_sub_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8));
+        s0 = _mm256_fmadd_ps(d0, d0, s0);
+        s1 = _mm256_fmadd_ps(d1, d1, s1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        auto d = _mm256_sub_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+        s0 = _mm256_fmadd_ps(d, d, s0);
+    }
+    auto sum = avx2_sum(_mm256_add_ps(s0, s1));
+    for (; i < n; ++i) {
+        auto d = load_float(a, i) - load_float(b, i);
+        sum += d * d;
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma"))) inline void avx2_cosine_terms(const void* a, const void* b, std::size_t n, float* terms) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto ab = _mm256_setzero_ps();
+    auto aa = _mm256_setzero_ps();
+    auto bb = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto u = _mm256_loadu_ps(x + i);
+        auto v = _mm256_loadu_ps(y + i);
+        ab = _mm256_fmadd_ps(u, v, ab);
+        aa = _mm256_fmadd_ps(u, u, aa);
+        bb = _mm256_fmadd_ps(v, v, bb);
+    }
+    terms[0] = avx2_sum(ab);
+    terms[1] = avx2_sum(aa);
+    terms[2] = avx2_sum(bb);
+    for (; i < n; ++i) {
+        auto u = load_float(a, i);
+        auto v = load_float(b, i);
+        terms[0] += u * v;
+        terms[1] += u * u;
+        terms[2] += v * v;
+    }
+}
+
+__attribute__((target("avx512f"))) inline float avx512_dot(const void* a, const void* b, std::size_t n) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto s0 = _mm512_setzero_ps();
+    auto s1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+    }
+    s0 = _mm512_add_ps(s0, s1);
+    if (i + 16 <= n) {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+        i += 16;
+    }
+    if (i < n) {
+        // a masked load does not touch the bytes past the end of the blob
+        auto mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), s0);
+    }
+    return _mm512_reduce_add_ps(s0);
+}
+
+__attribute__((target("avx512f"))) inline float avx512_l2_squared(const void* a, const void* b, std::size_t n) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto s0 = _mm512_setzero_ps();
+    auto s1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        auto d0 = _mm512_sub_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i));
+        auto d1 = _mm512_sub_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16));
+        s0 = _mm512_fmadd_ps(d0, d0, s0);
+        s1 = _mm512_fmadd_ps(d1, d1, s1);
+    }
+    s0 = _mm512_add_ps(s0, s1);
+    if (i + 16 <= n) {
+        auto d = _mm512_sub_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i));
+        s0 = _mm512_fmadd_ps(d, d, s0);
+        i += 16;
+    }
+    if (i < n) {
+        auto mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        auto d = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+        s0 = _mm512_fmadd_ps(d, d, s0);
+    }
+    return _mm512_reduce_add_ps(s0);
+}
+
+__attribute__((target("avx512f"))) inline void avx512_cosine_terms(const void* a, const void* b, std::size_t n, float* terms) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto ab = _mm512_setzero_ps();
+    auto aa = _mm512_setzero_ps();
+    auto bb = _mm512_setzero_ps();
+    for (std::size_t i = 0; i < n; i += 16) {
+        auto mask = n - i >= 16 ? static_cast<__mmask16>(0xffff) : static_cast<__mmask16>((1u << (n - i)) - 1);
+        auto u = _mm512_maskz_loadu_ps(mask, x + i);
+        auto v = _mm512_maskz_loadu_ps(mask, y + i);
+        ab = _mm512_fmadd_ps(u, v, ab);
+        aa = _mm512_fmadd_ps(u, u, aa);
+        bb = _mm512_fmadd_ps(v, v, bb);
+    }
+    terms[0] = _mm512_reduce_add_ps(ab);
+    terms[1] = _mm512_reduce_add_ps(aa);
+    terms[2] = _mm512_reduce_add_ps(bb);
+}
+
+#elif defined(SQLITEPP_VECTOR_NEON)
+
+inline float neon_dot(const void* a, const void* b, std::size_t n) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto s0 = vdupq_n_f32(0);
+    auto s1 = vdupq_n_f32(0);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = vfmaq_f32(s0, vld1q_f32(x + i), vld1q_f32(y + i));
+        s1 = vfmaq_f32(s1, vld1q_f32(x + i + 4), vld1q_f32(y + i + 4));
+    }
+    auto sum = vaddvq_f32(vaddq_f32(s0, s1));
+    for (; i < n; ++i) {
+        sum += load_float(a, i) * load_float(b, i);
+    }
+    return sum;
+}
+
+inline float neon_l2_squared(const void* a, const void* b, std::size_t n) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto s0 = vdupq_n_f32(0);
+    auto s1 = vdupq_n_f32(0);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto d0 = vsubq_f32(vld1q_f32(x + i), vld1q_f32(y + i));
+        auto d1 = vsubq_f32(vld1q_f32(x + i + 4), vld1q_f32(y + i + 4));
+        s0 = vfmaq_f32(s0, d0, d0);
+        s1 = vfmaq_f32(s1, d1, d1);
+    }
+    auto sum = vaddvq_f32(vaddq_f32(s0, s1));
+    for (; i < n; ++i) {
+        auto d = load_float(a, i) - load_float(b, i);
+        sum += d * d;
+    }
+    return sum;
+}
+
+inline void neon_cosine_terms(const void* a, const void* b, std::size_t n, float* terms) noexcept
+{
+    auto x = static_cast<const float*>(a);
+    auto y = static_cast<const float*>(b);
+    auto ab = vdupq_n_f32(0);
+    auto aa = vdupq_n_f32(0);
+    auto bb = vdupq_n_f32(0);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto u = vld1q_f32(x + i);
+        auto v = vld1q_f32(y + i);
+        ab = vfmaq_f32(ab, u, v);
+        aa = vfmaq_f32(aa, u, u);
+        bb = vfmaq_f32(bb, v, v);
+    }
+    terms[0] = vaddvq_f32(ab);
+    terms[1] = vaddvq_f32(aa);
+    terms[2] = vaddvq_f32(bb);
+    for (; i < n; ++i) {
+        auto u = load_float(a, i);
+        auto v = load_float(b, i);
+        terms[0] += u * v;
+        terms[1] += u * u;
+        terms[2] += v * v;
+    }
+}
+
+#endif
+
+inline const vector_kernels& scalar_vector_kernels() noexcept
+{
+    static const vector_kernels kernels{"scalar", &scalar_dot, &scalar_l2_squared, &scalar_cosine_terms};
+    return kernels;
+}
+
+// The widest kernels the processor supports, chosen on first use.
+inline const vector_kernels& select_vector_kernels() noexcept
+{
+    static const vector_kernels& kernels = []() -> const vector_kernels& {
+#if defined(SQLITEPP_VECTOR_X86)
+        static const vector_kernels avx512{"avx512", &avx512_dot, &avx512_l2_squared, &avx512_cosine_terms};
+        static const vector_kernels avx2{"avx2", &avx2_dot, &avx2_l2_squared, &avx2_cosine_terms};
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return avx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return avx2;
+        }
+#elif defined(SQLITEPP_VECTOR_NEON)
+        // NEON is part of the aarch64 baseline
+        static const vector_kernels neon{"neon", &neon_dot, &neon_l2_squared, &neon_cosine_terms};
+        return neon;
+#endif
+        return scalar_vector_kernels();
+    }();
+    return kernels;
+}
+
+// The cosine similarity of a and b, false when either is a zero vector.
+inline bool cosine_similarity(const vector_kernels& kernels, const void* a, const void* b, std::size_t n, double& similarity) noexcept
+{
+    float terms[3];
+    kernels.cosine_terms(a, b, n, terms);
+    if (terms[1] == 0 || terms[2] == 0) {
+        return false;
+    }
+    similarity = static_cast<double>(terms[0]) / (std::sqrt(static_cast<double>(terms[1])) * std::sqrt(static_cast<double>(terms[2])));
+    return true;
+}
+
+} // namespace sqlitepp::detail
+
+#endif // SQLITEPP_DETAIL_VECTOR_IMPL_HPP
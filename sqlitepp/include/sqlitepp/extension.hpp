@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_EXTENSION_HPP
+#define SQLITEPP_EXTENSION_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/function_impl.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <exception>
+#include <functional>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// SQL functions, collations and virtual table modules declared with C++
+// types, registered together on a connection. Arguments and results convert
+// like statement parameters and columns: integers, reals, std::string_view,
+// std::string, blob_view, byte containers, value and std::optional of these.
+// Exceptions thrown by a function become its SQL error.
+class extension_registry
+{
+public:
+    // A function of a fixed number of arguments, those of the parameters of
+    // f. flags adds to SQLITE_UTF8, such as SQLITE_DETERMINISTIC,
+    // SQLITE_INNOCUOUS or SQLITE_DIRECTONLY.
+    template<typename F>
+    extension_registry& function(std::string name, F f, int flags = SQLITE_DETERMINISTIC)
+    {
+        using function_type = std::decay_t<F>;
+        entries_.push_back({std::move(name), [f = std::move(f), flags](conn_handle_t db, const char* sql_name) {
+                                return sqlite3_create_function_v2(db, sql_name, detail::arity_v<function_type>, SQLITE_UTF8 | flags, new function_type(f),
+                                                                  &detail::scalar_function<function_type>, nullptr, nullptr,
+                                                                  &detail::delete_object<function_type>);
+                            }});
+        return *this;
+    }
+
+    // An aggregate function whose state is a State, created for each group
+    // by value-initialization, fed with State::step(args...) for each row and
+    // asked for the result with State::finish().
+    template<typename State>
+    extension_registry& aggregate(std::string name, int flags = SQLITE_DETERMINISTIC)
+    {
+        entries_.push_back({std::move(name), [flags](conn_handle_t db, const char* sql_name) {
+                                return sqlite3_create_function_v2(db, sql_name, detail::arity_v<decltype(&State::step)>, SQLITE_UTF8 | flags, nullptr, nullptr,
+                                                                  &detail::aggregate_step<State>, &detail::aggregate_final<State>, nullptr);
+                            }});
+        return *this;
+    }
+
+    // A collation ordering text by compare(std::string_view, std::string_view),
+    // which returns a negative, zero or positive int.
+    template<typename F>
+    extension_registry& collation(std::string name, F compare)
+    {
+        using compare_type = std::decay_t<F>;
+        entries_.push_back({std::move(name), [compare = std::move(compare)](conn_handle_t db, const char* sql_name) {
+                                auto copy = new compare_type(compare);
+                                int rc = sqlite3_create_collation_v2(db, sql_name, SQLITE_UTF8, copy, &detail::collation_compare<compare_type>,
+                                                                     &detail::delete_object<compare_type>);
+                                if (rc != SQLITE_OK) {
+                                    // unlike the other interfaces, a failed sqlite3_create_collation_v2 leaves the argument to the caller
+                                    delete copy;
+                                }
+                                return rc;
+                            }});
+        return *this;
+    }
+
+    // A virtual table module; module must outlive the connections and aux is
+    // passed to its xCreate and xConnect.
+    extension_registry& module(std::string name, const sqlite3_module* module, void* aux = nullptr)
+    {
+        entries_.push_back({std::move(name), [module, aux](conn_handle_t db, const char* sql_name) {
+                                return sqlite3_create_module_v2(db, sql_name, module, aux, nullptr);
+                            }});
+        return *this;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return entries_.size();
+    }
+
+    // Registers every declaration on db in one pass under the mutex of the
+    // connection, stopping at the first failure, whose message is then the
+    // error message of db.
+    void install(conn_handle_t db, std::error_code& ec) const noexcept
+    {
+        ec.clear();
+        if (db == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        auto mutex = sqlite3_db_mutex(db);
+        if (mutex != nullptr) {
+            sqlite3_mutex_enter(mutex);
+        }
+        for (auto& entry : entries_) {
+            int rc = SQLITE_NOMEM;
+            try {
+                rc = entry.install(db, entry.name.c_str());
+            }
+            catch (const std::bad_alloc&) {
+            }
+            if (rc != SQLITE_OK) {
+                ec.assign(rc, sqlite3_category());
+                break;
+            }
+        }
+        if (mutex != nullptr) {
+            sqlite3_mutex_leave(mutex);
+        }
+    }
+
+    void install(connection& conn, std::error_code& ec) const noexcept
+    {
+        install(conn.conn_handle(), ec);
+    }
+
+    void install(connection& conn) const
+    {
+        std::error_code ec;
+        install(conn.conn_handle(), ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+private:
+    struct entry
+    {
+        std::string name;
+        std::function<int(conn_handle_t, const char*)> install;
+    };
+
+    std::vector<entry> entries_;
+};
+
+namespace detail
+{
+
+// The body of an extension entry point: declares into a registry and
+// installs it on db.
+inline int init_extension(conn_handle_t db, char** message, void (*declare)(extension_registry&)) noexcept
+{
+    try {
+        extension_registry registry;
+        declare(registry);
+        std::error_code ec;
+        registry.install(db, ec);
+        if (!ec) {
+            return SQLITE_OK;
+        }
+        if (message != nullptr) {
+            *message = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+        }
+        return ec.category() == sqlite3_category() ? ec.value() : SQLITE_ERROR;
+    }
+    catch (const std::bad_alloc&) {
+        return SQLITE_NOMEM;
+    }
+    catch (const std::exception& e) {
+        if (message != nullptr) {
+            *message = sqlite3_mprintf("%s", e.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
+} // namespace detail
+
+} // namespace sqlitepp
+
+#if defined(_WIN32)
+#define SQLITEPP_EXTENSION_EXPORT __declspec(dllexport)
+#else
+#define SQLITEPP_EXTENSION_EXPORT __attribute__((visibility("default")))
+#endif
+
+#if defined(SQLITEPP_INCLUDE_SQLITE3EXT)
+#define SQLITEPP_EXTENSION_API_DEFINE SQLITE_EXTENSION_INIT1
+#define SQLITEPP_EXTENSION_API_INIT(api) SQLITE_EXTENSION_INIT2(api)
+#else
+#define SQLITEPP_EXTENSION_API_DEFINE
+#define SQLITEPP_EXTENSION_API_INIT(api) (void)(api);
+#endif
+
+// Defines the entry point sqlite3_<name>_init of an extension, followed by
+// the body of a function that declares its contents into `registry`:
+//
+//     SQLITEPP_EXTENSION(vecmath)
+//     {
+//         registry.function("dot3", [](double x, double y, double z) { ... });
+//     }
+//
+// Built against SQLitepp::sqlitepp_ext, see sqlitepp_add_extension, it is a
+// loadable extension, of which a shared module holds one; SQLite derives
+// the entry point from a file name such as vecmath.so. Built against
+// SQLitepp::sqlitepp nothing registers it; pass sqlite3_<name>_init to
+// sqlite3_auto_extension to install it on the connections opened afterwards.
+#define SQLITEPP_EXTENSION(name)                                                                                                                     \
+    SQLITEPP_EXTENSION_API_DEFINE                                                                                                                    \
+    static void sqlitepp_declare_##name(::sqlitepp::extension_registry& registry);                                                                  \
+    extern "C" SQLITEPP_EXTENSION_EXPORT int sqlite3_##name##_init(sqlite3* db, char** message, const sqlite3_api_routines* api)                   \
+    {                                                                                                                                                \
+        SQLITEPP_EXTENSION_API_INIT(api)                                                                                                             \
+        return ::sqlitepp::detail::init_extension(db, message, &sqlitepp_declare_##name);                                                           \
+    }                                                                                                                                                \
+    static void sqlitepp_declare_##name(::sqlitepp::extension_registry& registry)
+
+#endif // SQLITEPP_EXTENSION_HPP
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_FIXED_STRING_HPP
+#define SQLITEPP_FIXED_STRING_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// String literals as template arguments need class types as non-type
+// template parameters, which came with C++20.
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+#define SQLITEPP_HAS_FIXED_STRING 1
+#endif
+
+#if defined(SQLITEPP_HAS_FIXED_STRING)
+
+namespace sqlitepp
+{
+
+template<std::size_t N>
+struct fixed_string
+{
+    char data[N]{};
+
+    constexpr fixed_string(const char (&text)[N]) noexcept
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            data[i] = text[i];
+        }
+    }
+
+    constexpr std::string_view view() const noexcept
+    {
+        return {data, N - 1};
+    }
+
+    constexpr const char* c_str() const noexcept
+    {
+        return data;
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_HAS_FIXED_STRING
+
+#endif // SQLITEPP_FIXED_STRING_HPP
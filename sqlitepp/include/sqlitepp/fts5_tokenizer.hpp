@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_FTS5_TOKENIZER_HPP
+#define SQLITEPP_FTS5_TOKENIZER_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/tokenizer_impl.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// The FTS5 API of a connection, null with an error when SQLite is built
+// without FTS5.
+inline fts5_api* get_fts5_api(connection& conn, std::error_code& ec) noexcept
+{
+    ec.clear();
+    auto db = conn.conn_handle();
+    if (db == nullptr) {
+        ec = sqlitepp_errc::invalid_handle;
+        return nullptr;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        ec.assign(rc, sqlite3_category());
+        return nullptr;
+    }
+    fts5_api* api = nullptr;
+    sqlite3_bind_pointer(stmt, 1, &api, "fts5_api_ptr", nullptr);
+    sqlite3_step(stmt);
+    rc = sqlite3_finalize(stmt);
+    if (rc != SQLITE_OK || api == nullptr) {
+        ec.assign(rc != SQLITE_OK ? rc : SQLITE_ERROR, sqlite3_category());
+    }
+    return api;
+}
+
+// What a tokenizer is given a text for: the flags of xTokenize, such as
+// FTS5_TOKENIZE_DOCUMENT or FTS5_TOKENIZE_QUERY, and the callback taking its
+// tokens.
+class token_emitter
+{
+public:
+    using callback_type = int (*)(void*, int, const char*, int, int, int);
+
+    token_emitter(void* context, int reason, callback_type callback) noexcept : context_(context), reason_(reason), callback_(callback)
+    {
+    }
+
+    int reason() const noexcept
+    {
+        return reason_;
+    }
+
+    // Passes a token found at the bytes [start, end) of the text, with flags
+    // 0 or FTS5_TOKEN_COLOCATED for a synonym of the previous token. Returns
+    // false when FTS5 failed, after which the tokenizer should return.
+    bool operator()(std::string_view token, std::size_t start, std::size_t end, int flags = 0) noexcept
+    {
+        if (status_ == SQLITE_OK) {
+            status_ = callback_(context_, flags, token.data(), static_cast<int>(token.size()), static_cast<int>(start), static_cast<int>(end));
+        }
+        return status_ == SQLITE_OK;
+    }
+
+    int status() const noexcept
+    {
+        return status_;
+    }
+
+private:
+    void* context_;
+    int reason_;
+    callback_type callback_;
+    int status_{SQLITE_OK};
+};
+
+namespace detail
+{
+
+template<typename Tokenizer>
+struct fts5_tokenizer_adapter
+{
+    static int create(void* api, const char** argv, int argc, Fts5Tokenizer** out) noexcept
+    {
+        try {
+            if constexpr (std::is_constructible_v<Tokenizer, fts5_api*, const std::vector<std::string_view>&>) {
+                std::vector<std::string_view> args(argv, argv + argc);
+                *out = reinterpret_cast<Fts5Tokenizer*>(new Tokenizer(static_cast<fts5_api*>(api), args));
+            }
+            else if constexpr (std::is_constructible_v<Tokenizer, const std::vector<std::string_view>&>) {
+                std::vector<std::string_view> args(argv, argv + argc);
+                *out = reinterpret_cast<Fts5Tokenizer*>(new Tokenizer(args));
+            }
+            else {
+                if (argc != 0) {
+                    return SQLITE_ERROR;
+                }
+                *out = reinterpret_cast<Fts5Tokenizer*>(new Tokenizer());
+            }
+            return SQLITE_OK;
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+        }
+        catch (const std::system_error& e) {
+            return e.code().category() == sqlite3_category() ? e.code().value() : SQLITE_ERROR;
+        }
+        catch (...) {
+            return SQLITE_ERROR;
+        }
+    }
+
+    static void destroy(Fts5Tokenizer* tokenizer) noexcept
+    {
+        delete reinterpret_cast<Tokenizer*>(tokenizer);
+    }
+
+    static int tokenize(Fts5Tokenizer* tokenizer, void* context, int flags, const char* text, int size,
+                        token_emitter::callback_type callback) noexcept
+    {
+        token_emitter emit{context, flags, callback};
+        try {
+            reinterpret_cast<Tokenizer*>(tokenizer)->tokenize(std::string_view{text, static_cast<std::size_t>(size)}, emit);
+            return emit.status();
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+        }
+        catch (const std::system_error& e) {
+            return e.code().category() == sqlite3_category() ? e.code().value() : SQLITE_ERROR;
+        }
+        catch (...) {
+            return SQLITE_ERROR;
+        }
+    }
+};
+
+} // namespace detail
+
+// Registers Tokenizer as the FTS5 tokenizer name, for tables created with
+// tokenize = 'name arg...'. A tokenizer is constructed for each table from
+// the FTS5 API and its arguments, when it has a constructor taking a
+// fts5_api* and a const std::vector<std::string_view>&, from its arguments
+// alone when it takes only the latter, or else by default with none
+// allowed. Its member tokenize(std::string_view text, token_emitter& emit)
+// passes the tokens of text to emit; exceptions become the error of the
+// statement using the table. A tokenizer serves one connection at a time.
+template<typename Tokenizer>
+void register_tokenizer(connection& conn, const char* name, std::error_code& ec) noexcept
+{
+    auto api = get_fts5_api(conn, ec);
+    if (ec) {
+        return;
+    }
+    fts5_tokenizer tokenizer{&detail::fts5_tokenizer_adapter<Tokenizer>::create, &detail::fts5_tokenizer_adapter<Tokenizer>::destroy,
+                             &detail::fts5_tokenizer_adapter<Tokenizer>::tokenize};
+    int rc = api->xCreateTokenizer(api, name, api, &tokenizer, nullptr);
+    if (rc != SQLITE_OK) {
+        ec.assign(rc, sqlite3_category());
+    }
+}
+
+template<typename Tokenizer>
+void register_tokenizer(connection& conn, const char* name)
+{
+    std::error_code ec;
+    register_tokenizer<Tokenizer>(conn, name, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+}
+
+// Splits text into runs of letters and digits and folds them as unicode61
+// does. ASCII words are classified and lower-cased 16 bytes at a time with
+// SSE2 or NEON; words with other characters are passed to the connection's
+// unicode61 tokenizer, which splits them at Unicode separators, folds their
+// case and removes diacritics. Takes unicode61's remove_diacritics option;
+// its tokenchars, separators and categories options, which would change
+// the tokens of ASCII text, are refused.
+class word_tokenizer
+{
+public:
+    word_tokenizer(fts5_api* api, const std::vector<std::string_view>& args)
+    {
+        std::vector<std::string> options;
+        for (std::size_t i = 0; i < args.size(); i += 2) {
+            if (args[i] != "remove_diacritics" || i + 1 == args.size()) {
+                throw std::system_error(SQLITE_ERROR, sqlite3_category());
+            }
+            options.emplace_back(args[i]);
+            options.emplace_back(args[i + 1]);
+        }
+        std::vector<const char*> argv;
+        for (auto& option : options) {
+            argv.push_back(option.c_str());
+        }
+        void* user_data = nullptr;
+        int rc = api != nullptr ? api->xFindTokenizer(api, "unicode61", &user_data, &unicode61_) : SQLITE_MISUSE;
+        if (rc == SQLITE_OK) {
+            rc = unicode61_.xCreate(user_data, argv.data(), static_cast<int>(argv.size()), &unicode61_instance_);
+        }
+        if (rc != SQLITE_OK) {
+            throw std::system_error(rc, sqlite3_category());
+        }
+    }
+
+    word_tokenizer(const word_tokenizer&) = delete;
+    word_tokenizer& operator=(const word_tokenizer&) = delete;
+
+    ~word_tokenizer()
+    {
+        unicode61_.xDelete(unicode61_instance_);
+    }
+
+    void tokenize(std::string_view text, token_emitter& emit)
+    {
+        auto n = text.size();
+        lower_.resize(n);
+        detail::classify_bytes(text.data(), n, lower_.data(), classes_);
+        for (auto start = detail::find_bit(classes_.word, 0, n, true); start < n;) {
+            auto end = detail::find_bit(classes_.word, start, n, false);
+            bool ascii = detail::find_bit(classes_.high, start, end, true) == end;
+            if (ascii ? !emit(std::string_view{lower_.data() + start, end - start}, start, end) : !tokenize_unicode(text, start, end, emit)) {
+                return;
+            }
+            start = detail::find_bit(classes_.word, end, n, true);
+        }
+    }
+
+private:
+    fts5_tokenizer unicode61_{};
+    Fts5Tokenizer* unicode61_instance_{nullptr};
+    std::string lower_;
+    detail::byte_classes classes_;
+
+    // Passes the word at [begin, end) of the text to unicode61, with the
+    // offsets of its tokens moved to those of the text.
+    bool tokenize_unicode(std::string_view text, std::size_t begin, std::size_t end, token_emitter& emit)
+    {
+        struct shifted_emitter
+        {
+            token_emitter& emit;
+            std::size_t offset;
+        };
+        shifted_emitter shifted{emit, begin};
+        auto callback = [](void* context, int flags, const char* token, int size, int start, int stop) noexcept {
+            auto& target = *static_cast<shifted_emitter*>(context);
+            target.emit(std::string_view{token, static_cast<std::size_t>(size)}, target.offset + static_cast<std::size_t>(start),
+                        target.offset + static_cast<std::size_t>(stop), flags);
+            return target.emit.status();
+        };
+        int rc = unicode61_.xTokenize(unicode61_instance_, &shifted, emit.reason(), text.data() + begin, static_cast<int>(end - begin), callback);
+        if (rc != SQLITE_OK && emit.status() == SQLITE_OK) {
+            throw std::system_error(rc, sqlite3_category());
+        }
+        return rc == SQLITE_OK;
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_FTS5_TOKENIZER_HPP
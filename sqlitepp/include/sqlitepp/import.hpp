@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_IMPORT_HPP
+#define SQLITEPP_IMPORT_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/import_impl.hpp>
+#include <sqlitepp/detail/mapped_file.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace sqlitepp
+{
+
+struct import_options
+{
+    char delimiter = ',';
+    char quote = '"';
+    // the first CSV record names the columns instead of holding data
+    bool header = true;
+    // rows per batch handed from the parser thread to the inserting thread
+    std::size_t batch_rows = 8192;
+    // batches in flight between the two threads
+    std::size_t batches = 4;
+    std::size_t transaction_rows = 1000000;
+};
+
+namespace detail
+{
+
+inline void append_column_list(std::string& sql, const std::vector<std::string>& columns)
+{
+    sql += '(';
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        sql += i != 0 ? ", " : "";
+        append_identifier(sql, columns[i]);
+    }
+    sql += ')';
+}
+
+inline void create_import_table(connection& conn, std::string_view table, const std::vector<std::string>& columns, std::error_code& ec)
+{
+    std::string sql{"CREATE TABLE IF NOT EXISTS "};
+    append_identifier(sql, table);
+    append_column_list(sql, columns);
+    statement stmt{conn, sql, ec};
+    if (!ec) {
+        stmt.step(ec);
+    }
+}
+
+// Appends name as a quoted member label of a JSON path, with backslashes
+// escaped as in the JSON key. Older SQLite versions, 3.40 among them, end a
+// label at the first double quote even when escaped, so the caller rejects
+// names holding one.
+inline void append_json_label(std::string& path, std::string_view name)
+{
+    path += '"';
+    for (char c : name) {
+        if (c == '\\') {
+            path += '\\';
+        }
+        path += c;
+    }
+    path += '"';
+}
+
+inline import_settings to_settings(const import_options& options) noexcept
+{
+    return {options.batch_rows, options.batches, options.transaction_rows};
+}
+
+} // namespace detail
+
+// Loads a CSV file into a table through a memory mapping of the file. Fields
+// are bound as text without copies. With a header the table is created when
+// missing, and the columns are matched by name. Returns the number of
+// committed rows; rows of transactions committed before an error stay.
+inline std::size_t import_csv(connection& conn, const std::string& path, std::string_view table, const import_options& options,
+                              std::error_code& ec) noexcept
+{
+    ec.clear();
+    if (options.delimiter == options.quote || options.delimiter == '\n' || options.quote == '\n') {
+        ec = sqlitepp_errc::invalid_argument;
+        return 0;
+    }
+    detail::mapped_file file;
+    file.open(path, ec);
+    if (ec) {
+        return 0;
+    }
+    try {
+        detail::csv_parser parser{file.data(), options.delimiter, options.quote};
+        if (parser.at_end()) {
+            return 0;
+        }
+
+        // the first record tells the number of columns, also without a header
+        detail::import_batch first;
+        auto columns = parser.parse_record(first, ec);
+        if (ec) {
+            return 0;
+        }
+
+        std::string sql{"INSERT INTO "};
+        detail::append_identifier(sql, table);
+        if (options.header) {
+            std::vector<std::string> names{first.fields.begin(), first.fields.end()};
+            detail::create_import_table(conn, table, names, ec);
+            if (ec) {
+                return 0;
+            }
+            detail::append_column_list(sql, names);
+        }
+        sql += " VALUES (";
+        for (std::size_t i = 1; i <= columns; ++i) {
+            sql += i != 1 ? ", ?" : "?";
+            sql += std::to_string(i);
+        }
+        sql += ')';
+
+        if (!options.header) {
+            // start over at the first record
+            parser = detail::csv_parser{file.data(), options.delimiter, options.quote};
+        }
+        return detail::run_import(conn, parser, sql, columns, detail::to_settings(options), ec);
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+        return 0;
+    }
+}
+
+inline std::size_t import_csv(connection& conn, const std::string& path, std::string_view table, std::error_code& ec) noexcept
+{
+    return import_csv(conn, path, table, import_options{}, ec);
+}
+
+inline std::size_t import_csv(connection& conn, const std::string& path, std::string_view table, const import_options& options = {})
+{
+    std::error_code ec;
+    auto rows = import_csv(conn, path, table, options, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+    return rows;
+}
+
+// Loads a file of one JSON object per line. Each line is bound once without
+// a copy and the columns are extracted by name with json_extract(), so a
+// column name may not contain a double quote. The table is created when
+// missing. Returns the number of committed rows.
+inline std::size_t import_ndjson(connection& conn, const std::string& path, std::string_view table, const std::vector<std::string>& columns,
+                                 const import_options& options, std::error_code& ec) noexcept
+{
+    ec.clear();
+    bool quoted = std::any_of(columns.begin(), columns.end(), [](const std::string& c) { return c.find('"') != std::string::npos; });
+    if (columns.empty() || quoted) {
+        ec = sqlitepp_errc::invalid_argument;
+        return 0;
+    }
+    detail::mapped_file file;
+    file.open(path, ec);
+    if (ec) {
+        return 0;
+    }
+    try {
+        detail::create_import_table(conn, table, columns, ec);
+        if (ec) {
+            return 0;
+        }
+
+        std::string sql{"INSERT INTO "};
+        detail::append_identifier(sql, table);
+        detail::append_column_list(sql, columns);
+        sql += " SELECT ";
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            sql += i != 0 ? ", json_extract(?1, " : "json_extract(?1, ";
+            std::string path_text{"$."};
+            detail::append_json_label(path_text, columns[i]);
+            detail::append_literal(sql, path_text);
+            sql += ')';
+        }
+
+        detail::ndjson_parser parser{file.data()};
+        return detail::run_import(conn, parser, sql, 1, detail::to_settings(options), ec);
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+        return 0;
+    }
+}
+
+inline std::size_t import_ndjson(connection& conn, const std::string& path, std::string_view table, const std::vector<std::string>& columns,
+                                 std::error_code& ec) noexcept
+{
+    return import_ndjson(conn, path, table, columns, import_options{}, ec);
+}
+
+inline std::size_t import_ndjson(connection& conn, const std::string& path, std::string_view table, const std::vector<std::string>& columns,
+                                 const import_options& options = {})
+{
+    std::error_code ec;
+    auto rows = import_ndjson(conn, path, table, columns, options, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+    return rows;
+}
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_IMPORT_HPP
@@ -0,0 +1,357 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_MEMORY_GOVERNOR_HPP
+#define SQLITEPP_MEMORY_GOVERNOR_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/detail/memory_pressure.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+class memory_governor;
+
+struct memory_governor_options
+{
+    std::chrono::milliseconds poll_interval{1000};
+    // share of time tasks of the cgroup stalled on memory, in percent, from
+    // which on idle connections are shrunk
+    double pressure_threshold{10.0};
+    // share of the memory limit from which on idle connections are shrunk
+    double usage_threshold{0.9};
+    // bytes, 0 for the memory.max of the cgroup
+    std::uint64_t memory_limit{0};
+    // the cgroup v2 directory to read memory.pressure, memory.current and
+    // memory.max from
+    std::string cgroup_path{"/sys/fs/cgroup"};
+};
+
+struct memory_governor_stats
+{
+    std::uint64_t polls{0};
+    // polls that found memory pressure
+    std::uint64_t pressured{0};
+    // idle connections whose memory was released
+    std::uint64_t released{0};
+};
+
+// Keeps a connection or pool in the registry of a memory_governor for its
+// lifetime.
+class memory_registration
+{
+public:
+    memory_registration() noexcept = default;
+
+    ~memory_registration() noexcept
+    {
+        unregister();
+    }
+
+    memory_registration(const memory_registration&) = delete;
+    memory_registration& operator=(const memory_registration&) = delete;
+
+    memory_registration(memory_registration&& other) noexcept
+        : governor_(std::exchange(other.governor_, nullptr)), id_(std::exchange(other.id_, 0))
+    {
+    }
+
+    memory_registration& operator=(memory_registration&& other) noexcept
+    {
+        if (this != &other) {
+            unregister();
+            governor_ = std::exchange(other.governor_, nullptr);
+            id_ = std::exchange(other.id_, 0);
+        }
+        return *this;
+    }
+
+    bool is_registered() const noexcept
+    {
+        return governor_ != nullptr;
+    }
+
+    // Returns once the governor no longer touches the connection.
+    void unregister() noexcept;
+
+private:
+    friend class memory_governor;
+
+    memory_governor* governor_{nullptr};
+    std::uint64_t id_{0};
+
+    memory_registration(memory_governor* governor, std::uint64_t id) noexcept : governor_(governor), id_(id)
+    {
+    }
+};
+
+// Sets the process-wide heap limits of SQLite and, under memory pressure,
+// releases the memory that idle connections can spare, mostly unused cache
+// pages, which the caches take back as they are used again. Pressure is read
+// from the cgroup v2 files of the container, or the resident set of the
+// process, by a polling thread or on request.
+class memory_governor
+{
+public:
+    // The governor of the process; SQLite heap limits are process-wide.
+    static memory_governor& instance()
+    {
+        static memory_governor governor;
+        return governor;
+    }
+
+    memory_governor() = default;
+
+    ~memory_governor() noexcept
+    {
+        stop();
+    }
+
+    memory_governor(const memory_governor&) = delete;
+    memory_governor& operator=(const memory_governor&) = delete;
+
+    // A negative limit leaves it as it is, 0 removes it. Past the soft limit
+    // SQLite frees cache pages before allocating, past the hard limit
+    // allocations fail with SQLITE_NOMEM.
+    void set_heap_limits(std::int64_t soft, std::int64_t hard) noexcept
+    {
+        sqlite3_soft_heap_limit64(soft);
+        sqlite3_hard_heap_limit64(hard);
+    }
+
+    std::int64_t soft_heap_limit() const noexcept
+    {
+        return sqlite3_soft_heap_limit64(-1);
+    }
+
+    std::int64_t hard_heap_limit() const noexcept
+    {
+        return sqlite3_hard_heap_limit64(-1);
+    }
+
+    // A connection counts as idle when no transaction is open and no
+    // statement is running on it. Telling so from another thread takes the
+    // mutex of the connection, which only serialized builds of SQLite have,
+    // so tracking fails with invalid_argument elsewhere or when the
+    // connection was opened with SQLITE_OPEN_NOMUTEX; track connection pools
+    // instead, whose idle connections are the ones not leased. The connection
+    // must outlive the registration and keep its handle meanwhile.
+    memory_registration track(connection& conn, std::error_code& ec) noexcept
+    {
+        auto db = conn.conn_handle();
+        if (db == nullptr) {
+            ec = sqlitepp_errc::invalid_handle;
+            return {};
+        }
+        if (sqlite3_threadsafe() != 1 || sqlite3_db_mutex(db) == nullptr) {
+            ec = sqlitepp_errc::invalid_argument;
+            return {};
+        }
+        return add([db]() { return release_if_idle(db); }, ec);
+    }
+
+    memory_registration track(connection& conn)
+    {
+        std::error_code ec;
+        auto registration = track(conn, ec);
+        throw_on_error(ec);
+        return registration;
+    }
+
+    // The pool must outlive the registration.
+    memory_registration track(connection_pool& pool, std::error_code& ec) noexcept
+    {
+        return add([&pool]() { return pool.release_idle_memory(); }, ec);
+    }
+
+    memory_registration track(connection_pool& pool)
+    {
+        std::error_code ec;
+        auto registration = track(pool, ec);
+        throw_on_error(ec);
+        return registration;
+    }
+
+    // Releases the memory of the idle tracked connections now. Returns how
+    // many were idle.
+    std::size_t shrink() noexcept
+    {
+        std::size_t released = 0;
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (auto& e : entries_) {
+            released += e.release();
+        }
+        released_ += released;
+        return released;
+    }
+
+    static bool under_pressure(const memory_governor_options& options) noexcept
+    {
+        auto sample = detail::sample_memory(options.cgroup_path);
+        if (sample.pressure && *sample.pressure >= options.pressure_threshold) {
+            return true;
+        }
+        auto limit = options.memory_limit != 0 ? std::optional<std::uint64_t>{options.memory_limit} : sample.limit;
+        return sample.current && limit && static_cast<double>(*sample.current) >= options.usage_threshold * static_cast<double>(*limit);
+    }
+
+    // Polls for memory pressure on a thread of the governor, shrinking the
+    // idle connections each time it finds some. Restarts a running poll
+    // with the new options.
+    void start(memory_governor_options options, std::error_code& ec) noexcept
+    {
+        stop();
+        try {
+            std::lock_guard<std::mutex> lock{poll_mutex_};
+            stopping_ = false;
+            poller_ = std::thread{[this, options = std::move(options)]() { poll(options); }};
+            ec.clear();
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        catch (const std::system_error& e) {
+            ec = e.code();
+        }
+    }
+
+    void start(memory_governor_options options = {})
+    {
+        std::error_code ec;
+        start(std::move(options), ec);
+        throw_on_error(ec);
+    }
+
+    void stop() noexcept
+    {
+        std::thread poller;
+        {
+            std::lock_guard<std::mutex> lock{poll_mutex_};
+            stopping_ = true;
+            poller = std::move(poller_);
+        }
+        wake_.notify_all();
+        if (poller.joinable()) {
+            poller.join();
+        }
+    }
+
+    memory_governor_stats stats() const noexcept
+    {
+        return {polls_.load(), pressured_.load(), released_.load()};
+    }
+
+private:
+    friend class memory_registration;
+
+    struct entry
+    {
+        std::uint64_t id;
+        std::function<std::size_t()> release;
+    };
+
+    // guards the registry; held while releasing, so unregistering waits for it
+    std::mutex mutex_;
+    std::vector<entry> entries_;
+    std::uint64_t last_id_{0};
+
+    std::mutex poll_mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread poller_;
+
+    std::atomic<std::uint64_t> polls_{0};
+    std::atomic<std::uint64_t> pressured_{0};
+    std::atomic<std::uint64_t> released_{0};
+
+    static void throw_on_error(const std::error_code& ec)
+    {
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    memory_registration add(std::function<std::size_t()> release, std::error_code& ec) noexcept
+    {
+        try {
+            std::lock_guard<std::mutex> lock{mutex_};
+            entries_.push_back({++last_id_, std::move(release)});
+            ec.clear();
+            return memory_registration{this, last_id_};
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        return {};
+    }
+
+    void remove(std::uint64_t id) noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [id](const entry& e) { return e.id == id; }), entries_.end());
+    }
+
+    static std::size_t release_if_idle(conn_handle_t db) noexcept
+    {
+        auto mutex = sqlite3_db_mutex(db);
+        // busy connections are not idle, so do not wait for them
+        if (sqlite3_mutex_try(mutex) != SQLITE_OK) {
+            return 0;
+        }
+        bool idle = sqlite3_get_autocommit(db) != 0;
+        for (auto stmt = sqlite3_next_stmt(db, nullptr); idle && stmt != nullptr; stmt = sqlite3_next_stmt(db, stmt)) {
+            idle = sqlite3_stmt_busy(stmt) == 0;
+        }
+        if (idle) {
+            sqlite3_db_release_memory(db);
+        }
+        sqlite3_mutex_leave(mutex);
+        return idle ? 1 : 0;
+    }
+
+    void poll(const memory_governor_options& options) noexcept
+    {
+        std::unique_lock<std::mutex> lock{poll_mutex_};
+        while (!wake_.wait_for(lock, options.poll_interval, [this]() { return stopping_; })) {
+            lock.unlock();
+            ++polls_;
+            if (under_pressure(options)) {
+                ++pressured_;
+                shrink();
+            }
+            lock.lock();
+        }
+    }
+};
+
+inline void memory_registration::unregister() noexcept
+{
+    if (governor_ != nullptr) {
+        governor_->remove(id_);
+        governor_ = nullptr;
+    }
+}
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_MEMORY_GOVERNOR_HPP
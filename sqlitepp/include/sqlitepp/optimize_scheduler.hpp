@@ -0,0 +1,365 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_OPTIMIZE_SCHEDULER_HPP
+#define SQLITEPP_OPTIMIZE_SCHEDULER_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/update_hooks.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+struct optimize_options
+{
+    // rows changed since the last ANALYZE, as a share of the rows it counted,
+    // from which the statistics of a table count as stale
+    double stale_ratio{0.5};
+    // changes below which a table is left alone, whatever its size
+    std::uint64_t min_changes{1000};
+    // PRAGMA analysis_limit of the runs, rows examined per index, 0 for all
+    int analysis_limit{400};
+    std::chrono::milliseconds poll_interval{10000};
+    // also run PRAGMA optimize when the connection closes
+    bool optimize_on_close{true};
+    int busy_timeout_ms{5000};
+};
+
+struct optimize_stats
+{
+    std::uint64_t runs{0};
+    // tables analyzed
+    std::uint64_t analyzed{0};
+};
+
+// Counts the rows a connection changes per table of its main schema, through
+// the update hook, and re-analyzes the tables whose sqlite_stat1 rows are
+// likely stale on a background connection to the same file, on request or
+// from a polling thread. The background connection runs ANALYZE per table
+// rather than PRAGMA optimize, which only considers the tables the
+// connection running it has queried; that one runs on close instead. The
+// update hook does not report WITHOUT ROWID tables. The connection may be
+// closed while the scheduler is attached, but the connection object must
+// outlive it; destroying the scheduler first restores the optimize-on-close
+// setting the connection had.
+class optimize_scheduler
+{
+public:
+    explicit optimize_scheduler(connection& conn, optimize_options options = {}) : options_(options)
+    {
+        std::error_code ec;
+        attach(conn, ec);
+        throw_on_error(ec);
+    }
+
+    optimize_scheduler(connection& conn, optimize_options options, std::error_code& ec) noexcept : options_(options)
+    {
+        attach(conn, ec);
+    }
+
+    ~optimize_scheduler() noexcept
+    {
+        stop();
+        // a closed connection took its hooks with it
+        if (auto hooks = hooks_.lock()) {
+            hooks->remove(conn_handle_, this);
+            if (options_.optimize_on_close && conn_->conn_handle() == conn_handle_) {
+                conn_->impl_.set_optimize_on_close(previous_optimize_on_close_);
+            }
+        }
+    }
+
+    optimize_scheduler(const optimize_scheduler&) = delete;
+    optimize_scheduler& operator=(const optimize_scheduler&) = delete;
+
+    bool is_attached() const noexcept
+    {
+        return conn_handle_ != nullptr;
+    }
+
+    // Rows of table changed since it was last analyzed by the scheduler.
+    std::uint64_t pending_changes(std::string_view table) const noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto it = changes_.find(table);
+        return it != changes_.end() ? it->second : 0;
+    }
+
+    // Analyzes the tables with stale statistics now. Returns how many.
+    std::size_t run_now(std::error_code& ec) noexcept
+    {
+        ec.clear();
+        if (!is_attached()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return 0;
+        }
+        std::lock_guard<std::mutex> run_lock{run_mutex_};
+        ++runs_;
+        std::size_t analyzed = 0;
+        try {
+            std::vector<std::pair<std::string, std::uint64_t>> candidates;
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                for (auto& [table, changes] : changes_) {
+                    if (changes >= options_.min_changes) {
+                        candidates.emplace_back(table, changes);
+                    }
+                }
+            }
+            if (candidates.empty()) {
+                return 0;
+            }
+            run_query(background_, "PRAGMA analysis_limit = " + std::to_string(options_.analysis_limit), ec);
+            for (auto& [table, changes] : candidates) {
+                if (ec) {
+                    break;
+                }
+                auto rows = analyzed_rows(table);
+                if (rows && static_cast<double>(changes) < options_.stale_ratio * static_cast<double>(*rows)) {
+                    continue;
+                }
+                std::string sql{"ANALYZE main."};
+                detail::append_identifier(sql, table);
+                run_query(background_, sql, ec);
+                if (ec == sqlite3_errc::generic_error && !table_exists(table)) {
+                    // dropped since its rows changed
+                    ec.clear();
+                    forget(table, changes);
+                    continue;
+                }
+                if (!ec) {
+                    forget(table, changes);
+                    ++analyzed;
+                }
+            }
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        analyzed_ += analyzed;
+        return analyzed;
+    }
+
+    std::size_t run_now()
+    {
+        std::error_code ec;
+        auto analyzed = run_now(ec);
+        throw_on_error(ec);
+        return analyzed;
+    }
+
+    // Calls run_now every poll_interval on a thread of the scheduler, which
+    // drops errors such as a busy database and tries again next time.
+    void start(std::error_code& ec) noexcept
+    {
+        stop();
+        try {
+            std::lock_guard<std::mutex> lock{poll_mutex_};
+            stopping_ = false;
+            poller_ = std::thread{[this]() { poll(); }};
+            ec.clear();
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        catch (const std::system_error& e) {
+            ec = e.code();
+        }
+    }
+
+    void start()
+    {
+        std::error_code ec;
+        start(ec);
+        throw_on_error(ec);
+    }
+
+    void stop() noexcept
+    {
+        std::thread poller;
+        {
+            std::lock_guard<std::mutex> lock{poll_mutex_};
+            stopping_ = true;
+            poller = std::move(poller_);
+        }
+        wake_.notify_all();
+        if (poller.joinable()) {
+            poller.join();
+        }
+    }
+
+    optimize_stats stats() const noexcept
+    {
+        return {runs_.load(), analyzed_.load()};
+    }
+
+private:
+    optimize_options options_;
+    connection* conn_{nullptr};
+    conn_handle_t conn_handle_{nullptr};
+    std::weak_ptr<detail::update_hooks> hooks_;
+    int previous_optimize_on_close_{-1};
+    connection background_;
+
+    // guards the counters, which the hook of the connection and the runs share
+    mutable std::mutex mutex_;
+    std::map<std::string, std::uint64_t, std::less<>> changes_;
+    // the counter of the last table of the main schema; compared by name, as
+    // SQLite may pass the address of a dropped table's name for another one
+    std::string last_table_;
+    std::uint64_t* last_changes_{nullptr};
+
+    std::mutex run_mutex_;
+    std::atomic<std::uint64_t> runs_{0};
+    std::atomic<std::uint64_t> analyzed_{0};
+
+    std::mutex poll_mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread poller_;
+
+    static void throw_on_error(const std::error_code& ec)
+    {
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    void attach(connection& conn, std::error_code& ec) noexcept
+    {
+        if (!conn.is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        auto db = conn.conn_handle();
+        auto filename = sqlite3_db_filename(db, "main");
+        if (filename == nullptr || *filename == '\0') {
+            // a temporary or in-memory database has no file to open twice
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        if (!background_.open(filename, connection::openmode::rw, ec)) {
+            return;
+        }
+        sqlite3_busy_timeout(background_.conn_handle(), options_.busy_timeout_ms);
+
+        auto hooks = conn.impl_.update_hook_registry(ec);
+        if (ec) {
+            return;
+        }
+        hooks->add(db, this, &optimize_scheduler::on_update, ec);
+        if (ec) {
+            return;
+        }
+        hooks_ = hooks;
+        conn_handle_ = db;
+        conn_ = &conn;
+        if (options_.optimize_on_close) {
+            previous_optimize_on_close_ = conn.impl_.optimize_on_close();
+            conn.set_optimize_on_close(true, options_.analysis_limit);
+        }
+    }
+
+    static void on_update(void* self, int, const char* db, const char* table, sqlite3_int64) noexcept
+    {
+        if (std::strcmp(db, "main") != 0) {
+            return;
+        }
+        auto& scheduler = *static_cast<optimize_scheduler*>(self);
+        std::lock_guard<std::mutex> lock{scheduler.mutex_};
+        if (scheduler.last_changes_ == nullptr || scheduler.last_table_ != table) {
+            scheduler.last_changes_ = nullptr;
+            try {
+                scheduler.last_table_ = table;
+                scheduler.last_changes_ = &scheduler.changes_[table];
+            }
+            catch (const std::bad_alloc&) {
+                return;
+            }
+        }
+        ++*scheduler.last_changes_;
+    }
+
+    static void run_query(connection& conn, std::string_view sql, std::error_code& ec) noexcept
+    {
+        statement stmt{conn, sql, ec};
+        while (!ec && stmt.step(ec)) {
+        }
+    }
+
+    // The row count the last ANALYZE stored for table, none when it has not
+    // been analyzed.
+    std::optional<std::uint64_t> analyzed_rows(const std::string& table) noexcept
+    {
+        std::error_code ec;
+        // the stat column starts with the row count; no sqlite_stat1 table fails to prepare
+        statement stmt{background_, "SELECT max(CAST(stat AS INTEGER)) FROM main.sqlite_stat1 WHERE tbl = ?1", ec};
+        if (!ec) {
+            stmt.bind(1, table, ec);
+        }
+        if (ec || !stmt.step(ec) || stmt.column_type(0) == datatype::null) {
+            return std::nullopt;
+        }
+        return static_cast<std::uint64_t>(stmt.column_int64(0));
+    }
+
+    bool table_exists(const std::string& table) noexcept
+    {
+        std::error_code ec;
+        statement stmt{background_, "SELECT 1 FROM main.sqlite_schema WHERE type = 'table' AND name = ?1", ec};
+        if (!ec) {
+            stmt.bind(1, table, ec);
+        }
+        return !ec && stmt.step(ec);
+    }
+
+    void forget(const std::string& table, std::uint64_t changes) noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto it = changes_.find(table);
+        if (it != changes_.end()) {
+            // keep what changed while the run went on
+            it->second -= std::min(it->second, changes);
+        }
+    }
+
+    void poll() noexcept
+    {
+        std::unique_lock<std::mutex> lock{poll_mutex_};
+        while (!wake_.wait_for(lock, options_.poll_interval, [this]() { return stopping_; })) {
+            lock.unlock();
+            std::error_code ec;
+            run_now(ec);
+            lock.lock();
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_OPTIMIZE_SCHEDULER_HPP
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_PARALLEL_QUERY_HPP
+#define SQLITEPP_PARALLEL_QUERY_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// Half-open key interval [lo, hi) bound to ?1 and ?2 of a partitioned query.
+struct key_range
+{
+    std::int64_t lo;
+    std::int64_t hi;
+};
+
+// Splits the rowid span of a table into at most n ranges of equal width.
+// Returns no ranges for an empty table.
+inline std::vector<key_range> split_rowid_range(connection& conn, std::string_view table, std::size_t n, std::error_code& ec) noexcept
+{
+    std::vector<key_range> ranges;
+    if (n == 0) {
+        ec = sqlitepp_errc::invalid_argument;
+        return ranges;
+    }
+    try {
+        std::string sql{"SELECT min(rowid), max(rowid) FROM "};
+        detail::append_identifier(sql, table);
+
+        statement stmt{conn, sql, ec};
+        if (ec || !stmt.step(ec) || stmt.column_type(0) == datatype::null) {
+            return ranges;
+        }
+        auto lo = stmt.column_int64(0);
+        auto hi = stmt.column_int64(1);
+        // unsigned arithmetic, the span of negative and positive rowids may not fit in int64
+        auto span = static_cast<std::uint64_t>(hi) - static_cast<std::uint64_t>(lo) + 1;
+        auto width = std::max<std::uint64_t>(span / n + (span % n != 0), 1);
+        for (std::uint64_t offset = 0; offset < span && ranges.size() < n; offset += width) {
+            auto begin = static_cast<std::int64_t>(static_cast<std::uint64_t>(lo) + offset);
+            auto end = span - offset <= width ? hi : static_cast<std::int64_t>(static_cast<std::uint64_t>(begin) + width - 1);
+            // store the inclusive end as an exclusive one where it cannot overflow
+            ranges.push_back({begin, end == INT64_MAX ? end : end + 1});
+        }
+        if (hi == INT64_MAX) {
+            // [lo, INT64_MAX) would miss the largest possible rowid, so the last range is closed
+            ranges.back().hi = INT64_MAX;
+        }
+    }
+    catch (const std::bad_alloc&) {
+        ranges.clear();
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+    return ranges;
+}
+
+inline std::vector<key_range> split_rowid_range(connection& conn, std::string_view table, std::size_t n)
+{
+    std::error_code ec;
+    auto ranges = split_rowid_range(conn, table, n, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+    return ranges;
+}
+
+// Runs one query per key range on pooled connections and folds the partial
+// results. The query takes the range bounds as ?1 and ?2, typically
+// "... WHERE rowid >= ?1 AND rowid < ?2". All partitions read the same
+// snapshot: every worker opens its read transaction while a write lock on the
+// database keeps other writers from committing in between. This requires a
+// database in WAL mode, so that readers are not blocked by that lock. The
+// lock is taken through a connection opened like those of the pool, but
+// read-write; on a database file this process may only read, it cannot be
+// taken and writers in other processes are not held off.
+class parallel_query
+{
+public:
+    parallel_query(connection_pool& connections, thread_pool& threads) noexcept : connections_(connections), threads_(threads)
+    {
+    }
+
+    // partial(statement&) returns the result of one partition from the bound,
+    // not yet stepped statement. combine(T, T) folds the partial results into
+    // init in partition order.
+    template<typename T, typename Partial, typename Combine>
+    T run(std::string_view sql, const std::vector<key_range>& partitions, T init, Partial partial, Combine combine, std::error_code& ec)
+    {
+        ec.clear();
+        auto workers = std::min({connections_.size(), threads_.size(), partitions.size()});
+        if (workers == 0) {
+            return init;
+        }
+
+        auto leases = connections_.acquire(workers);
+
+        std::deque<transaction> reads;
+        begin_snapshot(connections_, leases, reads, ec);
+        if (ec) {
+            return init;
+        }
+
+        std::vector<std::optional<T>> results(partitions.size());
+        std::vector<std::error_code> errors(workers);
+        std::atomic<std::size_t> next{0};
+        std::vector<std::future<void>> done;
+        done.reserve(workers);
+        for (std::size_t w = 0; w < workers; ++w) {
+            done.push_back(threads_.submit([&, w]() {
+                auto& error = errors[w];
+                statement stmt{*leases[w], sql, error};
+                for (auto i = next++; !error && i < partitions.size(); i = next++) {
+                    stmt.reset(error);
+                    if (!error) {
+                        stmt.bind(1, partitions[i].lo, error);
+                    }
+                    if (!error) {
+                        stmt.bind(2, partitions[i].hi, error);
+                    }
+                    if (!error) {
+                        results[i].emplace(partial(stmt));
+                    }
+                }
+                if (error) {
+                    // let the other workers stop early
+                    next = partitions.size();
+                }
+            }));
+        }
+        // wait for every worker before rethrowing, they reference this frame
+        for (auto& d : done) {
+            d.wait();
+        }
+        for (auto& d : done) {
+            d.get();
+        }
+        for (auto& error : errors) {
+            if (error) {
+                ec = error;
+                return init;
+            }
+        }
+
+        for (auto& result : results) {
+            init = combine(std::move(init), std::move(*result));
+        }
+        return init;
+    }
+
+    template<typename T, typename Partial, typename Combine>
+    T run(std::string_view sql, const std::vector<key_range>& partitions, T init, Partial partial, Combine combine)
+    {
+        std::error_code ec;
+        auto result = run(sql, partitions, std::move(init), std::move(partial), std::move(combine), ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+        return result;
+    }
+
+private:
+    static constexpr int gate_timeout_ms = 5000;
+
+    connection_pool& connections_;
+    thread_pool& threads_;
+
+    static void begin_snapshot(connection_pool& pool, std::vector<connection_pool::lease>& leases, std::deque<transaction>& reads,
+                               std::error_code& ec)
+    {
+        connection gate;
+        std::optional<transaction> gate_lock;
+        auto filename = sqlite3_db_filename(leases.front()->conn_handle(), "main");
+        // temporary and in-memory databases are private to each connection
+        if (leases.size() > 1 && filename != nullptr && *filename != '\0') {
+            auto flags = (pool.flags() & ~(SQLITE_OPEN_READONLY | SQLITE_OPEN_CREATE)) | SQLITE_OPEN_READWRITE;
+            if (!gate.open(pool.filename(), flags, pool.vfsname(), ec)) {
+                return;
+            }
+            if (sqlite3_db_readonly(gate.conn_handle(), "main") == 0) {
+                sqlite3_busy_timeout(gate.conn_handle(), gate_timeout_ms);
+                gate_lock.emplace(gate, transaction::mode::immediate, ec);
+                if (ec) {
+                    return;
+                }
+            }
+        }
+
+        for (auto& lease : leases) {
+            auto& read = reads.emplace_back(*lease, transaction::mode::deferred, ec);
+            if (ec) {
+                return;
+            }
+            // BEGIN DEFERRED takes no snapshot until the first read
+            statement probe{*lease, "SELECT count(*) FROM sqlite_master", ec};
+            if (!ec) {
+                probe.step(ec);
+            }
+            if (!ec && !read.is_active()) {
+                ec = sqlitepp_errc::invalid_handle;
+            }
+            if (ec) {
+                return;
+            }
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_PARALLEL_QUERY_HPP
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_PREPARED_STATEMENTS_HPP
+#define SQLITEPP_PREPARED_STATEMENTS_HPP
+
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace sqlitepp
+{
+
+// Statements prepared on one connection by name, for the thread that uses
+// the connection. Must be destroyed or cleared before the connection is
+// closed.
+class prepared_statements
+{
+public:
+    // nullptr when there is no statement of that name
+    statement* find(std::string_view name) noexcept
+    {
+        auto it = statements_.find(name);
+        return it != statements_.end() ? &it->second : nullptr;
+    }
+
+    statement& at(std::string_view name)
+    {
+        auto stmt = find(name);
+        if (stmt == nullptr) {
+            throw std::system_error(sqlitepp_errc::invalid_argument);
+        }
+        return *stmt;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return statements_.size();
+    }
+
+    void add(const std::string& name, statement stmt)
+    {
+        statements_.insert_or_assign(name, std::move(stmt));
+    }
+
+    void clear() noexcept
+    {
+        statements_.clear();
+    }
+
+private:
+    std::map<std::string, statement, std::less<>> statements_;
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_PREPARED_STATEMENTS_HPP
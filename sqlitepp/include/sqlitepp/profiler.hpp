@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_PROFILER_HPP
+#define SQLITEPP_PROFILER_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/latency_histogram.hpp>
+#include <sqlitepp/detail/profiler_impl.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace sqlitepp
+{
+
+class latency_histogram
+{
+public:
+    void merge(const latency_histogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+    }
+
+    std::uint64_t count() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (auto n : counts_) {
+            total += n;
+        }
+        return total;
+    }
+
+    // Returns the upper bound of the bucket holding the given quantile (0.0 - 1.0).
+    std::chrono::nanoseconds percentile(double quantile) const noexcept
+    {
+        std::uint64_t total = count();
+        if (total == 0) {
+            return std::chrono::nanoseconds{0};
+        }
+        quantile = std::clamp(quantile, 0.0, 1.0);
+        auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(quantile * static_cast<double>(total) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                auto bound = static_cast<double>(detail::histogram_layout::upper_bound_of(i)) * nanoseconds_per_unit_;
+                return std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(bound)};
+            }
+        }
+        return std::chrono::nanoseconds::max();
+    }
+
+private:
+    friend class profiler;
+
+    std::array<std::uint64_t, detail::histogram_layout::bucket_count> counts_{};
+    double nanoseconds_per_unit_{1.0};
+};
+
+struct statement_profile
+{
+    std::string sql;
+    std::uint64_t calls{0};
+    std::uint64_t rows{0};
+    std::chrono::nanoseconds total_time{0};
+    std::chrono::nanoseconds min_time{0};
+    std::chrono::nanoseconds max_time{0};
+    latency_histogram latency;
+
+    std::chrono::nanoseconds mean_time() const noexcept
+    {
+        return calls != 0 ? total_time / static_cast<std::chrono::nanoseconds::rep>(calls) : std::chrono::nanoseconds{0};
+    }
+};
+
+using profile_snapshot = std::vector<statement_profile>;
+
+// Aggregates execution statistics per normalized SQL text of all statements
+// run on a connection: literals and parameters are replaced by ?, so the
+// runs of a statement with different values are counted together. The text
+// is the one of sqlite3_normalized_sql when SQLITE_ENABLE_NORMALIZE is
+// defined, and otherwise normalized by the profiler, which also drops
+// comments and collapses whitespace. Shares the trace callback of the
+// connection with the other users in the library, replacing any callback set
+// with sqlite3_trace_v2. The connection may be closed while the profiler is
+// attached, after which the profiler is detached and keeps the statistics
+// gathered until then.
+class profiler
+{
+public:
+    explicit profiler(connection& conn)
+    {
+        std::error_code ec;
+        attach(conn, ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    profiler(connection& conn, std::error_code& ec) noexcept
+    {
+        attach(conn, ec);
+    }
+
+    ~profiler() noexcept
+    {
+        // a closed connection took its hooks with it
+        if (auto traces = traces_.lock()) {
+            traces->remove(conn_handle_, &impl_);
+        }
+    }
+
+    profiler(const profiler&) = delete;
+    profiler& operator=(const profiler&) = delete;
+
+    bool is_attached() const noexcept
+    {
+        return conn_handle_ != nullptr && !traces_.expired();
+    }
+
+    // Merges the per-thread statistics; safe to call while statements run.
+    profile_snapshot snapshot() const
+    {
+        std::unordered_map<std::string_view, statement_profile> merged;
+        double scale = impl_.nanoseconds_per_tick();
+        auto to_nanoseconds = [scale](std::uint64_t ticks) {
+            return std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(static_cast<double>(ticks) * scale)};
+        };
+        impl_.visit([&merged, &to_nanoseconds, scale](const detail::profiler_impl::entry& e) {
+            auto calls = e.calls.load(std::memory_order_relaxed);
+            if (calls == 0) {
+                return;
+            }
+            auto [it, inserted] = merged.try_emplace(e.sql);
+            auto& profile = it->second;
+            auto min_time = to_nanoseconds(e.min_ticks.load(std::memory_order_relaxed));
+            auto max_time = to_nanoseconds(e.max_ticks.load(std::memory_order_relaxed));
+            if (inserted) {
+                profile.sql = e.sql;
+                profile.min_time = min_time;
+                profile.latency.nanoseconds_per_unit_ = scale;
+            }
+            profile.calls += calls;
+            profile.rows += e.rows.load(std::memory_order_relaxed);
+            profile.total_time += to_nanoseconds(e.total_ticks.load(std::memory_order_relaxed));
+            profile.min_time = std::min(profile.min_time, min_time);
+            profile.max_time = std::max(profile.max_time, max_time);
+            e.histogram.merge_into(profile.latency.counts_);
+        });
+
+        profile_snapshot result;
+        result.reserve(merged.size());
+        for (auto& [sql, profile] : merged) {
+            result.push_back(std::move(profile));
+        }
+        std::sort(result.begin(), result.end(), [](const statement_profile& a, const statement_profile& b) { return a.total_time > b.total_time; });
+        return result;
+    }
+
+private:
+    detail::profiler_impl impl_;
+    conn_handle_t conn_handle_{nullptr};
+    std::weak_ptr<detail::trace_hooks> traces_;
+
+    void attach(connection& conn, std::error_code& ec) noexcept
+    {
+        if (!conn.is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        auto traces = conn.impl_.trace_hook_registry(ec);
+        if (ec) {
+            return;
+        }
+        traces->add(conn.conn_handle(), &impl_, detail::profiler_impl::trace_mask(), &detail::profiler_impl::on_trace, ec);
+        if (ec) {
+            return;
+        }
+        conn_handle_ = conn.conn_handle();
+        traces_ = traces;
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_PROFILER_HPP
@@ -0,0 +1,635 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_QUERY_CACHE_HPP
+#define SQLITEPP_QUERY_CACHE_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/query_cache_impl.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/statement_impl.hpp>
+#include <sqlitepp/detail/update_hooks.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// All rows of a query, copied out of the statement. Values keep the storage
+// class they had in the result; the accessors convert between integer and
+// real only, and read NULL as 0 or empty.
+class query_result
+{
+public:
+    std::size_t row_count() const noexcept
+    {
+        return column_count_ != 0 ? cells_.size() / static_cast<std::size_t>(column_count_) : 0;
+    }
+
+    int column_count() const noexcept
+    {
+        return column_count_;
+    }
+
+    std::string_view column_name(int column) const noexcept
+    {
+        return names_[static_cast<std::size_t>(column)];
+    }
+
+    datatype column_type(std::size_t row, int column) const noexcept
+    {
+        return at(row, column).type;
+    }
+
+    std::int64_t column_int64(std::size_t row, int column) const noexcept
+    {
+        auto& c = at(row, column);
+        return c.type == datatype::integer ? c.integer : c.type == datatype::real ? static_cast<std::int64_t>(c.real) : 0;
+    }
+
+    double column_double(std::size_t row, int column) const noexcept
+    {
+        auto& c = at(row, column);
+        return c.type == datatype::real ? c.real : c.type == datatype::integer ? static_cast<double>(c.integer) : 0.0;
+    }
+
+    std::string_view column_text(std::size_t row, int column) const noexcept
+    {
+        auto& c = at(row, column);
+        return is_bytes(c) ? std::string_view{data_.data() + c.offset, c.size} : std::string_view{};
+    }
+
+    blob_view column_blob(std::size_t row, int column) const noexcept
+    {
+        auto& c = at(row, column);
+        return is_bytes(c) ? blob_view{data_.data() + c.offset, c.size} : blob_view{};
+    }
+
+    // Bytes held by the result, as charged against the cache budget.
+    std::size_t memory_size() const noexcept
+    {
+        std::size_t size = sizeof(*this) + cells_.capacity() * sizeof(cell) + data_.capacity();
+        for (auto& name : names_) {
+            size += sizeof(name) + name.capacity();
+        }
+        return size;
+    }
+
+private:
+    friend class query_cache;
+
+    struct cell
+    {
+        datatype type;
+        std::size_t size;
+        union
+        {
+            std::int64_t integer;
+            double real;
+            std::size_t offset;
+        };
+    };
+
+    int column_count_{0};
+    std::vector<std::string> names_;
+    std::vector<cell> cells_;
+    std::string data_;
+
+    const cell& at(std::size_t row, int column) const noexcept
+    {
+        return cells_[row * static_cast<std::size_t>(column_count_) + static_cast<std::size_t>(column)];
+    }
+
+    static bool is_bytes(const cell& c) noexcept
+    {
+        return c.type == datatype::text || c.type == datatype::blob;
+    }
+
+    // Steps the statement to the end; throws std::bad_alloc.
+    void read(detail::statement_impl& stmt, std::error_code& ec)
+    {
+        auto handle = stmt.stmt_handle();
+        column_count_ = stmt.column_count();
+        names_.reserve(static_cast<std::size_t>(column_count_));
+        for (int i = 0; i < column_count_; ++i) {
+            names_.emplace_back(stmt.column_name(i));
+        }
+        while (stmt.step(ec)) {
+            for (int i = 0; i < column_count_; ++i) {
+                cell c{};
+                c.type = static_cast<datatype>(sqlite3_column_type(handle, i));
+                switch (c.type) {
+                case datatype::integer:
+                    c.integer = sqlite3_column_int64(handle, i);
+                    break;
+                case datatype::real:
+                    c.real = sqlite3_column_double(handle, i);
+                    break;
+                case datatype::text: {
+                    auto text = stmt.column_text(i);
+                    c.offset = data_.size();
+                    c.size = text.size();
+                    data_.append(text);
+                    break;
+                }
+                case datatype::blob: {
+                    auto blob = stmt.column_blob(i);
+                    c.offset = data_.size();
+                    c.size = blob.size;
+                    data_.append(static_cast<const char*>(blob.data), blob.size);
+                    break;
+                }
+                case datatype::null:
+                    break;
+                }
+                cells_.push_back(c);
+            }
+        }
+        cells_.shrink_to_fit();
+        data_.shrink_to_fit();
+    }
+};
+
+struct query_cache_options
+{
+    // bytes of keys, results and prepared statements kept before the least
+    // recently used entries, then statements, are evicted
+    std::size_t memory_budget{16 * 1024 * 1024};
+    // prepared statements kept before the least recently used is finalized
+    std::size_t max_statements{256};
+};
+
+struct query_cache_stats
+{
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    // entries dropped because data they were read from changed
+    std::uint64_t invalidations{0};
+    std::uint64_t evictions{0};
+    std::size_t entries{0};
+    std::size_t statements{0};
+    std::size_t memory_used{0};
+
+    double hit_rate() const noexcept
+    {
+        auto lookups = hits + misses;
+        return lookups != 0 ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+    }
+};
+
+// Caches the results of read queries on a connection, keyed by the SQL text
+// and the bound values. An entry is invalidated when a table it read
+// changes: writes through this connection are seen by the update hook,
+// writes by other connections by PRAGMA data_version, and schema changes by
+// PRAGMA schema_version. Writes the update hook misses, such as to WITHOUT
+// ROWID tables, show up as a gap in sqlite3_total_changes and flush the
+// whole cache. Queries inside a transaction, queries that write and queries
+// over virtual tables run uncached.
+//
+// Only cache deterministic queries; a result that depends on random() or the
+// current time is served unchanged until a table changes. Like the
+// connection, a cache is used by one thread at a time; give every connection
+// of a pool its own. The connection may be closed while the cache is
+// attached, after which the cache is detached, but the connection object
+// must outlive it.
+class query_cache
+{
+public:
+    explicit query_cache(connection& conn, query_cache_options options = {}) : options_(options)
+    {
+        std::error_code ec;
+        attach(conn, ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    query_cache(connection& conn, query_cache_options options, std::error_code& ec) noexcept : options_(options)
+    {
+        attach(conn, ec);
+    }
+
+    ~query_cache() noexcept
+    {
+        // a closed connection took its hooks with it
+        if (auto hooks = hooks_.lock()) {
+            hooks->remove(conn_handle_, this);
+        }
+    }
+
+    query_cache(const query_cache&) = delete;
+    query_cache& operator=(const query_cache&) = delete;
+
+    bool is_attached() const noexcept
+    {
+        return conn_handle_ != nullptr && !hooks_.expired();
+    }
+
+    // Returns the rows of sql with args bound to parameters 1..N, from the
+    // cache when a current entry exists.
+    template<typename... Args, std::enable_if_t<std::disjunction_v<std::is_same<Args, std::error_code&>...>, bool> = true>
+    std::shared_ptr<const query_result> query(std::string_view sql, Args&&... args) noexcept
+    {
+        constexpr auto n = sizeof...(Args) - 1;
+        static_assert(std::is_same_v<std::tuple_element_t<n, std::tuple<Args...>>, std::error_code&>, "the error code goes last");
+        auto values = std::forward_as_tuple(args...);
+        return lookup(sql, values, std::get<n>(values), std::make_index_sequence<n>{});
+    }
+
+    template<typename... Args, std::enable_if_t<std::negation_v<std::disjunction<std::is_same<Args, std::error_code&>...>>, bool> = true>
+    std::shared_ptr<const query_result> query(std::string_view sql, Args&&... args)
+    {
+        std::error_code ec;
+        auto values = std::forward_as_tuple(args...);
+        auto result = lookup(sql, values, ec, std::index_sequence_for<Args...>{});
+        if (ec) {
+            throw std::system_error(ec);
+        }
+        return result;
+    }
+
+    void clear() noexcept
+    {
+        index_.clear();
+        entries_.clear();
+        memory_used_ = 0;
+    }
+
+    query_cache_stats stats() const noexcept
+    {
+        return {hits_, misses_, invalidations_, evictions_, entries_.size(), queries_.size(), memory_used_ + statement_memory_};
+    }
+
+private:
+    // per-entry bookkeeping charged on top of key and result
+    static constexpr std::size_t entry_overhead = 128;
+
+    struct table_state
+    {
+        std::uint64_t modified{0};
+    };
+
+    struct prepared_query
+    {
+        std::string sql;
+        detail::statement_impl stmt;
+        std::vector<table_state*> tables;
+        bool cacheable{false};
+        std::size_t bytes{0};
+    };
+
+    using query_iterator = std::list<prepared_query>::iterator;
+
+    struct entry
+    {
+        std::string key;
+        std::shared_ptr<const query_result> result;
+        query_iterator query;
+        std::uint64_t epoch;
+        std::size_t bytes;
+    };
+
+    query_cache_options options_;
+    conn_handle_t conn_handle_{nullptr};
+    std::weak_ptr<detail::update_hooks> hooks_;
+    // plain pragmas, joining their table-valued forms costs several times more
+    detail::statement_impl data_version_stmt_;
+    detail::statement_impl schema_version_stmt_;
+
+    std::list<entry> entries_;
+    std::unordered_map<std::string_view, std::list<entry>::iterator> index_;
+    std::list<prepared_query> queries_;
+    std::unordered_map<std::string_view, query_iterator> query_index_;
+    std::unordered_map<std::string, table_state> tables_;
+    std::string key_;
+    std::string table_key_;
+
+    // bumped by every change to a tracked table; an entry is current while
+    // none of its tables changed after the epoch it was filled in
+    std::uint64_t epoch_{0};
+    std::int64_t data_version_{0};
+    std::int64_t schema_version_{0};
+    std::int64_t total_changes_{0};
+    std::int64_t hooked_changes_{0};
+    std::int64_t seen_hooked_changes_{0};
+    bool lost_change_{false};
+
+    // the table of the last update, by name: SQLite may pass the address of a
+    // dropped table's name for another one
+    std::string last_db_;
+    std::string last_table_;
+    table_state* last_state_{nullptr};
+
+    // of the entries, and of the prepared statements
+    std::size_t memory_used_{0};
+    std::size_t statement_memory_{0};
+    std::uint64_t hits_{0};
+    std::uint64_t misses_{0};
+    std::uint64_t invalidations_{0};
+    std::uint64_t evictions_{0};
+
+    void attach(connection& conn, std::error_code& ec) noexcept
+    {
+        if (!conn.is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        auto db = conn.conn_handle();
+        data_version_stmt_.prepare(db, "PRAGMA data_version", SQLITE_PREPARE_PERSISTENT, ec);
+        if (!ec) {
+            schema_version_stmt_.prepare(db, "PRAGMA schema_version", SQLITE_PREPARE_PERSISTENT, ec);
+        }
+        if (ec || !read_versions(data_version_, schema_version_, ec)) {
+            return;
+        }
+        auto hooks = conn.impl_.update_hook_registry(ec);
+        if (ec) {
+            return;
+        }
+        hooks->add(db, this, &query_cache::on_update, ec);
+        if (ec) {
+            return;
+        }
+        hooks_ = hooks;
+        conn_handle_ = db;
+        total_changes_ = sqlite3_total_changes64(db);
+    }
+
+    static void on_update(void* self, int, const char* db, const char* table, sqlite3_int64) noexcept
+    {
+        auto& cache = *static_cast<query_cache*>(self);
+        ++cache.hooked_changes_;
+        if (cache.last_table_ != table || cache.last_db_ != db) {
+            cache.forget_last_table();
+            try {
+                cache.table_key_.assign(db);
+                cache.table_key_ += '\0';
+                cache.table_key_ += table;
+                auto it = cache.tables_.find(cache.table_key_);
+                cache.last_state_ = it != cache.tables_.end() ? &it->second : nullptr;
+                cache.last_db_ = db;
+                cache.last_table_ = table;
+            }
+            catch (const std::bad_alloc&) {
+                cache.forget_last_table();
+                cache.lost_change_ = true;
+            }
+        }
+        if (cache.last_state_ != nullptr) {
+            cache.last_state_->modified = ++cache.epoch_;
+        }
+    }
+
+    bool read_versions(std::int64_t& data_version, std::int64_t& schema_version, std::error_code& ec) noexcept
+    {
+        return read_pragma(data_version_stmt_, data_version, ec) && read_pragma(schema_version_stmt_, schema_version, ec);
+    }
+
+    static bool read_pragma(detail::statement_impl& stmt, std::int64_t& value, std::error_code& ec) noexcept
+    {
+        if (!stmt.step(ec)) {
+            return false;
+        }
+        value = stmt.column_int64(0);
+        stmt.reset(ec);
+        return !ec;
+    }
+
+    // Drops what other connections, schema changes or unseen writes made stale.
+    void validate(std::error_code& ec) noexcept
+    {
+        std::int64_t data_version = 0;
+        std::int64_t schema_version = 0;
+        if (!read_versions(data_version, schema_version, ec)) {
+            return;
+        }
+        auto total_changes = sqlite3_total_changes64(conn_handle_);
+        bool unseen = total_changes - total_changes_ > hooked_changes_ - seen_hooked_changes_;
+        total_changes_ = total_changes;
+        seen_hooked_changes_ = hooked_changes_;
+
+        if (schema_version != schema_version_) {
+            // root pages and table names may have changed
+            invalidate_all();
+            query_index_.clear();
+            queries_.clear();
+            statement_memory_ = 0;
+            tables_.clear();
+            forget_last_table();
+        }
+        else if (data_version != data_version_ || unseen || lost_change_) {
+            invalidate_all();
+        }
+        data_version_ = data_version;
+        schema_version_ = schema_version;
+        lost_change_ = false;
+    }
+
+    void forget_last_table() noexcept
+    {
+        last_db_.clear();
+        last_table_.clear();
+        last_state_ = nullptr;
+    }
+
+    void invalidate_all() noexcept
+    {
+        invalidations_ += entries_.size();
+        clear();
+    }
+
+    bool is_current(const entry& e) const noexcept
+    {
+        for (auto* table : e.query->tables) {
+            if (table->modified > e.epoch) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void erase(std::list<entry>::iterator it) noexcept
+    {
+        memory_used_ -= it->bytes;
+        index_.erase(it->key);
+        entries_.erase(it);
+    }
+
+    query_iterator prepare(std::string_view sql, std::error_code& ec)
+    {
+        auto found = query_index_.find(sql);
+        if (found != query_index_.end()) {
+            queries_.splice(queries_.begin(), queries_, found->second);
+            return found->second;
+        }
+        std::string text{sql};
+        auto& query = queries_.emplace_front();
+        query.sql = std::move(text);
+        query.stmt.prepare(conn_handle_, sql, SQLITE_PREPARE_PERSISTENT, ec);
+        auto deps = ec ? detail::query_dependencies{} : detail::resolve_query_dependencies(conn_handle_, query.stmt.stmt_handle(), ec);
+        if (ec) {
+            queries_.pop_front();
+            return queries_.end();
+        }
+        try {
+            query_index_.emplace(query.sql, queries_.begin());
+            for (auto& table : deps.tables) {
+                query.tables.push_back(&tables_[table]);
+            }
+        }
+        catch (const std::bad_alloc&) {
+            query_index_.erase(query.sql);
+            queries_.pop_front();
+            throw;
+        }
+        // the last update may have been to a table that was not tracked until now
+        forget_last_table();
+        query.cacheable = deps.cacheable;
+        query.bytes = sizeof(prepared_query) + query.sql.capacity() + query.tables.capacity() * sizeof(table_state*) +
+                      static_cast<std::size_t>(sqlite3_stmt_status(query.stmt.stmt_handle(), SQLITE_STMTSTATUS_MEMUSED, 0));
+        statement_memory_ += query.bytes;
+        while (queries_.size() > std::max<std::size_t>(options_.max_statements, 1)) {
+            erase_query(std::prev(queries_.end()));
+        }
+        shrink();
+        return queries_.begin();
+    }
+
+    // Finalizes a statement along with the entries read through it.
+    void erase_query(query_iterator query) noexcept
+    {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            auto next = std::next(it);
+            if (it->query == query) {
+                erase(it);
+                ++evictions_;
+            }
+            it = next;
+        }
+        statement_memory_ -= query->bytes;
+        query_index_.erase(query->sql);
+        queries_.erase(query);
+    }
+
+    // Evicts entries, then statements other than the most recent one, until
+    // the budget holds.
+    void shrink() noexcept
+    {
+        while (memory_used_ + statement_memory_ > options_.memory_budget) {
+            if (!entries_.empty()) {
+                erase(std::prev(entries_.end()));
+                ++evictions_;
+            }
+            else if (queries_.size() > 1) {
+                erase_query(std::prev(queries_.end()));
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    void store(query_iterator query, const std::shared_ptr<const query_result>& result)
+    {
+        auto bytes = key_.size() + result->memory_size() + entry_overhead;
+        if (bytes + statement_memory_ > options_.memory_budget) {
+            return;
+        }
+        entries_.push_front(entry{key_, result, query, epoch_, bytes});
+        index_.emplace(entries_.front().key, entries_.begin());
+        memory_used_ += bytes;
+        shrink();
+    }
+
+    template<typename Tuple, std::size_t... I>
+    std::shared_ptr<const query_result> lookup(std::string_view sql, const Tuple& values, std::error_code& ec, std::index_sequence<I...>) noexcept
+    {
+        if (!is_attached()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return nullptr;
+        }
+        try {
+            key_.assign(sql);
+            key_ += '\0';
+            (detail::append_key_value(key_, std::get<I>(values)), ...);
+
+            // reads inside a transaction may see its uncommitted writes
+            bool cached = sqlite3_get_autocommit(conn_handle_) != 0;
+            if (cached) {
+                validate(ec);
+                if (ec) {
+                    return nullptr;
+                }
+                auto it = index_.find(key_);
+                if (it != index_.end()) {
+                    if (is_current(*it->second)) {
+                        entries_.splice(entries_.begin(), entries_, it->second);
+                        queries_.splice(queries_.begin(), queries_, it->second->query);
+                        ++hits_;
+                        ec.clear();
+                        return entries_.front().result;
+                    }
+                    erase(it->second);
+                    ++invalidations_;
+                }
+            }
+            ++misses_;
+
+            auto query = prepare(sql, ec);
+            if (ec) {
+                return nullptr;
+            }
+            auto& stmt = query->stmt;
+            if (stmt.parameter_count() != static_cast<int>(sizeof...(I))) {
+                ec = sqlitepp_errc::invalid_argument;
+                return nullptr;
+            }
+            ec.clear();
+            ((ec ? void() : stmt.bind(static_cast<int>(I + 1), std::get<I>(values), ec)), ...);
+            auto result = std::make_shared<query_result>();
+            std::error_code reset_ec;
+            if (!ec) {
+                try {
+                    result->read(stmt, ec);
+                }
+                catch (const std::bad_alloc&) {
+                    stmt.reset(reset_ec);
+                    throw;
+                }
+            }
+            stmt.reset(reset_ec);
+            stmt.clear_bindings(reset_ec);
+            if (ec) {
+                return nullptr;
+            }
+            if (cached && query->cacheable) {
+                store(query, result);
+            }
+            return result;
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return nullptr;
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_QUERY_CACHE_HPP
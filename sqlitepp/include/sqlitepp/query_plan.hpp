@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_QUERY_PLAN_HPP
+#define SQLITEPP_QUERY_PLAN_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// One row of EXPLAIN QUERY PLAN, with the rows it is the parent of.
+struct plan_node
+{
+    int id{0};
+    int parent{0};
+    // such as "SEARCH t USING INDEX t_x (x=?)" or "SCAN t"
+    std::string detail;
+    std::vector<plan_node> children;
+};
+
+struct query_plan
+{
+    std::vector<plan_node> nodes;
+
+    // The SCAN nodes that read a whole table or index, leaving out scans of
+    // constant rows and of subqueries and CTEs materialized for the query.
+    // Scans of a covering index count, they read every row too.
+    std::vector<const plan_node*> full_scans() const
+    {
+        std::vector<std::string_view> temporary;
+        for_each(nodes, [&](const plan_node& node) {
+            for (std::string_view prefix : {"MATERIALIZE ", "CO-ROUTINE "}) {
+                if (std::string_view{node.detail}.substr(0, prefix.size()) == prefix) {
+                    temporary.push_back(first_word(std::string_view{node.detail}.substr(prefix.size())));
+                }
+            }
+        });
+        std::vector<const plan_node*> scans;
+        for_each(nodes, [&](const plan_node& node) {
+            std::string_view detail{node.detail};
+            if (detail.substr(0, 5) != "SCAN " || detail == "SCAN CONSTANT ROW") {
+                return;
+            }
+            auto name = first_word(detail.substr(5));
+            for (auto t : temporary) {
+                if (t == name) {
+                    return;
+                }
+            }
+            scans.push_back(&node);
+        });
+        return scans;
+    }
+
+    // The plan as the sqlite3 shell prints it, a node per line indented by depth.
+    std::string to_string() const
+    {
+        std::string text;
+        append(text, nodes, 0);
+        return text;
+    }
+
+private:
+    template<typename Function>
+    static void for_each(const std::vector<plan_node>& nodes, Function&& f)
+    {
+        for (auto& node : nodes) {
+            f(node);
+            for_each(node.children, f);
+        }
+    }
+
+    static std::string_view first_word(std::string_view text) noexcept
+    {
+        return text.substr(0, text.find(' '));
+    }
+
+    static void append(std::string& text, const std::vector<plan_node>& nodes, std::size_t depth)
+    {
+        for (auto& node : nodes) {
+            text.append(2 * depth, ' ');
+            text += node.detail;
+            text += '\n';
+            append(text, node.children, depth + 1);
+        }
+    }
+};
+
+// What sqlite3_stmt_scanstatus reports about one loop of a statement, counted
+// since it was prepared or the counters were reset.
+struct scan_loop
+{
+    // the table or index the loop reads
+    std::string name;
+    // the EXPLAIN QUERY PLAN detail of the loop
+    std::string explain;
+    int select_id{0};
+    // times the loop ran
+    std::int64_t loops{0};
+    // rows it visited over all of them
+    std::int64_t visited{0};
+    // rows the planner expected per run
+    double estimated{0.0};
+
+    // rows visited per run, to compare with estimated
+    double actual() const noexcept
+    {
+        return loops != 0 ? static_cast<double>(visited) / static_cast<double>(loops) : 0.0;
+    }
+};
+
+// Called by statement::expect_indexed for each full scan of a statement that
+// should not need one. Tests install a handler that fails the test; without
+// one expect_indexed does nothing.
+using full_scan_handler = void (*)(std::string_view sql, std::string_view detail);
+
+namespace detail
+{
+
+inline std::atomic<full_scan_handler> installed_full_scan_handler{nullptr};
+
+} // namespace detail
+
+// Installs handler for the process, nullptr to remove it. Returns the
+// previous handler.
+inline full_scan_handler set_full_scan_handler(full_scan_handler handler) noexcept
+{
+    return detail::installed_full_scan_handler.exchange(handler);
+}
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_QUERY_PLAN_HPP
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_SCRIPT_HPP
+#define SQLITEPP_SCRIPT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace sqlitepp
+{
+
+struct script_timing
+{
+    // byte range of the statement in the script
+    std::size_t offset{0};
+    std::size_t length{0};
+    std::chrono::nanoseconds elapsed{0};
+};
+
+struct script_result
+{
+    // statements run to completion
+    std::size_t statements{0};
+    // per statement, with script_options::timed only
+    std::vector<script_timing> timings;
+    // when the script failed, the index of the failing statement and the
+    // byte offset of the error in the script: the token SQLite points at for
+    // a syntax error, or else the start of the statement
+    std::size_t error_statement{0};
+    std::size_t error_offset{0};
+};
+
+struct script_options
+{
+    bool timed{false};
+};
+
+// Thrown by connection::execute_script with where the script failed.
+class script_error : public std::system_error
+{
+public:
+    script_error(std::error_code ec, std::size_t statement, std::size_t offset)
+        : std::system_error(ec, "statement " + std::to_string(statement) + " at byte " + std::to_string(offset)), statement_(statement), offset_(offset)
+    {
+    }
+
+    std::size_t statement() const noexcept
+    {
+        return statement_;
+    }
+
+    std::size_t offset() const noexcept
+    {
+        return offset_;
+    }
+
+private:
+    std::size_t statement_;
+    std::size_t offset_;
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_SCRIPT_HPP
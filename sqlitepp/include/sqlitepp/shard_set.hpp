@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_SHARD_SET_HPP
+#define SQLITEPP_SHARD_SET_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/shard_hash.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// Hashes the bytes of a shard key; integer keys are hashed as their 8 bytes
+// in little-endian order. Must give the same result in every process that
+// opens the files.
+using shard_hash = std::function<std::uint64_t(std::string_view key)>;
+
+// 64-bit FNV-1a, the default shard hash.
+inline std::uint64_t fnv1a_hash(std::string_view key) noexcept
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct shard_options
+{
+    // lets the reader of a shard run alongside its writer
+    bool wal{true};
+    int busy_timeout_ms{5000};
+};
+
+// A table rebalance moves rows of, routed by the value of key_column.
+struct shard_table
+{
+    std::string name;
+    std::string key_column;
+};
+
+// Database files that split the rows of the same tables by key, so that
+// writes to different shards do not wait on each other. Each shard has a
+// writer connection for the rows routed to it and a read-only connection
+// for queries over all shards. Keys are mapped to shards by a jump
+// consistent hash, so adding a shard moves only the keys that now belong
+// to it. The filenames must name files, an in-memory database cannot be
+// shared by the two connections of a shard.
+class shard_set
+{
+public:
+    shard_set(std::vector<std::string> filenames, std::error_code& ec) noexcept : shard_set(std::move(filenames), fnv1a_hash, shard_options{}, ec)
+    {
+    }
+
+    shard_set(std::vector<std::string> filenames, shard_hash hash, shard_options options, std::error_code& ec) noexcept
+        : hash_(std::move(hash)), options_(options)
+    {
+        open(filenames, ec);
+    }
+
+    explicit shard_set(std::vector<std::string> filenames) : shard_set(std::move(filenames), fnv1a_hash, shard_options{})
+    {
+    }
+
+    shard_set(std::vector<std::string> filenames, shard_hash hash, shard_options options) : hash_(std::move(hash)), options_(options)
+    {
+        std::error_code ec;
+        open(filenames, ec);
+        throw_on_error(ec);
+    }
+
+    shard_set(const shard_set&) = delete;
+    shard_set& operator=(const shard_set&) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return shards_.size();
+    }
+
+    const std::string& filename(std::size_t shard) const noexcept
+    {
+        return shards_[shard]->filename;
+    }
+
+    std::size_t shard_index(std::string_view key) const
+    {
+        return detail::jump_consistent_hash(hash_(key), shards_.size());
+    }
+
+    std::size_t shard_index(std::int64_t key) const
+    {
+        return shard_index(detail::integer_key{key}.view());
+    }
+
+    // The writer of a shard. Not synchronized, see write() for threads that
+    // share a shard.
+    connection& writer(std::size_t shard) noexcept
+    {
+        return shards_[shard]->writer;
+    }
+
+    // Calls fn(connection&) with the writer of the shard of key, one thread
+    // per shard at a time.
+    template<typename Key, typename F>
+    decltype(auto) write(const Key& key, F&& fn)
+    {
+        auto& s = *shards_[shard_index(key)];
+        std::lock_guard<std::mutex> lock{s.mutex};
+        return std::forward<F>(fn)(s.writer);
+    }
+
+    // Runs sql on the reader of every shard in parallel. partial(statement&)
+    // returns the result of one shard from the prepared, not yet stepped
+    // statement; combine(T, T) folds the results into init in shard order.
+    // Each shard is read at its own point in time.
+    template<typename T, typename Partial, typename Combine>
+    T query_all(thread_pool& threads, std::string_view sql, T init, Partial partial, Combine combine, std::error_code& ec)
+    {
+        ec.clear();
+        std::vector<std::optional<T>> results(shards_.size());
+        std::vector<std::error_code> errors(shards_.size());
+        std::vector<std::future<void>> done;
+        done.reserve(shards_.size());
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            done.push_back(threads.submit([&, i]() {
+                statement stmt{shards_[i]->reader, sql, errors[i]};
+                if (!errors[i]) {
+                    results[i].emplace(partial(stmt));
+                }
+            }));
+        }
+        // wait for every shard before rethrowing, they reference this frame
+        for (auto& d : done) {
+            d.wait();
+        }
+        for (auto& d : done) {
+            d.get();
+        }
+        for (auto& error : errors) {
+            if (error) {
+                ec = error;
+                return init;
+            }
+        }
+
+        for (auto& result : results) {
+            init = combine(std::move(init), std::move(*result));
+        }
+        return init;
+    }
+
+    template<typename T, typename Partial, typename Combine>
+    T query_all(thread_pool& threads, std::string_view sql, T init, Partial partial, Combine combine)
+    {
+        std::error_code ec;
+        auto result = query_all(threads, sql, std::move(init), std::move(partial), std::move(combine), ec);
+        throw_on_error(ec);
+        return result;
+    }
+
+    // Changes the shards to filenames and moves the rows of tables to the
+    // shards their keys now belong to. filenames must start with the current
+    // shards, in order, when there are fewer of them, or with filenames of
+    // its own size otherwise; new shards get the schema of the tables from
+    // the first shard, and the files of dropped shards are left empty.
+    // Offline: nothing else may use the set meanwhile. Each move commits on
+    // its own and replaces rows by key, so after a failure the set keeps its
+    // old shards and running the rebalance again completes it.
+    void rebalance(const std::vector<std::string>& filenames, const std::vector<shard_table>& tables, std::error_code& ec) noexcept
+    {
+        ec.clear();
+        try {
+            if (filenames.empty()) {
+                ec = sqlitepp_errc::invalid_argument;
+                return;
+            }
+            for (std::size_t i = 0; i < std::min(filenames.size(), shards_.size()); ++i) {
+                if (filenames[i] != shards_[i]->filename) {
+                    ec = sqlitepp_errc::invalid_argument;
+                    return;
+                }
+            }
+
+            std::vector<std::unique_ptr<shard>> added;
+            for (auto i = shards_.size(); i < filenames.size(); ++i) {
+                added.push_back(open_shard(filenames[i], ec));
+                if (ec) {
+                    return;
+                }
+                for (auto& table : tables) {
+                    copy_schema(shards_.front()->writer, added.back()->writer, table.name, ec);
+                    if (ec) {
+                        return;
+                    }
+                }
+            }
+
+            detail::shard_routing routing{&hash_, filenames.size()};
+            for (std::size_t i = 0; i < shards_.size() && !ec; ++i) {
+                auto& source = shards_[i]->writer;
+                int rc = sqlite3_create_function_v2(source.conn_handle(), shard_of_name, 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, &routing,
+                                                    &detail::shard_of_function, nullptr, nullptr, nullptr);
+                if (rc != SQLITE_OK) {
+                    ec.assign(rc, sqlite3_category());
+                    break;
+                }
+                try {
+                    for (auto& table : tables) {
+                        move_rows(source, i, filenames, table, ec);
+                        if (ec) {
+                            break;
+                        }
+                    }
+                }
+                catch (const std::bad_alloc&) {
+                    ec.assign(SQLITE_NOMEM, sqlite3_category());
+                }
+                // routing lives on this frame
+                sqlite3_create_function_v2(source.conn_handle(), shard_of_name, 1, SQLITE_UTF8, nullptr, nullptr, nullptr, nullptr, nullptr);
+            }
+            if (ec) {
+                return;
+            }
+
+            shards_.resize(std::min(shards_.size(), filenames.size()));
+            for (auto& s : added) {
+                shards_.push_back(std::move(s));
+            }
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+    }
+
+    void rebalance(const std::vector<std::string>& filenames, const std::vector<shard_table>& tables)
+    {
+        std::error_code ec;
+        rebalance(filenames, tables, ec);
+        throw_on_error(ec);
+    }
+
+private:
+    static constexpr const char* shard_of_name = "sqlitepp_shard_of";
+    static constexpr const char* rebalance_schema = "sqlitepp_rebalance";
+
+    struct shard
+    {
+        std::string filename;
+        connection writer;
+        connection reader;
+        std::mutex mutex;
+    };
+
+    shard_hash hash_;
+    shard_options options_;
+    std::vector<std::unique_ptr<shard>> shards_;
+
+    static void throw_on_error(const std::error_code& ec)
+    {
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    static void run(connection& conn, std::string_view sql, std::error_code& ec) noexcept
+    {
+        statement stmt{conn, sql, ec};
+        if (!ec) {
+            while (stmt.step(ec)) {
+            }
+        }
+    }
+
+    void open(const std::vector<std::string>& filenames, std::error_code& ec) noexcept
+    {
+        ec.clear();
+        if (filenames.empty()) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        try {
+            shards_.reserve(filenames.size());
+            for (auto& filename : filenames) {
+                shards_.push_back(open_shard(filename, ec));
+                if (ec) {
+                    shards_.clear();
+                    return;
+                }
+            }
+        }
+        catch (const std::bad_alloc&) {
+            shards_.clear();
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+    }
+
+    std::unique_ptr<shard> open_shard(const std::string& filename, std::error_code& ec)
+    {
+        auto s = std::make_unique<shard>();
+        s->filename = filename;
+        // the writer creates the file and switches it to WAL before the reader opens it
+        if (s->writer.open(filename, connection::openmode::rwc, ec)) {
+            sqlite3_busy_timeout(s->writer.conn_handle(), options_.busy_timeout_ms);
+            if (options_.wal) {
+                run(s->writer, "PRAGMA journal_mode = WAL", ec);
+            }
+        }
+        if (!ec && s->reader.open(filename, connection::openmode::rw, ec)) {
+            sqlite3_busy_timeout(s->reader.conn_handle(), options_.busy_timeout_ms);
+            run(s->reader, "PRAGMA query_only = ON", ec);
+        }
+        if (ec) {
+            return nullptr;
+        }
+        return s;
+    }
+
+    static void copy_schema(connection& from, connection& to, const std::string& table, std::error_code& ec)
+    {
+        statement exists{to, "SELECT 1 FROM sqlite_schema WHERE type = 'table' AND name = ?1", ec};
+        if (!ec) {
+            exists.bind(1, table, ec);
+        }
+        if (ec || exists.step(ec) || ec) {
+            return;
+        }
+
+        // the table before its indexes and triggers
+        statement schema{from, "SELECT sql FROM sqlite_schema WHERE tbl_name = ?1 AND sql IS NOT NULL ORDER BY type <> 'table'", ec};
+        if (!ec) {
+            schema.bind(1, table, ec);
+        }
+        while (!ec && schema.step(ec)) {
+            run(to, schema.column_text(0), ec);
+        }
+    }
+
+    static void move_rows(connection& source, std::size_t index, const std::vector<std::string>& filenames, const shard_table& table,
+                          std::error_code& ec)
+    {
+        std::string key;
+        detail::append_identifier(key, table.key_column);
+        std::string name;
+        detail::append_identifier(name, table.name);
+
+        std::vector<std::size_t> targets;
+        {
+            statement shards{source, "SELECT DISTINCT " + std::string{shard_of_name} + "(" + key + ") FROM main." + name, ec};
+            while (!ec && shards.step(ec)) {
+                auto target = static_cast<std::size_t>(shards.column_int64(0));
+                if (target != index) {
+                    targets.push_back(target);
+                }
+            }
+        }
+
+        for (auto target : targets) {
+            if (ec) {
+                return;
+            }
+            statement attach{source, "ATTACH DATABASE ?1 AS " + std::string{rebalance_schema}, ec};
+            if (!ec) {
+                attach.bind(1, filenames[target], ec);
+            }
+            if (!ec) {
+                attach.step(ec);
+            }
+            if (ec) {
+                return;
+            }
+            {
+                transaction tx{source, transaction::mode::immediate, ec};
+                if (ec) {
+                    // without the transaction the copy and the delete would commit apart
+                    std::error_code detach_ec;
+                    run(source, "DETACH DATABASE " + std::string{rebalance_schema}, detach_ec);
+                    return;
+                }
+                auto where = " WHERE " + std::string{shard_of_name} + "(" + key + ") = ?1";
+                statement copy{source, "INSERT OR REPLACE INTO " + std::string{rebalance_schema} + "." + name + " SELECT * FROM main." + name + where, ec};
+                if (!ec) {
+                    copy.bind(1, static_cast<std::int64_t>(target), ec);
+                }
+                if (!ec) {
+                    copy.step(ec);
+                }
+                if (!ec) {
+                    statement remove{source, "DELETE FROM main." + name + where, ec};
+                    if (!ec) {
+                        remove.bind(1, static_cast<std::int64_t>(target), ec);
+                    }
+                    if (!ec) {
+                        remove.step(ec);
+                    }
+                }
+                if (!ec) {
+                    tx.commit(ec);
+                }
+            }
+            std::error_code detach_ec;
+            run(source, "DETACH DATABASE " + std::string{rebalance_schema}, detach_ec);
+            if (!ec) {
+                ec = detach_ec;
+            }
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_SHARD_SET_HPP
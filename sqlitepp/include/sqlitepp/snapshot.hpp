@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_SNAPSHOT_HPP
+#define SQLITEPP_SNAPSHOT_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+
+#include <string>
+#include <utility>
+
+#if defined(SQLITEPP_ENABLE_SNAPSHOT)
+
+namespace sqlitepp
+{
+
+// A point in the WAL history of one schema of a database, taken with
+// connection::snapshot_get and handed to connection::snapshot_open of other
+// connections to the same file. Requires SQLite built with
+// SQLITE_ENABLE_SNAPSHOT, see the SQLITEPP_ENABLE_SNAPSHOT CMake option.
+class snapshot
+{
+public:
+    snapshot() noexcept = default;
+
+    snapshot(sqlite3_snapshot* handle, std::string schema) noexcept : handle_(handle), schema_(std::move(schema))
+    {
+    }
+
+    ~snapshot() noexcept
+    {
+        if (handle_ != nullptr) {
+            sqlite3_snapshot_free(handle_);
+        }
+    }
+
+    snapshot(const snapshot&) = delete;
+    snapshot& operator=(const snapshot&) = delete;
+
+    snapshot(snapshot&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)), schema_(std::move(other.schema_))
+    {
+    }
+
+    snapshot& operator=(snapshot&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle_ != nullptr) {
+                sqlite3_snapshot_free(handle_);
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+            schema_ = std::move(other.schema_);
+        }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return handle_ != nullptr;
+    }
+
+    sqlite3_snapshot* handle() const noexcept
+    {
+        return handle_;
+    }
+
+    const std::string& schema() const noexcept
+    {
+        return schema_;
+    }
+
+    // Negative when this snapshot is older than other, zero when they are the
+    // same and positive when it is newer. Only meaningful for snapshots of the
+    // same database file taken since the WAL was last reset.
+    int compare(const snapshot& other) const noexcept
+    {
+        return sqlite3_snapshot_cmp(handle_, other.handle_);
+    }
+
+private:
+    sqlite3_snapshot* handle_{nullptr};
+    std::string schema_;
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_ENABLE_SNAPSHOT
+
+#endif // SQLITEPP_SNAPSHOT_HPP
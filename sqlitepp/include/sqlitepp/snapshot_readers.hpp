@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_SNAPSHOT_READERS_HPP
+#define SQLITEPP_SNAPSHOT_READERS_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/snapshot.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(SQLITEPP_ENABLE_SNAPSHOT)
+
+namespace sqlitepp
+{
+
+// Connections leased from a pool, each in a read transaction pinned to the
+// same snapshot of one schema, so that a report fanned out over threads, one
+// connection per thread, reads a single consistent state. The database must
+// be in WAL mode. Checkpoints cannot reset the WAL while the readers are
+// held, so release them when the report is done.
+class snapshot_readers
+{
+public:
+    snapshot_readers(connection_pool& pool, std::size_t n, std::error_code& ec) noexcept : snapshot_readers(pool, n, "main", ec)
+    {
+    }
+
+    // Blocks until n connections of the pool are available.
+    snapshot_readers(connection_pool& pool, std::size_t n, std::string_view schema, std::error_code& ec) noexcept
+    {
+        pin(pool, n, schema, ec);
+    }
+
+    explicit snapshot_readers(connection_pool& pool, std::size_t n, std::string_view schema = "main")
+    {
+        std::error_code ec;
+        pin(pool, n, schema, ec);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+    snapshot_readers(const snapshot_readers&) = delete;
+    snapshot_readers& operator=(const snapshot_readers&) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return leases_.size();
+    }
+
+    connection& operator[](std::size_t i) const noexcept
+    {
+        return *leases_[i];
+    }
+
+    const snapshot& pinned() const noexcept
+    {
+        return snapshot_;
+    }
+
+private:
+    std::vector<connection_pool::lease> leases_;
+    // after the leases, so the transactions end before the connections go back
+    std::deque<transaction> reads_;
+    snapshot snapshot_;
+
+    void pin(connection_pool& pool, std::size_t n, std::string_view schema, std::error_code& ec) noexcept
+    {
+        if (n == 0 || n > pool.size()) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        try {
+            // all at once, so that readers built together on a small pool
+            // cannot each hold some connections while waiting for the rest
+            leases_ = pool.acquire(n, ec);
+            if (ec) {
+                return;
+            }
+
+            // BEGIN DEFERRED takes no snapshot until the first read
+            auto& first = *leases_.front();
+            reads_.emplace_back(first, transaction::mode::deferred, ec);
+            if (!ec) {
+                std::string sql{"SELECT count(*) FROM "};
+                detail::append_identifier(sql, schema);
+                sql += ".sqlite_schema";
+                statement probe{first, sql, ec};
+                if (!ec) {
+                    probe.step(ec);
+                }
+            }
+            if (!ec) {
+                snapshot_ = first.snapshot_get(schema, ec);
+            }
+
+            for (std::size_t i = 1; i < n && !ec; ++i) {
+                reads_.emplace_back(*leases_[i], transaction::mode::deferred, ec);
+                if (!ec) {
+                    leases_[i]->snapshot_open(snapshot_, ec);
+                }
+            }
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+        }
+        if (ec) {
+            reads_.clear();
+            leases_.clear();
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_ENABLE_SNAPSHOT
+
+#endif // SQLITEPP_SNAPSHOT_READERS_HPP
@@ -9,7 +9,8 @@ namespace sqlitepp
 enum class sqlitepp_errc
 {
     invalid_handle = 1,
-    invalid_argument
+    invalid_argument,
+    deadline_exceeded
 };
 
 } // namespace sqlitepp
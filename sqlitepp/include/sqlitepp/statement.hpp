@@ -0,0 +1,391 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_STATEMENT_HPP
+#define SQLITEPP_STATEMENT_HPP
+
+#include <sqlitepp/arrow.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/arrow_impl.hpp>
+#include <sqlitepp/detail/query_plan_impl.hpp>
+#include <sqlitepp/detail/statement_impl.hpp>
+#include <sqlitepp/detail/status_impl.hpp>
+#include <sqlitepp/query_plan.hpp>
+#include <sqlitepp/status.hpp>
+#include <sqlitepp/types.hpp>
+#include <sqlitepp/value.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+class statement
+{
+public:
+    statement() noexcept = default;
+    virtual ~statement() noexcept = default;
+
+    statement(connection& conn, std::string_view sql)
+    {
+        std::error_code ec;
+        impl_.prepare(conn.conn_handle(), conn.impl_.shared_deadline_guard(), sql, 0, ec);
+        throw_on_error(ec);
+    }
+
+    statement(connection& conn, std::string_view sql, std::error_code& ec) noexcept
+    {
+        impl_.prepare(conn.conn_handle(), conn.impl_.shared_deadline_guard(), sql, 0, ec);
+    }
+
+    statement(const statement&) = delete;
+    statement& operator=(const statement&) = delete;
+
+    statement(statement&& other) noexcept
+    {
+        impl_.swap(other.impl_);
+        arrow_types_.swap(other.arrow_types_);
+    }
+
+    statement& operator=(statement&& other) noexcept
+    {
+        if (this != &other) {
+            impl_.finalize();
+            impl_.swap(other.impl_);
+            arrow_types_.clear();
+            arrow_types_.swap(other.arrow_types_);
+        }
+        return *this;
+    }
+
+    void prepare(connection& conn, std::string_view sql, std::error_code& ec) noexcept
+    {
+        arrow_types_.clear();
+        impl_.prepare(conn.conn_handle(), conn.impl_.shared_deadline_guard(), sql, 0, ec);
+    }
+
+    void prepare(connection& conn, std::string_view sql)
+    {
+        std::error_code ec;
+        arrow_types_.clear();
+        impl_.prepare(conn.conn_handle(), conn.impl_.shared_deadline_guard(), sql, 0, ec);
+        throw_on_error(ec);
+    }
+
+    void finalize() noexcept
+    {
+        impl_.finalize();
+    }
+
+    bool is_prepared() const noexcept
+    {
+        return impl_.is_prepared();
+    }
+
+    stmt_handle_t stmt_handle() const noexcept
+    {
+        return impl_.stmt_handle();
+    }
+
+    std::string_view sql() const noexcept
+    {
+        return impl_.sql();
+    }
+
+    template<typename T>
+    void bind(int index, const T& value, std::error_code& ec) noexcept
+    {
+        impl_.bind(index, value, ec);
+    }
+
+    template<typename T>
+    void bind(int index, const T& value)
+    {
+        std::error_code ec;
+        impl_.bind(index, value, ec);
+        throw_on_error(ec);
+    }
+
+    template<typename T>
+    void bind_static(int index, const T& value, std::error_code& ec) noexcept
+    {
+        impl_.bind_static(index, value, ec);
+    }
+
+    template<typename T>
+    void bind_static(int index, const T& value)
+    {
+        std::error_code ec;
+        impl_.bind_static(index, value, ec);
+        throw_on_error(ec);
+    }
+
+    // Binds the fields of an aggregate to parameters 1..N by position. The
+    // statement must have exactly as many parameters as the struct has fields.
+    template<typename Params, typename = std::enable_if_t<std::is_aggregate_v<Params>>>
+    void bind(const Params& params, std::error_code& ec) noexcept
+    {
+        impl_.bind_fields(params, ec);
+    }
+
+    template<typename Params, typename = std::enable_if_t<std::is_aggregate_v<Params>>>
+    void bind(const Params& params)
+    {
+        std::error_code ec;
+        impl_.bind_fields(params, ec);
+        throw_on_error(ec);
+    }
+
+    void clear_bindings(std::error_code& ec) noexcept
+    {
+        impl_.clear_bindings(ec);
+    }
+
+    void clear_bindings()
+    {
+        std::error_code ec;
+        impl_.clear_bindings(ec);
+        throw_on_error(ec);
+    }
+
+    int parameter_count() const noexcept
+    {
+        return impl_.parameter_count();
+    }
+
+    int parameter_index(const char* name) const noexcept
+    {
+        return impl_.parameter_index(name);
+    }
+
+    bool step(std::error_code& ec) noexcept
+    {
+        return impl_.step(ec);
+    }
+
+    bool step()
+    {
+        std::error_code ec;
+        bool row = impl_.step(ec);
+        throw_on_error(ec);
+        return row;
+    }
+
+    void reset(std::error_code& ec) noexcept
+    {
+        arrow_types_.clear();
+        impl_.reset(ec);
+    }
+
+    void reset()
+    {
+        std::error_code ec;
+        arrow_types_.clear();
+        impl_.reset(ec);
+        throw_on_error(ec);
+    }
+
+    int column_count() const noexcept
+    {
+        return impl_.column_count();
+    }
+
+    datatype column_type(int index) const noexcept
+    {
+        return impl_.column_type(index);
+    }
+
+    std::string_view column_name(int index) const noexcept
+    {
+        return impl_.column_name(index);
+    }
+
+    std::int64_t column_int64(int index) const noexcept
+    {
+        return impl_.column_int64(index);
+    }
+
+    double column_double(int index) const noexcept
+    {
+        return impl_.column_double(index);
+    }
+
+    std::string_view column_text(int index) const noexcept
+    {
+        return impl_.column_text(index);
+    }
+
+    blob_view column_blob(int index) const noexcept
+    {
+        return impl_.column_blob(index);
+    }
+
+    // Copies a column; text and blobs too long to be stored inline go into
+    // arena when there is one, or else onto the heap.
+    value column_value(int index, value_arena* arena = nullptr) const
+    {
+        return impl_.column_value(index, arena);
+    }
+
+    // Steps one row into an aggregate, field i from column i, with each
+    // conversion picked at compile time. Returns false when the statement is
+    // done. The result must have exactly as many columns as the struct has
+    // fields; std::string_view and blob_view fields are valid until the next step.
+    template<typename Row, typename = std::enable_if_t<std::is_aggregate_v<Row>>>
+    bool fetch(Row& row, std::error_code& ec) noexcept
+    {
+        return impl_.fetch(row, ec);
+    }
+
+    template<typename Row, typename = std::enable_if_t<std::is_aggregate_v<Row>>>
+    bool fetch(Row& row)
+    {
+        std::error_code ec;
+        bool fetched = impl_.fetch(row, ec);
+        throw_on_error(ec);
+        return fetched;
+    }
+
+    template<typename Row>
+    std::optional<Row> fetch(std::error_code& ec) noexcept
+    {
+        std::optional<Row> row{std::in_place};
+        if (!impl_.fetch(*row, ec)) {
+            row.reset();
+        }
+        return row;
+    }
+
+    template<typename Row>
+    std::optional<Row> fetch()
+    {
+        std::error_code ec;
+        auto row = fetch<Row>(ec);
+        throw_on_error(ec);
+        return row;
+    }
+
+    // Steps up to max_rows rows, constructing each in place at the back of
+    // rows; reserve the vector to avoid reallocating. Returns the number of
+    // rows appended, fewer than max_rows once the statement is done.
+    template<typename Row>
+    std::size_t fetch(std::vector<Row>& rows, std::size_t max_rows, std::error_code& ec) noexcept
+    {
+        return impl_.fetch(rows, max_rows, ec);
+    }
+
+    template<typename Row>
+    std::size_t fetch(std::vector<Row>& rows, std::error_code& ec) noexcept
+    {
+        return impl_.fetch(rows, SIZE_MAX, ec);
+    }
+
+    template<typename Row>
+    std::size_t fetch(std::vector<Row>& rows, std::size_t max_rows = SIZE_MAX)
+    {
+        std::error_code ec;
+        auto appended = impl_.fetch(rows, max_rows, ec);
+        throw_on_error(ec);
+        return appended;
+    }
+
+    // Steps up to batch_rows rows into Arrow buffers. A batch with fewer rows
+    // is the last one, after which the statement is reset. The batches of a
+    // run share the column types of the first: declared ones, or those of
+    // the values, int64 widening to float64 when a real appears; values of
+    // later batches convert to them.
+    arrow_batch to_arrow(std::size_t batch_rows, std::error_code& ec) noexcept
+    {
+        arrow_batch batch;
+        detail::export_arrow(impl_.stmt_handle(), impl_.deadline(), batch_rows, *batch.array(), *batch.schema(), arrow_types_, ec);
+        return batch;
+    }
+
+    arrow_batch to_arrow(std::size_t batch_rows)
+    {
+        std::error_code ec;
+        auto batch = to_arrow(batch_rows, ec);
+        throw_on_error(ec);
+        return batch;
+    }
+
+    statement_status status(status_mode mode = status_mode::current) noexcept
+    {
+        return detail::read_statement_status(impl_.stmt_handle(), mode);
+    }
+
+    // The plan of the statement from EXPLAIN QUERY PLAN, prepared on its
+    // connection; a schema change since preparing it may change the plan.
+    sqlitepp::query_plan query_plan(std::error_code& ec) const noexcept
+    {
+        return detail::read_query_plan(impl_.stmt_handle(), ec);
+    }
+
+    sqlitepp::query_plan query_plan() const
+    {
+        std::error_code ec;
+        auto result = query_plan(ec);
+        throw_on_error(ec);
+        return result;
+    }
+
+    // Declares that the statement should find its rows through indexes. When
+    // a full_scan_handler is installed, as tests do, each full scan of the
+    // plan is reported to it; otherwise nothing is checked.
+    void expect_indexed(std::error_code& ec) const noexcept
+    {
+        detail::check_indexed(impl_.stmt_handle(), ec);
+    }
+
+    void expect_indexed() const
+    {
+        std::error_code ec;
+        expect_indexed(ec);
+        throw_on_error(ec);
+    }
+
+#if defined(SQLITEPP_ENABLE_STMT_SCANSTATUS)
+    // Rows each loop visited against the planner estimate, since the
+    // statement was prepared or scan_status_reset was called.
+    std::vector<scan_loop> scan_status(std::error_code& ec) const noexcept
+    {
+        return detail::read_scan_status(impl_.stmt_handle(), ec);
+    }
+
+    std::vector<scan_loop> scan_status() const
+    {
+        std::error_code ec;
+        auto loops = scan_status(ec);
+        throw_on_error(ec);
+        return loops;
+    }
+
+    void scan_status_reset() noexcept
+    {
+        if (impl_.stmt_handle() != nullptr) {
+            sqlite3_stmt_scanstatus_reset(impl_.stmt_handle());
+        }
+    }
+#endif
+
+private:
+    detail::statement_impl impl_;
+    std::vector<detail::arrow_type> arrow_types_;
+
+    static void throw_on_error(const std::error_code& ec)
+    {
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_STATEMENT_HPP
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_STATIC_STATEMENT_HPP
+#define SQLITEPP_STATIC_STATEMENT_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/sql_parameters.hpp>
+#include <sqlitepp/fixed_string.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstddef>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(SQLITEPP_HAS_FIXED_STRING)
+
+namespace sqlitepp
+{
+
+// Statement whose SQL is a template argument. The placeholders are parsed
+// at compile time, so binding checks indexes, names and arity while
+// compiling and never asks SQLite for parameter indexes.
+template<fixed_string Sql>
+class static_statement : public statement
+{
+    static constexpr detail::sql_parameters parameters = detail::parse_sql_parameters(Sql.view());
+
+    static_assert(parameters.valid, "malformed SQL or placeholder");
+
+    template<typename... Args>
+    static constexpr bool ends_with_error_code = sizeof...(Args) != 0 && std::is_same_v<std::tuple_element_t<sizeof...(Args) - 1, std::tuple<Args...>>, std::error_code&>;
+
+public:
+    static constexpr int parameter_count_v = parameters.count;
+
+    template<fixed_string Name>
+    static constexpr int parameter_index_v = parameters.index_of(Name.view());
+
+    static_statement() noexcept = default;
+
+    explicit static_statement(connection& conn) : statement(conn, Sql.view())
+    {
+    }
+
+    static_statement(connection& conn, std::error_code& ec) noexcept : statement(conn, Sql.view(), ec)
+    {
+    }
+
+    template<int Index, typename T>
+        requires(Index >= 1 && Index <= parameter_count_v)
+    void bind(const T& value, std::error_code& ec) noexcept
+    {
+        statement::bind(Index, value, ec);
+    }
+
+    template<int Index, typename T>
+        requires(Index >= 1 && Index <= parameter_count_v)
+    void bind(const T& value)
+    {
+        statement::bind(Index, value);
+    }
+
+    template<fixed_string Name, typename T>
+        requires(parameter_index_v<Name> != 0)
+    void bind(const T& value, std::error_code& ec) noexcept
+    {
+        statement::bind(parameter_index_v<Name>, value, ec);
+    }
+
+    template<fixed_string Name, typename T>
+        requires(parameter_index_v<Name> != 0)
+    void bind(const T& value)
+    {
+        statement::bind(parameter_index_v<Name>, value);
+    }
+
+    // Binds one value per parameter, in index order.
+    template<typename... Args>
+        requires(ends_with_error_code<Args...> && sizeof...(Args) == static_cast<std::size_t>(parameter_count_v) + 1)
+    void bind_all(Args&&... args) noexcept
+    {
+        auto values = std::forward_as_tuple(args...);
+        auto& ec = std::get<sizeof...(Args) - 1>(values);
+        ec.clear();
+        bind_each(values, ec, std::make_index_sequence<sizeof...(Args) - 1>{});
+    }
+
+    template<typename... Args>
+        requires(!ends_with_error_code<Args...> && sizeof...(Args) == static_cast<std::size_t>(parameter_count_v))
+    void bind_all(const Args&... args)
+    {
+        std::error_code ec;
+        bind_each(std::forward_as_tuple(args...), ec, std::index_sequence_for<Args...>{});
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+
+private:
+    template<typename Tuple, std::size_t... I>
+    void bind_each(const Tuple& values, std::error_code& ec, std::index_sequence<I...>) noexcept
+    {
+        ((ec ? void() : statement::bind(static_cast<int>(I + 1), std::get<I>(values), ec)), ...);
+    }
+};
+
+template<fixed_string Sql>
+static_statement<Sql> connection::prepare()
+{
+    return static_statement<Sql>{*this};
+}
+
+template<fixed_string Sql>
+static_statement<Sql> connection::prepare(std::error_code& ec) noexcept
+{
+    return static_statement<Sql>{*this, ec};
+}
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_HAS_FIXED_STRING
+
+#endif // SQLITEPP_STATIC_STATEMENT_HPP
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_STATUS_HPP
+#define SQLITEPP_STATUS_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// With status_mode::delta the counters are reset after reading, so that the
+// next read returns the increase since this one. Gauges are never reset.
+enum class status_mode
+{
+    current,
+    delta
+};
+
+struct connection_status
+{
+    // counters
+    std::int64_t cache_hit{0};
+    std::int64_t cache_miss{0};
+    std::int64_t cache_write{0};
+    std::int64_t cache_spill{0};
+    std::int64_t lookaside_hit{0};
+    std::int64_t lookaside_miss_size{0};
+    std::int64_t lookaside_miss_full{0};
+    // gauges
+    std::int64_t lookaside_used{0};
+    std::int64_t lookaside_used_highwater{0};
+    std::int64_t cache_used{0};
+    std::int64_t cache_used_shared{0};
+    std::int64_t schema_used{0};
+    std::int64_t stmt_used{0};
+    std::int64_t deferred_fks{0};
+};
+
+struct statement_status
+{
+    // counters
+    std::int64_t fullscan_steps{0};
+    std::int64_t sort_operations{0};
+    std::int64_t autoindex_count{0};
+    std::int64_t vm_steps{0};
+    std::int64_t reprepares{0};
+    std::int64_t runs{0};
+    std::int64_t filter_misses{0};
+    std::int64_t filter_hits{0};
+    // gauges
+    std::int64_t memory_used{0};
+};
+
+using metric_labels = std::vector<std::pair<std::string, std::string>>;
+
+// Renders status structs in the Prometheus text exposition format. Samples
+// of the same metric are grouped under a single HELP/TYPE header, so several
+// connections or statements can be exported with distinguishing labels.
+class prometheus_exporter
+{
+public:
+    explicit prometheus_exporter(std::string prefix = "sqlite") : prefix_(std::move(prefix))
+    {
+    }
+
+    void add(const connection_status& status, const metric_labels& labels = {})
+    {
+        add_sample("connection_cache_hit_total", "counter", "Pager cache hits", labels, status.cache_hit);
+        add_sample("connection_cache_miss_total", "counter", "Pager cache misses", labels, status.cache_miss);
+        add_sample("connection_cache_write_total", "counter", "Dirty cache pages written to disk", labels, status.cache_write);
+        add_sample("connection_cache_spill_total", "counter", "Dirty cache pages spilled mid-transaction", labels, status.cache_spill);
+        add_sample("connection_lookaside_hit_total", "counter", "Allocations satisfied by lookaside memory", labels, status.lookaside_hit);
+        add_sample("connection_lookaside_miss_size_total", "counter", "Lookaside misses because of the allocation size", labels,
+                   status.lookaside_miss_size);
+        add_sample("connection_lookaside_miss_full_total", "counter", "Lookaside misses because all slots were in use", labels,
+                   status.lookaside_miss_full);
+        add_sample("connection_lookaside_used", "gauge", "Lookaside slots in use", labels, status.lookaside_used);
+        add_sample("connection_lookaside_used_highwater", "gauge", "Most lookaside slots ever in use at once", labels, status.lookaside_used_highwater);
+        add_sample("connection_cache_used_bytes", "gauge", "Heap memory used by the pager cache", labels, status.cache_used);
+        add_sample("connection_cache_used_shared_bytes", "gauge", "Pager cache memory with shared caches divided evenly", labels,
+                   status.cache_used_shared);
+        add_sample("connection_schema_used_bytes", "gauge", "Heap memory used by schemas", labels, status.schema_used);
+        add_sample("connection_stmt_used_bytes", "gauge", "Heap memory used by prepared statements", labels, status.stmt_used);
+        add_sample("connection_deferred_fks", "gauge", "Unresolved deferred foreign key constraints", labels, status.deferred_fks);
+    }
+
+    void add(const statement_status& status, const metric_labels& labels = {})
+    {
+        add_sample("statement_fullscan_steps_total", "counter", "Forward steps in full table scans", labels, status.fullscan_steps);
+        add_sample("statement_sort_operations_total", "counter", "Sort operations", labels, status.sort_operations);
+        add_sample("statement_autoindex_total", "counter", "Rows inserted into automatic indexes", labels, status.autoindex_count);
+        add_sample("statement_vm_steps_total", "counter", "Virtual machine operations", labels, status.vm_steps);
+        add_sample("statement_reprepares_total", "counter", "Automatic regenerations after schema changes", labels, status.reprepares);
+        add_sample("statement_runs_total", "counter", "Completed runs", labels, status.runs);
+        add_sample("statement_filter_misses_total", "counter", "Bloom filter checks that let the row through", labels, status.filter_misses);
+        add_sample("statement_filter_hits_total", "counter", "Bloom filter checks that rejected the row", labels, status.filter_hits);
+        add_sample("statement_memory_used_bytes", "gauge", "Heap memory used by the statement", labels, status.memory_used);
+    }
+
+    std::string str() const
+    {
+        std::string out;
+        for (const auto& f : families_) {
+            out.append("# HELP ").append(prefix_).append("_").append(f.name).append(" ").append(f.help).append("\n");
+            out.append("# TYPE ").append(prefix_).append("_").append(f.name).append(" ").append(f.type).append("\n");
+            for (const auto& sample : f.samples) {
+                out.append(prefix_).append("_").append(f.name).append(sample).append("\n");
+            }
+        }
+        return out;
+    }
+
+    void clear() noexcept
+    {
+        families_.clear();
+    }
+
+private:
+    struct family
+    {
+        std::string_view name;
+        std::string_view type;
+        std::string_view help;
+        std::vector<std::string> samples;
+    };
+
+    std::string prefix_;
+    std::vector<family> families_;
+
+    void add_sample(std::string_view name, std::string_view type, std::string_view help, const metric_labels& labels, std::int64_t value)
+    {
+        family* target = nullptr;
+        for (auto& f : families_) {
+            if (f.name == name) {
+                target = &f;
+                break;
+            }
+        }
+        if (target == nullptr) {
+            target = &families_.emplace_back(family{name, type, help, {}});
+        }
+
+        std::string sample;
+        if (!labels.empty()) {
+            sample.push_back('{');
+            for (std::size_t i = 0; i < labels.size(); ++i) {
+                if (i != 0) {
+                    sample.push_back(',');
+                }
+                sample.append(labels[i].first).append("=\"");
+                append_escaped(sample, labels[i].second);
+                sample.push_back('"');
+            }
+            sample.push_back('}');
+        }
+        sample.push_back(' ');
+        sample.append(std::to_string(value));
+        target->samples.push_back(std::move(sample));
+    }
+
+    static void append_escaped(std::string& out, std::string_view value)
+    {
+        for (char c : value) {
+            switch (c) {
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            default:
+                out.push_back(c);
+                break;
+            }
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_STATUS_HPP
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_THREAD_POOL_HPP
+#define SQLITEPP_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+class thread_pool
+{
+public:
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        threads = std::max<std::size_t>(threads, 1);
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~thread_pool() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return workers_.size();
+    }
+
+    template<typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using result_type = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(task));
+        auto result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            queue_.emplace_back([packaged]() { (*packaged)(); });
+        }
+        ready_.notify_one();
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_{false};
+
+    void work()
+    {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{mutex_};
+                ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_THREAD_POOL_HPP
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_TRANSACTION_HPP
+#define SQLITEPP_TRANSACTION_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/control_statements.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <system_error>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// Scoped transaction that rolls back on destruction unless committed. The
+// default mode takes the write lock up front, so that a writer does not fail
+// with SQLITE_BUSY when upgrading a read transaction.
+class transaction
+{
+public:
+    enum class mode
+    {
+        deferred,
+        immediate,
+        exclusive
+    };
+
+    explicit transaction(connection& conn, mode m = mode::immediate) : conn_(conn)
+    {
+        std::error_code ec;
+        begin(m, ec);
+        throw_on_error(ec);
+    }
+
+    transaction(connection& conn, std::error_code& ec) noexcept : conn_(conn)
+    {
+        begin(mode::immediate, ec);
+    }
+
+    transaction(connection& conn, mode m, std::error_code& ec) noexcept : conn_(conn)
+    {
+        begin(m, ec);
+    }
+
+    ~transaction() noexcept
+    {
+        if (is_active()) {
+            std::error_code ec;
+            rollback(ec);
+        }
+    }
+
+    transaction(const transaction&) = delete;
+    transaction& operator=(const transaction&) = delete;
+
+    void commit(std::error_code& ec) noexcept
+    {
+        finish(detail::control_statement::commit, ec);
+    }
+
+    void commit()
+    {
+        std::error_code ec;
+        finish(detail::control_statement::commit, ec);
+        throw_on_error(ec);
+    }
+
+    void rollback(std::error_code& ec) noexcept
+    {
+        finish(detail::control_statement::rollback, ec);
+    }
+
+    void rollback()
+    {
+        std::error_code ec;
+        finish(detail::control_statement::rollback, ec);
+        throw_on_error(ec);
+    }
+
+    // False once committed or rolled back, also when SQLite rolled back on its own after an error.
+    bool is_active() const noexcept
+    {
+        return active_ && conn_.conn_handle() != nullptr && sqlite3_get_autocommit(conn_.conn_handle()) == 0;
+    }
+
+    connection& conn() const noexcept
+    {
+        return conn_;
+    }
+
+private:
+    friend class savepoint;
+
+    connection& conn_;
+    bool active_{false};
+    // generations of the savepoints open in the transaction, by depth, whose
+    // count numbers the next one
+    std::vector<std::uint64_t> savepoints_;
+    // never reset, so that no savepoint ever shares its generation
+    std::uint64_t generation_{0};
+
+    void begin(mode m, std::error_code& ec) noexcept
+    {
+        if (!conn_.is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        auto which = m == mode::deferred    ? detail::control_statement::begin_deferred
+                     : m == mode::immediate ? detail::control_statement::begin_immediate
+                                            : detail::control_statement::begin_exclusive;
+        conn_.impl_.execute(which, ec);
+        active_ = !ec;
+        savepoints_.clear();
+    }
+
+    void finish(detail::control_statement which, std::error_code& ec) noexcept
+    {
+        if (!is_active()) {
+            active_ = false;
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        conn_.impl_.execute(which, ec);
+        // a failed COMMIT, e.g. SQLITE_BUSY, leaves the transaction open for a retry
+        active_ = ec && sqlite3_get_autocommit(conn_.conn_handle()) == 0;
+    }
+
+    static void throw_on_error(const std::error_code& ec)
+    {
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+};
+
+// Scoped savepoint nested in a transaction or in another savepoint. Rolls
+// back to the start of the savepoint on destruction unless committed. Ending
+// a savepoint also ends the savepoints opened after it.
+class savepoint
+{
+public:
+    explicit savepoint(transaction& tx) : tx_(tx)
+    {
+        std::error_code ec;
+        begin(ec);
+        throw_on_error(ec);
+    }
+
+    savepoint(transaction& tx, std::error_code& ec) noexcept : tx_(tx)
+    {
+        begin(ec);
+    }
+
+    explicit savepoint(savepoint& parent) : tx_(parent.tx_)
+    {
+        std::error_code ec;
+        begin(ec);
+        throw_on_error(ec);
+    }
+
+    savepoint(savepoint& parent, std::error_code& ec) noexcept : tx_(parent.tx_)
+    {
+        begin(ec);
+    }
+
+    ~savepoint() noexcept
+    {
+        if (is_active()) {
+            std::error_code ec;
+            rollback(ec);
+        }
+    }
+
+    savepoint(const savepoint&) = delete;
+    savepoint& operator=(const savepoint&) = delete;
+
+    void commit(std::error_code& ec) noexcept
+    {
+        if (ended_by_outer()) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        if (!is_active()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        tx_.conn_.impl_.execute(detail::savepoint_statement::release, depth_, ec);
+        active_ = static_cast<bool>(ec);
+        if (!active_) {
+            tx_.savepoints_.resize(depth_);
+        }
+    }
+
+    void commit()
+    {
+        std::error_code ec;
+        commit(ec);
+        throw_on_error(ec);
+    }
+
+    void rollback(std::error_code& ec) noexcept
+    {
+        if (ended_by_outer()) {
+            ec = sqlitepp_errc::invalid_argument;
+            return;
+        }
+        if (!is_active()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        tx_.conn_.impl_.execute(detail::savepoint_statement::rollback_to, depth_, ec);
+        if (!ec) {
+            // ROLLBACK TO keeps the savepoint on the stack
+            tx_.conn_.impl_.execute(detail::savepoint_statement::release, depth_, ec);
+        }
+        active_ = false;
+        tx_.savepoints_.resize(depth_);
+    }
+
+    void rollback()
+    {
+        std::error_code ec;
+        rollback(ec);
+        throw_on_error(ec);
+    }
+
+    bool is_active() const noexcept
+    {
+        return active_ && !ended_by_outer() && tx_.conn_.conn_handle() != nullptr && sqlite3_get_autocommit(tx_.conn_.conn_handle()) == 0;
+    }
+
+private:
+    transaction& tx_;
+    std::size_t depth_{0};
+    std::uint64_t generation_{0};
+    bool active_{false};
+
+    // Committing or rolling back a savepoint opened before this one ended
+    // it too, and a later savepoint may have reused its name, which only
+    // the generation tells apart.
+    bool ended_by_outer() const noexcept
+    {
+        return active_ && (depth_ >= tx_.savepoints_.size() || tx_.savepoints_[depth_] != generation_);
+    }
+
+    void begin(std::error_code& ec) noexcept
+    {
+        if (!tx_.conn_.is_open()) {
+            ec = sqlitepp_errc::invalid_handle;
+            return;
+        }
+        // siblings get names of their own, which a shared nesting depth would not give them
+        depth_ = tx_.savepoints_.size();
+        try {
+            tx_.savepoints_.reserve(depth_ + 1);
+        }
+        catch (const std::bad_alloc&) {
+            ec.assign(SQLITE_NOMEM, sqlite3_category());
+            return;
+        }
+        tx_.conn_.impl_.execute(detail::savepoint_statement::begin, depth_, ec);
+        active_ = !ec;
+        if (active_) {
+            generation_ = ++tx_.generation_;
+            tx_.savepoints_.push_back(generation_);
+        }
+    }
+
+    static void throw_on_error(const std::error_code& ec)
+    {
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    }
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_TRANSACTION_HPP
@@ -4,12 +4,30 @@
 #define SQLITEPP_TYPES_HPP
 
 #include <sqlitepp/detail/sqlite3.hpp>
+
+#include <cstddef>
 #include <type_traits>
 
 namespace sqlitepp
 {
 
 using conn_handle_t = std::add_pointer_t<sqlite3>;
+using stmt_handle_t = std::add_pointer_t<sqlite3_stmt>;
+
+enum class datatype : int
+{
+    integer = SQLITE_INTEGER,
+    real = SQLITE_FLOAT,
+    text = SQLITE_TEXT,
+    blob = SQLITE_BLOB,
+    null = SQLITE_NULL
+};
+
+struct blob_view
+{
+    const void* data{nullptr};
+    std::size_t size{0};
+};
 
 } // namespace sqlitepp
 
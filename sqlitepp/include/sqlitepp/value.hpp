@@ -0,0 +1,407 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_VALUE_HPP
+#define SQLITEPP_VALUE_HPP
+
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/types.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// Bump allocator for the text and blobs of values too large to be stored
+// inline, such as the cells of a result set read at once. Values allocated
+// from an arena do not own their bytes; the arena must outlive them and all
+// their copies. Not thread-safe.
+class value_arena
+{
+public:
+    explicit value_arena(std::size_t block_size = 4096) noexcept : block_size_(block_size)
+    {
+    }
+
+    value_arena(const value_arena&) = delete;
+    value_arena& operator=(const value_arena&) = delete;
+    value_arena(value_arena&&) noexcept = default;
+    value_arena& operator=(value_arena&&) noexcept = default;
+
+    std::byte* allocate(std::size_t size)
+    {
+        if (size > block_size_ / 4) {
+            // large payloads get a block of their own, so the current one is not wasted
+            blocks_.emplace_back(new std::byte[size]);
+            return blocks_.back().get();
+        }
+        if (size > left_) {
+            blocks_.emplace_back(new std::byte[block_size_]);
+            next_ = blocks_.back().get();
+            left_ = block_size_;
+        }
+        auto bytes = next_;
+        next_ += size;
+        left_ -= size;
+        return bytes;
+    }
+
+    // Frees every allocation at once; the values using them must be gone.
+    void clear() noexcept
+    {
+        blocks_.clear();
+        next_ = nullptr;
+        left_ = 0;
+    }
+
+    std::size_t block_count() const noexcept
+    {
+        return blocks_.size();
+    }
+
+private:
+    std::size_t block_size_;
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte* next_{nullptr};
+    std::size_t left_{0};
+};
+
+// An owning SQLite value: NULL, integer, real, text or blob, in 24 bytes.
+// Text and blobs of up to inline_capacity bytes are stored inline, longer
+// ones on the heap or in a value_arena. Equality compares type and content,
+// with NULL equal to NULL and NaN equal to NaN, so that values can be cache
+// keys; std::hash is consistent with it.
+class value
+{
+public:
+    static constexpr std::size_t inline_capacity = 22;
+
+    value() noexcept = default;
+
+    value(std::nullptr_t) noexcept
+    {
+    }
+
+    template<typename T, std::enable_if_t<std::is_integral_v<T>, bool> = true>
+    value(T integer) noexcept : storage_(storage::integer)
+    {
+        store(static_cast<std::int64_t>(integer));
+    }
+
+    value(double real) noexcept : storage_(storage::real)
+    {
+        store(real);
+    }
+
+    // Copies the text inline, into arena or else onto the heap.
+    value(std::string_view text, value_arena* arena = nullptr)
+    {
+        assign_bytes(datatype::text, text.data(), text.size(), arena);
+    }
+
+    value(const char* text, value_arena* arena = nullptr) : value(std::string_view{text}, arena)
+    {
+    }
+
+    value(blob_view blob, value_arena* arena = nullptr)
+    {
+        assign_bytes(datatype::blob, blob.data, blob.size, arena);
+    }
+
+    // Copies an argument of a SQL function, or any protected sqlite3_value.
+    static value from(sqlite3_value* v, value_arena* arena = nullptr)
+    {
+        switch (sqlite3_value_type(v)) {
+        case SQLITE_INTEGER:
+            return value{static_cast<std::int64_t>(sqlite3_value_int64(v))};
+        case SQLITE_FLOAT:
+            return value{sqlite3_value_double(v)};
+        case SQLITE_TEXT: {
+            // the pointer must be fetched before the size, see sqlite3_value_bytes
+            auto text = reinterpret_cast<const char*>(sqlite3_value_text(v));
+            return value{std::string_view{text, static_cast<std::size_t>(sqlite3_value_bytes(v))}, arena};
+        }
+        case SQLITE_BLOB: {
+            auto data = sqlite3_value_blob(v);
+            return value{blob_view{data, static_cast<std::size_t>(sqlite3_value_bytes(v))}, arena};
+        }
+        default:
+            return value{};
+        }
+    }
+
+    ~value() noexcept
+    {
+        release();
+    }
+
+    // Copies of values in an arena share its bytes.
+    value(const value& other) : storage_(storage::null)
+    {
+        copy_from(other);
+    }
+
+    value& operator=(const value& other)
+    {
+        if (this != &other) {
+            value copy{other};
+            swap(copy);
+        }
+        return *this;
+    }
+
+    value(value&& other) noexcept : storage_(other.storage_), size_(other.size_)
+    {
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        other.storage_ = storage::null;
+    }
+
+    value& operator=(value&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            size_ = other.size_;
+            storage_ = std::exchange(other.storage_, storage::null);
+        }
+        return *this;
+    }
+
+    void swap(value& other) noexcept
+    {
+        unsigned char bytes[sizeof(bytes_)];
+        std::memcpy(bytes, bytes_, sizeof(bytes_));
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        std::memcpy(other.bytes_, bytes, sizeof(bytes_));
+        std::swap(size_, other.size_);
+        std::swap(storage_, other.storage_);
+    }
+
+    datatype type() const noexcept
+    {
+        switch (storage_) {
+        case storage::integer:
+            return datatype::integer;
+        case storage::real:
+            return datatype::real;
+        case storage::text_inline:
+        case storage::text_heap:
+        case storage::text_arena:
+            return datatype::text;
+        case storage::blob_inline:
+        case storage::blob_heap:
+        case storage::blob_arena:
+            return datatype::blob;
+        default:
+            return datatype::null;
+        }
+    }
+
+    bool is_null() const noexcept
+    {
+        return storage_ == storage::null;
+    }
+
+    // Whether the text or blob is stored in the value itself.
+    bool is_inline() const noexcept
+    {
+        return storage_ == storage::text_inline || storage_ == storage::blob_inline;
+    }
+
+    // The integer, the real truncated, or 0 for other types.
+    std::int64_t as_int64() const noexcept
+    {
+        if (storage_ == storage::integer) {
+            return load<std::int64_t>();
+        }
+        return storage_ == storage::real ? static_cast<std::int64_t>(load<double>()) : 0;
+    }
+
+    // The real, the integer converted, or 0.0 for other types.
+    double as_double() const noexcept
+    {
+        if (storage_ == storage::real) {
+            return load<double>();
+        }
+        return storage_ == storage::integer ? static_cast<double>(load<std::int64_t>()) : 0.0;
+    }
+
+    // The text, empty for other types.
+    std::string_view as_text() const noexcept
+    {
+        if (type() != datatype::text) {
+            return {};
+        }
+        auto [data, size] = payload();
+        return std::string_view{reinterpret_cast<const char*>(data), size};
+    }
+
+    // The blob, empty for other types.
+    blob_view as_blob() const noexcept
+    {
+        if (type() != datatype::blob) {
+            return {};
+        }
+        auto [data, size] = payload();
+        return blob_view{data, size};
+    }
+
+    std::size_t hash() const noexcept
+    {
+        auto seed = static_cast<std::size_t>(type()) * 0x9e3779b97f4a7c15ull;
+        switch (type()) {
+        case datatype::integer:
+            return seed ^ std::hash<std::int64_t>{}(load<std::int64_t>());
+        case datatype::real: {
+            auto real = load<double>();
+            // 0.0 == -0.0, and NaNs of any payload are equal
+            return seed ^ std::hash<double>{}(real == 0.0 ? 0.0 : std::isnan(real) ? std::numeric_limits<double>::quiet_NaN() : real);
+        }
+        case datatype::text:
+        case datatype::blob: {
+            auto [data, size] = payload();
+            return seed ^ std::hash<std::string_view>{}(std::string_view{reinterpret_cast<const char*>(data), size});
+        }
+        default:
+            return seed;
+        }
+    }
+
+    friend bool operator==(const value& a, const value& b) noexcept
+    {
+        if (a.type() != b.type()) {
+            return false;
+        }
+        switch (a.type()) {
+        case datatype::integer:
+            return a.load<std::int64_t>() == b.load<std::int64_t>();
+        case datatype::real: {
+            auto x = a.load<double>();
+            auto y = b.load<double>();
+            return x == y || (std::isnan(x) && std::isnan(y));
+        }
+        case datatype::text:
+        case datatype::blob: {
+            auto [a_data, a_size] = a.payload();
+            auto [b_data, b_size] = b.payload();
+            return a_size == b_size && (a_size == 0 || std::memcmp(a_data, b_data, a_size) == 0);
+        }
+        default:
+            return true;
+        }
+    }
+
+    friend bool operator!=(const value& a, const value& b) noexcept
+    {
+        return !(a == b);
+    }
+
+private:
+    enum class storage : unsigned char
+    {
+        null,
+        integer,
+        real,
+        text_inline,
+        text_heap,
+        text_arena,
+        blob_inline,
+        blob_heap,
+        blob_arena
+    };
+
+    // inline bytes, or the number, or the pointer and size of the payload
+    alignas(std::int64_t) unsigned char bytes_[inline_capacity]{};
+    storage storage_{storage::null};
+    // size of an inline payload
+    unsigned char size_{0};
+
+    template<typename T>
+    void store(const T& t) noexcept
+    {
+        std::memcpy(bytes_, &t, sizeof(T));
+    }
+
+    template<typename T>
+    T load(std::size_t offset = 0) const noexcept
+    {
+        T t;
+        std::memcpy(&t, bytes_ + offset, sizeof(T));
+        return t;
+    }
+
+    std::pair<const void*, std::size_t> payload() const noexcept
+    {
+        if (is_inline()) {
+            return {bytes_, size_};
+        }
+        return {load<const std::byte*>(), load<std::size_t>(sizeof(const std::byte*))};
+    }
+
+    void assign_bytes(datatype type, const void* data, std::size_t size, value_arena* arena)
+    {
+        bool text = type == datatype::text;
+        if (size <= inline_capacity) {
+            if (size != 0) {
+                std::memcpy(bytes_, data, size);
+            }
+            size_ = static_cast<unsigned char>(size);
+            storage_ = text ? storage::text_inline : storage::blob_inline;
+            return;
+        }
+        auto copy = arena != nullptr ? arena->allocate(size) : new std::byte[size];
+        std::memcpy(copy, data, size);
+        store(static_cast<const std::byte*>(copy));
+        std::memcpy(bytes_ + sizeof(const std::byte*), &size, sizeof(size));
+        if (arena != nullptr) {
+            storage_ = text ? storage::text_arena : storage::blob_arena;
+        }
+        else {
+            storage_ = text ? storage::text_heap : storage::blob_heap;
+        }
+    }
+
+    void copy_from(const value& other)
+    {
+        if (other.storage_ == storage::text_heap || other.storage_ == storage::blob_heap) {
+            auto [data, size] = other.payload();
+            assign_bytes(other.type(), data, size, nullptr);
+            return;
+        }
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        size_ = other.size_;
+        storage_ = other.storage_;
+    }
+
+    void release() noexcept
+    {
+        if (storage_ == storage::text_heap || storage_ == storage::blob_heap) {
+            delete[] load<const std::byte*>();
+        }
+        storage_ = storage::null;
+    }
+};
+
+static_assert(sizeof(value) == 24);
+
+} // namespace sqlitepp
+
+template<>
+struct std::hash<sqlitepp::value>
+{
+    std::size_t operator()(const sqlitepp::value& v) const noexcept
+    {
+        return v.hash();
+    }
+};
+
+#endif // SQLITEPP_VALUE_HPP
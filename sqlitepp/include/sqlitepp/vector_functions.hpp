@@ -0,0 +1,471 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_VECTOR_FUNCTIONS_HPP
+#define SQLITEPP_VECTOR_FUNCTIONS_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/detail/vector_impl.hpp>
+#include <sqlitepp/extension.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// The instruction set of the vector kernels on this processor: "avx512",
+// "avx2", "neon" or "scalar".
+inline const char* vector_isa() noexcept
+{
+    return detail::select_vector_kernels().name;
+}
+
+namespace detail
+{
+
+// The number of floats of two float32 blob arguments of the same size, none
+// when either is NULL.
+inline std::optional<std::size_t> vector_arguments(const char* function, sqlite3_value* a, sqlite3_value* b)
+{
+    auto a_type = sqlite3_value_type(a);
+    auto b_type = sqlite3_value_type(b);
+    if (a_type == SQLITE_NULL || b_type == SQLITE_NULL) {
+        return std::nullopt;
+    }
+    if (a_type != SQLITE_BLOB || b_type != SQLITE_BLOB) {
+        throw std::invalid_argument(std::string{function} + ": arguments must be float32 blobs");
+    }
+    auto size = sqlite3_value_bytes(a);
+    if (size != sqlite3_value_bytes(b) || size % sizeof(float) != 0) {
+        throw std::invalid_argument(std::string{function} + ": vectors differ in size or are not float32");
+    }
+    return static_cast<std::size_t>(size) / sizeof(float);
+}
+
+enum class vector_metric
+{
+    cosine,
+    l2,
+    dot
+};
+
+inline std::optional<vector_metric> parse_vector_metric(std::string_view name) noexcept
+{
+    if (name == "cosine") {
+        return vector_metric::cosine;
+    }
+    if (name == "l2") {
+        return vector_metric::l2;
+    }
+    if (name == "dot") {
+        return vector_metric::dot;
+    }
+    return std::nullopt;
+}
+
+// The distance of vec_topk, smaller is closer: 1 - cosine similarity,
+// Euclidean distance or the negated dot product.
+inline std::optional<double> vector_distance(const vector_kernels& kernels, vector_metric metric, const void* a, const void* b, std::size_t n) noexcept
+{
+    switch (metric) {
+    case vector_metric::cosine: {
+        double similarity;
+        if (!cosine_similarity(kernels, a, b, n, similarity)) {
+            return std::nullopt;
+        }
+        return 1.0 - similarity;
+    }
+    case vector_metric::l2:
+        return std::sqrt(static_cast<double>(kernels.l2_squared(a, b, n)));
+    default:
+        return -static_cast<double>(kernels.dot(a, b, n));
+    }
+}
+
+// vec_topk(table, column, query, k[, metric]): the k rows of table whose
+// float32 blob in column is closest to query, as (id, distance) ordered by
+// distance. The table is scanned on the connection of the query, reading
+// each blob in place, and the best k are kept in a bounded max-heap. Rows
+// whose distance is undefined or NaN are skipped.
+struct topk_vtab
+{
+    enum column_index
+    {
+        id_column,
+        distance_column,
+        table_column,
+        vector_column,
+        query_column,
+        k_column,
+        metric_column,
+        column_count
+    };
+
+    static constexpr int required_columns = (1 << table_column) | (1 << vector_column) | (1 << query_column) | (1 << k_column);
+
+    struct table
+    {
+        sqlite3_vtab base;
+        sqlite3* db;
+    };
+
+    struct hit
+    {
+        double distance;
+        sqlite3_int64 id;
+
+        friend bool operator<(const hit& a, const hit& b) noexcept
+        {
+            return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+        }
+    };
+
+    struct cursor
+    {
+        sqlite3_vtab_cursor base;
+        std::vector<hit> hits;
+        std::size_t position{0};
+        std::string table_name;
+        std::string vector_name;
+        std::vector<unsigned char> query;
+        sqlite3_int64 k{0};
+        std::string metric;
+    };
+
+    static int connect(sqlite3* db, void*, int, const char* const*, sqlite3_vtab** vtab, char**) noexcept
+    {
+        int rc = sqlite3_declare_vtab(
+            db, "CREATE TABLE x(id INTEGER, distance REAL, table_name HIDDEN, column_name HIDDEN, query HIDDEN, k HIDDEN, metric HIDDEN)");
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        auto t = new (std::nothrow) table{};
+        if (t == nullptr) {
+            return SQLITE_NOMEM;
+        }
+        t->db = db;
+        *vtab = &t->base;
+        sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+        return SQLITE_OK;
+    }
+
+    static int disconnect(sqlite3_vtab* vtab) noexcept
+    {
+        delete reinterpret_cast<table*>(vtab);
+        return SQLITE_OK;
+    }
+
+    // Takes the equality constraints on the arguments in column order, which
+    // idxNum records as a bit set.
+    static int best_index(sqlite3_vtab*, sqlite3_index_info* info) noexcept
+    {
+        int constraint_of[column_count];
+        std::fill(std::begin(constraint_of), std::end(constraint_of), -1);
+        int unusable = 0;
+        for (int i = 0; i < info->nConstraint; ++i) {
+            auto& constraint = info->aConstraint[i];
+            if (constraint.iColumn < table_column || constraint.op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                continue;
+            }
+            if (!constraint.usable) {
+                unusable |= 1 << constraint.iColumn;
+                continue;
+            }
+            constraint_of[constraint.iColumn] = i;
+        }
+        int used = 0;
+        int argv_index = 0;
+        for (int column = table_column; column < column_count; ++column) {
+            if (constraint_of[column] >= 0) {
+                used |= 1 << column;
+                info->aConstraintUsage[constraint_of[column]].argvIndex = ++argv_index;
+                info->aConstraintUsage[constraint_of[column]].omit = 1;
+            }
+        }
+        if ((used & required_columns) != required_columns) {
+            // another join order may supply the arguments; if none does, xFilter reports them missing
+            if ((unusable & required_columns & ~used) != 0) {
+                return SQLITE_CONSTRAINT;
+            }
+            info->estimatedCost = 1e300;
+            info->idxNum = used;
+            return SQLITE_OK;
+        }
+        info->idxNum = used;
+        info->estimatedCost = 1e6;
+        info->estimatedRows = 25;
+        if (info->nOrderBy == 1 && info->aOrderBy[0].iColumn == distance_column && !info->aOrderBy[0].desc) {
+            info->orderByConsumed = 1;
+        }
+        return SQLITE_OK;
+    }
+
+    static int open(sqlite3_vtab*, sqlite3_vtab_cursor** c) noexcept
+    {
+        auto cur = new (std::nothrow) cursor{};
+        if (cur == nullptr) {
+            return SQLITE_NOMEM;
+        }
+        *c = &cur->base;
+        return SQLITE_OK;
+    }
+
+    static int close(sqlite3_vtab_cursor* c) noexcept
+    {
+        delete reinterpret_cast<cursor*>(c);
+        return SQLITE_OK;
+    }
+
+    static int fail(sqlite3_vtab* vtab, int rc, const char* message) noexcept
+    {
+        sqlite3_free(vtab->zErrMsg);
+        vtab->zErrMsg = sqlite3_mprintf("vec_topk: %s", message);
+        return rc;
+    }
+
+    static int filter(sqlite3_vtab_cursor* c, int idx_num, const char*, int, sqlite3_value** argv) noexcept
+    {
+        auto& cur = *reinterpret_cast<cursor*>(c);
+        auto vtab = c->pVtab;
+        cur.hits.clear();
+        cur.position = 0;
+        if ((idx_num & required_columns) != required_columns) {
+            return fail(vtab, SQLITE_ERROR, "needs the table, column, query and k arguments");
+        }
+        try {
+            sqlite3_value* args[column_count]{};
+            for (int column = table_column, i = 0; column < column_count; ++column) {
+                if ((idx_num & (1 << column)) != 0) {
+                    args[column] = argv[i++];
+                }
+            }
+            auto text = [](sqlite3_value* v) {
+                auto t = reinterpret_cast<const char*>(sqlite3_value_text(v));
+                return std::string{t != nullptr ? t : ""};
+            };
+            cur.table_name = text(args[table_column]);
+            cur.vector_name = text(args[vector_column]);
+            cur.k = sqlite3_value_int64(args[k_column]);
+            cur.metric = args[metric_column] != nullptr ? text(args[metric_column]) : "cosine";
+            auto metric = parse_vector_metric(cur.metric);
+            if (!metric) {
+                return fail(vtab, SQLITE_ERROR, "metric must be 'cosine', 'l2' or 'dot'");
+            }
+            if (sqlite3_value_type(args[query_column]) != SQLITE_BLOB || sqlite3_value_bytes(args[query_column]) % sizeof(float) != 0) {
+                return fail(vtab, SQLITE_MISMATCH, "query must be a float32 blob");
+            }
+            if (cur.k <= 0) {
+                return SQLITE_OK;
+            }
+            auto query = static_cast<const unsigned char*>(sqlite3_value_blob(args[query_column]));
+            cur.query.assign(query, query + sqlite3_value_bytes(args[query_column]));
+            return scan(cur, *metric);
+        }
+        catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+        }
+    }
+
+    static int scan(cursor& cur, vector_metric metric)
+    {
+        auto vtab = cur.base.pVtab;
+        auto db = reinterpret_cast<table*>(vtab)->db;
+        std::string sql{"SELECT rowid, "};
+        append_identifier(sql, cur.vector_name);
+        sql += " FROM ";
+        append_identifier(sql, cur.table_name);
+
+        sqlite3_stmt* stmt = nullptr;
+        int rc = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+        if (rc != SQLITE_OK) {
+            return fail(vtab, rc, sqlite3_errmsg(db));
+        }
+        auto& kernels = select_vector_kernels();
+        auto n = cur.query.size() / sizeof(float);
+        auto k = static_cast<std::size_t>(std::min<sqlite3_int64>(cur.k, 1 << 20));
+        cur.hits.reserve(std::min<std::size_t>(k, 4096));
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            // the pointer must be fetched before the size, see sqlite3_column_bytes
+            auto data = sqlite3_column_blob(stmt, 1);
+            if (data == nullptr) {
+                continue;
+            }
+            if (static_cast<std::size_t>(sqlite3_column_bytes(stmt, 1)) != cur.query.size()) {
+                sqlite3_finalize(stmt);
+                return fail(vtab, SQLITE_MISMATCH, "a vector differs in size from the query");
+            }
+            auto distance = vector_distance(kernels, metric, cur.query.data(), data, n);
+            // a NaN distance, from a vector holding NaN or infinity, cannot be ordered in the heap
+            if (!distance || std::isnan(*distance)) {
+                continue;
+            }
+            hit h{*distance, sqlite3_column_int64(stmt, 0)};
+            if (cur.hits.size() < k) {
+                cur.hits.push_back(h);
+                std::push_heap(cur.hits.begin(), cur.hits.end());
+            }
+            else if (h < cur.hits.front()) {
+                std::pop_heap(cur.hits.begin(), cur.hits.end());
+                cur.hits.back() = h;
+                std::push_heap(cur.hits.begin(), cur.hits.end());
+            }
+        }
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) {
+            cur.hits.clear();
+            return fail(vtab, rc, sqlite3_errmsg(db));
+        }
+        std::sort_heap(cur.hits.begin(), cur.hits.end());
+        return SQLITE_OK;
+    }
+
+    static int next(sqlite3_vtab_cursor* c) noexcept
+    {
+        ++reinterpret_cast<cursor*>(c)->position;
+        return SQLITE_OK;
+    }
+
+    static int eof(sqlite3_vtab_cursor* c) noexcept
+    {
+        auto& cur = *reinterpret_cast<cursor*>(c);
+        return cur.position >= cur.hits.size();
+    }
+
+    static int column(sqlite3_vtab_cursor* c, sqlite3_context* ctx, int index) noexcept
+    {
+        auto& cur = *reinterpret_cast<cursor*>(c);
+        switch (index) {
+        case id_column:
+            sqlite3_result_int64(ctx, cur.hits[cur.position].id);
+            break;
+        case distance_column:
+            sqlite3_result_double(ctx, cur.hits[cur.position].distance);
+            break;
+        case table_column:
+            sqlite3_result_text(ctx, cur.table_name.c_str(), -1, SQLITE_STATIC);
+            break;
+        case vector_column:
+            sqlite3_result_text(ctx, cur.vector_name.c_str(), -1, SQLITE_STATIC);
+            break;
+        case query_column:
+            sqlite3_result_blob(ctx, cur.query.data(), static_cast<int>(cur.query.size()), SQLITE_STATIC);
+            break;
+        case k_column:
+            sqlite3_result_int64(ctx, cur.k);
+            break;
+        default:
+            sqlite3_result_text(ctx, cur.metric.c_str(), -1, SQLITE_STATIC);
+        }
+        return SQLITE_OK;
+    }
+
+    static int rowid(sqlite3_vtab_cursor* c, sqlite3_int64* rowid) noexcept
+    {
+        *rowid = static_cast<sqlite3_int64>(reinterpret_cast<cursor*>(c)->position + 1);
+        return SQLITE_OK;
+    }
+
+    static const sqlite3_module* module() noexcept
+    {
+        // eponymous only: no xCreate, so there is no CREATE VIRTUAL TABLE ... USING vec_topk
+        static const sqlite3_module module = []() {
+            sqlite3_module m{};
+            m.xConnect = &connect;
+            m.xBestIndex = &best_index;
+            m.xDisconnect = &disconnect;
+            m.xOpen = &open;
+            m.xClose = &close;
+            m.xFilter = &filter;
+            m.xNext = &next;
+            m.xEof = &eof;
+            m.xColumn = &column;
+            m.xRowid = &rowid;
+            return m;
+        }();
+        return &module;
+    }
+};
+
+} // namespace detail
+
+// Declares vec_dot(a, b), vec_cosine(a, b) and vec_l2(a, b) over float32
+// blobs of the same size, read in place with the widest kernels the
+// processor supports, and the table-valued function vec_topk(table, column,
+// query, k[, metric]) with metric 'cosine', the default, 'l2' or 'dot'. The
+// functions return NULL for a NULL argument and vec_cosine for a zero vector.
+inline void declare_vector_functions(extension_registry& registry)
+{
+    constexpr int flags = SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+    registry
+        .function(
+            "vec_dot",
+            [](sqlite3_value* a, sqlite3_value* b) -> std::optional<double> {
+                auto n = detail::vector_arguments("vec_dot", a, b);
+                if (!n) {
+                    return std::nullopt;
+                }
+                return detail::select_vector_kernels().dot(sqlite3_value_blob(a), sqlite3_value_blob(b), *n);
+            },
+            flags)
+        .function(
+            "vec_cosine",
+            [](sqlite3_value* a, sqlite3_value* b) -> std::optional<double> {
+                auto n = detail::vector_arguments("vec_cosine", a, b);
+                double similarity;
+                if (!n || !detail::cosine_similarity(detail::select_vector_kernels(), sqlite3_value_blob(a), sqlite3_value_blob(b), *n, similarity)) {
+                    return std::nullopt;
+                }
+                return similarity;
+            },
+            flags)
+        .function(
+            "vec_l2",
+            [](sqlite3_value* a, sqlite3_value* b) -> std::optional<double> {
+                auto n = detail::vector_arguments("vec_l2", a, b);
+                if (!n) {
+                    return std::nullopt;
+                }
+                return std::sqrt(static_cast<double>(detail::select_vector_kernels().l2_squared(sqlite3_value_blob(a), sqlite3_value_blob(b), *n)));
+            },
+            flags)
+        .module("vec_topk", detail::topk_vtab::module());
+}
+
+inline void install_vector_functions(connection& conn, std::error_code& ec) noexcept
+{
+    try {
+        extension_registry registry;
+        declare_vector_functions(registry);
+        registry.install(conn, ec);
+    }
+    catch (const std::bad_alloc&) {
+        ec.assign(SQLITE_NOMEM, sqlite3_category());
+    }
+}
+
+inline void install_vector_functions(connection& conn)
+{
+    std::error_code ec;
+    install_vector_functions(conn, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+}
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_VECTOR_FUNCTIONS_HPP
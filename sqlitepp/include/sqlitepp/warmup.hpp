@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_WARMUP_HPP
+#define SQLITEPP_WARMUP_HPP
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/detail/sql_text.hpp>
+#include <sqlitepp/detail/sqlite3.hpp>
+#include <sqlitepp/prepared_statements.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace sqlitepp
+{
+
+// Named SQL statements an application prepares up front.
+class statement_registry
+{
+public:
+    struct entry
+    {
+        std::string name;
+        std::string sql;
+    };
+
+    void add(std::string name, std::string sql)
+    {
+        entries_.push_back({std::move(name), std::move(sql)});
+    }
+
+    std::size_t size() const noexcept
+    {
+        return entries_.size();
+    }
+
+    std::vector<entry>::const_iterator begin() const noexcept
+    {
+        return entries_.begin();
+    }
+
+    std::vector<entry>::const_iterator end() const noexcept
+    {
+        return entries_.end();
+    }
+
+private:
+    std::vector<entry> entries_;
+};
+
+struct warmup_options
+{
+    // PRAGMA mmap_size of each connection, so that hot pages are read through
+    // the shared page cache of the OS; 0 leaves the setting as it is
+    std::int64_t mmap_size{0};
+    // tables and indexes of the main schema whose pages are read once, on the
+    // first connection only when mmap_size maps them
+    std::vector<std::string> hot_objects;
+};
+
+struct warmup_error
+{
+    // index of the connection in its pool, 0 for a single connection
+    std::size_t connection;
+    // the statement name, "schema", "mmap_size" or the hot object
+    std::string what;
+    std::error_code ec;
+};
+
+struct warmup_report
+{
+    // pool indexes of the connections warmed up, see connection_pool::lease::index
+    std::vector<std::size_t> connections;
+    std::vector<warmup_error> errors;
+
+    bool ok() const noexcept
+    {
+        return errors.empty();
+    }
+};
+
+namespace detail
+{
+
+inline void run_warmup_query(connection& conn, std::string_view sql, std::error_code& ec) noexcept
+{
+    statement stmt{conn, sql, ec};
+    while (!ec && stmt.step(ec)) {
+    }
+}
+
+// Reads every page of a table or index of the main schema once.
+inline void touch_object(connection& conn, const std::string& name, std::error_code& ec)
+{
+    statement lookup{conn, "SELECT type, tbl_name FROM main.sqlite_schema WHERE name = ?1 AND type IN ('table', 'index')", ec};
+    if (!ec) {
+        lookup.bind(1, name, ec);
+    }
+    if (ec || !lookup.step(ec)) {
+        if (!ec) {
+            ec = sqlitepp_errc::invalid_argument;
+        }
+        return;
+    }
+    bool index = lookup.column_text(0) == std::string_view{"index"};
+    std::string sql{"SELECT count(*) FROM main."};
+    append_identifier(sql, lookup.column_text(1));
+    if (index) {
+        sql += " INDEXED BY ";
+        append_identifier(sql, name);
+    }
+    else {
+        sql += " NOT INDEXED";
+    }
+    run_warmup_query(conn, sql, ec);
+}
+
+} // namespace detail
+
+// Readies a freshly opened connection: loads the schema, sets mmap_size,
+// touches the hot objects when touch is set and prepares the registry into
+// prepared. Failures are collected in errors rather than stopping the warmup.
+inline void warmup_connection(connection& conn, std::size_t index, const statement_registry& registry, const warmup_options& options, bool touch,
+                              prepared_statements& prepared, std::vector<warmup_error>& errors)
+{
+    auto fail = [&](std::string what, const std::error_code& ec) { errors.push_back({index, std::move(what), ec}); };
+
+    std::error_code ec;
+    // reading the schema table parses the schema of every attached database
+    detail::run_warmup_query(conn, "SELECT count(*) FROM sqlite_schema", ec);
+    if (ec) {
+        fail("schema", ec);
+    }
+    if (options.mmap_size != 0) {
+        detail::run_warmup_query(conn, "PRAGMA mmap_size = " + std::to_string(options.mmap_size), ec);
+        if (ec) {
+            fail("mmap_size", ec);
+        }
+    }
+    if (touch) {
+        for (auto& name : options.hot_objects) {
+            detail::touch_object(conn, name, ec);
+            if (ec) {
+                fail(name, ec);
+            }
+        }
+    }
+    for (auto& entry : registry) {
+        statement stmt{conn, entry.sql, ec};
+        if (ec) {
+            fail(entry.name, ec);
+        }
+        else {
+            prepared.add(entry.name, std::move(stmt));
+        }
+    }
+}
+
+// Warms up a single connection, preparing the registry into prepared.
+inline warmup_report warmup(connection& conn, prepared_statements& prepared, const statement_registry& registry, const warmup_options& options = {})
+{
+    warmup_report report;
+    report.connections.push_back(0);
+    warmup_connection(conn, 0, registry, options, true, prepared, report.errors);
+    return report;
+}
+
+// Warms up the idle connections of pool in parallel on threads, leasing them
+// for the time of the warmup. The statements are kept with each connection,
+// for whoever leases it next through connection_pool::lease::prepared.
+// Connections leased out by the caller or other threads are skipped.
+inline warmup_report warmup(connection_pool& pool, thread_pool& threads, const statement_registry& registry, const warmup_options& options = {})
+{
+    std::vector<connection_pool::lease> leases;
+    leases.reserve(pool.size());
+    while (auto lease = pool.try_acquire()) {
+        leases.push_back(std::move(*lease));
+    }
+
+    warmup_report report;
+    std::vector<std::vector<warmup_error>> errors(leases.size());
+    std::vector<std::future<void>> done;
+    done.reserve(leases.size());
+    try {
+        for (std::size_t i = 0; i < leases.size(); ++i) {
+            auto& lease = leases[i];
+            report.connections.push_back(lease.index());
+            // through mmap the OS page cache is shared, so one connection reading the pages is enough
+            bool touch = options.mmap_size == 0 || i == 0;
+            done.push_back(threads.submit([&lease, &registry, &options, &errors, i, touch]() {
+                warmup_connection(*lease, lease.index(), registry, options, touch, lease.prepared(), errors[i]);
+            }));
+        }
+        for (auto& d : done) {
+            d.wait();
+        }
+    }
+    catch (...) {
+        // the queued warmups write into errors and the leased connections
+        for (auto& d : done) {
+            d.wait();
+        }
+        throw;
+    }
+    for (auto& d : done) {
+        d.get();
+    }
+    for (auto& connection_errors : errors) {
+        for (auto& error : connection_errors) {
+            report.errors.push_back(std::move(error));
+        }
+    }
+    return report;
+}
+
+// A connection warmed up as it is opened, owning the statements prepared on
+// it; constructed from a registry, options and the arguments of connection.
+// When the connection fails to open with an error code argument, there is no
+// warmup.
+class warm_connection
+{
+public:
+    template<typename... Args>
+    explicit warm_connection(const statement_registry& registry, const warmup_options& options, Args&&... args) : conn_(std::forward<Args>(args)...)
+    {
+        if (conn_.is_open()) {
+            report_ = warmup(conn_, prepared_, registry, options);
+        }
+    }
+
+    warm_connection(const warm_connection&) = delete;
+    warm_connection& operator=(const warm_connection&) = delete;
+
+    connection& operator*() noexcept
+    {
+        return conn_;
+    }
+
+    connection* operator->() noexcept
+    {
+        return &conn_;
+    }
+
+    prepared_statements& prepared() noexcept
+    {
+        return prepared_;
+    }
+
+    const warmup_report& report() const noexcept
+    {
+        return report_;
+    }
+
+private:
+    connection conn_;
+    // after the connection, so that the statements are finalized first
+    prepared_statements prepared_;
+    warmup_report report_;
+};
+
+} // namespace sqlitepp
+
+#endif // SQLITEPP_WARMUP_HPP
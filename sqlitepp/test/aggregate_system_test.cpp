@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/aggregate.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+struct item
+{
+    std::int64_t id;
+    double price;
+    std::string name;
+    std::optional<std::string> note;
+    std::vector<unsigned char> tag;
+};
+
+struct name_and_id
+{
+    std::string_view name;
+    int id;
+};
+
+static_assert(detail::field_count_v<item> == 5);
+static_assert(detail::field_count_v<name_and_id> == 2);
+
+} // namespace
+
+class AggregateSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE items(id INTEGER PRIMARY KEY, price REAL, name TEXT, note TEXT, tag BLOB)", nullptr,
+                               nullptr, nullptr),
+                  SQLITE_OK);
+    }
+
+    void insert(const item& value)
+    {
+        statement stmt{conn_, "INSERT INTO items VALUES (?, ?, ?, ?, ?)"};
+        stmt.bind(value);
+        stmt.step();
+    }
+};
+
+TEST_F(AggregateSystemTest, BindAndFetchRoundTrip)
+{
+    try {
+        insert({1, 2.5, "one", std::nullopt, {1, 2}});
+        insert({2, 0.5, "two", "second", {}});
+
+        statement select{conn_, "SELECT id, price, name, note, tag FROM items ORDER BY id"};
+        auto first = select.fetch<item>();
+        ASSERT_TRUE(first);
+        EXPECT_EQ(first->id, 1);
+        EXPECT_DOUBLE_EQ(first->price, 2.5);
+        EXPECT_EQ(first->name, "one");
+        EXPECT_FALSE(first->note);
+        EXPECT_EQ(first->tag, (std::vector<unsigned char>{1, 2}));
+
+        auto second = select.fetch<item>();
+        ASSERT_TRUE(second);
+        EXPECT_EQ(second->note, "second");
+        EXPECT_TRUE(second->tag.empty());
+
+        EXPECT_FALSE(select.fetch<item>());
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(AggregateSystemTest, FetchIntoVector)
+{
+    ASSERT_EQ(sqlite3_exec(conn_.conn_handle(),
+                           "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < 10) "
+                           "INSERT INTO items SELECT x, x / 2.0, 'item-' || x, NULL, NULL FROM n",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+
+    statement select{conn_, "SELECT id, price, name, note, tag FROM items ORDER BY id"};
+    std::vector<item> rows;
+    rows.reserve(10);
+    std::error_code ec;
+
+    EXPECT_EQ(select.fetch(rows, 4, ec), 4u);
+    ASSERT_FALSE(ec);
+    EXPECT_EQ(select.fetch(rows, ec), 6u);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(rows.size(), 10u);
+    EXPECT_EQ(rows.capacity(), 10u);
+    EXPECT_EQ(rows[9].id, 10);
+    EXPECT_EQ(rows[9].name, "item-10");
+    EXPECT_DOUBLE_EQ(rows[3].price, 2.0);
+}
+
+TEST_F(AggregateSystemTest, FetchReusesRow)
+{
+    insert({1, 1.0, "first", std::nullopt, {}});
+    insert({2, 2.0, "second", std::nullopt, {}});
+
+    statement select{conn_, "SELECT name, id FROM items ORDER BY id"};
+    name_and_id row{};
+    std::vector<int> ids;
+    while (select.fetch(row)) {
+        EXPECT_EQ(row.name, ids.empty() ? "first" : "second");
+        ids.push_back(row.id);
+    }
+    EXPECT_EQ(ids, (std::vector<int>{1, 2}));
+}
+
+TEST_F(AggregateSystemTest, ErrorOnColumnCountMismatch)
+{
+    statement select{conn_, "SELECT id FROM items"};
+    std::error_code ec;
+    auto row = select.fetch<name_and_id>(ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_FALSE(row);
+}
+
+TEST_F(AggregateSystemTest, ErrorOnParameterCountMismatch)
+{
+    statement stmt{conn_, "SELECT ?"};
+    std::error_code ec;
+    stmt.bind(name_and_id{"x", 1}, ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+}
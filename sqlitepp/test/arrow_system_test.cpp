@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/arrow.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace sqlitepp;
+
+class ArrowSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(),
+                               "CREATE TABLE t(i INTEGER, r REAL, s TEXT, b BLOB);"
+                               "INSERT INTO t VALUES (1, 0.5, 'one', x'01');"
+                               "INSERT INTO t VALUES (NULL, 1.5, NULL, x'0203');"
+                               "INSERT INTO t VALUES (3, NULL, 'three', NULL);",
+                               nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+    }
+
+    static bool is_valid(const ArrowArray* array, std::int64_t row)
+    {
+        auto validity = static_cast<const std::uint8_t*>(array->buffers[0]);
+        return validity == nullptr || (validity[row / 8] >> (row % 8) & 1) != 0;
+    }
+
+    static std::string_view string_at(const ArrowArray* array, std::int64_t row)
+    {
+        auto offsets = static_cast<const std::int64_t*>(array->buffers[1]);
+        auto data = static_cast<const char*>(array->buffers[2]);
+        return {data + offsets[row], static_cast<std::size_t>(offsets[row + 1] - offsets[row])};
+    }
+};
+
+TEST_F(ArrowSystemTest, ExportsDeclaredTypes)
+{
+    statement stmt{conn_, "SELECT i, r, s, b FROM t ORDER BY rowid"};
+    auto batch = stmt.to_arrow(10);
+
+    ASSERT_EQ(batch.rows(), 3);
+    auto schema = batch.schema();
+    EXPECT_STREQ(schema->format, "+s");
+    ASSERT_EQ(schema->n_children, 4);
+    EXPECT_STREQ(schema->children[0]->format, "l");
+    EXPECT_STREQ(schema->children[0]->name, "i");
+    EXPECT_STREQ(schema->children[1]->format, "g");
+    EXPECT_STREQ(schema->children[2]->format, "U");
+    EXPECT_STREQ(schema->children[3]->format, "Z");
+
+    auto array = batch.array();
+    ASSERT_EQ(array->n_children, 4);
+
+    auto integers = array->children[0];
+    EXPECT_EQ(integers->null_count, 1);
+    EXPECT_TRUE(is_valid(integers, 0));
+    EXPECT_FALSE(is_valid(integers, 1));
+    EXPECT_EQ(static_cast<const std::int64_t*>(integers->buffers[1])[2], 3);
+
+    auto reals = array->children[1];
+    EXPECT_EQ(static_cast<const double*>(reals->buffers[1])[1], 1.5);
+    EXPECT_FALSE(is_valid(reals, 2));
+
+    auto texts = array->children[2];
+    EXPECT_EQ(string_at(texts, 0), "one");
+    EXPECT_FALSE(is_valid(texts, 1));
+    EXPECT_EQ(string_at(texts, 1), "");
+    EXPECT_EQ(string_at(texts, 2), "three");
+
+    auto blobs = array->children[3];
+    EXPECT_EQ(string_at(blobs, 1), std::string_view("\x02\x03", 2));
+}
+
+TEST_F(ArrowSystemTest, InfersTypeOfExpressions)
+{
+    statement stmt{conn_, "SELECT CASE WHEN i IS NULL THEN NULL ELSE i * 2 END AS doubled, NULL AS missing FROM t ORDER BY rowid DESC"};
+    auto batch = stmt.to_arrow(10);
+
+    ASSERT_EQ(batch.rows(), 3);
+    EXPECT_STREQ(batch.schema()->children[0]->format, "l");
+    EXPECT_STREQ(batch.schema()->children[1]->format, "n");
+    auto doubled = batch.array()->children[0];
+    EXPECT_EQ(static_cast<const std::int64_t*>(doubled->buffers[1])[0], 6);
+    EXPECT_FALSE(is_valid(doubled, 1));
+    EXPECT_EQ(static_cast<const std::int64_t*>(doubled->buffers[1])[2], 2);
+    EXPECT_EQ(batch.array()->children[1]->null_count, 3);
+}
+
+TEST_F(ArrowSystemTest, WidensIntegersToReals)
+{
+    ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE n(v NUMERIC); INSERT INTO n VALUES (1), (NULL), (2.5)", nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    statement stmt{conn_, "SELECT v, CASE WHEN v > 2 THEN v / 2 ELSE v END FROM n ORDER BY rowid"};
+    auto batch = stmt.to_arrow(10);
+
+    ASSERT_EQ(batch.rows(), 3);
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_STREQ(batch.schema()->children[i]->format, "g");
+        auto values = static_cast<const double*>(batch.array()->children[i]->buffers[1]);
+        EXPECT_EQ(values[0], 1.0);
+        EXPECT_FALSE(is_valid(batch.array()->children[i], 1));
+    }
+    EXPECT_EQ(static_cast<const double*>(batch.array()->children[0]->buffers[1])[2], 2.5);
+    EXPECT_EQ(static_cast<const double*>(batch.array()->children[1]->buffers[1])[2], 1.25);
+}
+
+TEST_F(ArrowSystemTest, KeepsTypesAcrossBatches)
+{
+    ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE n(v NUMERIC); INSERT INTO n VALUES (NULL), (NULL), (7), (7.5)", nullptr, nullptr,
+                           nullptr),
+              SQLITE_OK);
+    statement stmt{conn_, "SELECT v, v * 2 AS twice, i FROM n LEFT JOIN t ON t.i = n.v ORDER BY n.rowid"};
+
+    // the first batch has nulls only, its types are kept for the rest
+    auto first = stmt.to_arrow(2);
+    ASSERT_EQ(first.rows(), 2);
+    EXPECT_STREQ(first.schema()->children[0]->format, "g");
+    EXPECT_STREQ(first.schema()->children[1]->format, "U");
+    EXPECT_STREQ(first.schema()->children[2]->format, "l");
+    EXPECT_EQ(first.array()->children[1]->null_count, 2);
+
+    auto second = stmt.to_arrow(2);
+    ASSERT_EQ(second.rows(), 2);
+    EXPECT_STREQ(second.schema()->children[0]->format, "g");
+    EXPECT_STREQ(second.schema()->children[1]->format, "U");
+    EXPECT_EQ(static_cast<const double*>(second.array()->children[0]->buffers[1])[0], 7.0);
+    EXPECT_EQ(static_cast<const double*>(second.array()->children[0]->buffers[1])[1], 7.5);
+    EXPECT_EQ(string_at(second.array()->children[1], 0), "14");
+    EXPECT_EQ(string_at(second.array()->children[1], 1), "15.0");
+
+    // the short batch ended the run, the next one infers its types again
+    EXPECT_EQ(stmt.to_arrow(2).rows(), 0);
+    auto again = stmt.to_arrow(10);
+    EXPECT_STREQ(again.schema()->children[1]->format, "g");
+}
+
+TEST_F(ArrowSystemTest, ExportsInBatches)
+{
+    statement stmt{conn_, "SELECT i FROM t ORDER BY rowid"};
+
+    EXPECT_EQ(stmt.to_arrow(2).rows(), 2);
+    EXPECT_EQ(stmt.to_arrow(2).rows(), 1);
+    // the short batch reset the statement
+    EXPECT_EQ(stmt.to_arrow(2).rows(), 2);
+}
+
+TEST_F(ArrowSystemTest, ConsumerMovesChildOut)
+{
+    ArrowArray moved{};
+    {
+        statement stmt{conn_, "SELECT s FROM t ORDER BY rowid"};
+        auto batch = stmt.to_arrow(10);
+        auto child = batch.array()->children[0];
+        moved = *child;
+        child->release = nullptr;
+    }
+
+    // the child outlives the released parent
+    ASSERT_NE(moved.release, nullptr);
+    EXPECT_EQ(string_at(&moved, 2), "three");
+    moved.release(&moved);
+    EXPECT_EQ(moved.release, nullptr);
+}
+
+TEST_F(ArrowSystemTest, ErrorOnUnpreparedStatement)
+{
+    statement stmt;
+    std::error_code ec;
+    auto batch = stmt.to_arrow(10, ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_EQ(batch.rows(), 0);
+    EXPECT_EQ(batch.array()->release, nullptr);
+}
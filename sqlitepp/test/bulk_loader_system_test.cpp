@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/bulk_loader.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace sqlitepp;
+
+class BulkLoaderSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+    thread_pool threads_{4};
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        exec("CREATE TABLE kv(id INTEGER PRIMARY KEY, v TEXT NOT NULL)");
+        exec("CREATE INDEX kv_v ON kv(v)");
+    }
+
+    void exec(const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+
+    std::int64_t query(const char* sql)
+    {
+        statement stmt{conn_, sql};
+        stmt.step();
+        return stmt.column_int64(0);
+    }
+
+    static std::vector<std::int64_t> shuffled_keys(std::int64_t rows)
+    {
+        std::vector<std::int64_t> keys(rows);
+        std::iota(keys.begin(), keys.end(), std::int64_t{1});
+        std::shuffle(keys.begin(), keys.end(), std::mt19937_64{7});
+        return keys;
+    }
+};
+
+TEST_F(BulkLoaderSystemTest, LoadsInKeyOrder)
+{
+    constexpr std::int64_t rows = 100000;
+    try {
+        bulk_loader<std::int64_t, std::string> loader{conn_, "kv", "INSERT INTO kv(id, v) VALUES (?1, ?2)", threads_};
+        for (auto key : shuffled_keys(rows)) {
+            loader.add(key, std::to_string(key));
+        }
+        EXPECT_EQ(loader.size(), static_cast<std::size_t>(rows));
+
+        EXPECT_EQ(loader.load(), static_cast<std::size_t>(rows));
+        EXPECT_EQ(loader.size(), 0u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+
+    EXPECT_EQ(query("SELECT count(*) FROM kv"), rows);
+    EXPECT_EQ(query("SELECT count(*) FROM kv WHERE v = CAST(id AS TEXT)"), rows);
+    // without explicit rowids the insertion order shows up as rowid order
+    exec("CREATE TABLE copy(id INTEGER)");
+    bulk_loader<std::int64_t> sorted{conn_, "copy", "INSERT INTO copy(id) SELECT ?1", threads_};
+    for (auto key : shuffled_keys(1000)) {
+        sorted.add(key);
+    }
+    sorted.load();
+    EXPECT_EQ(query("SELECT count(*) FROM copy WHERE id <> rowid"), 0);
+}
+
+TEST_F(BulkLoaderSystemTest, RebuildsIndexes)
+{
+    bulk_load_options options;
+    options.rebuild_indexes = true;
+    options.transaction_rows = 100;
+    bulk_loader<std::int64_t, std::string> loader{conn_, "kv", "INSERT INTO kv(id, v) VALUES (?1, ?2)", threads_, options};
+    for (auto key : shuffled_keys(1000)) {
+        loader.add(key, "value");
+    }
+
+    loader.load();
+
+    EXPECT_EQ(query("SELECT count(*) FROM sqlite_master WHERE type = 'index' AND name = 'kv_v'"), 1);
+    EXPECT_EQ(query("SELECT count(*) FROM kv INDEXED BY kv_v WHERE v = 'value'"), 1000);
+}
+
+TEST_F(BulkLoaderSystemTest, ErrorKeepsCommittedTransactions)
+{
+    bulk_load_options options;
+    options.rebuild_indexes = true;
+    options.transaction_rows = 10;
+    bulk_loader<std::int64_t, std::string> loader{conn_, "kv", "INSERT INTO kv(id, v) VALUES (?1, ?2)", threads_, options};
+    for (std::int64_t key = 1; key <= 25; ++key) {
+        loader.add(key, "value");
+    }
+    // sorts right behind key 15, in the second transaction
+    loader.add(std::int64_t{15}, "duplicate");
+
+    std::error_code ec;
+    auto loaded = loader.load(ec);
+
+    EXPECT_EQ(ec, sqlite3_errc::constraint_violation);
+    EXPECT_EQ(loaded, 10u);
+    EXPECT_EQ(query("SELECT count(*) FROM kv"), 10);
+    EXPECT_EQ(query("SELECT count(*) FROM sqlite_master WHERE type = 'index' AND name = 'kv_v'"), 1);
+}
+
+TEST_F(BulkLoaderSystemTest, ErrorOnThrowingColumn)
+{
+    struct label
+    {
+        std::string text;
+
+        explicit label(const char* s) : text(s)
+        {
+        }
+
+        label(const label&) = default;
+
+        label(label&&)
+        {
+            throw std::runtime_error("cannot move");
+        }
+
+        label& operator=(const label&) = default;
+
+        label& operator=(label&&)
+        {
+            throw std::runtime_error("cannot move");
+        }
+
+        operator std::string_view() const noexcept
+        {
+            return text;
+        }
+    };
+
+    bulk_loader<std::int64_t, label> loader{conn_, "kv", "INSERT INTO kv(id, v) VALUES (?1, ?2)", threads_};
+    const label two{"two"};
+    const label one{"one"};
+    loader.add(std::int64_t{2}, two);
+    loader.add(std::int64_t{1}, one);
+
+    std::error_code ec;
+    EXPECT_EQ(loader.load(ec), 0u);
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_EQ(loader.size(), 0u);
+    EXPECT_EQ(query("SELECT count(*) FROM kv"), 0);
+}
@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/change_subscription.hpp>
+#include <sqlitepp/change_types.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <condition_variable>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sqlitepp;
+
+class ChangeBusSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+    std::vector<table_changes> received_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        exec("CREATE TABLE t(x); CREATE TABLE other(y)");
+    }
+
+    void exec(const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK) << sqlite3_errmsg(conn_.conn_handle());
+    }
+
+    change_callback record()
+    {
+        return [this](const table_changes& changes) { received_.push_back(changes); };
+    }
+};
+
+TEST_F(ChangeBusSystemTest, DeliversBatchOnCommit)
+{
+    try {
+        auto subscription = conn_.on_change("t", record());
+        EXPECT_TRUE(subscription.is_subscribed());
+
+        transaction tx{conn_};
+        exec("INSERT INTO t VALUES (1), (2); UPDATE t SET x = 3 WHERE rowid = 1; DELETE FROM t WHERE rowid = 2; INSERT INTO other VALUES (1)");
+        EXPECT_TRUE(received_.empty());
+        tx.commit();
+
+        ASSERT_EQ(received_.size(), 1u);
+        auto& batch = received_.front();
+        EXPECT_EQ(batch.database, "main");
+        EXPECT_EQ(batch.table, "t");
+        EXPECT_TRUE(batch.complete);
+        ASSERT_EQ(batch.rows.size(), 4u);
+        EXPECT_EQ(batch.rows[0].kind, change_kind::insert);
+        EXPECT_EQ(batch.rows[1].rowid, 2);
+        EXPECT_EQ(batch.rows[2].kind, change_kind::update);
+        EXPECT_EQ(batch.rows[3].kind, change_kind::erase);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ChangeBusSystemTest, AutocommitStatementsAreBatchesOfTheirOwn)
+{
+    auto subscription = conn_.on_change("T", record());
+    exec("INSERT INTO t VALUES (1)");
+    exec("INSERT INTO t VALUES (2)");
+
+    ASSERT_EQ(received_.size(), 2u);
+    EXPECT_EQ(received_[1].rows.front().rowid, 2);
+}
+
+TEST_F(ChangeBusSystemTest, DropsRolledBackChanges)
+{
+    auto subscription = conn_.on_change("t", record());
+    exec("BEGIN; INSERT INTO t VALUES (1); ROLLBACK");
+    EXPECT_TRUE(received_.empty());
+
+    exec("INSERT INTO t VALUES (2)");
+    ASSERT_EQ(received_.size(), 1u);
+    ASSERT_EQ(received_.front().rows.size(), 1u);
+}
+
+TEST_F(ChangeBusSystemTest, WaitsForBusyCommitToSucceed)
+{
+    auto filename = temp_path("change_bus.db");
+    std::remove(filename.c_str());
+    try {
+        auto writer = connect(filename);
+        auto reader = connect(filename);
+        writer.execute_script("CREATE TABLE t(x)");
+        sqlite3_busy_timeout(writer.conn_handle(), 0);
+        auto subscription = writer.on_change("t", record());
+
+        // the reader keeps its shared lock, so the writer cannot commit
+        reader.execute_script("BEGIN; SELECT count(*) FROM t");
+        writer.execute_script("BEGIN; INSERT INTO t VALUES (1)");
+        std::error_code ec;
+        writer.execute_script("COMMIT", {}, ec);
+        EXPECT_EQ(ec, sqlite3_errc::database_busy);
+        EXPECT_TRUE(received_.empty());
+
+        writer.execute_script("INSERT INTO t VALUES (2)");
+        reader.execute_script("COMMIT");
+        writer.execute_script("COMMIT");
+        ASSERT_EQ(received_.size(), 1u);
+        ASSERT_EQ(received_.front().rows.size(), 2u);
+        EXPECT_EQ(received_.front().rows[1].rowid, 2);
+
+        reader.execute_script("BEGIN; SELECT count(*) FROM t");
+        writer.execute_script("BEGIN; INSERT INTO t VALUES (3)");
+        writer.execute_script("COMMIT", {}, ec);
+        EXPECT_EQ(ec, sqlite3_errc::database_busy);
+        writer.execute_script("ROLLBACK");
+        reader.execute_script("COMMIT");
+        writer.execute_script("INSERT INTO t VALUES (4)");
+        ASSERT_EQ(received_.size(), 2u);
+        ASSERT_EQ(received_.back().rows.size(), 1u);
+    }
+    catch (const std::system_error& ec) {
+        ADD_FAILURE() << ec.what();
+    }
+    std::remove(filename.c_str());
+}
+
+TEST_F(ChangeBusSystemTest, TellsTablesCreatedAfterDropsApart)
+{
+    auto subscription = conn_.on_change("w", record());
+    for (int i = 0; i < 20; ++i) {
+        auto name = std::string{i % 2 == 0 ? "v" : "w"};
+        exec(("CREATE TABLE " + name + "(x); INSERT INTO " + name + " VALUES (" + std::to_string(i) + "); DROP TABLE " + name).c_str());
+    }
+
+    ASSERT_EQ(received_.size(), 10u);
+    for (auto& batch : received_) {
+        EXPECT_EQ(batch.table, "w");
+    }
+}
+
+TEST_F(ChangeBusSystemTest, StopsAfterUnsubscribe)
+{
+    auto subscription = conn_.on_change("t", record());
+    auto other = conn_.on_change("other", record());
+    subscription.unsubscribe();
+    EXPECT_FALSE(subscription.is_subscribed());
+
+    exec("INSERT INTO t VALUES (1); INSERT INTO other VALUES (1)");
+    ASSERT_EQ(received_.size(), 1u);
+    EXPECT_EQ(received_.front().table, "other");
+}
+
+TEST_F(ChangeBusSystemTest, CallbackMayUnsubscribeItself)
+{
+    change_subscription subscription;
+    int calls = 0;
+    subscription = conn_.on_change("t", [&](const table_changes&) {
+        ++calls;
+        subscription.unsubscribe();
+    });
+
+    exec("INSERT INTO t VALUES (1)");
+    exec("INSERT INTO t VALUES (2)");
+    EXPECT_EQ(calls, 1);
+}
+
+TEST_F(ChangeBusSystemTest, DeliversOnWorkerInCommitOrder)
+{
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<std::int64_t> rowids;
+    std::thread::id caller = std::this_thread::get_id();
+    std::thread::id worker;
+
+    auto subscription = conn_.on_change(
+        "t",
+        [&](const table_changes& changes) {
+            std::lock_guard<std::mutex> lock{mutex};
+            worker = std::this_thread::get_id();
+            rowids.push_back(changes.rows.front().rowid);
+            done.notify_one();
+        },
+        change_delivery::worker);
+
+    for (int i = 0; i < 20; ++i) {
+        exec("INSERT INTO t VALUES (0)");
+    }
+
+    std::unique_lock<std::mutex> lock{mutex};
+    ASSERT_TRUE(done.wait_for(lock, std::chrono::seconds{10}, [&]() { return rowids.size() == 20; }));
+    EXPECT_NE(worker, caller);
+    for (std::size_t i = 0; i < rowids.size(); ++i) {
+        EXPECT_EQ(rowids[i], static_cast<std::int64_t>(i + 1));
+    }
+}
+
+TEST_F(ChangeBusSystemTest, SubscriptionOutlivesConnection)
+{
+    auto subscription = conn_.on_change("t", record(), change_delivery::worker);
+    conn_.close();
+
+    EXPECT_FALSE(subscription.is_subscribed());
+}
+
+TEST_F(ChangeBusSystemTest, ErrorOnClosedConnection)
+{
+    connection closed;
+    std::error_code ec;
+    auto subscription = closed.on_change("t", record(), change_delivery::on_commit, ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_FALSE(subscription.is_subscribed());
+}
@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/compress_vfs.hpp>
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace sqlitepp;
+
+TEST(LzCodecTest, RoundTrips)
+{
+    std::mt19937 random{42};
+    std::vector<std::vector<unsigned char>> inputs{{}, {'a'}, std::vector<unsigned char>(12, 'x'), std::vector<unsigned char>(13, 'x'),
+                                                   std::vector<unsigned char>(65536, 0)};
+    std::vector<unsigned char> text;
+    for (int i = 0; i < 4096; ++i) {
+        auto row = "row " + std::to_string(i % 97) + " name-" + std::to_string(i % 13) + ";";
+        text.insert(text.end(), row.begin(), row.end());
+    }
+    text.resize(4096);
+    inputs.push_back(text);
+    std::vector<unsigned char> noise(4096);
+    for (auto& c : noise) {
+        c = static_cast<unsigned char>(random());
+    }
+    inputs.push_back(noise);
+
+    detail::lz_codec codec;
+    for (auto& input : inputs) {
+        std::vector<unsigned char> compressed(input.size() + input.size() / 255 + 16);
+        auto size = codec.compress(input.data(), input.size(), compressed.data(), compressed.size());
+        ASSERT_GT(size, 0u);
+        std::vector<unsigned char> output(input.size());
+        ASSERT_TRUE(detail::lz_codec::decompress(compressed.data(), size, output.data(), output.size()));
+        EXPECT_EQ(output, input);
+        if (input.size() > 1) {
+            EXPECT_FALSE(detail::lz_codec::decompress(compressed.data(), size, output.data(), output.size() - 1));
+        }
+    }
+    EXPECT_LT(codec.compress(text.data(), text.size(), std::vector<unsigned char>(4096).data(), 4096), 2048u);
+    EXPECT_EQ(codec.compress(noise.data(), noise.size(), std::vector<unsigned char>(4095).data(), 4095), 0u);
+}
+
+class CompressVfsSystemTest : public ::testing::Test
+{
+protected:
+    std::string filename_;
+
+    void SetUp() override
+    {
+        vfs::register_compress();
+        filename_ = temp_path("compress_vfs.db");
+        remove_files();
+    }
+
+    void TearDown() override
+    {
+        remove_files();
+    }
+
+    void remove_files()
+    {
+        for (auto suffix : {"", "-journal", "-wal", "-shm", "-compact"}) {
+            std::remove((filename_ + suffix).c_str());
+        }
+    }
+
+    connection open()
+    {
+        return connect(filename_, connection::openmode::rwc, "compress");
+    }
+
+    static void fill(connection& conn, int rows)
+    {
+        conn.execute_script("CREATE TABLE IF NOT EXISTS t(id INTEGER PRIMARY KEY, name TEXT, body TEXT)");
+        statement insert{conn, "INSERT INTO t(name, body) VALUES (?1, ?2)"};
+        conn.execute_script("BEGIN");
+        for (int i = 0; i < rows; ++i) {
+            insert.bind(1, "name " + std::to_string(i % 50));
+            insert.bind(2, "the body of row " + std::to_string(i) + " repeats the same words again and again");
+            insert.step();
+            insert.reset();
+        }
+        conn.execute_script("COMMIT");
+    }
+
+    static std::int64_t scalar(connection& conn, const std::string& sql)
+    {
+        statement stmt{conn, sql};
+        return stmt.step() ? stmt.column_int64(0) : -1;
+    }
+
+    static std::string text(connection& conn, const std::string& sql)
+    {
+        statement stmt{conn, sql};
+        return stmt.step() ? std::string{stmt.column_text(0)} : std::string{};
+    }
+};
+
+TEST_F(CompressVfsSystemTest, CompressesPages)
+{
+    try {
+        {
+            auto conn = open();
+            fill(conn, 20000);
+            auto stats = vfs::stats(conn);
+            EXPECT_EQ(static_cast<std::int64_t>(stats.logical_size), scalar(conn, "PRAGMA page_count") * scalar(conn, "PRAGMA page_size"));
+            EXPECT_LT(stats.physical_size, stats.logical_size / 2);
+            EXPECT_EQ(static_cast<std::int64_t>(stats.pages), scalar(conn, "PRAGMA page_count"));
+        }
+        auto conn = open();
+        EXPECT_EQ(text(conn, "PRAGMA integrity_check"), "ok");
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t"), 20000);
+        EXPECT_EQ(text(conn, "SELECT body FROM t WHERE id = 12345"), "the body of row 12344 repeats the same words again and again");
+
+        // the journal is a plain file of page images
+        conn.execute_script("PRAGMA journal_mode = DELETE; BEGIN; DELETE FROM t WHERE id > 100; UPDATE t SET name = 'x'");
+        std::ifstream journal{filename_ + "-journal", std::ios::binary | std::ios::ate};
+        EXPECT_GT(static_cast<std::int64_t>(journal.tellg()), scalar(conn, "PRAGMA page_size") * 100);
+        conn.execute_script("ROLLBACK");
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t"), 20000);
+        EXPECT_EQ(text(conn, "PRAGMA integrity_check"), "ok");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, StoresIncompressiblePages)
+{
+    try {
+        std::vector<unsigned char> blob(100000);
+        std::mt19937 random{7};
+        for (auto& c : blob) {
+            c = static_cast<unsigned char>(random());
+        }
+        {
+            auto conn = open();
+            conn.execute_script("PRAGMA page_size = 65536; CREATE TABLE b(data BLOB)");
+            statement insert{conn, "INSERT INTO b VALUES (?1)"};
+            insert.bind(1, blob_view{blob.data(), blob.size()});
+            insert.step();
+        }
+        auto conn = open();
+        statement select{conn, "SELECT data FROM b"};
+        ASSERT_TRUE(select.step());
+        auto data = select.column_blob(0);
+        ASSERT_EQ(data.size, blob.size());
+        EXPECT_EQ(std::memcmp(data.data, blob.data(), blob.size()), 0);
+        EXPECT_EQ(scalar(conn, "PRAGMA page_size"), 65536);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, SharesWalDatabaseBetweenConnections)
+{
+    try {
+        auto writer = open();
+        writer.execute_script("PRAGMA journal_mode = WAL");
+        fill(writer, 1000);
+        auto reader = open();
+        EXPECT_EQ(scalar(reader, "SELECT count(*) FROM t"), 1000);
+
+        // pages the checkpoint appends are read through the new records
+        writer.execute_script("PRAGMA wal_checkpoint(TRUNCATE)");
+        fill(writer, 1000);
+        writer.execute_script("PRAGMA wal_checkpoint(TRUNCATE)");
+        EXPECT_EQ(scalar(reader, "SELECT count(*) FROM t"), 2000);
+        EXPECT_EQ(text(reader, "PRAGMA integrity_check"), "ok");
+
+        writer.close();
+        reader.execute_script("PRAGMA journal_mode = DELETE");
+        reader.close();
+        auto conn = open();
+        fill(conn, 10);
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t"), 2010);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, CheckpointsFromSeveralConnections)
+{
+    try {
+        auto first = open();
+        first.execute_script("PRAGMA journal_mode = WAL; PRAGMA wal_autocheckpoint = 0");
+        auto second = open();
+        second.execute_script("PRAGMA wal_autocheckpoint = 0");
+        fill(first, 500);
+        // first appends nothing to the file between the checkpoints of second and its own
+        second.execute_script("PRAGMA wal_checkpoint(PASSIVE)");
+        fill(second, 476);
+        auto before = vfs::stats(second).physical_size;
+        first.execute_script("PRAGMA wal_checkpoint(PASSIVE)");
+        EXPECT_GT(vfs::stats(second).physical_size, before);
+        second.execute_script("PRAGMA wal_checkpoint(PASSIVE)");
+        first.close();
+        second.close();
+
+        auto conn = open();
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t"), 976);
+        EXPECT_EQ(text(conn, "PRAGMA integrity_check"), "ok");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, SharesRollbackDatabaseBetweenConnections)
+{
+    try {
+        auto first = open();
+        auto second = open();
+        fill(first, 500);
+        EXPECT_EQ(scalar(second, "SELECT count(*) FROM t"), 500);
+        second.execute_script("DELETE FROM t WHERE id <= 250; VACUUM");
+        EXPECT_EQ(scalar(first, "SELECT count(*) FROM t"), 250);
+        fill(first, 10);
+        EXPECT_EQ(scalar(second, "SELECT count(*) FROM t"), 260);
+        EXPECT_EQ(text(second, "PRAGMA integrity_check"), "ok");
+        EXPECT_EQ(vfs::stats(first).logical_size, vfs::stats(second).logical_size);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, Compacts)
+{
+    try {
+        vfs::compress_stats before;
+        {
+            auto conn = open();
+            fill(conn, 5000);
+            conn.execute_script("UPDATE t SET name = 'renamed'; UPDATE t SET name = 'again'");
+            before = vfs::stats(conn);
+            EXPECT_LT(before.live_size, before.physical_size / 2);
+        }
+        vfs::compact(filename_);
+        auto conn = open();
+        auto after = vfs::stats(conn);
+        EXPECT_LT(after.physical_size, before.physical_size / 2);
+        EXPECT_EQ(after.live_size + vfs::detail::compress_file_header_size, after.physical_size);
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t WHERE name = 'again'"), 5000);
+
+        std::error_code ec;
+        vfs::compact(filename_, ec, "no such vfs");
+        EXPECT_TRUE(ec);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, IgnoresTornTail)
+{
+    try {
+        {
+            auto conn = open();
+            fill(conn, 300);
+        }
+        {
+            std::ofstream file{filename_, std::ios::binary | std::ios::app};
+            file << "a record header that never got its payload";
+        }
+        auto conn = open();
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t"), 300);
+        fill(conn, 300);
+        conn.close();
+        conn = open();
+        EXPECT_EQ(scalar(conn, "SELECT count(*) FROM t"), 600);
+        EXPECT_EQ(text(conn, "PRAGMA integrity_check"), "ok");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(CompressVfsSystemTest, Errors)
+{
+    {
+        auto plain = connect(filename_);
+        plain.execute_script("CREATE TABLE t(x)");
+    }
+    std::error_code ec;
+    connection conn;
+    conn.open(filename_, connection::openmode::rw, "compress", ec);
+    if (!ec) {
+        statement stmt{conn, "SELECT count(*) FROM t", ec};
+    }
+    EXPECT_EQ(ec, sqlite3_errc::not_a_database);
+
+    auto plain = connect(filename_);
+    vfs::stats(plain, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    connection closed;
+    vfs::stats(closed, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+
+    vfs::register_compress({"compress2", "no such vfs"}, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    vfs::register_compress({"compress2"}, ec);
+    EXPECT_FALSE(ec);
+    EXPECT_NE(sqlite3_vfs_find("compress2"), nullptr);
+}
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/deadline.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace sqlitepp;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+// counts forever; only an interrupt ends it
+constexpr const char* runaway_sql = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c";
+
+} // namespace
+
+class DeadlineSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+    }
+};
+
+TEST_F(DeadlineSystemTest, InterruptsRunawayQuery)
+{
+    statement stmt{conn_, runaway_sql};
+    auto start = std::chrono::steady_clock::now();
+    conn_.set_deadline(start + 50ms);
+
+    std::error_code ec;
+    EXPECT_FALSE(stmt.step(ec));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+    EXPECT_GE(elapsed, 50ms);
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST_F(DeadlineSystemTest, FastQuerySucceeds)
+{
+    try {
+        conn_.set_deadline(std::chrono::steady_clock::now() + 10s);
+        statement stmt{conn_, "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c LIMIT 10000) SELECT count(*) FROM c"};
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(sqlite3_column_int(stmt.stmt_handle(), 0), 10000);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(DeadlineSystemTest, ExpiredDeadlineFailsNextStatement)
+{
+    conn_.set_deadline(std::chrono::steady_clock::now() - 1ms);
+    statement stmt{conn_, runaway_sql};
+
+    std::error_code ec;
+    EXPECT_FALSE(stmt.step(ec));
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+}
+
+TEST_F(DeadlineSystemTest, ExpiredDeadlineFailsTrivialStatement)
+{
+    statement stmt{conn_, "SELECT 1"};
+    conn_.set_deadline(std::chrono::steady_clock::now() - 1ms);
+
+    std::error_code ec;
+    EXPECT_FALSE(stmt.step(ec));
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+
+    conn_.execute_script("SELECT 1", {}, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+
+    stmt.to_arrow(10, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+
+    conn_.clear_deadline();
+    EXPECT_TRUE(stmt.step(ec));
+    EXPECT_FALSE(ec);
+}
+
+TEST_F(DeadlineSystemTest, ClearDeadline)
+{
+    conn_.set_deadline(std::chrono::steady_clock::now() - 1ms);
+    EXPECT_TRUE(conn_.deadline().has_value());
+    conn_.clear_deadline();
+    EXPECT_FALSE(conn_.deadline().has_value());
+
+    statement stmt{conn_, "SELECT 1"};
+    std::error_code ec;
+    EXPECT_TRUE(stmt.step(ec));
+    EXPECT_FALSE(ec);
+}
+
+TEST_F(DeadlineSystemTest, ScopeKeepsEarlierDeadlineAndRestoresIt)
+{
+    auto outer = std::chrono::steady_clock::now() + 1h;
+    conn_.set_deadline(outer);
+    {
+        deadline_scope scope{conn_, 50ms};
+        EXPECT_LT(*conn_.deadline(), outer);
+        {
+            deadline_scope later{conn_, 2h};
+            EXPECT_LT(*conn_.deadline(), outer);
+        }
+
+        statement stmt{conn_, runaway_sql};
+        std::error_code ec;
+        EXPECT_FALSE(stmt.step(ec));
+        EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+    }
+    EXPECT_EQ(conn_.deadline(), outer);
+
+    conn_.clear_deadline();
+    {
+        deadline_scope scope{conn_, 1h};
+    }
+    EXPECT_FALSE(conn_.deadline().has_value());
+}
+
+TEST_F(DeadlineSystemTest, FollowsConnectionOnSwap)
+{
+    statement before{conn_, "SELECT 1"};
+    conn_.set_deadline(std::chrono::steady_clock::now() - 1ms);
+    connection other = connect(":memory:");
+    std::swap(conn_, other);
+    EXPECT_FALSE(conn_.deadline().has_value());
+
+    std::error_code ec;
+    EXPECT_FALSE(before.step(ec));
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+
+    statement fast{conn_, "SELECT 1"};
+    EXPECT_TRUE(fast.step());
+
+    statement slow{other, runaway_sql};
+    EXPECT_FALSE(slow.step(ec));
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+
+    statement trivial{other, "SELECT 1"};
+    EXPECT_FALSE(trivial.step(ec));
+    EXPECT_EQ(ec, sqlitepp_errc::deadline_exceeded);
+}
+
+TEST_F(DeadlineSystemTest, PlainInterruptIsNotDeadline)
+{
+    conn_.set_deadline(std::chrono::steady_clock::now() + 1h);
+    statement stmt{conn_, runaway_sql};
+    // an interrupt only reaches statements already running
+    std::thread interrupter{[db = conn_.conn_handle()]() {
+        std::this_thread::sleep_for(50ms);
+        sqlite3_interrupt(db);
+    }};
+
+    std::error_code ec;
+    EXPECT_FALSE(stmt.step(ec));
+    interrupter.join();
+    EXPECT_EQ(ec.category(), sqlite3_category());
+    EXPECT_EQ(ec.value(), SQLITE_INTERRUPT);
+}
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: MIT
+
+// A loadable extension for extension_system_test, built with sqlitepp_add_extension.
+
+#include <sqlitepp/extension.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+struct product
+{
+    double result{1.0};
+
+    void step(double x)
+    {
+        result *= x;
+    }
+
+    double finish() const
+    {
+        return result;
+    }
+};
+
+// An eponymous virtual table numbers(n) holding the rows 1, 2 and 3.
+struct numbers_cursor
+{
+    sqlite3_vtab_cursor base;
+    std::int64_t row;
+};
+
+int numbers_connect(sqlite3* db, void*, int, const char* const*, sqlite3_vtab** vtab, char**)
+{
+    int rc = sqlite3_declare_vtab(db, "CREATE TABLE x(n)");
+    if (rc == SQLITE_OK) {
+        *vtab = static_cast<sqlite3_vtab*>(sqlite3_malloc(sizeof(sqlite3_vtab)));
+        if (*vtab == nullptr) {
+            return SQLITE_NOMEM;
+        }
+        **vtab = sqlite3_vtab{};
+    }
+    return rc;
+}
+
+int numbers_best_index(sqlite3_vtab*, sqlite3_index_info* info)
+{
+    info->estimatedCost = 3.0;
+    info->estimatedRows = 3;
+    return SQLITE_OK;
+}
+
+int numbers_disconnect(sqlite3_vtab* vtab)
+{
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+int numbers_open(sqlite3_vtab*, sqlite3_vtab_cursor** cursor)
+{
+    auto c = static_cast<numbers_cursor*>(sqlite3_malloc(sizeof(numbers_cursor)));
+    if (c == nullptr) {
+        return SQLITE_NOMEM;
+    }
+    *c = numbers_cursor{};
+    *cursor = &c->base;
+    return SQLITE_OK;
+}
+
+int numbers_close(sqlite3_vtab_cursor* cursor)
+{
+    sqlite3_free(cursor);
+    return SQLITE_OK;
+}
+
+int numbers_filter(sqlite3_vtab_cursor* cursor, int, const char*, int, sqlite3_value**)
+{
+    reinterpret_cast<numbers_cursor*>(cursor)->row = 1;
+    return SQLITE_OK;
+}
+
+int numbers_next(sqlite3_vtab_cursor* cursor)
+{
+    ++reinterpret_cast<numbers_cursor*>(cursor)->row;
+    return SQLITE_OK;
+}
+
+int numbers_eof(sqlite3_vtab_cursor* cursor)
+{
+    return reinterpret_cast<numbers_cursor*>(cursor)->row > 3;
+}
+
+int numbers_column(sqlite3_vtab_cursor* cursor, sqlite3_context* ctx, int)
+{
+    sqlite3_result_int64(ctx, reinterpret_cast<numbers_cursor*>(cursor)->row);
+    return SQLITE_OK;
+}
+
+int numbers_rowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid)
+{
+    *rowid = reinterpret_cast<numbers_cursor*>(cursor)->row;
+    return SQLITE_OK;
+}
+
+sqlite3_module make_numbers_module()
+{
+    sqlite3_module module{};
+    module.xConnect = numbers_connect;
+    module.xBestIndex = numbers_best_index;
+    module.xDisconnect = numbers_disconnect;
+    module.xOpen = numbers_open;
+    module.xClose = numbers_close;
+    module.xFilter = numbers_filter;
+    module.xNext = numbers_next;
+    module.xEof = numbers_eof;
+    module.xColumn = numbers_column;
+    module.xRowid = numbers_rowid;
+    return module;
+}
+
+const sqlite3_module numbers_module = make_numbers_module();
+
+} // namespace
+
+SQLITEPP_EXTENSION(sqlitepptest)
+{
+    registry.function("reverse_text", [](std::string text) {
+        std::reverse(text.begin(), text.end());
+        return text;
+    });
+    registry.aggregate<product>("product");
+    registry.collation("by_length", [](std::string_view a, std::string_view b) { return static_cast<int>(a.size()) - static_cast<int>(b.size()); });
+    registry.module("numbers", &numbers_module);
+}
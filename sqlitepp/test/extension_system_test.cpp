@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/extension.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/value.hpp>
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+struct concat
+{
+    std::string result;
+
+    void step(std::string_view text, std::optional<std::string_view> separator)
+    {
+        if (!result.empty()) {
+            result += separator.value_or(",");
+        }
+        result += text;
+    }
+
+    std::optional<std::string> finish() const
+    {
+        return result.empty() ? std::nullopt : std::optional<std::string>{result};
+    }
+};
+
+int twice(int x)
+{
+    return 2 * x;
+}
+
+} // namespace
+
+SQLITEPP_EXTENSION(inprocess)
+{
+    registry.function("plus_one", [](std::int64_t x) { return x + 1; });
+}
+
+class ExtensionSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+    }
+
+    std::string text(std::string_view sql)
+    {
+        statement stmt{conn_, sql};
+        stmt.step();
+        return std::string{stmt.column_text(0)};
+    }
+
+    sqlitepp::value query(std::string_view sql)
+    {
+        statement stmt{conn_, sql};
+        stmt.step();
+        return stmt.column_value(0);
+    }
+};
+
+TEST_F(ExtensionSystemTest, RegistersFunctions)
+{
+    try {
+        extension_registry registry;
+        registry.function("twice", &twice)
+            .function("describe", [](const sqlitepp::value& v, std::optional<double> scale) {
+                return std::string{v.is_null() ? "null" : "value"} + (scale ? " scaled" : "");
+            })
+            .function("bytes", [](blob_view blob) { return std::vector<unsigned char>(blob.size, 7); })
+            .function("noop", []() {});
+        EXPECT_EQ(registry.size(), 4u);
+        registry.install(conn_);
+
+        EXPECT_EQ(query("SELECT twice(21)"), sqlitepp::value{42});
+        EXPECT_EQ(text("SELECT describe(NULL, 2.0)"), "null scaled");
+        EXPECT_EQ(text("SELECT describe('x', NULL)"), "value");
+        EXPECT_EQ(query("SELECT bytes(x'0102')"), (sqlitepp::value{blob_view{"\x07\x07", 2}}));
+        EXPECT_TRUE(query("SELECT noop()").is_null());
+
+        // the arity is that of the C++ function
+        std::error_code ec;
+        statement stmt{conn_, "SELECT twice(1, 2)", ec};
+        EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ExtensionSystemTest, ReportsExceptionsAsErrors)
+{
+    try {
+        extension_registry registry;
+        registry.function("fail", [](std::string_view message) -> int { throw std::runtime_error(std::string{message}); })
+            .function("busy", []() -> int { throw std::system_error(SQLITE_BUSY, sqlite3_category()); });
+        registry.install(conn_);
+
+        std::error_code ec;
+        statement stmt{conn_, "SELECT fail('no luck')"};
+        stmt.step(ec);
+        EXPECT_EQ(ec, sqlite3_errc::generic_error);
+        EXPECT_STREQ(sqlite3_errmsg(conn_.conn_handle()), "no luck");
+
+        statement busy{conn_, "SELECT busy()"};
+        busy.step(ec);
+        EXPECT_EQ(ec, sqlite3_errc::database_busy);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ExtensionSystemTest, RegistersAggregatesAndCollations)
+{
+    try {
+        extension_registry registry;
+        registry.aggregate<concat>("concat").collation("reverse", [](std::string_view a, std::string_view b) { return b.compare(a); });
+        registry.install(conn_);
+
+        EXPECT_EQ(text("SELECT concat(column1, '-') FROM (VALUES ('a'), ('b'), ('c'))"), "a-b-c");
+        EXPECT_EQ(text("SELECT concat(column1, NULL) FROM (VALUES ('a'), ('b'))"), "a,b");
+        EXPECT_TRUE(query("SELECT concat(column1, NULL) FROM (VALUES ('a')) WHERE 0").is_null());
+        EXPECT_EQ(text("SELECT group_concat(column1, '') FROM (SELECT column1 FROM (VALUES ('a'), ('c'), ('b')) ORDER BY column1 COLLATE reverse)"),
+                  "cba");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ExtensionSystemTest, InstallsAutoExtensions)
+{
+    try {
+        auto entry = reinterpret_cast<void (*)()>(sqlite3_inprocess_init);
+        ASSERT_EQ(sqlite3_auto_extension(entry), SQLITE_OK);
+        auto conn = connect(":memory:");
+        sqlite3_cancel_auto_extension(entry);
+
+        statement stmt{conn, "SELECT plus_one(1)"};
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_int64(0), 2);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ExtensionSystemTest, LoadsExtensionModules)
+{
+    try {
+        ASSERT_EQ(sqlite3_db_config(conn_.conn_handle(), SQLITE_DBCONFIG_ENABLE_LOAD_EXTENSION, 1, nullptr), SQLITE_OK);
+        char* message = nullptr;
+        ASSERT_EQ(sqlite3_load_extension(conn_.conn_handle(), SQLITEPP_TEST_EXTENSION, nullptr, &message), SQLITE_OK) << message;
+
+        EXPECT_EQ(text("SELECT reverse_text('abc')"), "cba");
+        EXPECT_EQ(query("SELECT product(column1) FROM (VALUES (2.0), (3.5))"), sqlitepp::value{7.0});
+        EXPECT_EQ(text("SELECT group_concat(column1, ' ') FROM (SELECT column1 FROM (VALUES ('ccc'), ('a'), ('bb')) ORDER BY column1 COLLATE by_length)"),
+                  "a bb ccc");
+        EXPECT_EQ(query("SELECT sum(n) FROM numbers"), sqlitepp::value{6});
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ExtensionSystemTest, Errors)
+{
+    std::error_code ec;
+    extension_registry registry;
+    registry.function("f", []() { return 1; });
+    connection closed;
+    registry.install(closed, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+
+    // SQLite limits function names to 255 bytes
+    registry.function(std::string(256, 'g'), []() { return 0; });
+    registry.install(conn_, ec);
+    EXPECT_EQ(ec, sqlite3_errc::inappropriate_use);
+    EXPECT_THROW(registry.install(conn_), std::system_error);
+}
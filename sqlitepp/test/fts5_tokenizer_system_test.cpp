@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/fts5_tokenizer.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+// Splits on a separator given as its argument, and emits each token a
+// second time, upper-cased, as a synonym.
+class split_tokenizer
+{
+public:
+    explicit split_tokenizer(const std::vector<std::string_view>& args)
+    {
+        if (args.size() != 1 || args[0].size() != 1) {
+            throw std::invalid_argument("split takes one separator");
+        }
+        separator_ = args[0][0];
+    }
+
+    void tokenize(std::string_view text, token_emitter& emit)
+    {
+        std::size_t start = 0;
+        while (start <= text.size()) {
+            auto end = std::min(text.find(separator_, start), text.size());
+            if (end > start) {
+                std::string token{text.substr(start, end - start)};
+                if (!emit(token, start, end)) {
+                    return;
+                }
+                if ((emit.reason() & FTS5_TOKENIZE_DOCUMENT) != 0) {
+                    for (auto& c : token) {
+                        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                    }
+                    emit(token, start, end, FTS5_TOKEN_COLOCATED);
+                }
+            }
+            start = end + 1;
+        }
+    }
+
+private:
+    char separator_{' '};
+};
+
+class failing_tokenizer
+{
+public:
+    void tokenize(std::string_view, token_emitter&)
+    {
+        throw std::runtime_error("no tokens today");
+    }
+};
+
+} // namespace
+
+class Fts5TokenizerSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        std::error_code ec;
+        if (get_fts5_api(conn_, ec) == nullptr) {
+            GTEST_SKIP() << "SQLite without FTS5";
+        }
+        register_tokenizer<word_tokenizer>(conn_, "word");
+    }
+
+    // The terms of the instance table of an fts5vocab table over the
+    // table named, in document order.
+    std::vector<std::string> terms(const std::string& table)
+    {
+        conn_.execute_script("CREATE VIRTUAL TABLE IF NOT EXISTS " + table + "_vocab USING fts5vocab(" + table + ", 'instance')");
+        std::vector<std::string> result;
+        statement stmt{conn_, "SELECT term FROM " + table + "_vocab ORDER BY doc, col, offset"};
+        while (stmt.step()) {
+            result.emplace_back(stmt.column_text(0));
+        }
+        return result;
+    }
+
+    void index(const std::string& table, const std::string& tokenize, const std::vector<std::string>& documents)
+    {
+        conn_.execute_script("CREATE VIRTUAL TABLE " + table + " USING fts5(body, tokenize = \"" + tokenize + "\")");
+        statement insert{conn_, "INSERT INTO " + table + "(body) VALUES (?1)"};
+        for (auto& document : documents) {
+            insert.bind(1, document);
+            insert.step();
+            insert.reset();
+        }
+    }
+};
+
+TEST_F(Fts5TokenizerSystemTest, MatchesUnicode61OnAscii)
+{
+    try {
+        std::vector<std::string> documents{
+            "The Quick brown fox, jumped over the LAZY dog!",
+            "snake_case and kebab-case; CamelCase42 x86_64 -- 3.14159 (e.g. v2.0)",
+            std::string(200, 'a') + " " + std::string(100, 'Z'),
+            "",
+            "   leading and trailing separators...   ",
+            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~ end",
+        };
+        // every length around the 16 and 64 byte boundaries of the classification
+        for (int length = 1; length < 140; length += 7) {
+            std::string document;
+            for (int i = 0; i < length; ++i) {
+                document += i % 5 == 4 ? ' ' : static_cast<char>('A' + i % 26);
+            }
+            documents.push_back(document);
+        }
+        index("reference", "unicode61", documents);
+        index("fast", "word", documents);
+        EXPECT_EQ(terms("fast"), terms("reference"));
+
+        statement stmt{conn_, "SELECT rowid FROM fast WHERE fast MATCH 'camelcase42 AND kebab'"};
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_int64(0), 2);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(Fts5TokenizerSystemTest, MatchesUnicode61OnUnicode)
+{
+    try {
+        std::vector<std::string> documents{
+            "Ünïcode ÉCOLE Straße — Привет, ΚΌΣΜΕ! naïve…café",
+            "mixed:Übergröße€price 東京タワー",
+            "ǅemal Ærø Łódź ĳssel Ωmega Ǆ ﬁne",
+            "ԱՐԱՐԱՏ ႠႡ Ⓐbc ＡＢＣ",
+        };
+        index("reference", "unicode61", documents);
+        index("fast", "word", documents);
+        EXPECT_EQ(terms("fast"), terms("reference"));
+
+        // diacritics are removed, and offsets are those of the original text
+        statement stmt{conn_, "SELECT highlight(fast, 0, '[', ']') FROM fast WHERE fast MATCH 'ecole AND naive'"};
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_text(0), "Ünïcode [ÉCOLE] Straße — Привет, ΚΌΣΜΕ! [naïve]…café");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(Fts5TokenizerSystemTest, KeepsDiacriticsWhenAsked)
+{
+    try {
+        index("docs", "word remove_diacritics 0", {"Ünïcode ÉCOLE plain"});
+        EXPECT_EQ(terms("docs"), (std::vector<std::string>{"ünïcode", "école", "plain"}));
+
+        // options that would change ASCII tokens are refused
+        std::error_code ec;
+        statement create{conn_, "CREATE VIRTUAL TABLE bad USING fts5(body, tokenize = \"word tokenchars '_'\")"};
+        create.step(ec);
+        EXPECT_TRUE(ec);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(Fts5TokenizerSystemTest, RegistersTokenizersWithArguments)
+{
+    try {
+        register_tokenizer<split_tokenizer>(conn_, "split");
+        index("tags", "split ','", {"red,green,blue", "green,,yellow"});
+
+        statement stmt{conn_, "SELECT rowid FROM tags WHERE tags MATCH ?1 ORDER BY rowid"};
+        stmt.bind(1, "green");
+        std::vector<std::int64_t> rows;
+        while (stmt.step()) {
+            rows.push_back(stmt.column_int64(0));
+        }
+        EXPECT_EQ(rows, (std::vector<std::int64_t>{1, 2}));
+
+        // the upper-case synonyms were indexed with the documents
+        stmt.reset();
+        stmt.bind(1, "YELLOW");
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_int64(0), 2);
+
+        std::error_code ec;
+        statement create{conn_, "CREATE VIRTUAL TABLE bad USING fts5(body, tokenize = 'split')"};
+        create.step(ec);
+        EXPECT_TRUE(ec);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(Fts5TokenizerSystemTest, Errors)
+{
+    register_tokenizer<failing_tokenizer>(conn_, "failing");
+    conn_.execute_script("CREATE VIRTUAL TABLE docs USING fts5(body, tokenize = 'failing')");
+    std::error_code ec;
+    statement insert{conn_, "INSERT INTO docs VALUES ('text')"};
+    insert.step(ec);
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+
+    // a tokenizer without a constructor for arguments takes none
+    statement create{conn_, "CREATE VIRTUAL TABLE words USING fts5(body, tokenize = 'failing extra')"};
+    create.step(ec);
+    EXPECT_TRUE(ec);
+
+    connection closed;
+    EXPECT_EQ(get_fts5_api(closed, ec), nullptr);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    register_tokenizer<word_tokenizer>(closed, "word", ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+}
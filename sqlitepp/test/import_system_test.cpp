@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/import.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace sqlitepp;
+
+class ImportSystemTest : public ::testing::Test
+{
+protected:
+    std::string filename_;
+
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        filename_ = temp_path("import.txt");
+    }
+
+    void TearDown() override
+    {
+        std::remove(filename_.c_str());
+    }
+
+    void write(const std::string& text)
+    {
+        std::ofstream out{filename_, std::ios::binary};
+        out << text;
+    }
+
+    std::string text(const char* sql)
+    {
+        statement stmt{conn_, sql};
+        stmt.step();
+        return std::string{stmt.column_text(0)};
+    }
+
+    std::int64_t count(const char* table)
+    {
+        statement stmt{conn_, std::string{"SELECT count(*) FROM "} + table};
+        stmt.step();
+        return stmt.column_int64(0);
+    }
+};
+
+TEST_F(ImportSystemTest, CsvWithHeaderCreatesTable)
+{
+    write("id,name,note\r\n"
+          "1,alice,plain\r\n"
+          "2,\"bob, jr\",\"says \"\"hi\"\"\"\r\n"
+          "\r\n"
+          "3,carol,\"two\nlines\"\n"
+          "4,dave,");
+
+    try {
+        EXPECT_EQ(import_csv(conn_, filename_, "people"), 4u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+
+    EXPECT_EQ(count("people"), 4);
+    EXPECT_EQ(text("SELECT name FROM people WHERE id = '2'"), "bob, jr");
+    EXPECT_EQ(text("SELECT note FROM people WHERE id = '2'"), "says \"hi\"");
+    EXPECT_EQ(text("SELECT note FROM people WHERE id = '3'"), "two\nlines");
+    EXPECT_EQ(text("SELECT note FROM people WHERE id = '4'"), "");
+    EXPECT_EQ(text("SELECT note FROM people WHERE id = '1'"), "plain");
+}
+
+TEST_F(ImportSystemTest, CsvWithoutHeaderIntoExistingTable)
+{
+    ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE t(a INTEGER, b TEXT)", nullptr, nullptr, nullptr), SQLITE_OK);
+    std::string csv;
+    for (int i = 0; i < 1000; ++i) {
+        csv += std::to_string(i) + ";value \"" + std::to_string(i) + "\"\n";
+    }
+    write(csv);
+
+    import_options options;
+    options.header = false;
+    options.delimiter = ';';
+    options.batch_rows = 7;
+    options.batches = 2;
+    options.transaction_rows = 100;
+    EXPECT_EQ(import_csv(conn_, filename_, "t", options), 1000u);
+
+    EXPECT_EQ(count("t"), 1000);
+    EXPECT_EQ(text("SELECT sum(a) FROM t"), "499500");
+    EXPECT_EQ(text("SELECT b FROM t WHERE a = 999"), "value \"999\"");
+}
+
+TEST_F(ImportSystemTest, ErrorOnFieldCount)
+{
+    write("a,b\n1,2\n3\n");
+
+    std::error_code ec;
+    import_csv(conn_, filename_, "t", ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_EQ(count("t"), 0);
+}
+
+TEST_F(ImportSystemTest, ErrorOnUnterminatedQuote)
+{
+    write("a,b\n1,\"open\n");
+
+    std::error_code ec;
+    import_csv(conn_, filename_, "t", ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+}
+
+TEST_F(ImportSystemTest, ErrorOnMissingFile)
+{
+    std::error_code ec;
+    auto rows = import_csv(conn_, "does_not_exist.csv", "t", ec);
+
+    EXPECT_EQ(ec, std::errc::no_such_file_or_directory);
+    EXPECT_EQ(rows, 0u);
+}
+
+TEST_F(ImportSystemTest, NdjsonExtractsColumns)
+{
+    write("{\"id\": 1, \"name\": \"alice\", \"tags\": [\"x\"]}\n"
+          "\n"
+          "{\"name\": \"bob\", \"id\": 2}\r\n"
+          "{\"id\": 3}");
+
+    try {
+        EXPECT_EQ(import_ndjson(conn_, filename_, "people", {"id", "name"}), 3u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+
+    EXPECT_EQ(count("people"), 3);
+    EXPECT_EQ(text("SELECT name FROM people WHERE id = 2"), "bob");
+    EXPECT_EQ(text("SELECT count(*) FROM people WHERE name IS NULL"), "1");
+}
+
+TEST_F(ImportSystemTest, NdjsonQuotesColumnNames)
+{
+    write("{\"c.d\": 2, \"e\\\\f\": 3, \"c\": 4}\n");
+
+    try {
+        EXPECT_EQ(import_ndjson(conn_, filename_, "t", {"c.d", "e\\f"}), 1u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+
+    EXPECT_EQ(text("SELECT \"c.d\" || ',' || \"e\\f\" FROM t"), "2,3");
+}
+
+TEST_F(ImportSystemTest, ErrorOnQuoteInNdjsonColumn)
+{
+    write("{\"a\\\"b\": 1}\n");
+
+    std::error_code ec;
+    EXPECT_EQ(import_ndjson(conn_, filename_, "t", {"a\"b"}, ec), 0u);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+}
+
+TEST_F(ImportSystemTest, ErrorOnMalformedJson)
+{
+    write("{\"id\": 1}\n{\"id\": \n");
+
+    std::error_code ec;
+    import_ndjson(conn_, filename_, "t", {"id"}, ec);
+
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_EQ(count("t"), 0);
+}
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/memory_governor.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace sqlitepp;
+
+class MemoryGovernorSystemTest : public ::testing::Test
+{
+protected:
+    std::string filename_;
+    std::string cgroup_;
+
+    connection conn_;
+
+    void SetUp() override
+    {
+        filename_ = temp_path("memory_governor.db");
+        cgroup_ = temp_path("cgroup");
+        std::remove(filename_.c_str());
+        conn_ = connect(filename_);
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(),
+                               "CREATE TABLE t(x);"
+                               "WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM c LIMIT 5000) INSERT INTO t SELECT zeroblob(200) FROM c",
+                               nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+        mkdir(cgroup_.c_str(), 0755);
+    }
+
+    void TearDown() override
+    {
+        conn_.close();
+        std::remove(filename_.c_str());
+        for (auto file : {"memory.pressure", "memory.current", "memory.max"}) {
+            std::remove((cgroup_ + "/" + file).c_str());
+        }
+        rmdir(cgroup_.c_str());
+    }
+
+    void write_cgroup_file(const char* file, const char* content)
+    {
+        std::ofstream{cgroup_ + "/" + file} << content;
+    }
+
+    memory_governor_options cgroup_options()
+    {
+        memory_governor_options options;
+        options.cgroup_path = cgroup_;
+        options.poll_interval = std::chrono::milliseconds{5};
+        return options;
+    }
+
+    int cache_used()
+    {
+        int current = 0;
+        int highwater = 0;
+        sqlite3_db_status(conn_.conn_handle(), SQLITE_DBSTATUS_CACHE_USED, &current, &highwater, 0);
+        return current;
+    }
+
+    void scan()
+    {
+        statement select{conn_, "SELECT count(x) FROM t"};
+        select.step();
+    }
+};
+
+TEST_F(MemoryGovernorSystemTest, SetsHeapLimits)
+{
+    memory_governor governor;
+    auto soft = governor.soft_heap_limit();
+    auto hard = governor.hard_heap_limit();
+
+    governor.set_heap_limits(64 << 20, 256 << 20);
+    EXPECT_EQ(governor.soft_heap_limit(), 64 << 20);
+    EXPECT_EQ(governor.hard_heap_limit(), 256 << 20);
+
+    governor.set_heap_limits(-1, -1);
+    EXPECT_EQ(governor.soft_heap_limit(), 64 << 20);
+
+    governor.set_heap_limits(soft, hard);
+}
+
+TEST_F(MemoryGovernorSystemTest, ShrinksIdleConnection)
+{
+    if (sqlite3_threadsafe() != 1) {
+        GTEST_SKIP() << "tracking connections needs serialized SQLite";
+    }
+    try {
+        memory_governor governor;
+        auto registration = governor.track(conn_);
+        EXPECT_TRUE(registration.is_registered());
+
+        scan();
+        auto before = cache_used();
+        EXPECT_EQ(governor.shrink(), 1u);
+        EXPECT_LT(cache_used(), before);
+        EXPECT_EQ(governor.stats().released, 1u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(MemoryGovernorSystemTest, RefusesConnectionWithoutMutex)
+{
+    auto unserialized = connect(filename_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX);
+    memory_governor governor;
+    std::error_code ec;
+    auto registration = governor.track(unserialized, ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_FALSE(registration.is_registered());
+    if (sqlite3_threadsafe() != 1) {
+        registration = governor.track(conn_, ec);
+        EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    }
+}
+
+TEST_F(MemoryGovernorSystemTest, SkipsConnectionInTransaction)
+{
+    if (sqlite3_threadsafe() != 1) {
+        GTEST_SKIP() << "tracking connections needs serialized SQLite";
+    }
+    memory_governor governor;
+    auto registration = governor.track(conn_);
+    transaction tx{conn_, transaction::mode::deferred};
+    scan();
+
+    auto before = cache_used();
+    EXPECT_EQ(governor.shrink(), 0u);
+    EXPECT_EQ(cache_used(), before);
+}
+
+TEST_F(MemoryGovernorSystemTest, StopsAfterUnregister)
+{
+    if (sqlite3_threadsafe() != 1) {
+        GTEST_SKIP() << "tracking connections needs serialized SQLite";
+    }
+    memory_governor governor;
+    {
+        auto registration = governor.track(conn_);
+        auto moved = std::move(registration);
+        EXPECT_FALSE(registration.is_registered());
+        EXPECT_TRUE(moved.is_registered());
+    }
+    EXPECT_EQ(governor.shrink(), 0u);
+}
+
+TEST_F(MemoryGovernorSystemTest, ShrinksUnleasedPoolConnections)
+{
+    connection_pool pool{3, filename_};
+    memory_governor governor;
+    auto registration = governor.track(pool);
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(governor.shrink(), 2u);
+}
+
+TEST_F(MemoryGovernorSystemTest, ReadsPressureFromCgroup)
+{
+    auto options = cgroup_options();
+    write_cgroup_file("memory.pressure", "some avg10=0.50 avg60=0.10 avg300=0.00 total=100\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    write_cgroup_file("memory.current", "500\n");
+    write_cgroup_file("memory.max", "1000\n");
+    EXPECT_FALSE(memory_governor::under_pressure(options));
+
+    write_cgroup_file("memory.current", "950\n");
+    EXPECT_TRUE(memory_governor::under_pressure(options));
+
+    write_cgroup_file("memory.max", "max\n");
+    EXPECT_FALSE(memory_governor::under_pressure(options));
+    options.memory_limit = 900;
+    EXPECT_TRUE(memory_governor::under_pressure(options));
+
+    options.memory_limit = 0;
+    write_cgroup_file("memory.pressure", "some avg10=25.00 avg60=5.00 avg300=1.00 total=100\n");
+    EXPECT_TRUE(memory_governor::under_pressure(options));
+}
+
+TEST_F(MemoryGovernorSystemTest, PollsForPressure)
+{
+    write_cgroup_file("memory.pressure", "some avg10=80.00 avg60=20.00 avg300=5.00 total=100\n");
+    connection_pool pool{1, filename_};
+    memory_governor governor;
+    auto registration = governor.track(pool);
+
+    governor.start(cgroup_options());
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (governor.stats().released == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    governor.stop();
+
+    auto stats = governor.stats();
+    EXPECT_GT(stats.polls, 0u);
+    EXPECT_GT(stats.pressured, 0u);
+    EXPECT_GT(stats.released, 0u);
+}
+
+TEST_F(MemoryGovernorSystemTest, ErrorOnClosedConnection)
+{
+    memory_governor governor;
+    connection closed;
+    std::error_code ec;
+    auto registration = governor.track(closed, ec);
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_FALSE(registration.is_registered());
+}
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/optimize_scheduler.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace sqlitepp;
+
+class OptimizeSchedulerSystemTest : public ::testing::Test
+{
+protected:
+    std::string filename_;
+    connection conn_;
+
+    void SetUp() override
+    {
+        filename_ = temp_path("optimize_scheduler.db");
+        std::remove(filename_.c_str());
+        conn_ = connect(filename_);
+        exec(conn_, "CREATE TABLE t(x, y); CREATE INDEX t_x ON t(x); CREATE TABLE u(x)");
+    }
+
+    void TearDown() override
+    {
+        conn_.close();
+        std::remove(filename_.c_str());
+    }
+
+    static void exec(connection& conn, const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+
+    static void insert(connection& conn, const char* table, int rows)
+    {
+        auto sql = std::string{"WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM c LIMIT "} + std::to_string(rows) + ") INSERT INTO " + table +
+                   " SELECT i % 100" + (std::string{table} == "t" ? ", i" : "") + " FROM c";
+        exec(conn, sql.c_str());
+    }
+
+    static std::int64_t analyzed_rows(connection& conn, const char* table)
+    {
+        std::error_code ec;
+        statement stmt{conn, "SELECT max(CAST(stat AS INTEGER)) FROM sqlite_stat1 WHERE tbl = ?1", ec};
+        if (ec) {
+            return -1;
+        }
+        stmt.bind(1, std::string{table});
+        return stmt.step() && stmt.column_type(0) != datatype::null ? stmt.column_int64(0) : -1;
+    }
+};
+
+TEST_F(OptimizeSchedulerSystemTest, CountsChangesPerTable)
+{
+    try {
+        optimize_scheduler scheduler{conn_};
+        insert(conn_, "t", 300);
+        insert(conn_, "u", 20);
+        exec(conn_, "UPDATE t SET y = 0 WHERE x = 1");
+        exec(conn_, "DELETE FROM u WHERE x < 5");
+        EXPECT_EQ(scheduler.pending_changes("t"), 303u);
+        EXPECT_EQ(scheduler.pending_changes("u"), 24u);
+        EXPECT_EQ(scheduler.pending_changes("v"), 0u);
+
+        // changes to other schemas are not counted
+        exec(conn_, "CREATE TEMP TABLE t(x); INSERT INTO temp.t VALUES (1)");
+        EXPECT_EQ(scheduler.pending_changes("t"), 303u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, CountsTablesCreatedAfterDrops)
+{
+    try {
+        optimize_scheduler scheduler{conn_};
+        for (int i = 0; i < 20; ++i) {
+            auto name = "v" + std::to_string(i);
+            exec(conn_, ("CREATE TABLE " + name + "(x)").c_str());
+            insert(conn_, name.c_str(), 10);
+            exec(conn_, ("DROP TABLE " + name).c_str());
+            EXPECT_EQ(scheduler.pending_changes(name), 10u);
+        }
+        EXPECT_EQ(scheduler.pending_changes("t"), 0u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, AnalyzesStaleTables)
+{
+    try {
+        optimize_options options;
+        options.min_changes = 100;
+        // exact row counts in sqlite_stat1
+        options.analysis_limit = 0;
+        optimize_scheduler scheduler{conn_, options};
+        insert(conn_, "t", 1000);
+        insert(conn_, "u", 50);
+
+        EXPECT_EQ(scheduler.run_now(), 1u);
+        EXPECT_EQ(analyzed_rows(conn_, "t"), 1000);
+        EXPECT_EQ(analyzed_rows(conn_, "u"), -1);
+        EXPECT_EQ(scheduler.pending_changes("t"), 0u);
+        EXPECT_EQ(scheduler.pending_changes("u"), 50u);
+
+        // 200 changes against 1000 analyzed rows is under the stale ratio
+        insert(conn_, "t", 200);
+        EXPECT_EQ(scheduler.run_now(), 0u);
+        EXPECT_EQ(scheduler.pending_changes("t"), 200u);
+        insert(conn_, "t", 400);
+        EXPECT_EQ(scheduler.run_now(), 1u);
+        EXPECT_EQ(analyzed_rows(conn_, "t"), 1600);
+
+        auto stats = scheduler.stats();
+        EXPECT_EQ(stats.runs, 3u);
+        EXPECT_EQ(stats.analyzed, 2u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, ForgetsDroppedTables)
+{
+    try {
+        optimize_options options;
+        options.min_changes = 10;
+        optimize_scheduler scheduler{conn_, options};
+        insert(conn_, "u", 50);
+        exec(conn_, "DROP TABLE u");
+        EXPECT_EQ(scheduler.run_now(), 0u);
+        EXPECT_EQ(scheduler.pending_changes("u"), 0u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, PollsInTheBackground)
+{
+    try {
+        optimize_options options;
+        options.min_changes = 100;
+        options.analysis_limit = 0;
+        options.poll_interval = std::chrono::milliseconds{5};
+        optimize_scheduler scheduler{conn_, options};
+        scheduler.start();
+        insert(conn_, "t", 500);
+        for (int i = 0; i < 400 && scheduler.stats().analyzed == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        }
+        scheduler.stop();
+        EXPECT_EQ(scheduler.stats().analyzed, 1u);
+        EXPECT_EQ(analyzed_rows(conn_, "t"), 500);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, OptimizesOnClose)
+{
+    try {
+        optimize_scheduler scheduler{conn_};
+        insert(conn_, "t", 1000);
+        {
+            // the planner looks at the index, which makes the table a candidate of PRAGMA optimize
+            statement stmt{conn_, "SELECT y FROM t WHERE x = 5"};
+            while (stmt.step()) {
+            }
+        }
+        conn_.close();
+
+        conn_ = connect(filename_);
+        // estimated from the rows analysis_limit let ANALYZE look at
+        EXPECT_GT(analyzed_rows(conn_, "t"), 0);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, DoesNotOptimizeOnCloseByDefault)
+{
+    try {
+        insert(conn_, "t", 1000);
+        {
+            statement stmt{conn_, "SELECT y FROM t WHERE x = 5"};
+            while (stmt.step()) {
+            }
+        }
+        conn_.close();
+
+        conn_ = connect(filename_);
+        EXPECT_EQ(analyzed_rows(conn_, "t"), -1);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, RestoresOptimizeOnCloseWhenDestroyed)
+{
+    try {
+        {
+            optimize_scheduler scheduler{conn_};
+            insert(conn_, "t", 1000);
+            statement stmt{conn_, "SELECT y FROM t WHERE x = 5"};
+            while (stmt.step()) {
+            }
+        }
+        conn_.close();
+
+        conn_ = connect(filename_);
+        EXPECT_EQ(analyzed_rows(conn_, "t"), -1);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(OptimizeSchedulerSystemTest, Errors)
+{
+    std::error_code ec;
+    connection closed;
+    optimize_scheduler detached{closed, {}, ec};
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_FALSE(detached.is_attached());
+    detached.run_now(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+
+    auto memory = connect(":memory:");
+    EXPECT_THROW(optimize_scheduler{memory}, std::system_error);
+}
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/parallel_query.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sqlitepp;
+
+class ParallelQuerySystemTest : public ::testing::Test
+{
+protected:
+    static constexpr std::int64_t rows = 10000;
+
+    std::string filename;
+    connection writer_;
+
+    void SetUp() override
+    {
+        filename = temp_path("parallel_query.db");
+        remove_database();
+        writer_ = connect(filename);
+        exec("PRAGMA journal_mode=WAL");
+        exec("CREATE TABLE t(x INTEGER)");
+        exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 10000) INSERT INTO t SELECT i FROM n");
+    }
+
+    void TearDown() override
+    {
+        writer_.close();
+        remove_database();
+    }
+
+    void exec(const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(writer_.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+
+    void remove_database()
+    {
+        for (auto suffix : {"", "-wal", "-shm"}) {
+            std::remove((filename + suffix).c_str());
+        }
+    }
+
+    static std::int64_t sum(statement& stmt)
+    {
+        stmt.step();
+        return stmt.column_int64(0);
+    }
+};
+
+TEST_F(ParallelQuerySystemTest, PoolHandsOutEachConnectionOnce)
+{
+    connection_pool pool{2, filename, connection::openmode::ro};
+    ASSERT_EQ(pool.size(), 2u);
+
+    auto first = pool.acquire();
+    auto second = pool.try_acquire();
+    ASSERT_TRUE(second.has_value());
+    EXPECT_NE(first.index(), second->index());
+    EXPECT_FALSE(pool.try_acquire().has_value());
+
+    second->release();
+    EXPECT_TRUE(pool.try_acquire().has_value());
+}
+
+TEST_F(ParallelQuerySystemTest, PoolHandsOutSeveralConnectionsTogether)
+{
+    connection_pool pool{2, filename, connection::openmode::ro};
+    EXPECT_THROW(pool.acquire(3), std::system_error);
+    std::error_code ec;
+    EXPECT_TRUE(pool.acquire(3, ec).empty());
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+
+    auto first = pool.acquire();
+    std::vector<connection_pool::lease> both;
+    std::thread waiter{[&]() { both = pool.acquire(2); }};
+    // the waiter takes neither connection until both are free
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(pool.try_acquire().has_value());
+    first.release();
+    waiter.join();
+    ASSERT_EQ(both.size(), 2u);
+    EXPECT_NE(both[0].index(), both[1].index());
+    EXPECT_FALSE(pool.try_acquire().has_value());
+}
+
+TEST_F(ParallelQuerySystemTest, PoolWakesWaitersForOneAndForSeveral)
+{
+    connection_pool pool{2, filename, connection::openmode::ro};
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+
+    std::vector<connection_pool::lease> both;
+    std::thread several{[&]() { both = pool.acquire(2); }};
+    std::atomic<bool> got_one{false};
+    std::thread one{[&]() {
+        auto lease = pool.acquire();
+        got_one = true;
+    }};
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // only the waiter for one connection can proceed on the first release
+    first.release();
+    for (int i = 0; i < 500 && !got_one; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_TRUE(got_one);
+    one.join();
+    second.release();
+    several.join();
+    EXPECT_EQ(both.size(), 2u);
+}
+
+TEST_F(ParallelQuerySystemTest, ErrorOnPoolOpen)
+{
+    std::error_code ec;
+    connection_pool pool{2, temp_path("does_not_exist.db"), connection::openmode::ro, ec};
+
+    EXPECT_EQ(ec, sqlite3_errc::database_open_failed);
+    EXPECT_EQ(pool.size(), 0u);
+}
+
+TEST_F(ParallelQuerySystemTest, SplitRowidRange)
+{
+    auto ranges = split_rowid_range(writer_, "t", 3);
+
+    ASSERT_EQ(ranges.size(), 3u);
+    EXPECT_EQ(ranges.front().lo, 1);
+    EXPECT_EQ(ranges.back().hi, rows + 1);
+    for (std::size_t i = 1; i < ranges.size(); ++i) {
+        EXPECT_EQ(ranges[i - 1].hi, ranges[i].lo);
+    }
+
+    exec("DELETE FROM t");
+    EXPECT_TRUE(split_rowid_range(writer_, "t", 3).empty());
+}
+
+TEST_F(ParallelQuerySystemTest, SumMatchesSerialQuery)
+{
+    try {
+        connection_pool pool{4, filename, connection::openmode::ro};
+        thread_pool threads{4};
+        parallel_query query{pool, threads};
+
+        auto total = query.run(
+            "SELECT sum(x) FROM t WHERE rowid >= ?1 AND rowid < ?2", split_rowid_range(writer_, "t", 16), std::int64_t{0}, sum,
+            [](std::int64_t a, std::int64_t b) { return a + b; });
+
+        EXPECT_EQ(total, rows * (rows + 1) / 2);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ParallelQuerySystemTest, PartitionsReadOneSnapshot)
+{
+    try {
+        connection_pool pool{4, filename, connection::openmode::ro};
+        thread_pool threads{4};
+        parallel_query query{pool, threads};
+        std::atomic<bool> written{false};
+
+        auto total = query.run(
+            "SELECT sum(x) FROM t WHERE rowid >= ?1 AND rowid < ?2", split_rowid_range(writer_, "t", 8), std::int64_t{0},
+            [&](statement& stmt) {
+                if (!written.exchange(true)) {
+                    // commits while the partitions are running
+                    auto other = connect(filename);
+                    EXPECT_EQ(sqlite3_exec(other.conn_handle(), "UPDATE t SET x = x + 1", nullptr, nullptr, nullptr), SQLITE_OK);
+                }
+                return sum(stmt);
+            },
+            [](std::int64_t a, std::int64_t b) { return a + b; });
+
+        EXPECT_TRUE(written);
+        EXPECT_EQ(total, rows * (rows + 1) / 2);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ParallelQuerySystemTest, GateOpensLikeThePool)
+{
+    // a pass-through VFS that goes away after the pool is open
+    static sqlite3_vfs vfs = *sqlite3_vfs_find(nullptr);
+    vfs.zName = "parallel_query_test";
+    ASSERT_EQ(sqlite3_vfs_register(&vfs, 0), SQLITE_OK);
+    connection_pool pool{2, filename, connection::openmode::ro, "parallel_query_test"};
+    EXPECT_EQ(pool.filename(), filename);
+    EXPECT_EQ(pool.flags(), SQLITE_OPEN_READONLY);
+    EXPECT_STREQ(pool.vfsname(), "parallel_query_test");
+    thread_pool threads{2};
+    parallel_query query{pool, threads};
+    auto partitions = split_rowid_range(writer_, "t", 4);
+    auto add = [](std::int64_t a, std::int64_t b) { return a + b; };
+    std::error_code ec;
+
+    EXPECT_EQ(query.run("SELECT sum(x) FROM t WHERE rowid >= ?1 AND rowid < ?2", partitions, std::int64_t{0}, sum, add, ec), rows * (rows + 1) / 2);
+    EXPECT_FALSE(ec);
+
+    sqlite3_vfs_unregister(&vfs);
+    query.run("SELECT sum(x) FROM t WHERE rowid >= ?1 AND rowid < ?2", partitions, std::int64_t{0}, sum, add, ec);
+    EXPECT_TRUE(ec);
+}
+
+TEST_F(ParallelQuerySystemTest, ErrorOnInvalidQuery)
+{
+    connection_pool pool{2, filename, connection::openmode::ro};
+    thread_pool threads{2};
+    parallel_query query{pool, threads};
+    std::error_code ec;
+
+    query.run("SELECT sum(x) FROM missing WHERE rowid >= ?1 AND rowid < ?2", split_rowid_range(writer_, "t", 4), std::int64_t{0}, sum,
+              [](std::int64_t a, std::int64_t b) { return a + b; }, ec);
+
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    // every lease went back to the pool
+    EXPECT_TRUE(pool.try_acquire().has_value());
+    EXPECT_TRUE(pool.try_acquire().has_value());
+}
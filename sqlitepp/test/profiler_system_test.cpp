@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/profiler.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace sqlitepp;
+
+class ProfilerSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        exec("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT)");
+        exec("INSERT INTO t(v) VALUES ('a'), ('b'), ('c')");
+    }
+
+    void exec(const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+
+    void run(sqlite3_stmt* stmt, int id)
+    {
+        sqlite3_bind_int(stmt, 1, id);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+        }
+        sqlite3_reset(stmt);
+    }
+
+    static const statement_profile* find(const profile_snapshot& snapshot, const std::string& sql)
+    {
+        auto it = std::find_if(snapshot.begin(), snapshot.end(), [&sql](const statement_profile& p) { return p.sql == sql; });
+        return it != snapshot.end() ? &*it : nullptr;
+    }
+};
+
+TEST_F(ProfilerSystemTest, AggregatesCallsAndRows)
+{
+    profiler prof{conn_};
+
+    const char* sql = "SELECT v FROM t WHERE id >= ?1";
+    sqlite3_stmt* stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(conn_.conn_handle(), sql, -1, &stmt, nullptr), SQLITE_OK);
+    run(stmt, 1);
+    run(stmt, 2);
+    run(stmt, 4);
+    sqlite3_finalize(stmt);
+
+    auto snapshot = prof.snapshot();
+    auto profile = find(snapshot, "SELECT v FROM t WHERE id >= ?");
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 3u);
+    EXPECT_EQ(profile->rows, 5u);
+    EXPECT_EQ(profile->latency.count(), 3u);
+    EXPECT_LE(profile->min_time, profile->max_time);
+    EXPECT_LE(profile->max_time, profile->total_time);
+    EXPECT_GE(profile->latency.percentile(1.0), profile->max_time);
+}
+
+TEST_F(ProfilerSystemTest, MergesThreads)
+{
+    profiler prof{conn_};
+
+    const char* sql = "SELECT count(*) FROM t";
+    auto worker = [this, sql]() {
+        sqlite3_stmt* stmt = nullptr;
+        ASSERT_EQ(sqlite3_prepare_v2(conn_.conn_handle(), sql, -1, &stmt, nullptr), SQLITE_OK);
+        for (int i = 0; i < 10; ++i) {
+            run(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    };
+    std::thread first{worker};
+    first.join();
+    std::thread second{worker};
+    second.join();
+
+    auto snapshot = prof.snapshot();
+    auto profile = find(snapshot, sql);
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 20u);
+    EXPECT_EQ(profile->rows, 20u);
+}
+
+TEST_F(ProfilerSystemTest, GroupsByNormalizedText)
+{
+    profiler prof{conn_};
+
+    exec("SELECT v FROM t WHERE id = 1");
+    exec("SELECT v FROM t WHERE id = 2 /* two */");
+    exec("SELECT  v FROM t\n  WHERE id = 'x'");
+    exec("SELECT v FROM t WHERE id = x'01' -- blob");
+    exec("SELECT \"v\" FROM t WHERE id = 1.5e+3");
+
+    auto snapshot = prof.snapshot();
+    auto profile = find(snapshot, "SELECT v FROM t WHERE id = ?");
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 4u);
+    profile = find(snapshot, "SELECT \"v\" FROM t WHERE id = ?");
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 1u);
+}
+
+TEST_F(ProfilerSystemTest, SeparatesStatementsAtReusedAddresses)
+{
+    profiler prof{conn_};
+
+    // a finalized statement's memory is typically handed to the next one prepared
+    for (const char* sql : {"SELECT v FROM t WHERE id = ?1", "SELECT id FROM t WHERE id = ?1", "SELECT v FROM t WHERE id = ?1"}) {
+        sqlite3_stmt* stmt = nullptr;
+        ASSERT_EQ(sqlite3_prepare_v2(conn_.conn_handle(), sql, -1, &stmt, nullptr), SQLITE_OK);
+        run(stmt, 1);
+        sqlite3_finalize(stmt);
+    }
+
+    auto snapshot = prof.snapshot();
+    auto profile = find(snapshot, "SELECT v FROM t WHERE id = ?");
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 2u);
+    profile = find(snapshot, "SELECT id FROM t WHERE id = ?");
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 1u);
+}
+
+TEST_F(ProfilerSystemTest, DetachOnDestruction)
+{
+    {
+        profiler prof{conn_};
+        EXPECT_TRUE(prof.is_attached());
+    }
+    exec("SELECT 1");
+}
+
+TEST_F(ProfilerSystemTest, DetachedWhenConnectionCloses)
+{
+    profiler prof{conn_};
+    exec("SELECT v FROM t");
+    conn_.close();
+
+    // the profiler outlives the hooks of the closed connection, and keeps its statistics
+    EXPECT_FALSE(prof.is_attached());
+    auto snapshot = prof.snapshot();
+    auto profile = find(snapshot, "SELECT v FROM t");
+    ASSERT_NE(profile, nullptr);
+    EXPECT_EQ(profile->calls, 1u);
+}
+
+TEST_F(ProfilerSystemTest, ErrorOnClosedConnection)
+{
+    connection closed;
+    std::error_code ec;
+    profiler prof{closed, ec};
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_FALSE(prof.is_attached());
+}
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/query_cache.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace sqlitepp;
+
+class QueryCacheSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        exec(conn_,
+             "CREATE TABLE kv(id INTEGER PRIMARY KEY, v TEXT);"
+             "CREATE TABLE other(x);"
+             "CREATE TABLE pairs(k PRIMARY KEY, v) WITHOUT ROWID;"
+             "CREATE VIEW kv_view AS SELECT v FROM kv;"
+             "INSERT INTO kv VALUES (1, 'one'), (2, 'two');"
+             "INSERT INTO pairs VALUES ('a', 1)");
+    }
+
+    static void exec(connection& conn, const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK) << sqlite3_errmsg(conn.conn_handle());
+    }
+};
+
+TEST_F(QueryCacheSystemTest, HitsRepeatedQuery)
+{
+    try {
+        query_cache cache{conn_};
+        auto first = cache.query("SELECT v FROM kv WHERE id = ?", 2);
+        auto second = cache.query("SELECT v FROM kv WHERE id = ?", 2);
+        auto other = cache.query("SELECT v FROM kv WHERE id = ?", 1);
+
+        ASSERT_EQ(first->row_count(), 1u);
+        EXPECT_EQ(first->column_name(0), "v");
+        EXPECT_EQ(first->column_text(0, 0), "two");
+        EXPECT_EQ(first, second);
+        EXPECT_EQ(other->column_text(0, 0), "one");
+
+        auto stats = cache.stats();
+        EXPECT_EQ(stats.hits, 1u);
+        EXPECT_EQ(stats.misses, 2u);
+        EXPECT_EQ(stats.entries, 2u);
+        EXPECT_GT(stats.memory_used, 0u);
+        EXPECT_DOUBLE_EQ(stats.hit_rate(), 1.0 / 3.0);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(QueryCacheSystemTest, KeysByBoundType)
+{
+    query_cache cache{conn_};
+    auto integer = cache.query("SELECT typeof(?)", 1);
+    auto text = cache.query("SELECT typeof(?)", "1");
+
+    EXPECT_EQ(integer->column_text(0, 0), "integer");
+    EXPECT_EQ(text->column_text(0, 0), "text");
+}
+
+TEST_F(QueryCacheSystemTest, InvalidatedByWriteToReadTable)
+{
+    query_cache cache{conn_};
+    auto sql = "SELECT count(*) FROM kv";
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 2);
+
+    exec(conn_, "INSERT INTO other VALUES (1)");
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 2);
+    EXPECT_EQ(cache.stats().hits, 1u);
+
+    exec(conn_, "INSERT INTO kv VALUES (3, 'three')");
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 3);
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+}
+
+TEST_F(QueryCacheSystemTest, InvalidatedThroughView)
+{
+    query_cache cache{conn_};
+    auto sql = "SELECT group_concat(v, ',') FROM kv_view";
+    EXPECT_EQ(cache.query(sql)->column_text(0, 0), "one,two");
+
+    exec(conn_, "UPDATE kv SET v = 'uno' WHERE id = 1");
+    EXPECT_EQ(cache.query(sql)->column_text(0, 0), "uno,two");
+}
+
+TEST_F(QueryCacheSystemTest, InvalidatedByWriteWithoutRowid)
+{
+    query_cache cache{conn_};
+    auto sql = "SELECT v FROM pairs WHERE k = 'a'";
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 1);
+
+    // the update hook does not report WITHOUT ROWID tables
+    exec(conn_, "UPDATE pairs SET v = 2");
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 2);
+}
+
+TEST_F(QueryCacheSystemTest, InvalidatedBySchemaChange)
+{
+    query_cache cache{conn_};
+    auto sql = "SELECT count(*) FROM kv";
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 2);
+
+    exec(conn_, "DROP TABLE kv; CREATE TABLE kv(id INTEGER PRIMARY KEY, v TEXT)");
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 0);
+}
+
+TEST_F(QueryCacheSystemTest, InvalidatedByOtherConnection)
+{
+    const char* filename = "query_cache_test.db";
+    std::remove(filename);
+    {
+        auto reader = connect(filename);
+        auto writer = connect(filename);
+        exec(writer, "CREATE TABLE t(x); INSERT INTO t VALUES (1)");
+
+        query_cache cache{reader};
+        auto sql = "SELECT sum(x) FROM t";
+        EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 1);
+        EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 1);
+
+        exec(writer, "INSERT INTO t VALUES (2)");
+        EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 3);
+        EXPECT_EQ(cache.stats().hits, 1u);
+    }
+    std::remove(filename);
+}
+
+TEST_F(QueryCacheSystemTest, BypassedInTransaction)
+{
+    query_cache cache{conn_};
+    auto sql = "SELECT count(*) FROM kv";
+
+    exec(conn_, "BEGIN; INSERT INTO kv VALUES (3, 'three')");
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 3);
+    exec(conn_, "ROLLBACK");
+
+    EXPECT_EQ(cache.query(sql)->column_int64(0, 0), 2);
+    EXPECT_EQ(cache.stats().hits, 0u);
+}
+
+TEST_F(QueryCacheSystemTest, EvictsLeastRecentlyUsed)
+{
+    query_cache cache{conn_, query_cache_options{16 * 1024}};
+    for (int i = 0; i < 32; ++i) {
+        cache.query("SELECT ?, zeroblob(1000)", i);
+    }
+
+    auto stats = cache.stats();
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_LE(stats.memory_used, 16u * 1024u);
+    EXPECT_EQ(stats.entries + stats.evictions, 32u);
+
+    // the most recent entry survived
+    cache.query("SELECT ?, zeroblob(1000)", 31);
+    EXPECT_EQ(cache.stats().hits, 1u);
+}
+
+TEST_F(QueryCacheSystemTest, CapsPreparedStatements)
+{
+    try {
+        query_cache_options options;
+        options.max_statements = 2;
+        query_cache cache{conn_, options};
+        cache.query("SELECT v FROM kv WHERE id = ?", 1);
+        cache.query("SELECT v FROM kv WHERE id = ?", 2);
+        cache.query("SELECT x FROM other");
+        // the statement used last is kept
+        cache.query("SELECT v FROM kv WHERE id = ?", 1);
+        cache.query("SELECT count(*) FROM kv");
+
+        auto stats = cache.stats();
+        EXPECT_EQ(stats.statements, 2u);
+        EXPECT_EQ(stats.hits, 1u);
+        // the entry read through the finalized statement went with it
+        EXPECT_EQ(stats.entries, 3u);
+        EXPECT_EQ(stats.evictions, 1u);
+
+        cache.query("SELECT x FROM other");
+        EXPECT_EQ(cache.stats().misses, 5u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(QueryCacheSystemTest, ChargesStatementsToBudget)
+{
+    try {
+        query_cache cache{conn_, query_cache_options{1}};
+        auto first = cache.query("SELECT v FROM kv WHERE id = ?", 1);
+        auto second = cache.query("SELECT v FROM kv WHERE id = ?", 1);
+        cache.query("SELECT x FROM other");
+
+        EXPECT_EQ(first->column_text(0, 0), "one");
+        EXPECT_NE(first, second);
+        auto stats = cache.stats();
+        EXPECT_EQ(stats.entries, 0u);
+        EXPECT_EQ(stats.statements, 1u);
+        EXPECT_GT(stats.memory_used, 0u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(QueryCacheSystemTest, ErrorOnBadQuery)
+{
+    query_cache cache{conn_};
+    std::error_code ec;
+
+    EXPECT_EQ(cache.query("SELECT * FROM missing", ec), nullptr);
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+
+    EXPECT_EQ(cache.query("SELECT ?, ?", 1, ec), nullptr);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+}
+
+TEST_F(QueryCacheSystemTest, ErrorOnClosedConnection)
+{
+    connection closed;
+    std::error_code ec;
+    query_cache cache{closed, {}, ec};
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_FALSE(cache.is_attached());
+}
+
+TEST_F(QueryCacheSystemTest, DetachedWhenConnectionCloses)
+{
+    query_cache cache{conn_};
+    ASSERT_NE(cache.query("SELECT v FROM kv WHERE id = ?1", 1), nullptr);
+    conn_.close();
+
+    // the cache outlives the hooks of the closed connection
+    EXPECT_FALSE(cache.is_attached());
+    std::error_code ec;
+    EXPECT_EQ(cache.query("SELECT v FROM kv WHERE id = ?1", 1, ec), nullptr);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+}
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/query_plan.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <gtest/gtest-spi.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace sqlitepp;
+
+class QueryPlanSystemTest : public ::testing::Test
+{
+protected:
+    static inline std::vector<std::string> reported;
+
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE t(x, y); CREATE INDEX t_x ON t(x); CREATE TABLE u(a)", nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+        reported.clear();
+    }
+
+    void TearDown() override
+    {
+        set_full_scan_handler(nullptr);
+    }
+
+    static void record(std::string_view sql, std::string_view detail)
+    {
+        reported.push_back(std::string{sql} + ": " + std::string{detail});
+    }
+
+    static void expect_unindexed_query_indexed()
+    {
+        auto conn = connect(":memory:");
+        statement{conn, "CREATE TABLE v(x, y)"}.step();
+        statement{conn, "SELECT y FROM v WHERE x = ?1"}.expect_indexed();
+    }
+};
+
+TEST_F(QueryPlanSystemTest, ParsesThePlanIntoATree)
+{
+    try {
+        statement stmt{conn_, "WITH c AS MATERIALIZED (SELECT a FROM u) SELECT * FROM c CROSS JOIN t WHERE t.x = c.a"};
+        auto plan = stmt.query_plan();
+        ASSERT_EQ(plan.nodes.size(), 3u);
+        EXPECT_EQ(plan.nodes[0].detail, "MATERIALIZE c");
+        ASSERT_EQ(plan.nodes[0].children.size(), 1u);
+        EXPECT_EQ(plan.nodes[0].children[0].detail, "SCAN u");
+        EXPECT_EQ(plan.nodes[0].children[0].parent, plan.nodes[0].id);
+        EXPECT_EQ(plan.nodes[1].detail, "SCAN c");
+        EXPECT_EQ(plan.nodes[2].detail, "SEARCH t USING INDEX t_x (x=?)");
+        EXPECT_EQ(plan.to_string(), "MATERIALIZE c\n  SCAN u\nSCAN c\nSEARCH t USING INDEX t_x (x=?)\n");
+
+        // the scan of the materialized CTE reads no table
+        auto scans = plan.full_scans();
+        ASSERT_EQ(scans.size(), 1u);
+        EXPECT_EQ(scans[0]->detail, "SCAN u");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(QueryPlanSystemTest, FindsFullScans)
+{
+    try {
+        EXPECT_TRUE(statement(conn_, "SELECT y FROM t WHERE x = ?1").query_plan().full_scans().empty());
+        EXPECT_TRUE(statement(conn_, "SELECT 1").query_plan().full_scans().empty());
+        EXPECT_EQ(statement(conn_, "SELECT * FROM t WHERE y = 1").query_plan().full_scans().size(), 1u);
+        // a covering index is read whole too
+        EXPECT_EQ(statement(conn_, "SELECT x FROM t").query_plan().full_scans().size(), 1u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(QueryPlanSystemTest, ReportsFullScansOfIndexedStatements)
+{
+    try {
+        statement indexed{conn_, "SELECT y FROM t WHERE x = ?1"};
+        statement scanning{conn_, "SELECT x FROM t WHERE y = ?1"};
+
+        // without a handler nothing is checked
+        scanning.expect_indexed();
+        EXPECT_TRUE(reported.empty());
+
+        EXPECT_EQ(set_full_scan_handler(&record), nullptr);
+        indexed.expect_indexed();
+        EXPECT_TRUE(reported.empty());
+        scanning.expect_indexed();
+        ASSERT_EQ(reported.size(), 1u);
+        EXPECT_EQ(reported[0], "SELECT x FROM t WHERE y = ?1: SCAN t");
+        EXPECT_EQ(set_full_scan_handler(nullptr), &record);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(QueryPlanSystemTest, FailsTestsThroughTheHandler)
+{
+    set_full_scan_handler([](std::string_view sql, std::string_view detail) { ADD_FAILURE() << sql << " runs " << detail; });
+    EXPECT_NONFATAL_FAILURE(expect_unindexed_query_indexed(), "SELECT y FROM v WHERE x = ?1 runs SCAN v");
+}
+
+#if defined(SQLITEPP_ENABLE_STMT_SCANSTATUS)
+
+TEST_F(QueryPlanSystemTest, ScanStatus)
+{
+    try {
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(),
+                               "WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM c LIMIT 100) INSERT INTO t SELECT i % 10, i FROM c", nullptr,
+                               nullptr, nullptr),
+                  SQLITE_OK);
+        statement stmt{conn_, "SELECT y FROM t WHERE x = 3"};
+        while (stmt.step()) {
+        }
+        auto loops = stmt.scan_status();
+        ASSERT_EQ(loops.size(), 1u);
+        EXPECT_EQ(loops[0].name, "t_x");
+        EXPECT_EQ(loops[0].explain, "SEARCH t USING INDEX t_x (x=?)");
+        EXPECT_EQ(loops[0].loops, 1);
+        EXPECT_EQ(loops[0].visited, 10);
+        EXPECT_DOUBLE_EQ(loops[0].actual(), 10.0);
+        EXPECT_GT(loops[0].estimated, 0.0);
+
+        stmt.scan_status_reset();
+        EXPECT_EQ(stmt.scan_status()[0].visited, 0);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+#endif
+
+TEST_F(QueryPlanSystemTest, Errors)
+{
+    std::error_code ec;
+    statement unprepared;
+    unprepared.query_plan(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+
+    set_full_scan_handler(&record);
+    unprepared.expect_indexed(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_THROW(unprepared.expect_indexed(), std::system_error);
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/script.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace sqlitepp;
+
+class ScriptSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+    }
+
+    std::int64_t count(const char* table)
+    {
+        statement stmt{conn_, std::string{"SELECT count(*) FROM "} + table};
+        stmt.step();
+        return stmt.column_int64(0);
+    }
+};
+
+TEST_F(ScriptSystemTest, RunsEveryStatement)
+{
+    try {
+        auto result = conn_.execute_script("CREATE TABLE t(x);\n"
+                                           "-- rows\n"
+                                           "INSERT INTO t VALUES (1), (2);;\n"
+                                           "/* results are dropped */ SELECT * FROM t;\n"
+                                           "INSERT INTO t SELECT x + 2 FROM t  ");
+        EXPECT_EQ(result.statements, 4u);
+        EXPECT_TRUE(result.timings.empty());
+        EXPECT_EQ(count("t"), 4);
+
+        EXPECT_EQ(conn_.execute_script("").statements, 0u);
+        EXPECT_EQ(conn_.execute_script("  -- nothing\n ;").statements, 0u);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ScriptSystemTest, TimesStatements)
+{
+    try {
+        std::string_view sql{"CREATE TABLE t(x);\n  INSERT INTO t VALUES (1)"};
+        auto result = conn_.execute_script(sql, {true});
+        ASSERT_EQ(result.timings.size(), 2u);
+        EXPECT_EQ(sql.substr(result.timings[0].offset, result.timings[0].length), "CREATE TABLE t(x);");
+        EXPECT_EQ(sql.substr(result.timings[1].offset, result.timings[1].length), "INSERT INTO t VALUES (1)");
+        EXPECT_GE(result.timings[1].elapsed.count(), 0);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ScriptSystemTest, ReportsWhereSyntaxErrorsAre)
+{
+    std::string_view sql{"CREATE TABLE t(x);\nINSERT INTO t VALUES (1);\nSELECT x FROM t WHERE;\nINSERT INTO t VALUES (2)"};
+    std::error_code ec;
+    auto result = conn_.execute_script(sql, {}, ec);
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_EQ(result.statements, 2u);
+    EXPECT_EQ(result.error_statement, 2u);
+    EXPECT_EQ(sql.substr(result.error_offset, 1), ";");
+    EXPECT_EQ(result.error_offset, sql.find("WHERE;") + 5);
+    // the statements before the error stay done
+    EXPECT_EQ(count("t"), 1);
+}
+
+TEST_F(ScriptSystemTest, ReportsWhereRuntimeErrorsAre)
+{
+    std::string_view sql{"CREATE TABLE t(x UNIQUE);\n  INSERT INTO t VALUES (1);\n  INSERT INTO t VALUES (1)"};
+    try {
+        conn_.execute_script(sql);
+        FAIL();
+    }
+    catch (const script_error& e) {
+        EXPECT_EQ(e.code(), sqlite3_errc::constraint_violation);
+        EXPECT_EQ(e.statement(), 2u);
+        EXPECT_EQ(e.offset(), sql.rfind("INSERT"));
+    }
+}
+
+TEST_F(ScriptSystemTest, Errors)
+{
+    std::error_code ec;
+    connection closed;
+    closed.execute_script("SELECT 1", {}, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_THROW(closed.execute_script("SELECT 1"), std::system_error);
+}
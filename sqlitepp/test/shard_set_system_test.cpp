@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/shard_set.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace sqlitepp;
+
+class ShardSetSystemTest : public ::testing::Test
+{
+protected:
+    static constexpr int rows = 300;
+
+    std::vector<std::string> filenames_;
+    thread_pool threads_{2};
+
+    void SetUp() override
+    {
+        filenames_ = {temp_path("shard_0.db"), temp_path("shard_1.db"), temp_path("shard_2.db")};
+        remove_files();
+    }
+
+    void TearDown() override
+    {
+        remove_files();
+    }
+
+    void remove_files()
+    {
+        for (auto& filename : filenames_) {
+            for (auto suffix : {"", "-wal", "-shm"}) {
+                std::remove((filename + suffix).c_str());
+            }
+        }
+    }
+
+    std::vector<std::string> first(std::size_t n) const
+    {
+        return {filenames_.begin(), filenames_.begin() + n};
+    }
+
+    static void create_schema(shard_set& shards)
+    {
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            statement{shards.writer(i), "CREATE TABLE events(id INTEGER PRIMARY KEY, tenant TEXT)"}.step();
+            statement{shards.writer(i), "CREATE INDEX events_tenant ON events(tenant)"}.step();
+        }
+    }
+
+    static void ingest(shard_set& shards)
+    {
+        for (std::int64_t id = 1; id <= rows; ++id) {
+            shards.write(id, [id](connection& conn) {
+                statement insert{conn, "INSERT INTO events VALUES (?1, ?2)"};
+                insert.bind(1, id);
+                insert.bind(2, "tenant" + std::to_string(id % 7));
+                insert.step();
+            });
+        }
+    }
+
+    static std::set<std::int64_t> ids(shard_set& shards, std::size_t shard)
+    {
+        std::set<std::int64_t> result;
+        statement select{shards.writer(shard), "SELECT id FROM events"};
+        while (select.step()) {
+            result.insert(select.column_int64(0));
+        }
+        return result;
+    }
+
+    static void expect_routed(shard_set& shards)
+    {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            auto shard_ids = ids(shards, i);
+            for (auto id : shard_ids) {
+                EXPECT_EQ(shards.shard_index(id), i) << id;
+            }
+            total += shard_ids.size();
+        }
+        EXPECT_EQ(total, static_cast<std::size_t>(rows));
+    }
+
+    static std::int64_t count_all(shard_set& shards, thread_pool& threads)
+    {
+        return shards.query_all(
+            threads, "SELECT count(*) FROM events", std::int64_t{0},
+            [](statement& stmt) {
+                stmt.step();
+                return stmt.column_int64(0);
+            },
+            [](std::int64_t a, std::int64_t b) { return a + b; });
+    }
+};
+
+TEST_F(ShardSetSystemTest, RoutesWritesByKey)
+{
+    try {
+        shard_set shards{first(3)};
+        EXPECT_EQ(shards.size(), 3u);
+        EXPECT_EQ(shards.filename(1), filenames_[1]);
+        create_schema(shards);
+        ingest(shards);
+
+        expect_routed(shards);
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            EXPECT_FALSE(ids(shards, i).empty());
+        }
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(ShardSetSystemTest, QueriesAllShardsInParallel)
+{
+    shard_set shards{first(3)};
+    create_schema(shards);
+    ingest(shards);
+
+    EXPECT_EQ(count_all(shards, threads_), rows);
+
+    auto tenants = shards.query_all(
+        threads_, "SELECT DISTINCT tenant FROM events", std::set<std::string>{},
+        [](statement& stmt) {
+            std::set<std::string> partial;
+            while (stmt.step()) {
+                partial.emplace(stmt.column_text(0));
+            }
+            return partial;
+        },
+        [](std::set<std::string> a, std::set<std::string> b) {
+            a.merge(b);
+            return a;
+        });
+    EXPECT_EQ(tenants.size(), 7u);
+}
+
+TEST_F(ShardSetSystemTest, PluggableHash)
+{
+    // every key of the same length lands on the same shard
+    shard_set shards{first(3), [](std::string_view key) { return static_cast<std::uint64_t>(key.size()); }, shard_options{}};
+    EXPECT_EQ(shards.shard_index("abc"), shards.shard_index("xyz"));
+    EXPECT_EQ(shards.shard_index(std::int64_t{1}), shards.shard_index(std::int64_t{-5}));
+}
+
+TEST_F(ShardSetSystemTest, RebalanceGrowsByMovingKeysToNewShard)
+{
+    shard_set shards{first(2)};
+    create_schema(shards);
+    ingest(shards);
+    auto before0 = ids(shards, 0);
+    auto before1 = ids(shards, 1);
+
+    shards.rebalance(first(3), {{"events", "id"}});
+
+    ASSERT_EQ(shards.size(), 3u);
+    expect_routed(shards);
+    EXPECT_FALSE(ids(shards, 2).empty());
+    // nothing moved between the old shards
+    auto after0 = ids(shards, 0);
+    auto after1 = ids(shards, 1);
+    EXPECT_TRUE(std::includes(before0.begin(), before0.end(), after0.begin(), after0.end()));
+    EXPECT_TRUE(std::includes(before1.begin(), before1.end(), after1.begin(), after1.end()));
+
+    // the new shard got the index too
+    statement index{shards.writer(2), "SELECT count(*) FROM sqlite_schema WHERE name = 'events_tenant'"};
+    ASSERT_TRUE(index.step());
+    EXPECT_EQ(index.column_int64(0), 1);
+    EXPECT_EQ(count_all(shards, threads_), rows);
+}
+
+TEST_F(ShardSetSystemTest, RebalanceShrinks)
+{
+    shard_set shards{first(3)};
+    create_schema(shards);
+    ingest(shards);
+
+    shards.rebalance(first(2), {{"events", "id"}});
+
+    ASSERT_EQ(shards.size(), 2u);
+    expect_routed(shards);
+
+    shard_set dropped{{filenames_[2]}};
+    EXPECT_TRUE(ids(dropped, 0).empty());
+}
+
+TEST_F(ShardSetSystemTest, RebalanceMovesNothingWhenBusy)
+{
+    shard_options options;
+    options.busy_timeout_ms = 0;
+    shard_set shards{first(2), fnv1a_hash, options};
+    create_schema(shards);
+    ingest(shards);
+
+    // another writer holds the first shard
+    auto other = connect(filenames_[0]);
+    statement{other, "BEGIN IMMEDIATE"}.step();
+    std::error_code ec;
+    shards.rebalance(first(3), {{"events", "id"}}, ec);
+    EXPECT_EQ(ec, sqlite3_errc::database_busy);
+    statement{other, "COMMIT"}.step();
+    EXPECT_EQ(shards.size(), 2u);
+
+    // no row was copied without being deleted
+    std::int64_t total = 0;
+    for (auto& filename : filenames_) {
+        auto conn = connect(filename);
+        statement count{conn, "SELECT count(*) FROM sqlite_schema WHERE name = 'events'"};
+        count.step();
+        if (count.column_int64(0) != 0) {
+            statement rows_of{conn, "SELECT count(*) FROM events"};
+            rows_of.step();
+            total += rows_of.column_int64(0);
+        }
+    }
+    EXPECT_EQ(total, rows);
+
+    shards.rebalance(first(3), {{"events", "id"}});
+    expect_routed(shards);
+}
+
+TEST_F(ShardSetSystemTest, RebalanceByTextKey)
+{
+    shard_set shards{first(2)};
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        statement{shards.writer(i), "CREATE TABLE tenants(name TEXT PRIMARY KEY)"}.step();
+    }
+    for (int i = 0; i < 50; ++i) {
+        auto name = "tenant" + std::to_string(i);
+        shards.write(std::string_view{name}, [&name](connection& conn) {
+            statement insert{conn, "INSERT INTO tenants VALUES (?1)"};
+            insert.bind(1, name);
+            insert.step();
+        });
+    }
+
+    shards.rebalance(first(3), {{"tenants", "name"}});
+
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        statement select{shards.writer(i), "SELECT name FROM tenants"};
+        while (select.step()) {
+            EXPECT_EQ(shards.shard_index(select.column_text(0)), i);
+        }
+    }
+}
+
+TEST_F(ShardSetSystemTest, ErrorOnBadArguments)
+{
+    std::error_code ec;
+    shard_set empty{{}, ec};
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+
+    shard_set shards{first(2), ec};
+    ASSERT_FALSE(ec);
+    shards.rebalance({filenames_[1], filenames_[0]}, {}, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_EQ(shards.size(), 2u);
+
+    auto result = shards.query_all(
+        threads_, "SELECT * FROM missing", 0, [](statement&) { return 1; }, [](int a, int b) { return a + b; }, ec);
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_EQ(result, 0);
+}
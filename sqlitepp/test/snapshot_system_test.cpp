@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/snapshot.hpp>
+#include <sqlitepp/snapshot_readers.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace sqlitepp;
+
+class SnapshotSystemTest : public ::testing::Test
+{
+protected:
+    std::string filename_;
+
+    connection writer_;
+
+    void SetUp() override
+    {
+        filename_ = temp_path("snapshot.db");
+        remove_files();
+        writer_ = connect(filename_);
+        exec(writer_, "PRAGMA journal_mode = WAL; CREATE TABLE t(x); INSERT INTO t VALUES (1)");
+    }
+
+    void TearDown() override
+    {
+        writer_.close();
+        remove_files();
+    }
+
+    void remove_files()
+    {
+        for (auto suffix : {"", "-wal", "-shm"}) {
+            std::remove((filename_ + suffix).c_str());
+        }
+    }
+
+    static void exec(connection& conn, const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK) << sqlite3_errmsg(conn.conn_handle());
+    }
+
+    static std::int64_t count(connection& conn)
+    {
+        statement select{conn, "SELECT count(*) FROM t"};
+        select.step();
+        return select.column_int64(0);
+    }
+};
+
+TEST_F(SnapshotSystemTest, OpensSnapshotOnOtherConnection)
+{
+    try {
+        auto reader = connect(filename_);
+        auto other = connect(filename_);
+
+        snapshot s;
+        {
+            transaction read{reader, transaction::mode::deferred};
+            EXPECT_EQ(count(reader), 1);
+            s = reader.snapshot_get();
+            EXPECT_TRUE(s);
+            EXPECT_EQ(s.schema(), "main");
+        }
+
+        exec(writer_, "INSERT INTO t VALUES (2)");
+
+        transaction read{other, transaction::mode::deferred};
+        other.snapshot_open(s);
+        EXPECT_EQ(count(other), 1);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(SnapshotSystemTest, ComparesSnapshots)
+{
+    auto reader = connect(filename_);
+    snapshot older;
+    {
+        transaction read{reader, transaction::mode::deferred};
+        count(reader);
+        older = reader.snapshot_get();
+    }
+    exec(writer_, "INSERT INTO t VALUES (2)");
+    snapshot newer;
+    {
+        transaction read{reader, transaction::mode::deferred};
+        count(reader);
+        newer = reader.snapshot_get();
+    }
+
+    EXPECT_LT(older.compare(newer), 0);
+    EXPECT_GT(newer.compare(older), 0);
+}
+
+TEST_F(SnapshotSystemTest, ReadersShareOneSnapshot)
+{
+    connection_pool pool{3, filename_};
+    snapshot_readers readers{pool, 3};
+    ASSERT_EQ(readers.size(), 3u);
+
+    // committed after the first reader pinned the snapshot
+    exec(writer_, "INSERT INTO t VALUES (2)");
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        EXPECT_EQ(count(readers[i]), 1);
+    }
+    EXPECT_EQ(count(writer_), 2);
+}
+
+TEST_F(SnapshotSystemTest, ErrorOutsideReadTransaction)
+{
+    auto reader = connect(filename_);
+    std::error_code ec;
+    auto s = reader.snapshot_get("main", ec);
+
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_FALSE(s);
+
+    reader.snapshot_open(s, ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+}
+
+TEST_F(SnapshotSystemTest, ErrorOnTooManyReaders)
+{
+    connection_pool pool{2, filename_};
+    std::error_code ec;
+    snapshot_readers readers{pool, 3, ec};
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_EQ(readers.size(), 0u);
+}
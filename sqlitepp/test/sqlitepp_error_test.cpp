@@ -37,6 +37,14 @@ TEST_F(SqliteppErrorTest, InvalidArgument)
     EXPECT_THAT(ec, Eq(sqlitepp_errc::invalid_argument));
 }
 
+TEST_F(SqliteppErrorTest, DeadlineExceeded)
+{
+    std::error_code ec = sqlitepp_errc::deadline_exceeded;
+    EXPECT_THAT(ec.message(), StrEq("Deadline exceeded"));
+    EXPECT_THAT(ec.category().name(), StrEq("sqlitepp"));
+    EXPECT_THAT(ec, Eq(sqlitepp_errc::deadline_exceeded));
+}
+
 TEST_F(SqliteppErrorTest, UnknownError)
 {
     std::error_code ec = static_cast<sqlitepp_errc>(-1);
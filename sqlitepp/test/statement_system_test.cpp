@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace sqlitepp;
+
+class StatementSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE t(i INTEGER, r REAL, s TEXT, b BLOB)", nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+};
+
+TEST_F(StatementSystemTest, BindStepAndReadColumns)
+{
+    try {
+        statement insert{conn_, "INSERT INTO t VALUES (?1, ?2, ?3, ?4)"};
+        EXPECT_TRUE(insert.is_prepared());
+        EXPECT_EQ(insert.parameter_count(), 4);
+
+        std::vector<unsigned char> bytes{1, 2, 3};
+        insert.bind(1, 42);
+        insert.bind(2, 2.5);
+        insert.bind(3, std::string("text"));
+        insert.bind(4, bytes);
+        EXPECT_FALSE(insert.step());
+        insert.reset();
+
+        insert.bind(1, std::optional<int>{});
+        insert.bind(2, nullptr);
+        insert.bind_static(3, std::string_view("static"));
+        insert.bind(4, blob_view{});
+        EXPECT_FALSE(insert.step());
+
+        statement select{conn_, "SELECT i, r, s, b FROM t ORDER BY rowid"};
+        EXPECT_EQ(select.column_count(), 4);
+        EXPECT_EQ(select.column_name(2), "s");
+
+        ASSERT_TRUE(select.step());
+        EXPECT_EQ(select.column_type(0), datatype::integer);
+        EXPECT_EQ(select.column_int64(0), 42);
+        EXPECT_DOUBLE_EQ(select.column_double(1), 2.5);
+        EXPECT_EQ(select.column_text(2), "text");
+        auto blob = select.column_blob(3);
+        ASSERT_EQ(blob.size, 3u);
+        EXPECT_EQ(std::memcmp(blob.data, bytes.data(), 3), 0);
+
+        ASSERT_TRUE(select.step());
+        EXPECT_EQ(select.column_type(0), datatype::null);
+        EXPECT_EQ(select.column_type(1), datatype::null);
+        EXPECT_EQ(select.column_text(2), "static");
+        EXPECT_EQ(select.column_type(3), datatype::blob);
+        EXPECT_EQ(select.column_blob(3).size, 0u);
+
+        EXPECT_FALSE(select.step());
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(StatementSystemTest, MoveTransfersOwnership)
+{
+    statement first{conn_, "SELECT 1"};
+    auto handle = first.stmt_handle();
+
+    statement second{std::move(first)};
+    EXPECT_FALSE(first.is_prepared());
+    EXPECT_EQ(second.stmt_handle(), handle);
+
+    first = std::move(second);
+    EXPECT_EQ(first.stmt_handle(), handle);
+    EXPECT_EQ(first.sql(), "SELECT 1");
+}
+
+TEST_F(StatementSystemTest, ErrorOnSyntax)
+{
+    std::error_code ec;
+    statement stmt{conn_, "SELEC 1", ec};
+
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_FALSE(stmt.is_prepared());
+}
+
+TEST_F(StatementSystemTest, ErrorOnEmptyText)
+{
+    std::error_code ec;
+    statement stmt{conn_, "  -- nothing", ec};
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+}
+
+TEST_F(StatementSystemTest, ErrorOnClosedConnection)
+{
+    connection closed;
+    std::error_code ec;
+    statement stmt{closed, "SELECT 1", ec};
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    stmt.step(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+}
+
+TEST_F(StatementSystemTest, ExceptionOnConstraint)
+{
+    ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE u(k INTEGER PRIMARY KEY)", nullptr, nullptr, nullptr), SQLITE_OK);
+    statement insert{conn_, "INSERT INTO u VALUES (1)"};
+    insert.step();
+    insert.reset();
+    try {
+        insert.step();
+
+        FAIL() << "No exception was thrown";
+    }
+    catch (const std::system_error& ec) {
+        EXPECT_EQ(ec.code(), sqlite3_errc::constraint_violation);
+    }
+}
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/detail/sql_parameters.hpp>
+#include <sqlitepp/static_statement.hpp>
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+constexpr int count(std::string_view sql)
+{
+    return detail::parse_sql_parameters(sql).count;
+}
+
+static_assert(count("SELECT 1") == 0);
+static_assert(count("SELECT ?, ?") == 2);
+static_assert(count("SELECT ?5, ?") == 6);
+static_assert(count("SELECT :a, @b, $c, :a") == 3);
+static_assert(count("SELECT '?', \"?\", `?`, [?] -- ?\n /* ? */ , ?") == 1);
+static_assert(count("SELECT 'it''s ?', ?") == 1);
+static_assert(count("SELECT ?1; SELECT ?2") == 1);
+static_assert(count("SELECT $ns::var") == 1);
+static_assert(detail::parse_sql_parameters("SELECT :a, ?, :b").index_of(":b") == 3);
+static_assert(detail::parse_sql_parameters("SELECT ?2, :a").index_of(":a") == 3);
+static_assert(!detail::parse_sql_parameters("SELECT 'open").valid);
+static_assert(!detail::parse_sql_parameters("SELECT ?0").valid);
+
+using lookup = static_statement<"SELECT v FROM kv WHERE id = :id AND v <> @v">;
+static_assert(lookup::parameter_count_v == 2);
+static_assert(lookup::parameter_index_v<":id"> == 1);
+static_assert(lookup::parameter_index_v<"@v"> == 2);
+
+template<typename S, int Index>
+concept binds_index = requires(S s) { s.template bind<Index>(1); };
+
+template<typename S, fixed_string Name>
+concept binds_name = requires(S s) { s.template bind<Name>(1); };
+
+template<typename S, typename... Args>
+concept binds_all = requires(S s, Args... args) { s.bind_all(args...); };
+
+// wrong indexes, names and arities do not compile
+static_assert(binds_index<lookup, 2>);
+static_assert(!binds_index<lookup, 3>);
+static_assert(!binds_index<lookup, 0>);
+static_assert(binds_name<lookup, ":id">);
+static_assert(!binds_name<lookup, ":missing">);
+static_assert(binds_all<lookup, int, const char*>);
+static_assert(binds_all<lookup, int, const char*, std::error_code&>);
+static_assert(!binds_all<lookup, int>);
+static_assert(!binds_all<lookup, int, const char*, const char*, std::error_code&>);
+
+} // namespace
+
+class StaticStatementSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), "CREATE TABLE kv(id INTEGER PRIMARY KEY, v TEXT); INSERT INTO kv VALUES (1, 'one'), (2, 'two')",
+                               nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+    }
+};
+
+TEST_F(StaticStatementSystemTest, CountMatchesSQLite)
+{
+    auto stmt = conn_.prepare<"SELECT ?5, :a, ?, @b, 'x?' -- ?">();
+
+    EXPECT_EQ(stmt.parameter_count(), decltype(stmt)::parameter_count_v);
+    EXPECT_EQ(stmt.parameter_index(":a"), decltype(stmt)::parameter_index_v<":a">);
+    EXPECT_EQ(stmt.parameter_index("@b"), decltype(stmt)::parameter_index_v<"@b">);
+}
+
+TEST_F(StaticStatementSystemTest, BindByName)
+{
+    try {
+        auto stmt = conn_.prepare<"SELECT v FROM kv WHERE id = :id">();
+        stmt.bind<":id">(2);
+
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_text(0), "two");
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(StaticStatementSystemTest, BindAll)
+{
+    auto stmt = conn_.prepare<"INSERT INTO kv(id, v) VALUES (?1, ?2)">();
+    std::error_code ec;
+    stmt.bind_all(3, std::string{"three"}, ec);
+    ASSERT_FALSE(ec);
+    stmt.step(ec);
+    ASSERT_FALSE(ec);
+
+    auto check = conn_.prepare<"SELECT v FROM kv WHERE id = ?">();
+    check.bind<1>(3);
+    ASSERT_TRUE(check.step());
+    EXPECT_EQ(check.column_text(0), "three");
+}
+
+TEST_F(StaticStatementSystemTest, ErrorOnPrepare)
+{
+    std::error_code ec;
+    auto stmt = conn_.prepare<"SELECT v FROM missing WHERE id = ?">(ec);
+
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_FALSE(stmt.is_prepared());
+}
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/status.hpp>
+
+#include <gmock/gmock.h>
+
+using namespace sqlitepp;
+
+using ::testing::HasSubstr;
+
+class StatusSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        exec("CREATE TABLE t(k INTEGER, v TEXT)");
+        exec("WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < 100) INSERT INTO t SELECT x, 'v' || x FROM n");
+    }
+
+    void exec(const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+
+    static void drain(statement& stmt)
+    {
+        while (stmt.step()) {
+        }
+        stmt.reset();
+    }
+};
+
+TEST_F(StatusSystemTest, StatementCountsFullScan)
+{
+    statement stmt{conn_, "SELECT v FROM t WHERE k = 50"};
+    drain(stmt);
+
+    auto status = stmt.status();
+    EXPECT_EQ(status.fullscan_steps, 99);
+    EXPECT_EQ(status.runs, 1);
+    EXPECT_GT(status.vm_steps, 0);
+    EXPECT_GT(status.memory_used, 0);
+}
+
+TEST_F(StatusSystemTest, StatementCountsSort)
+{
+    statement stmt{conn_, "SELECT v FROM t ORDER BY v"};
+    drain(stmt);
+
+    EXPECT_EQ(stmt.status().sort_operations, 1);
+}
+
+TEST_F(StatusSystemTest, StatementDeltaSinceLastRead)
+{
+    statement stmt{conn_, "SELECT v FROM t WHERE k = 50"};
+    drain(stmt);
+    drain(stmt);
+
+    EXPECT_EQ(stmt.status(status_mode::delta).runs, 2);
+    EXPECT_EQ(stmt.status(status_mode::delta).runs, 0);
+
+    drain(stmt);
+    auto delta = stmt.status(status_mode::delta);
+    EXPECT_EQ(delta.runs, 1);
+    EXPECT_EQ(delta.fullscan_steps, 99);
+    EXPECT_GT(delta.memory_used, 0);
+}
+
+TEST_F(StatusSystemTest, ConnectionMemoryAndCache)
+{
+    statement stmt{conn_, "SELECT count(*) FROM t"};
+    drain(stmt);
+
+    auto status = conn_.status();
+    EXPECT_GT(status.cache_used, 0);
+    EXPECT_GT(status.schema_used, 0);
+    EXPECT_GT(status.stmt_used, 0);
+    EXPECT_GT(status.cache_hit + status.cache_miss, 0);
+
+    conn_.status(status_mode::delta);
+    auto delta = conn_.status(status_mode::delta);
+    EXPECT_EQ(delta.cache_hit, 0);
+    EXPECT_EQ(delta.cache_used, status.cache_used);
+}
+
+TEST_F(StatusSystemTest, DeltaKeepsGaugeHighwater)
+{
+    if (sqlite3_compileoption_used("OMIT_LOOKASIDE") != 0) {
+        GTEST_SKIP() << "SQLite is built without lookaside memory";
+    }
+    auto conn = connect(":memory:");
+    ASSERT_EQ(sqlite3_db_config(conn.conn_handle(), SQLITE_DBCONFIG_LOOKASIDE, nullptr, 256, 64), SQLITE_OK);
+    conn.execute_script("CREATE TABLE t(x); SELECT * FROM t");
+
+    auto status = conn.status(status_mode::delta);
+    EXPECT_GT(status.lookaside_used_highwater, 0);
+    EXPECT_EQ(conn.status(status_mode::delta).lookaside_used_highwater, status.lookaside_used_highwater);
+}
+
+TEST_F(StatusSystemTest, ConnectionClosed)
+{
+    connection closed;
+    auto status = closed.status();
+
+    EXPECT_EQ(status.cache_used, 0);
+}
+
+TEST_F(StatusSystemTest, UnpreparedStatement)
+{
+    statement stmt;
+
+    EXPECT_EQ(stmt.status().runs, 0);
+    EXPECT_EQ(stmt.column_type(0), datatype::null);
+    EXPECT_TRUE(stmt.column_name(0).empty());
+    EXPECT_EQ(stmt.column_int64(0), 0);
+    EXPECT_EQ(stmt.column_double(0), 0.0);
+    EXPECT_TRUE(stmt.column_text(0).empty());
+    EXPECT_EQ(stmt.column_blob(0).data, nullptr);
+    EXPECT_TRUE(stmt.column_value(0).is_null());
+}
+
+TEST_F(StatusSystemTest, PrometheusExposition)
+{
+    connection_status first;
+    first.cache_hit = 7;
+    connection_status second;
+    second.cache_hit = 3;
+
+    prometheus_exporter exporter;
+    exporter.add(first, {{"db", "main"}});
+    exporter.add(second, {{"db", "q\"uote"}});
+    auto text = exporter.str();
+
+    EXPECT_THAT(text, HasSubstr("# HELP sqlite_connection_cache_hit_total Pager cache hits\n"
+                                "# TYPE sqlite_connection_cache_hit_total counter\n"
+                                "sqlite_connection_cache_hit_total{db=\"main\"} 7\n"
+                                "sqlite_connection_cache_hit_total{db=\"q\\\"uote\"} 3\n"));
+    EXPECT_THAT(text, HasSubstr("# TYPE sqlite_connection_cache_used_bytes gauge\n"));
+    EXPECT_THAT(text, HasSubstr("# TYPE sqlite_connection_lookaside_used_highwater gauge\n"));
+}
+
+TEST_F(StatusSystemTest, PrometheusStatementWithoutLabels)
+{
+    statement_status status;
+    status.fullscan_steps = 12;
+
+    prometheus_exporter exporter{"app"};
+    exporter.add(status);
+
+    EXPECT_THAT(exporter.str(), HasSubstr("\napp_statement_fullscan_steps_total 12\n"));
+}
@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SQLITEPP_TEST_TEMP_PATH_HPP
+#define SQLITEPP_TEST_TEMP_PATH_HPP
+
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <string>
+
+// A path in the temporary directory named after the running test, so that
+// tests using files do not collide when run in parallel.
+inline std::string temp_path(const std::string& name)
+{
+    auto info = ::testing::UnitTest::GetInstance()->current_test_info();
+    std::string test = info != nullptr ? std::string{info->test_suite_name()} + "." + info->name() : "sqlitepp";
+    for (auto& c : test) {
+        if (c == '/') {
+            c = '_';
+        }
+    }
+    return (std::filesystem::temp_directory_path() / (test + "." + name)).string();
+}
+
+#endif // SQLITEPP_TEST_TEMP_PATH_HPP
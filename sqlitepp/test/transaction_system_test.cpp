@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/transaction.hpp>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+using namespace sqlitepp;
+
+class TransactionSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        exec("CREATE TABLE t(x INTEGER)");
+    }
+
+    void exec(const char* sql)
+    {
+        ASSERT_EQ(sqlite3_exec(conn_.conn_handle(), sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+
+    std::int64_t count()
+    {
+        statement stmt{conn_, "SELECT count(*) FROM t"};
+        stmt.step();
+        return stmt.column_int64(0);
+    }
+};
+
+TEST_F(TransactionSystemTest, CommitKeepsChanges)
+{
+    try {
+        transaction tx{conn_};
+        EXPECT_TRUE(tx.is_active());
+        exec("INSERT INTO t VALUES (1)");
+        tx.commit();
+        EXPECT_FALSE(tx.is_active());
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+
+    EXPECT_EQ(count(), 1);
+    EXPECT_NE(sqlite3_get_autocommit(conn_.conn_handle()), 0);
+}
+
+TEST_F(TransactionSystemTest, RollbackOnDestruction)
+{
+    {
+        transaction tx{conn_, transaction::mode::deferred};
+        exec("INSERT INTO t VALUES (1)");
+    }
+
+    EXPECT_EQ(count(), 0);
+    EXPECT_NE(sqlite3_get_autocommit(conn_.conn_handle()), 0);
+}
+
+TEST_F(TransactionSystemTest, ControlStatementsAreReused)
+{
+    for (int i = 0; i < 3; ++i) {
+        transaction tx{conn_, transaction::mode::exclusive};
+        exec("INSERT INTO t VALUES (1)");
+        tx.commit();
+    }
+
+    // the cached BEGIN and COMMIT statements stay prepared between transactions
+    int statements = 0;
+    for (auto stmt = sqlite3_next_stmt(conn_.conn_handle(), nullptr); stmt != nullptr; stmt = sqlite3_next_stmt(conn_.conn_handle(), stmt)) {
+        ++statements;
+    }
+    EXPECT_EQ(statements, 2);
+    EXPECT_EQ(count(), 3);
+}
+
+TEST_F(TransactionSystemTest, NestedSavepoints)
+{
+    transaction tx{conn_};
+    exec("INSERT INTO t VALUES (1)");
+    {
+        savepoint outer{tx};
+        exec("INSERT INTO t VALUES (2)");
+        {
+            savepoint inner{outer};
+            exec("INSERT INTO t VALUES (3)");
+        }
+        EXPECT_EQ(count(), 2);
+        outer.commit();
+        EXPECT_FALSE(outer.is_active());
+    }
+    {
+        savepoint discarded{tx};
+        exec("INSERT INTO t VALUES (4)");
+        discarded.rollback();
+    }
+    EXPECT_TRUE(tx.is_active());
+    tx.commit();
+
+    EXPECT_EQ(count(), 2);
+}
+
+TEST_F(TransactionSystemTest, SiblingSavepoints)
+{
+    try {
+        transaction tx{conn_};
+        {
+            savepoint first{tx};
+            exec("INSERT INTO t VALUES (1)");
+            savepoint second{tx};
+            exec("INSERT INTO t VALUES (2)");
+            // releases the second savepoint along with the first
+            first.commit();
+        }
+        EXPECT_EQ(count(), 2);
+        {
+            savepoint kept{tx};
+            exec("INSERT INTO t VALUES (3)");
+            savepoint discarded{tx};
+            exec("INSERT INTO t VALUES (4)");
+            discarded.rollback();
+            kept.commit();
+        }
+        tx.commit();
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+
+    EXPECT_EQ(count(), 3);
+}
+
+TEST_F(TransactionSystemTest, ErrorOnSavepointEndedByOuter)
+{
+    transaction tx{conn_};
+    savepoint outer{tx};
+    savepoint inner{outer};
+    exec("INSERT INTO t VALUES (1)");
+    outer.rollback();
+    EXPECT_FALSE(inner.is_active());
+
+    // the name of the inner savepoint is in use again, and must not be rolled back to
+    savepoint reopened{tx};
+    exec("INSERT INTO t VALUES (2)");
+    std::error_code ec;
+    inner.rollback(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_TRUE(reopened.is_active());
+
+    // and once nesting is as deep as before, under the same name as the inner savepoint
+    savepoint reopened2{reopened};
+    exec("INSERT INTO t VALUES (3)");
+    EXPECT_FALSE(inner.is_active());
+    inner.rollback(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_argument);
+    EXPECT_TRUE(reopened2.is_active());
+    reopened2.commit();
+    reopened.commit();
+    tx.commit();
+
+    EXPECT_EQ(count(), 2);
+}
+
+TEST_F(TransactionSystemTest, ErrorOnNestedBegin)
+{
+    transaction tx{conn_};
+    std::error_code ec;
+    transaction nested{conn_, ec};
+
+    EXPECT_EQ(ec, sqlite3_errc::generic_error);
+    EXPECT_TRUE(tx.is_active());
+}
+
+TEST_F(TransactionSystemTest, ErrorOnCommitTwice)
+{
+    transaction tx{conn_};
+    tx.commit();
+
+    std::error_code ec;
+    tx.commit(ec);
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+}
+
+TEST_F(TransactionSystemTest, ErrorOnClosedConnection)
+{
+    connection closed;
+    std::error_code ec;
+    transaction tx{closed, ec};
+
+    EXPECT_EQ(ec, sqlitepp_errc::invalid_handle);
+    EXPECT_FALSE(tx.is_active());
+}
+
+TEST_F(TransactionSystemTest, ImmediateBlocksSecondWriter)
+{
+    const char* filename = "transaction_test.db";
+    std::remove(filename);
+    {
+        auto first = connect(filename);
+        auto second = connect(filename);
+        transaction tx{first};
+
+        try {
+            transaction other{second};
+
+            FAIL() << "No exception was thrown";
+        }
+        catch (const std::system_error& ec) {
+            EXPECT_EQ(ec.code(), sqlite3_errc::database_busy);
+        }
+    }
+    std::remove(filename);
+}
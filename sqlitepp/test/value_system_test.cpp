@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/value.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace sqlitepp;
+
+TEST(ValueSystemTest, HoldsEachType)
+{
+    EXPECT_EQ(sizeof(value), 24u);
+
+    value null;
+    EXPECT_TRUE(null.is_null());
+    EXPECT_EQ(null.type(), datatype::null);
+    EXPECT_EQ(value{nullptr}.type(), datatype::null);
+
+    value integer{42};
+    EXPECT_EQ(integer.type(), datatype::integer);
+    EXPECT_EQ(integer.as_int64(), 42);
+    EXPECT_DOUBLE_EQ(integer.as_double(), 42.0);
+    EXPECT_EQ(value{INT64_MIN}.as_int64(), INT64_MIN);
+
+    value real{2.5};
+    EXPECT_EQ(real.type(), datatype::real);
+    EXPECT_DOUBLE_EQ(real.as_double(), 2.5);
+    EXPECT_EQ(real.as_int64(), 2);
+
+    value text{"hello"};
+    EXPECT_EQ(text.type(), datatype::text);
+    EXPECT_EQ(text.as_text(), "hello");
+    EXPECT_TRUE(text.is_inline());
+    EXPECT_EQ(text.as_blob().size, 0u);
+
+    const unsigned char bytes[] = {0, 1, 2};
+    value blob{blob_view{bytes, sizeof(bytes)}};
+    EXPECT_EQ(blob.type(), datatype::blob);
+    ASSERT_EQ(blob.as_blob().size, 3u);
+    EXPECT_EQ(std::memcmp(blob.as_blob().data, bytes, 3), 0);
+    EXPECT_EQ(blob.as_text(), "");
+}
+
+TEST(ValueSystemTest, StoresShortPayloadsInline)
+{
+    std::string fits(value::inline_capacity, 'x');
+    std::string spills(value::inline_capacity + 1, 'y');
+    EXPECT_TRUE(value{fits}.is_inline());
+    EXPECT_FALSE(value{spills}.is_inline());
+    EXPECT_EQ(value{spills}.as_text(), spills);
+    EXPECT_TRUE(value{""}.is_inline());
+    EXPECT_EQ(value{blob_view{}}.type(), datatype::blob);
+}
+
+TEST(ValueSystemTest, CopiesAndMoves)
+{
+    std::string long_text(100, 'z');
+    value heap{long_text};
+    value copy{heap};
+    EXPECT_EQ(copy.as_text(), long_text);
+    EXPECT_NE(copy.as_text().data(), heap.as_text().data());
+
+    auto data = heap.as_text().data();
+    value moved{std::move(heap)};
+    EXPECT_EQ(moved.as_text().data(), data);
+    EXPECT_TRUE(heap.is_null());
+
+    value assigned{1};
+    assigned = moved;
+    EXPECT_EQ(assigned, moved);
+    assigned = value{"short"};
+    EXPECT_EQ(assigned.as_text(), "short");
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.as_text(), long_text);
+
+    value a{"a"};
+    value b{3.0};
+    a.swap(b);
+    EXPECT_DOUBLE_EQ(a.as_double(), 3.0);
+    EXPECT_EQ(b.as_text(), "a");
+}
+
+TEST(ValueSystemTest, AllocatesFromArena)
+{
+    value_arena arena{256};
+    std::string long_text(40, 'a');
+    std::vector<value> values;
+    for (int i = 0; i < 6; ++i) {
+        values.emplace_back(long_text, &arena);
+    }
+    EXPECT_EQ(arena.block_count(), 1u);
+    EXPECT_FALSE(values[0].is_inline());
+    EXPECT_EQ(values[5].as_text(), long_text);
+    // copies share the arena bytes
+    value copy{values[0]};
+    EXPECT_EQ(copy.as_text().data(), values[0].as_text().data());
+
+    // large payloads get their own block
+    std::string large(1000, 'b');
+    value big{large, &arena};
+    EXPECT_EQ(big.as_text(), large);
+    EXPECT_EQ(arena.block_count(), 2u);
+    values.emplace_back(long_text, &arena);
+    EXPECT_EQ(arena.block_count(), 3u);
+}
+
+TEST(ValueSystemTest, HashesAndCompares)
+{
+    std::unordered_map<value, int> cache;
+    cache[value{1}] = 1;
+    cache[value{1.0}] = 2;
+    cache[value{"1"}] = 3;
+    cache[value{blob_view{"1", 1}}] = 4;
+    cache[value{}] = 5;
+    cache[value{std::string(50, 'k')}] = 6;
+    EXPECT_EQ(cache.size(), 6u);
+    EXPECT_EQ(cache.at(value{1}), 1);
+    EXPECT_EQ(cache.at(value{"1"}), 3);
+    EXPECT_EQ(cache.at(value{}), 5);
+    value_arena arena;
+    EXPECT_EQ(cache.at(value{std::string(50, 'k'), &arena}), 6);
+
+    EXPECT_EQ(value{0.0}, value{-0.0});
+    EXPECT_EQ(std::hash<value>{}(value{0.0}), std::hash<value>{}(value{-0.0}));
+    EXPECT_EQ(value{std::nan("")}, value{-std::nan("1")});
+    EXPECT_EQ(std::hash<value>{}(value{std::nan("")}), std::hash<value>{}(value{-std::nan("1")}));
+    EXPECT_NE(value{std::nan("")}, value{0.0});
+    cache[value{std::nan("")}] = 7;
+    EXPECT_EQ(cache.at(value{std::nan("")}), 7);
+    EXPECT_NE(value{"a"}, value{"b"});
+    EXPECT_NE(value{1}, value{1.0});
+}
+
+TEST(ValueSystemTest, BindsAndReadsColumns)
+{
+    try {
+        auto conn = connect(":memory:");
+        statement{conn, "CREATE TABLE t(v)"}.step();
+        std::string long_text(64, 'q');
+        const unsigned char bytes[] = {9, 8, 7};
+        std::vector<value> values{value{}, value{7}, value{1.5}, value{"short"}, value{long_text}, value{blob_view{bytes, sizeof(bytes)}}};
+
+        statement insert{conn, "INSERT INTO t VALUES (?1)"};
+        for (auto& v : values) {
+            insert.bind(1, v);
+            insert.step();
+            insert.reset();
+        }
+
+        value_arena arena;
+        statement select{conn, "SELECT v FROM t ORDER BY rowid"};
+        std::vector<value> read;
+        while (select.step()) {
+            read.push_back(select.column_value(0, &arena));
+        }
+        EXPECT_EQ(read, values);
+        EXPECT_EQ(arena.block_count(), 1u);
+
+        struct row
+        {
+            value v;
+        };
+        select.reset();
+        row r;
+        ASSERT_TRUE(select.fetch(r));
+        EXPECT_TRUE(r.v.is_null());
+        ASSERT_TRUE(select.fetch(r));
+        EXPECT_EQ(r.v, value{7});
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: MIT
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/vector_functions.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using namespace sqlitepp;
+
+namespace
+{
+
+blob_view as_blob(const std::vector<float>& v)
+{
+    return blob_view{v.data(), v.size() * sizeof(float)};
+}
+
+std::vector<float> random_vector(std::mt19937& rng, std::size_t n)
+{
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+    std::vector<float> v(n);
+    for (auto& x : v) {
+        x = dist(rng);
+    }
+    return v;
+}
+
+} // namespace
+
+class VectorFunctionsSystemTest : public ::testing::Test
+{
+protected:
+    connection conn_;
+
+    void SetUp() override
+    {
+        conn_ = connect(":memory:");
+        install_vector_functions(conn_);
+    }
+
+    std::optional<double> evaluate(const char* sql, const std::vector<float>& a, const std::vector<float>& b)
+    {
+        statement stmt{conn_, sql};
+        stmt.bind(1, as_blob(a));
+        stmt.bind(2, as_blob(b));
+        stmt.step();
+        if (stmt.column_type(0) == datatype::null) {
+            return std::nullopt;
+        }
+        return stmt.column_double(0);
+    }
+};
+
+TEST(VectorKernelsTest, MatchScalarKernels)
+{
+    std::mt19937 rng{7};
+    auto& scalar = detail::scalar_vector_kernels();
+    auto& selected = detail::select_vector_kernels();
+    EXPECT_STREQ(vector_isa(), selected.name);
+    for (std::size_t n = 0; n < 80; ++n) {
+        auto a = random_vector(rng, n + 1);
+        auto b = random_vector(rng, n + 1);
+        // one float in, so that the loads are not aligned to the vector width
+        auto x = reinterpret_cast<const unsigned char*>(a.data()) + sizeof(float);
+        auto y = reinterpret_cast<const unsigned char*>(b.data()) + sizeof(float);
+        EXPECT_NEAR(selected.dot(x, y, n), scalar.dot(x, y, n), 1e-4) << n;
+        EXPECT_NEAR(selected.l2_squared(x, y, n), scalar.l2_squared(x, y, n), 1e-4) << n;
+        float expected[3];
+        float actual[3];
+        scalar.cosine_terms(x, y, n, expected);
+        selected.cosine_terms(x, y, n, actual);
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_NEAR(actual[i], expected[i], 1e-4) << n;
+        }
+    }
+}
+
+TEST(VectorKernelsTest, ReadUnalignedBlobs)
+{
+    std::vector<unsigned char> bytes(1 + 20 * sizeof(float));
+    for (std::size_t i = 0; i < 20; ++i) {
+        float f = static_cast<float>(i);
+        std::memcpy(bytes.data() + 1 + i * sizeof(float), &f, sizeof(f));
+    }
+    // sum of i * i for i < 20
+    EXPECT_FLOAT_EQ(detail::select_vector_kernels().dot(bytes.data() + 1, bytes.data() + 1, 20), 2470.0f);
+}
+
+TEST_F(VectorFunctionsSystemTest, ComputesSimilarities)
+{
+    try {
+        std::vector<float> a{1, 2, 3};
+        std::vector<float> b{4, -5, 6};
+        EXPECT_DOUBLE_EQ(*evaluate("SELECT vec_dot(?1, ?2)", a, b), 12.0);
+        EXPECT_NEAR(*evaluate("SELECT vec_l2(?1, ?2)", a, b), std::sqrt(9.0 + 49.0 + 9.0), 1e-6);
+        EXPECT_NEAR(*evaluate("SELECT vec_cosine(?1, ?2)", a, b), 12.0 / (std::sqrt(14.0) * std::sqrt(77.0)), 1e-6);
+        EXPECT_NEAR(*evaluate("SELECT vec_cosine(?1, ?2)", a, a), 1.0, 1e-6);
+
+        // a zero vector has no direction
+        EXPECT_FALSE(evaluate("SELECT vec_cosine(?1, ?2)", a, {0, 0, 0}));
+        EXPECT_DOUBLE_EQ(*evaluate("SELECT vec_dot(?1, ?2)", {}, {}), 0.0);
+
+        statement stmt{conn_, "SELECT vec_dot(NULL, x'00000000'), vec_l2(x'00000000', NULL)"};
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_type(0), datatype::null);
+        EXPECT_EQ(stmt.column_type(1), datatype::null);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(VectorFunctionsSystemTest, RejectsMismatchedVectors)
+{
+    std::error_code ec;
+    for (auto sql : {"SELECT vec_dot(x'0000803f', x'0000803f00000040')", "SELECT vec_l2(x'000080', x'000080')", "SELECT vec_cosine('abcd', x'00000000')"}) {
+        statement stmt{conn_, sql};
+        stmt.step(ec);
+        EXPECT_EQ(ec, sqlite3_errc::generic_error) << sql;
+    }
+    EXPECT_NE(std::string{sqlite3_errmsg(conn_.conn_handle())}.find("vec_cosine"), std::string::npos);
+}
+
+TEST_F(VectorFunctionsSystemTest, FindsTopK)
+{
+    try {
+        constexpr std::size_t dimensions = 37;
+        constexpr int rows = 500;
+        std::mt19937 rng{11};
+        std::vector<std::vector<float>> vectors;
+        conn_.execute_script("CREATE TABLE items(id INTEGER PRIMARY KEY, embedding BLOB)");
+        statement insert{conn_, "INSERT INTO items VALUES (?1, ?2)"};
+        for (int i = 1; i <= rows; ++i) {
+            vectors.push_back(random_vector(rng, dimensions));
+            insert.reset();
+            insert.bind(1, i);
+            insert.bind(2, as_blob(vectors.back()));
+            insert.step();
+        }
+        // rows without a vector are skipped
+        conn_.execute_script("INSERT INTO items VALUES (1000, NULL)");
+
+        auto query = random_vector(rng, dimensions);
+        const std::pair<const char*, const char*> metrics[] = {
+            {"cosine", "1 - vec_cosine(embedding, ?1)"}, {"l2", "vec_l2(embedding, ?1)"}, {"dot", "-vec_dot(embedding, ?1)"}};
+        for (auto [metric, distance] : metrics) {
+            std::vector<std::pair<double, std::int64_t>> expected;
+            statement all{conn_, std::string{"SELECT id, "} + distance + " AS d FROM items WHERE embedding IS NOT NULL ORDER BY d, id LIMIT 10"};
+            all.bind(1, as_blob(query));
+            while (all.step()) {
+                expected.emplace_back(all.column_double(1), all.column_int64(0));
+            }
+
+            statement topk{conn_, "SELECT id, distance FROM vec_topk('items', 'embedding', ?1, 10, ?2)"};
+            topk.bind(1, as_blob(query));
+            topk.bind(2, metric);
+            std::vector<std::pair<double, std::int64_t>> actual;
+            while (topk.step()) {
+                actual.emplace_back(topk.column_double(1), topk.column_int64(0));
+            }
+            ASSERT_EQ(actual.size(), expected.size()) << metric;
+            for (std::size_t i = 0; i < actual.size(); ++i) {
+                EXPECT_EQ(actual[i].second, expected[i].second) << metric << " " << i;
+                EXPECT_NEAR(actual[i].first, expected[i].first, 1e-6) << metric << " " << i;
+            }
+        }
+
+        // the rows of a join, ordered by distance without a sort
+        statement joined{conn_, "SELECT items.id FROM vec_topk('items', 'embedding', ?1, 3) AS t JOIN items ON items.id = t.id ORDER BY t.distance"};
+        joined.bind(1, as_blob(vectors[41]));
+        ASSERT_TRUE(joined.step());
+        EXPECT_EQ(joined.column_int64(0), 42);
+        EXPECT_TRUE(joined.step());
+        EXPECT_TRUE(joined.step());
+        EXPECT_FALSE(joined.step());
+        auto plan = joined.query_plan().to_string();
+        EXPECT_EQ(plan.find("TEMP B-TREE"), std::string::npos) << plan;
+
+        statement none{conn_, "SELECT count(*) FROM vec_topk('items', 'embedding', ?1, 0)"};
+        none.bind(1, as_blob(query));
+        ASSERT_TRUE(none.step());
+        EXPECT_EQ(none.column_int64(0), 0);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(VectorFunctionsSystemTest, TopKSkipsNaN)
+{
+    try {
+        const std::vector<float> vectors[] = {{1.0f, 0.0f}, {std::nanf(""), 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {INFINITY, 1.0f}, {2.0f, 0.0f}};
+        conn_.execute_script("CREATE TABLE items(id INTEGER PRIMARY KEY, embedding BLOB)");
+        statement insert{conn_, "INSERT INTO items VALUES (?1, ?2)"};
+        for (std::size_t i = 0; i < std::size(vectors); ++i) {
+            insert.reset();
+            insert.bind(1, static_cast<int>(i + 1));
+            insert.bind(2, as_blob(vectors[i]));
+            insert.step();
+        }
+
+        const std::vector<float> query{1.0f, 0.0f};
+        for (const char* metric : {"cosine", "l2", "dot"}) {
+            statement topk{conn_, "SELECT id, distance FROM vec_topk('items', 'embedding', ?1, 3, ?2)"};
+            topk.bind(1, as_blob(query));
+            topk.bind(2, metric);
+            std::vector<std::int64_t> ids;
+            double last = -INFINITY;
+            while (topk.step()) {
+                ids.push_back(topk.column_int64(0));
+                EXPECT_FALSE(std::isnan(topk.column_double(1))) << metric;
+                EXPECT_GE(topk.column_double(1), last) << metric;
+                last = topk.column_double(1);
+            }
+            EXPECT_EQ(ids.size(), 3u) << metric;
+            EXPECT_EQ(std::count(ids.begin(), ids.end(), 2), 0) << metric;
+        }
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(VectorFunctionsSystemTest, TopKErrors)
+{
+    std::error_code ec;
+    conn_.execute_script("CREATE TABLE items(id INTEGER PRIMARY KEY, embedding BLOB)");
+    conn_.execute_script("INSERT INTO items VALUES (1, x'0000803f0000803f')");
+
+    auto run = [&](const char* sql) {
+        statement stmt{conn_, sql, ec};
+        if (!ec) {
+            stmt.step(ec);
+        }
+        return std::string{sqlite3_errmsg(conn_.conn_handle())};
+    };
+    EXPECT_NE(run("SELECT * FROM vec_topk('items', 'embedding', x'0000803f', 1)").find("differs in size"), std::string::npos);
+    EXPECT_TRUE(ec);
+    EXPECT_NE(run("SELECT * FROM vec_topk('items', 'embedding', x'0000803f0000803f', 1, 'manhattan')").find("metric"), std::string::npos);
+    EXPECT_NE(run("SELECT * FROM vec_topk('missing', 'embedding', x'0000803f0000803f', 1)").find("no such table"), std::string::npos);
+    EXPECT_NE(run("SELECT * FROM vec_topk('items', 'embedding', 'text', 1)").find("query"), std::string::npos);
+    run("SELECT * FROM vec_topk('items', 'embedding')");
+    EXPECT_TRUE(ec);
+}
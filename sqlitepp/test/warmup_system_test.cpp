@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MIT
+
+#include "temp_path.hpp"
+
+#include <sqlitepp/connection.hpp>
+#include <sqlitepp/connection_pool.hpp>
+#include <sqlitepp/sqlite3_error.hpp>
+#include <sqlitepp/sqlitepp_error.hpp>
+#include <sqlitepp/statement.hpp>
+#include <sqlitepp/thread_pool.hpp>
+#include <sqlitepp/warmup.hpp>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace sqlitepp;
+
+class WarmupSystemTest : public ::testing::Test
+{
+protected:
+    std::string filename_;
+    statement_registry registry_;
+
+    void SetUp() override
+    {
+        filename_ = temp_path("warmup.db");
+        std::remove(filename_.c_str());
+        auto conn = connect(filename_);
+        ASSERT_EQ(sqlite3_exec(conn.conn_handle(),
+                               "CREATE TABLE users(id INTEGER PRIMARY KEY, name TEXT);"
+                               "CREATE INDEX users_name ON users(name);"
+                               "INSERT INTO users VALUES (1, 'ada'), (2, 'bob')",
+                               nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+
+        registry_.add("user_by_id", "SELECT name FROM users WHERE id = ?1");
+        registry_.add("user_by_name", "SELECT id FROM users WHERE name = ?1");
+    }
+
+    void TearDown() override
+    {
+        std::remove(filename_.c_str());
+    }
+};
+
+TEST_F(WarmupSystemTest, PreparesRegistryOnEveryPooledConnection)
+{
+    try {
+        connection_pool pool{3, filename_};
+        thread_pool threads{2};
+        warmup_options options;
+        options.mmap_size = 1 << 20;
+        options.hot_objects = {"users", "users_name"};
+
+        auto report = warmup(pool, threads, registry_, options);
+        EXPECT_TRUE(report.ok());
+        EXPECT_EQ(report.connections.size(), 3u);
+
+        auto lease = pool.acquire();
+        auto& prepared = lease.prepared();
+        EXPECT_EQ(prepared.size(), 2u);
+        auto& stmt = prepared.at("user_by_id");
+        stmt.bind(1, 2);
+        ASSERT_TRUE(stmt.step());
+        EXPECT_EQ(stmt.column_text(0), "bob");
+        EXPECT_EQ(sqlite3_db_handle(stmt.stmt_handle()), lease->conn_handle());
+
+        statement mmap{*lease, "PRAGMA mmap_size"};
+        ASSERT_TRUE(mmap.step());
+        EXPECT_EQ(mmap.column_int64(0), 1 << 20);
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}
+
+TEST_F(WarmupSystemTest, WarmsSingleConnection)
+{
+    auto conn = connect(filename_);
+    warmup_options options;
+    options.hot_objects = {"users"};
+
+    prepared_statements prepared;
+    auto report = warmup(conn, prepared, registry_, options);
+    EXPECT_TRUE(report.ok());
+    ASSERT_EQ(report.connections.size(), 1u);
+    EXPECT_NE(prepared.find("user_by_name"), nullptr);
+    EXPECT_EQ(prepared.find("missing"), nullptr);
+}
+
+TEST_F(WarmupSystemTest, WarmsConnectionAsItOpens)
+{
+    warm_connection conn{registry_, warmup_options{}, filename_};
+    EXPECT_TRUE(conn.report().ok());
+
+    auto& stmt = conn.prepared().at("user_by_name");
+    stmt.bind(1, "ada");
+    ASSERT_TRUE(stmt.step());
+    EXPECT_EQ(stmt.column_int64(0), 1);
+    EXPECT_EQ(sqlite3_db_handle(stmt.stmt_handle()), conn->conn_handle());
+
+    std::error_code ec;
+    warm_connection missing{registry_, warmup_options{}, temp_path("does_not_exist.db"), connection::openmode::ro, ec};
+    EXPECT_TRUE(ec);
+    EXPECT_EQ(missing.prepared().size(), 0u);
+}
+
+TEST_F(WarmupSystemTest, CollectsErrors)
+{
+    connection_pool pool{2, filename_};
+    thread_pool threads{2};
+    registry_.add("broken", "SELECT * FROM nowhere");
+    warmup_options options;
+    options.hot_objects = {"no_such_index"};
+
+    auto report = warmup(pool, threads, registry_, options);
+
+    EXPECT_FALSE(report.ok());
+    // the bad statement on both connections, the unknown object once per connection
+    ASSERT_EQ(report.errors.size(), 4u);
+    std::size_t broken = 0;
+    for (auto& error : report.errors) {
+        if (error.what == "broken") {
+            EXPECT_EQ(error.ec, sqlite3_errc::generic_error);
+            ++broken;
+        }
+        else {
+            EXPECT_EQ(error.what, "no_such_index");
+            EXPECT_EQ(error.ec, sqlitepp_errc::invalid_argument);
+        }
+    }
+    EXPECT_EQ(broken, 2u);
+
+    // the good statements were still prepared
+    auto lease = pool.acquire();
+    EXPECT_EQ(lease.prepared().size(), 2u);
+    EXPECT_THROW(lease.prepared().at("broken"), std::system_error);
+}
+
+TEST_F(WarmupSystemTest, SkipsLeasedConnections)
+{
+    try {
+        connection_pool pool{3, filename_};
+        thread_pool threads{2};
+        auto held = pool.acquire();
+
+        auto report = warmup(pool, threads, registry_);
+        EXPECT_TRUE(report.ok());
+        EXPECT_EQ(report.connections.size(), 2u);
+        EXPECT_EQ(held.prepared().size(), 0u);
+        // the warmed connections went back to the pool with their statements
+        auto leases = pool.acquire(2);
+        ASSERT_EQ(leases.size(), 2u);
+        for (auto& lease : leases) {
+            EXPECT_NE(lease.index(), held.index());
+            EXPECT_EQ(lease.prepared().size(), 2u) << lease.index();
+        }
+    }
+    catch (const std::system_error& ec) {
+        FAIL() << ec.what();
+    }
+}